@@ -0,0 +1,171 @@
+#include <gflags/gflags.h>
+#include <mkl.h>
+#include <mkl_dfti.h>
+
+#include <cmath>
+#include <complex>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "timer.h"
+
+double freq_ghz = -1.0;  // RDTSC frequency
+
+// First 20% iterations are for warmup and not accounted for in timing
+static constexpr double warmup_fraction = .2;
+
+// Subcarriers per partial transpose block and per cache line, as in Agora
+static constexpr size_t kTransposeBlockSize = 16;
+static constexpr size_t kSCsPerCacheline = 8;
+
+DEFINE_uint64(n_iters, 1000, "Number of iterations, each one OFDM symbol");
+DEFINE_uint64(fft_size, 2048, "FFT size (OfdmCaNum)");
+DEFINE_uint64(n_ant, 64, "Number of BS antennas");
+DEFINE_uint64(block_size, 4, "Number of antennas in an FFT event");
+
+using cx_float = std::complex<float>;
+
+// Convert the int16 samples of one antenna to floats, like
+// SimdConvertShortToFloat
+static void ConvertToFloat(const int16_t* in, cx_float* out) {
+  float* out_f = reinterpret_cast<float*>(out);
+  for (size_t i = 0; i < 2 * FLAGS_fft_size; i++) {
+    out_f[i] = in[i] * (1.0f / 32768.0f);
+  }
+}
+
+// Write the FFTs of num_ant consecutive antennas starting at ant_id, stored
+// FLAGS_fft_size apart in fft_out, to the partially-transposed out_buf in
+// the order of DoFFT::PartialTranspose: block by block, and within a block,
+// antenna by antenna
+static void PartialTranspose(const cx_float* fft_out, cx_float* out_buf,
+                             size_t ant_id, size_t num_ant) {
+  const size_t num_blocks = FLAGS_fft_size / kTransposeBlockSize;
+  for (size_t block_idx = 0; block_idx < num_blocks; block_idx++) {
+    const size_t block_base_offset =
+        block_idx * (kTransposeBlockSize * FLAGS_n_ant);
+    for (size_t i = 0; i < num_ant; i++) {
+      const cx_float* src = &fft_out[i * FLAGS_fft_size];
+      for (size_t sc_j = 0; sc_j < kTransposeBlockSize;
+           sc_j += kSCsPerCacheline) {
+        const size_t sc_idx = (block_idx * kTransposeBlockSize) + sc_j;
+        std::memcpy(&out_buf[block_base_offset +
+                             ((ant_id + i) * kTransposeBlockSize) + sc_j],
+                    &src[sc_idx], kSCsPerCacheline * sizeof(cx_float));
+      }
+    }
+  }
+}
+
+// Time one DftiComputeForward call per antenna, as DoFFT::Launch does.
+// Returns the average time per antenna-symbol.
+double single_fft(const std::vector<int16_t>& samples,
+                  std::vector<cx_float>& out_buf) {
+  TscTimer timer(FLAGS_n_iters, freq_ghz);
+  DFTI_DESCRIPTOR_HANDLE handle;
+  DftiCreateDescriptor(&handle, DFTI_SINGLE, DFTI_COMPLEX, 1,
+                       static_cast<MKL_LONG>(FLAGS_fft_size));
+  DftiCommitDescriptor(handle);
+  auto* fft_inout = static_cast<cx_float*>(
+      std::aligned_alloc(64, FLAGS_fft_size * sizeof(cx_float)));
+
+  for (size_t iter = 0; iter < FLAGS_n_iters; iter++) {
+    const bool take_measurement = (iter >= FLAGS_n_iters * warmup_fraction);
+    if (take_measurement) timer.start();
+
+    for (size_t ant = 0; ant < FLAGS_n_ant; ant++) {
+      ConvertToFloat(&samples[2 * ant * FLAGS_fft_size], fft_inout);
+      DftiComputeForward(handle, reinterpret_cast<float*>(fft_inout));
+      PartialTranspose(fft_inout, out_buf.data(), ant, 1);
+    }
+
+    if (take_measurement) timer.stop();
+  }
+  DftiFreeDescriptor(&handle);
+  std::free(fft_inout);
+  return timer.avg_usec() / FLAGS_n_ant;
+}
+
+// Time the "batched_fft" path of DoFFT::LaunchEvent: one multi-transform
+// call per event of FLAGS_block_size antennas. Returns the average time per
+// antenna-symbol.
+double batched_fft(const std::vector<int16_t>& samples,
+                   std::vector<cx_float>& out_buf) {
+  TscTimer timer(FLAGS_n_iters, freq_ghz);
+  const size_t num_events = FLAGS_n_ant / FLAGS_block_size;
+  DFTI_DESCRIPTOR_HANDLE handle;
+  DftiCreateDescriptor(&handle, DFTI_SINGLE, DFTI_COMPLEX, 1,
+                       static_cast<MKL_LONG>(FLAGS_fft_size));
+  DftiSetValue(handle, DFTI_NUMBER_OF_TRANSFORMS,
+               static_cast<MKL_LONG>(FLAGS_block_size));
+  DftiSetValue(handle, DFTI_INPUT_DISTANCE,
+               static_cast<MKL_LONG>(FLAGS_fft_size));
+  DftiSetValue(handle, DFTI_OUTPUT_DISTANCE,
+               static_cast<MKL_LONG>(FLAGS_fft_size));
+  DftiCommitDescriptor(handle);
+  auto* fft_staging = static_cast<cx_float*>(std::aligned_alloc(
+      64, FLAGS_block_size * FLAGS_fft_size * sizeof(cx_float)));
+
+  for (size_t iter = 0; iter < FLAGS_n_iters; iter++) {
+    const bool take_measurement = (iter >= FLAGS_n_iters * warmup_fraction);
+    if (take_measurement) timer.start();
+
+    for (size_t event = 0; event < num_events; event++) {
+      const size_t ant_id = event * FLAGS_block_size;
+      for (size_t i = 0; i < FLAGS_block_size; i++) {
+        ConvertToFloat(&samples[2 * (ant_id + i) * FLAGS_fft_size],
+                       &fft_staging[i * FLAGS_fft_size]);
+      }
+      DftiComputeForward(handle, reinterpret_cast<float*>(fft_staging));
+      PartialTranspose(fft_staging, out_buf.data(), ant_id, FLAGS_block_size);
+    }
+
+    if (take_measurement) timer.stop();
+  }
+  DftiFreeDescriptor(&handle);
+  std::free(fft_staging);
+  return timer.avg_usec() / (num_events * FLAGS_block_size);
+}
+
+int main(int argc, char** argv) {
+  mkl_set_num_threads(1);
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  if ((FLAGS_n_ant % FLAGS_block_size != 0) ||
+      (FLAGS_fft_size % kTransposeBlockSize != 0)) {
+    std::fprintf(stderr,
+                 "n_ant must be a multiple of block_size, and fft_size a "
+                 "multiple of %zu\n",
+                 kTransposeBlockSize);
+    return -1;
+  }
+  freq_ghz = measure_rdtsc_freq();
+  nano_sleep(100 * 1000 * 1000, freq_ghz);  // Trigger turbo for 100 ms
+
+  std::mt19937 gen(0);
+  std::uniform_int_distribution<int> dist(-2048, 2047);
+  std::vector<int16_t> samples(2 * FLAGS_n_ant * FLAGS_fft_size);
+  for (auto& s : samples) {
+    s = static_cast<int16_t>(dist(gen));
+  }
+
+  std::vector<cx_float> out_single(FLAGS_n_ant * FLAGS_fft_size);
+  std::vector<cx_float> out_batched(FLAGS_n_ant * FLAGS_fft_size);
+  const double single_us = single_fft(samples, out_single);
+  const double batched_us = batched_fft(samples, out_batched);
+
+  // Header: "<FFT size> <BS antennas> <block size> <Microseconds per
+  // antenna-symbol, one FFT per call> <Microseconds per antenna-symbol,
+  // batched> <Speedup>"
+  std::printf("%zu %zu %zu %.3f %.3f %.2f\n", FLAGS_fft_size, FLAGS_n_ant,
+              FLAGS_block_size, single_us, batched_us, single_us / batched_us);
+
+  double max_diff = 0.0;
+  for (size_t i = 0; i < out_single.size(); i++) {
+    max_diff = std::max(max_diff, static_cast<double>(std::abs(
+                                      out_single[i] - out_batched[i])));
+  }
+  std::fprintf(stderr, "Max difference between the two paths = %.6f\n",
+               max_diff);
+}
@@ -0,0 +1,7 @@
+#!/bin/bash
+echo "FFT_size BS_antennas Block_size Single_us Batched_us Single/Batched"
+for fft_size in 1024 2048 4096; do
+  for block_size in 1 2 4; do
+    numactl --physcpubind=0 --membind=0 ./bench --fft_size ${fft_size} --n_ant 64 --block_size ${block_size} --n_iters 1000 2>/dev/null
+  done
+done
@@ -0,0 +1,106 @@
+#include <gflags/gflags.h>
+#include <mkl.h>
+#define ARMA_DONT_PRINT_ERRORS
+#include <armadillo>
+#include <iostream>
+
+#include "batched_zf.h"
+#include "timer.h"
+
+double freq_ghz = -1.0;  // RDTSC frequency
+
+// First 20% iterations are for warmup and not accounted for in timing
+static constexpr double warmup_fraction = .2;
+
+DEFINE_uint64(n_iters, 1000, "Number of iterations, each one ZF block");
+DEFINE_uint64(n_rows, 64, "Number of matrix rows (BS antennas)");
+DEFINE_uint64(n_cols, 16, "Number of matrix columns (UE antennas)");
+DEFINE_uint64(n_sc, 16, "Number of subcarriers in a ZF block");
+
+// Time the formula used by DoZF::ComputePrecoder on each subcarrier. Returns
+// the detectors of the last block and the average time per block.
+std::pair<std::vector<arma::cx_fmat>, double> arma_zf(
+    const std::vector<arma::cx_fmat>& test_matrices) {
+  TscTimer timer(FLAGS_n_iters, freq_ghz);
+  std::vector<arma::cx_fmat> ret(FLAGS_n_sc);
+
+  for (size_t iter = 0; iter < FLAGS_n_iters; iter++) {
+    const bool take_measurement = (iter >= FLAGS_n_iters * warmup_fraction);
+    if (take_measurement) timer.start();
+
+    for (size_t sc = 0; sc < FLAGS_n_sc; sc++) {
+      const arma::cx_fmat& input = test_matrices[sc];
+      try {
+        ret[sc] = arma::inv_sympd(input.t() * input) * input.t();
+      } catch (std::runtime_error&) {
+        arma::pinv(ret[sc], input, 1e-2, "dc");
+      }
+    }
+
+    if (take_measurement) timer.stop();
+  }
+  return std::pair<std::vector<arma::cx_fmat>, double>(ret, timer.avg_usec());
+}
+
+// Time BatchedZf, including gathering the CSI into its SIMD layout
+std::pair<std::vector<arma::cx_fmat>, double> batched_zf(
+    const std::vector<arma::cx_fmat>& test_matrices) {
+  TscTimer timer(FLAGS_n_iters, freq_ghz);
+  BatchedZf zf(FLAGS_n_rows, FLAGS_n_cols, FLAGS_n_sc);
+  std::vector<arma::cx_fmat> ret(FLAGS_n_sc);
+
+  for (size_t iter = 0; iter < FLAGS_n_iters; iter++) {
+    const bool take_measurement = (iter >= FLAGS_n_iters * warmup_fraction);
+    if (take_measurement) timer.start();
+
+    for (size_t sc = 0; sc < FLAGS_n_sc; sc++) {
+      const arma::cx_fmat& input = test_matrices[sc];
+      for (size_t ue = 0; ue < FLAGS_n_cols; ue++) {
+        for (size_t ant = 0; ant < FLAGS_n_rows; ant++) {
+          const arma::cx_float val = input(ant, ue);
+          zf.SetCsi(sc, ant, ue, {val.real(), val.imag()});
+        }
+      }
+    }
+    zf.Compute(FLAGS_n_sc);
+    for (size_t sc = 0; sc < FLAGS_n_sc; sc++) {
+      ret[sc].set_size(FLAGS_n_cols, FLAGS_n_rows);
+      zf.GetZf(sc, reinterpret_cast<complex_float*>(ret[sc].memptr()));
+    }
+
+    if (take_measurement) timer.stop();
+  }
+  return std::pair<std::vector<arma::cx_fmat>, double>(ret, timer.avg_usec());
+}
+
+int main(int argc, char** argv) {
+  mkl_set_num_threads(1);
+  arma::arma_rng::set_seed_random();
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  freq_ghz = measure_rdtsc_freq();
+  nano_sleep(100 * 1000 * 1000, freq_ghz);  // Trigger turbo for 100 ms
+
+  std::vector<arma::cx_fmat> test_matrices;
+  for (size_t i = 0; i < FLAGS_n_sc; i++) {
+    test_matrices.push_back(
+        arma::randn<arma::cx_fmat>(FLAGS_n_rows, FLAGS_n_cols));
+  }
+
+  std::pair<std::vector<arma::cx_fmat>, double> ret_arma =
+      arma_zf(test_matrices);
+  std::pair<std::vector<arma::cx_fmat>, double> ret_batched =
+      batched_zf(test_matrices);
+
+  // Header: "<matrix size> <block size> <Microseconds per subcarrier with
+  // Armadillo> <Microseconds per subcarrier with BatchedZf> <Speedup>"
+  std::printf("%zux%zu %zu %.2f %.2f %.1f\n", FLAGS_n_rows, FLAGS_n_cols,
+              FLAGS_n_sc, ret_arma.second / FLAGS_n_sc,
+              ret_batched.second / FLAGS_n_sc,
+              ret_arma.second / ret_batched.second);
+
+  double norm_sum = 0.0;
+  for (size_t i = 0; i < FLAGS_n_sc; i++) {
+    norm_sum += arma::norm(ret_arma.first[i] - ret_batched.first[i]);
+  }
+  std::fprintf(stderr, "Computation proof = %.4f\n", norm_sum);
+}
@@ -0,0 +1,9 @@
+#!/bin/bash
+echo "Matrix_size Block_size Armadillo_us BatchedZf_us Armadillo/BatchedZf"
+for n_rows in 64; do
+  for n_cols in 8 16 32; do
+    for n_sc in 1 16 64; do
+      numactl --physcpubind=0 --membind=0 ./bench --n_rows ${n_rows} --n_cols ${n_cols} --n_sc ${n_sc} --n_iters 1000 2>/dev/null
+    done
+  done
+done
@@ -0,0 +1,99 @@
+#include <gflags/gflags.h>
+#include <mkl.h>
+
+#include <complex>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "timer.h"
+
+double freq_ghz = -1.0;  // RDTSC frequency
+
+// First 20% iterations are for warmup and not accounted for in timing
+static constexpr double warmup_fraction = .2;
+// Subcarriers per 64-byte cache line of complex floats
+static constexpr size_t kSCsPerCacheline = 8;
+
+DEFINE_uint64(n_iters, 10000, "Number of iterations, each one demul block");
+DEFINE_uint64(n_ants, 64, "Number of BS antennas");
+DEFINE_uint64(n_ues, 16, "Number of UE antennas");
+DEFINE_uint64(n_sc, 48, "Number of subcarriers in a demul block");
+DEFINE_uint64(max_run, 0,
+              "Most subcarriers equalized in one GEMM, 0 for no limit");
+
+using cx_float = std::complex<float>;
+
+// Equalize the demul block like DoDemul: subcarriers sharing a precoder
+// (groups of n_ues subcarriers with frequency-orthogonal pilots) are
+// multiplied with it in one GEMM of at most [max_run] subcarriers, which do
+// not cross [run_boundary] subcarrier boundaries. Returns the average time
+// per block.
+double equalize(const std::vector<cx_float>& zf,
+                const std::vector<cx_float>& data, std::vector<cx_float>& out,
+                size_t max_run, size_t run_boundary) {
+  TscTimer timer(FLAGS_n_iters, freq_ghz);
+  const cx_float alpha = 1;
+  const cx_float beta = 0;
+
+  for (size_t iter = 0; iter < FLAGS_n_iters; iter++) {
+    const bool take_measurement = (iter >= FLAGS_n_iters * warmup_fraction);
+    if (take_measurement) timer.start();
+
+    for (size_t j = 0; j < FLAGS_n_sc;) {
+      const size_t group = j / FLAGS_n_ues;
+      size_t num_sc = 1;
+      while ((j + num_sc < FLAGS_n_sc) && (num_sc < max_run) &&
+             ((j + num_sc) % run_boundary != 0) &&
+             ((j + num_sc) / FLAGS_n_ues == group)) {
+        num_sc++;
+      }
+      cblas_cgemm(CblasColMajor, CblasNoTrans, CblasNoTrans, FLAGS_n_ues,
+                  num_sc, FLAGS_n_ants, &alpha,
+                  &zf[group * FLAGS_n_ues * FLAGS_n_ants], FLAGS_n_ues,
+                  &data[j * FLAGS_n_ants], FLAGS_n_ants, &beta,
+                  &out[j * FLAGS_n_ues], FLAGS_n_ues);
+      j += num_sc;
+    }
+
+    if (take_measurement) timer.stop();
+  }
+  return timer.avg_usec();
+}
+
+int main(int argc, char** argv) {
+  mkl_set_num_threads(1);
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  freq_ghz = measure_rdtsc_freq();
+  nano_sleep(100 * 1000 * 1000, freq_ghz);  // Trigger turbo for 100 ms
+
+  std::mt19937 gen(0);
+  std::normal_distribution<float> dist(0, 1);
+  const size_t n_groups = (FLAGS_n_sc + FLAGS_n_ues - 1) / FLAGS_n_ues;
+  std::vector<cx_float> zf(n_groups * FLAGS_n_ues * FLAGS_n_ants);
+  std::vector<cx_float> data(FLAGS_n_sc * FLAGS_n_ants);
+  for (auto& v : zf) v = {dist(gen), dist(gen)};
+  for (auto& v : data) v = {dist(gen), dist(gen)};
+  const size_t max_run = (FLAGS_max_run == 0) ? FLAGS_n_sc : FLAGS_max_run;
+
+  std::vector<cx_float> out_sc(FLAGS_n_sc * FLAGS_n_ues);
+  std::vector<cx_float> out_line(FLAGS_n_sc * FLAGS_n_ues);
+  std::vector<cx_float> out_block(FLAGS_n_sc * FLAGS_n_ues);
+  const double us_sc = equalize(zf, data, out_sc, 1, 1);
+  const double us_line =
+      equalize(zf, data, out_line, max_run, kSCsPerCacheline);
+  const double us_block = equalize(zf, data, out_block, max_run, FLAGS_n_sc);
+
+  // Header: "<ants>x<ues> <block size> <Microseconds per block with one GEMM
+  // per subcarrier> <... per run within a cache line> <... per run within
+  // the block> <Speedup of block runs over cache line runs>"
+  std::printf("%zux%zu %zu %.2f %.2f %.2f %.2f\n", FLAGS_n_ants, FLAGS_n_ues,
+              FLAGS_n_sc, us_sc, us_line, us_block, us_line / us_block);
+
+  double diff = 0.0;
+  for (size_t i = 0; i < out_sc.size(); i++) {
+    diff += std::abs(out_sc[i] - out_line[i]) +
+            std::abs(out_sc[i] - out_block[i]);
+  }
+  std::fprintf(stderr, "Computation proof = %.4f\n", diff);
+}
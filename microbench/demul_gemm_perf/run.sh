@@ -0,0 +1,9 @@
+#!/bin/bash
+echo "Matrix_size Block_size PerSc_us CachelineRuns_us BlockRuns_us CachelineRuns/BlockRuns"
+for n_ants in 64; do
+  for n_ues in 8 16 32; do
+    for n_sc in 48 96; do
+      numactl --physcpubind=0 --membind=0 ./bench --n_ants ${n_ants} --n_ues ${n_ues} --n_sc ${n_sc} --n_iters 10000 2>/dev/null
+    done
+  done
+done
@@ -0,0 +1,257 @@
+#include <gflags/gflags.h>
+#include <immintrin.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <ctime>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include "fixed_point.h"
+#include "modulation.h"
+#include "timer.h"
+
+double freq_ghz = -1.0;  // RDTSC frequency
+
+// First 20% iterations are for warmup and not accounted for in timing
+static constexpr double warmup_fraction = .2;
+
+// Subcarriers in a cache line and in a partial transpose block
+static constexpr size_t kScBlock = 8;
+
+DEFINE_uint64(n_iters, 1000, "Number of iterations, each one demul block");
+DEFINE_uint64(n_ant, 64, "Number of BS antennas");
+DEFINE_uint64(n_ue, 16, "Number of UE antennas, a multiple of 8");
+DEFINE_uint64(n_sc, 64, "Number of subcarriers in a demul block");
+DEFINE_uint64(mod_bits, 4, "Modulation order bits (2, 4, 6 or 8)");
+
+#ifdef __AVX512F__
+using SimdCx = __m512;
+static constexpr size_t kCxPerSimd = 8;
+static inline SimdCx SimdZero() { return _mm512_setzero_ps(); }
+static inline SimdCx SimdSet1(float val) { return _mm512_set1_ps(val); }
+static inline SimdCx SimdLoad(const float* ptr) { return _mm512_loadu_ps(ptr); }
+static inline SimdCx SimdFmadd(SimdCx a, SimdCx b, SimdCx c) {
+  return _mm512_fmadd_ps(a, b, c);
+}
+static inline SimdCx SimdFmaddsub(SimdCx a, SimdCx b, SimdCx c) {
+  return _mm512_fmaddsub_ps(a, b, c);
+}
+static inline SimdCx SimdSwapReIm(SimdCx a) {
+  return _mm512_permute_ps(a, 0xb1);
+}
+static inline void SimdStore(float* ptr, SimdCx a) { _mm512_store_ps(ptr, a); }
+#else
+using SimdCx = __m256;
+static constexpr size_t kCxPerSimd = 4;
+static inline SimdCx SimdZero() { return _mm256_setzero_ps(); }
+static inline SimdCx SimdSet1(float val) { return _mm256_set1_ps(val); }
+static inline SimdCx SimdLoad(const float* ptr) { return _mm256_loadu_ps(ptr); }
+static inline SimdCx SimdFmadd(SimdCx a, SimdCx b, SimdCx c) {
+  return _mm256_fmadd_ps(a, b, c);
+}
+static inline SimdCx SimdFmaddsub(SimdCx a, SimdCx b, SimdCx c) {
+  return _mm256_fmaddsub_ps(a, b, c);
+}
+static inline SimdCx SimdSwapReIm(SimdCx a) {
+  return _mm256_permute_ps(a, 0xb1);
+}
+static inline void SimdStore(float* ptr, SimdCx a) { _mm256_store_ps(ptr, a); }
+#endif
+
+// Float equalization of kNumSimds registers of users, as done by the fused
+// kernel of DoDemul
+template <size_t kNumSimds>
+static void equalize_float_users(const complex_float* zf,
+                                 const complex_float* data, size_t ue_start,
+                                 complex_float* out) {
+  SimdCx acc_re[kNumSimds];
+  SimdCx acc_im[kNumSimds];
+  for (size_t v = 0; v < kNumSimds; v++) {
+    acc_re[v] = SimdZero();
+    acc_im[v] = SimdZero();
+  }
+  for (size_t ant = 0; ant < FLAGS_n_ant; ant++) {
+    const SimdCx x_re = SimdSet1(data[ant * kScBlock].re);
+    const SimdCx x_im = SimdSet1(data[ant * kScBlock].im);
+    const auto* col =
+        reinterpret_cast<const float*>(&zf[ant * FLAGS_n_ue + ue_start]);
+    for (size_t v = 0; v < kNumSimds; v++) {
+      const SimdCx w = SimdLoad(&col[v * kCxPerSimd * 2]);
+      acc_re[v] = SimdFmadd(w, x_re, acc_re[v]);
+      acc_im[v] = SimdFmadd(w, x_im, acc_im[v]);
+    }
+  }
+  alignas(64) complex_float result[kCxPerSimd];
+  const SimdCx one = SimdSet1(1.0f);
+  for (size_t v = 0; v < kNumSimds; v++) {
+    SimdStore(reinterpret_cast<float*>(result),
+              SimdFmaddsub(acc_re[v], one, SimdSwapReIm(acc_im[v])));
+    for (size_t k = 0; k < kCxPerSimd; k++) {
+      out[(ue_start + v * kCxPerSimd + k) * FLAGS_n_sc] = result[k];
+    }
+  }
+}
+
+// Float soft demapping of one user, as done by DoDemul
+static void demod_float(float* equal, int8_t* llr) {
+  switch (FLAGS_mod_bits) {
+    case 2:
+      DemodQpskSoftSse(equal, llr, FLAGS_n_sc * 2);
+      break;
+    case 4:
+      Demod16qamSoftAvx2(equal, llr, FLAGS_n_sc);
+      break;
+    case 6:
+      Demod64qamSoftAvx2(equal, llr, FLAGS_n_sc);
+      break;
+    default:
+#ifdef __AVX512F__
+      Demod256qamSoftAvx512(equal, llr, FLAGS_n_sc);
+#else
+      Demod256qamSoftAvx2(equal, llr, FLAGS_n_sc);
+#endif
+  }
+}
+
+// Time the float datapath on one demul block. Returns the average time per
+// block.
+static double float_demul(const complex_float* data,
+                          const std::vector<complex_float*>& zf,
+                          complex_float* equal, int8_t* llr) {
+  TscTimer timer(FLAGS_n_iters, freq_ghz);
+  static constexpr size_t kUesPerPass = 4 * kCxPerSimd;
+  for (size_t iter = 0; iter < FLAGS_n_iters; iter++) {
+    const bool take_measurement = (iter >= FLAGS_n_iters * warmup_fraction);
+    if (take_measurement) timer.start();
+
+    for (size_t sc = 0; sc < FLAGS_n_sc; sc++) {
+      const complex_float* data_sc =
+          &data[(sc / kScBlock) * kScBlock * FLAGS_n_ant + sc % kScBlock];
+      for (size_t ue = 0; ue < FLAGS_n_ue; ue += kUesPerPass) {
+        switch (std::min(kUesPerPass, FLAGS_n_ue - ue) / kCxPerSimd) {
+          case 1:
+            equalize_float_users<1>(zf[sc], data_sc, ue, &equal[sc]);
+            break;
+          case 2:
+            equalize_float_users<2>(zf[sc], data_sc, ue, &equal[sc]);
+            break;
+          case 3:
+            equalize_float_users<3>(zf[sc], data_sc, ue, &equal[sc]);
+            break;
+          default:
+            equalize_float_users<4>(zf[sc], data_sc, ue, &equal[sc]);
+        }
+      }
+    }
+    for (size_t ue = 0; ue < FLAGS_n_ue; ue++) {
+      demod_float(reinterpret_cast<float*>(&equal[ue * FLAGS_n_sc]),
+                  &llr[ue * FLAGS_n_sc * FLAGS_mod_bits]);
+    }
+
+    if (take_measurement) timer.stop();
+  }
+  return timer.avg_usec();
+}
+
+// Time the Q15 datapath on one demul block, as done by DoDemul with
+// "fixed_point_demul". Returns the average time per block.
+static double q15_demul(const complex_float* data,
+                        const std::vector<complex_float*>& zf,
+                        int16_t* data_q15, int8_t* symbols, int8_t* llr) {
+  TscTimer timer(FLAGS_n_iters, freq_ghz);
+  const size_t bits = Q15OperandBits(FLAGS_n_ant);
+  int16_t* data_rot = &data_q15[FLAGS_n_ant * kScBlock * 2];
+  for (size_t iter = 0; iter < FLAGS_n_iters; iter++) {
+    const bool take_measurement = (iter >= FLAGS_n_iters * warmup_fraction);
+    if (take_measurement) timer.start();
+
+    for (size_t sc = 0; sc < FLAGS_n_sc; sc += kScBlock) {
+      const auto* block =
+          reinterpret_cast<const float*>(&data[sc * FLAGS_n_ant]);
+      const int exponent =
+          Q15BlockExponent(block, FLAGS_n_ant * kScBlock * 2, bits);
+      FloatToQ15(block, data_q15, FLAGS_n_ant * kScBlock * 2, exponent);
+      Q15RotateMinusJ(data_q15, data_rot, FLAGS_n_ant * kScBlock);
+      for (size_t j = 0; j < kScBlock; j++) {
+        Q15Equalize(zf[sc + j], FLAGS_n_ant, FLAGS_n_ue, &data_q15[j * 2],
+                    &data_rot[j * 2], kScBlock, exponent, &symbols[(sc + j) * 2], FLAGS_n_sc);
+      }
+    }
+    for (size_t ue = 0; ue < FLAGS_n_ue; ue++) {
+      Q15DemodSoft(&symbols[ue * FLAGS_n_sc * 2],
+                   &llr[ue * FLAGS_n_sc * FLAGS_mod_bits], FLAGS_n_sc,
+                   FLAGS_mod_bits);
+    }
+
+    if (take_measurement) timer.stop();
+  }
+  return timer.avg_usec();
+}
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  freq_ghz = measure_rdtsc_freq();
+  nano_sleep(100 * 1000 * 1000, freq_ghz);  // Trigger turbo for 100 ms
+
+  // Samples in the partial transpose layout of data_buffer_, and detectors
+  // followed by their Q15 copies like in the uplink ZF matrices
+  std::mt19937 gen(1);
+  std::normal_distribution<float> dist(0, 1);
+  auto* data = static_cast<complex_float*>(std::aligned_alloc(
+      64, FLAGS_n_sc * FLAGS_n_ant * sizeof(complex_float)));
+  for (size_t i = 0; i < FLAGS_n_sc * FLAGS_n_ant; i++) {
+    data[i] = {0.05f * dist(gen), 0.05f * dist(gen)};
+  }
+  const size_t cell_entries = FLAGS_n_ant * FLAGS_n_ue +
+                              Q15ZfEntries(FLAGS_n_ant, FLAGS_n_ue);
+  std::vector<complex_float*> zf(FLAGS_n_sc);
+  const std::vector<float> llr_scales(FLAGS_n_ue, Q15LlrScale(FLAGS_mod_bits));
+  for (auto& mat : zf) {
+    mat = static_cast<complex_float*>(
+        std::aligned_alloc(64, cell_entries * sizeof(complex_float)));
+    for (size_t i = 0; i < FLAGS_n_ant * FLAGS_n_ue; i++) {
+      const float gain = 1.0f / std::sqrt(FLAGS_n_ant) / 0.05f;
+      mat[i] = {gain * dist(gen), gain * dist(gen)};
+    }
+    Q15QuantizeZf(mat, FLAGS_n_ant, FLAGS_n_ue, llr_scales.data());
+  }
+
+  const size_t n_llr = FLAGS_n_ue * FLAGS_n_sc * FLAGS_mod_bits;
+  auto* equal = static_cast<complex_float*>(std::aligned_alloc(
+      64, FLAGS_n_ue * FLAGS_n_sc * sizeof(complex_float)));
+  auto* llr_float = static_cast<int8_t*>(std::aligned_alloc(64, n_llr));
+  auto* llr_q15 = static_cast<int8_t*>(std::aligned_alloc(64, n_llr));
+  auto* data_q15 = static_cast<int16_t*>(
+      std::aligned_alloc(64, FLAGS_n_ant * kScBlock * 4 * sizeof(int16_t)));
+  auto* symbols =
+      static_cast<int8_t*>(std::aligned_alloc(64, FLAGS_n_ue * FLAGS_n_sc * 2));
+
+  const double float_us = float_demul(data, zf, equal, llr_float);
+  const double q15_us = q15_demul(data, zf, data_q15, symbols, llr_q15);
+
+  // Header: "<matrix size> <modulation bits> <Nanoseconds per subcarrier
+  // with float> <Nanoseconds per subcarrier with Q15> <Speedup>"
+  std::printf("%zux%zu %zu %.1f %.1f %.2f\n", FLAGS_n_ant, FLAGS_n_ue,
+              FLAGS_mod_bits, float_us * 1000 / FLAGS_n_sc,
+              q15_us * 1000 / FLAGS_n_sc, float_us / q15_us);
+
+  size_t max_diff = 0;
+  for (size_t i = 0; i < n_llr; i++) {
+    max_diff = std::max(
+        max_diff, static_cast<size_t>(std::abs(llr_float[i] - llr_q15[i])));
+  }
+  std::fprintf(stderr, "Max LLR difference = %zu\n", max_diff);
+
+  for (auto* mat : zf) {
+    std::free(mat);
+  }
+  std::free(data);
+  std::free(equal);
+  std::free(llr_float);
+  std::free(llr_q15);
+  std::free(data_q15);
+  std::free(symbols);
+}
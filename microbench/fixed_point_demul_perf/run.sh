@@ -0,0 +1,9 @@
+#!/bin/bash
+echo "Matrix_size Modulation Float_ns/sc Q15_ns/sc Float/Q15"
+for n_ant in 32 64; do
+  for n_ue in 8 16 32; do
+    for mod_bits in 4 6; do
+      numactl --physcpubind=0 --membind=0 ./bench --n_ant ${n_ant} --n_ue ${n_ue} --mod_bits ${mod_bits} 2>/dev/null
+    done
+  done
+done
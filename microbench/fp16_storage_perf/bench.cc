@@ -0,0 +1,120 @@
+#include <gflags/gflags.h>
+#include <immintrin.h>
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include "timer.h"
+
+double freq_ghz = -1.0;  // RDTSC frequency
+
+DEFINE_uint64(n_iters, 20, "Number of passes over the data buffer");
+DEFINE_uint64(n_ant, 64, "Number of BS antennas");
+DEFINE_uint64(n_sc, 1200, "Number of OFDM data subcarriers");
+DEFINE_uint64(n_syms, 40 * 13, "Number of uplink symbols in the buffer");
+
+// Samples in one cache line of float32 data
+static constexpr size_t kFloatsPerSimd = 16;
+
+// Sum all floats of the float32 buffer [buf] with [n] floats
+static float load_fp32(const float* buf, size_t n) {
+  __m256 acc0 = _mm256_setzero_ps();
+  __m256 acc1 = _mm256_setzero_ps();
+  for (size_t i = 0; i < n; i += kFloatsPerSimd) {
+    acc0 = _mm256_add_ps(acc0, _mm256_load_ps(buf + i));
+    acc1 = _mm256_add_ps(acc1, _mm256_load_ps(buf + i + 8));
+  }
+  alignas(32) float res[8];
+  _mm256_store_ps(res, _mm256_add_ps(acc0, acc1));
+  return res[0] + res[1] + res[2] + res[3] + res[4] + res[5] + res[6] + res[7];
+}
+
+// Convert and sum all floats of the float16 buffer [buf] with [n] floats
+static float load_fp16(const uint16_t* buf, size_t n) {
+  __m256 acc0 = _mm256_setzero_ps();
+  __m256 acc1 = _mm256_setzero_ps();
+  for (size_t i = 0; i < n; i += kFloatsPerSimd) {
+    const __m256i val = _mm256_load_si256((const __m256i*)(buf + i));
+    acc0 = _mm256_add_ps(acc0, _mm256_cvtph_ps(_mm256_castsi256_si128(val)));
+    acc1 =
+        _mm256_add_ps(acc1, _mm256_cvtph_ps(_mm256_extracti128_si256(val, 1)));
+  }
+  alignas(32) float res[8];
+  _mm256_store_ps(res, _mm256_add_ps(acc0, acc1));
+  return res[0] + res[1] + res[2] + res[3] + res[4] + res[5] + res[6] + res[7];
+}
+
+// EVM in dB of rounding 64QAM symbols with amplitude [scale] plus noise at
+// 30 dB SNR to float16
+static double fp16_evm_db(float scale, size_t n) {
+  std::mt19937 gen(1);
+  std::uniform_int_distribution<int> level(0, 7);
+  std::normal_distribution<float> noise(0, std::sqrt(0.001f / 2));
+  double err = 0;
+  double pwr = 0;
+  for (size_t i = 0; i < n; i++) {
+    for (size_t k = 0; k < 2; k++) {
+      const float x = scale * ((2 * level(gen) - 7) / std::sqrt(42.0f) +
+                               noise(gen));
+      const float y = _cvtsh_ss(_cvtss_sh(x, _MM_FROUND_NO_EXC));
+      err += (y - x) * (y - x);
+      pwr += x * x;
+    }
+  }
+  return 10 * std::log10(err / pwr);
+}
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  freq_ghz = measure_rdtsc_freq();
+  nano_sleep(100 * 1000 * 1000, freq_ghz);  // Trigger turbo for 100 ms
+
+  const size_t n_floats = FLAGS_n_syms * FLAGS_n_sc * FLAGS_n_ant * 2;
+  auto* buf_fp32 =
+      static_cast<float*>(std::aligned_alloc(64, n_floats * sizeof(float)));
+  auto* buf_fp16 = static_cast<uint16_t*>(
+      std::aligned_alloc(64, n_floats * sizeof(uint16_t)));
+  std::mt19937 gen(2);
+  std::normal_distribution<float> sample(0, 0.1f);
+  for (size_t i = 0; i < n_floats; i++) {
+    buf_fp32[i] = sample(gen);
+    buf_fp16[i] = _cvtss_sh(buf_fp32[i], _MM_FROUND_NO_EXC);
+  }
+
+  std::printf("Data buffer footprint: FP32 %.1f MB, FP16 %.1f MB\n",
+              n_floats * sizeof(float) / 1e6, n_floats * sizeof(uint16_t) / 1e6);
+
+  TscTimer timer_fp32(FLAGS_n_iters, freq_ghz);
+  TscTimer timer_fp16(FLAGS_n_iters, freq_ghz);
+  float sum = 0;
+  for (size_t iter = 0; iter < FLAGS_n_iters; iter++) {
+    timer_fp32.start();
+    sum += load_fp32(buf_fp32, n_floats);
+    timer_fp32.stop();
+    timer_fp16.start();
+    sum += load_fp16(buf_fp16, n_floats);
+    timer_fp16.stop();
+  }
+  // Header: "<Storage> <GB/s read from memory> <Gsamples/s loaded>"
+  const double fp32_sec = timer_fp32.avg_usec() / 1e6;
+  const double fp16_sec = timer_fp16.avg_usec() / 1e6;
+  std::printf("FP32 %.2f GB/s %.2f Gsamples/s\n",
+              n_floats * sizeof(float) / fp32_sec / 1e9,
+              n_floats / 2 / fp32_sec / 1e9);
+  std::printf("FP16 %.2f GB/s %.2f Gsamples/s\n",
+              n_floats * sizeof(uint16_t) / fp16_sec / 1e9,
+              n_floats / 2 / fp16_sec / 1e9);
+
+  for (float scale : {1e-4f, 1e-3f, 1e-2f, 1.0f, 100.0f}) {
+    std::printf("Amplitude %g: FP16 rounding EVM %.1f dB\n", scale,
+                fp16_evm_db(scale, 1 << 16));
+  }
+  std::fprintf(stderr, "Computation proof = %.4f\n", sum);
+  std::free(buf_fp32);
+  std::free(buf_fp16);
+}
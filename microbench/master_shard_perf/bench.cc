@@ -0,0 +1,115 @@
+#include <gflags/gflags.h>
+
+#include <atomic>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include "buffer.h"
+#include "concurrentqueue.h"
+#include "gettime.h"
+
+DEFINE_uint64(n_masters, 2, "Number of master threads, including shards");
+DEFINE_uint64(n_rounds, 50, "Number of passes over the frame window");
+DEFINE_uint64(n_symbols, 14, "Number of symbols per frame");
+DEFINE_uint64(n_tasks, 64, "Number of tasks per symbol");
+
+static constexpr size_t kScheduleQueues = 2;
+static constexpr size_t kDequeueBulkSize = 64;
+
+// Model of the Agora master: completion events of kFrameWnd frames are
+// waiting in the per-frame-parity completion queues. With one master thread,
+// it counts every event. With more, the other master threads (shards) count
+// the events and forward only symbol completions to the first master thread.
+// Returns the number of completion events handled per second.
+double MasterThroughput(size_t num_masters) {
+  using mt_queue_t = moodycamel::ConcurrentQueue<EventData>;
+  const size_t num_shards = num_masters - 1;
+  const size_t num_events = kFrameWnd * FLAGS_n_symbols * FLAGS_n_tasks;
+
+  FrameCounters counters;
+  counters.Init(FLAGS_n_symbols, FLAGS_n_tasks);
+  mt_queue_t complete_task_queue[kScheduleQueues];
+  mt_queue_t shard_complete_queue;
+  double total_us = 0;
+
+  for (size_t round = 0; round < FLAGS_n_rounds; round++) {
+    for (size_t frame_id = 0; frame_id < kFrameWnd; frame_id++) {
+      for (size_t symbol_id = 0; symbol_id < FLAGS_n_symbols; symbol_id++) {
+        for (size_t task = 0; task < FLAGS_n_tasks; task++) {
+          complete_task_queue[frame_id & 0x1].enqueue(EventData(
+              EventType::kDemul,
+              gen_tag_t::FrmSymSc(frame_id, symbol_id, task).tag_));
+        }
+      }
+    }
+
+    std::atomic<bool> running(true);
+    auto shard_func = [&](size_t shard_id) {
+      const bool own_queue = (num_shards >= kScheduleQueues);
+      moodycamel::ProducerToken ptok(shard_complete_queue);
+      EventData events_list[kDequeueBulkSize];
+      while (running == true) {
+        for (size_t qid = 0; qid < kScheduleQueues; qid++) {
+          if (own_queue && (qid != (shard_id % kScheduleQueues))) {
+            continue;
+          }
+          const size_t num = complete_task_queue[qid].try_dequeue_bulk(
+              events_list, kDequeueBulkSize);
+          for (size_t i = 0; i < num; i++) {
+            gen_tag_t tag(events_list[i].tags_[0]);
+            if (counters.CompleteTask(tag.frame_id_, tag.symbol_id_)) {
+              shard_complete_queue.enqueue(ptok, events_list[i]);
+            }
+          }
+        }
+      }
+    };
+
+    std::vector<std::thread> shards;
+    const double start_us = GetTime::GetTimeUs();
+    for (size_t i = 0; i < num_shards; i++) {
+      shards.emplace_back(shard_func, i);
+    }
+
+    size_t num_frames_done = 0;
+    size_t qid = 0;
+    EventData events_list[kDequeueBulkSize];
+    while (num_frames_done < kFrameWnd) {
+      size_t num = 0;
+      if (num_shards > 0) {
+        num = shard_complete_queue.try_dequeue_bulk(events_list,
+                                                    kDequeueBulkSize);
+      } else {
+        num = complete_task_queue[qid].try_dequeue_bulk(events_list,
+                                                        kDequeueBulkSize);
+        qid ^= 0x1;
+      }
+      for (size_t i = 0; i < num; i++) {
+        gen_tag_t tag(events_list[i].tags_[0]);
+        const bool last_task =
+            (num_shards > 0) ||
+            counters.CompleteTask(tag.frame_id_, tag.symbol_id_);
+        if (last_task && counters.CompleteSymbol(tag.frame_id_)) {
+          counters.Reset(tag.frame_id_);
+          num_frames_done++;
+        }
+      }
+    }
+    total_us += GetTime::GetTimeUs() - start_us;
+
+    running = false;
+    for (auto& t : shards) {
+      t.join();
+    }
+  }
+
+  return (num_events * FLAGS_n_rounds) / total_us * 1e6;
+}
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  const double events_per_sec = MasterThroughput(FLAGS_n_masters);
+  std::printf("%zu %.2f\n", FLAGS_n_masters, events_per_sec / 1e6);
+  return 0;
+}
@@ -0,0 +1,5 @@
+#!/bin/bash
+echo "Master_threads Million_events/sec"
+for n_masters in 1 2 3 4; do
+  ./bench --n_masters ${n_masters} --n_rounds 50 2>/dev/null
+done
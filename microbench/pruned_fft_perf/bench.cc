@@ -0,0 +1,130 @@
+#include <gflags/gflags.h>
+#include <mkl.h>
+#include <mkl_dfti.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "pruned_fft.h"
+#include "timer.h"
+
+double freq_ghz = -1.0;  // RDTSC frequency
+
+// First 20% iterations are for warmup and not accounted for in timing
+static constexpr double warmup_fraction = .2;
+
+DEFINE_uint64(n_iters, 10000, "Number of iterations, each one transform");
+DEFINE_uint64(fft_size, 2048, "FFT size (OfdmCaNum)");
+DEFINE_uint64(data_num, 1200, "Number of centered data subcarriers");
+
+// Time full in-place MKL transforms, as DoFFT and DoIFFT compute them.
+// Returns the average time per transform.
+double full_fft(const std::vector<complex_float>& in,
+                std::vector<complex_float>& out, bool forward) {
+  TscTimer timer(FLAGS_n_iters, freq_ghz);
+  const size_t data_start = (FLAGS_fft_size - FLAGS_data_num) / 2;
+  const size_t data_stop = data_start + FLAGS_data_num;
+  DFTI_DESCRIPTOR_HANDLE handle;
+  DftiCreateDescriptor(&handle, DFTI_SINGLE, DFTI_COMPLEX, 1,
+                       static_cast<MKL_LONG>(FLAGS_fft_size));
+  DftiCommitDescriptor(handle);
+
+  for (size_t iter = 0; iter < FLAGS_n_iters; iter++) {
+    const bool take_measurement = (iter >= FLAGS_n_iters * warmup_fraction);
+    if (take_measurement) timer.start();
+
+    if (forward) {
+      std::memcpy(out.data(), in.data(), in.size() * sizeof(complex_float));
+      DftiComputeForward(handle, reinterpret_cast<float*>(out.data()));
+    } else {
+      // Zero the guard bands and copy the data subcarriers, like DoIFFT
+      std::memset(out.data(), 0, data_start * sizeof(complex_float));
+      std::memset(&out[data_stop], 0,
+                  (FLAGS_fft_size - data_stop) * sizeof(complex_float));
+      std::memcpy(&out[data_start], &in[data_start],
+                  FLAGS_data_num * sizeof(complex_float));
+      DftiComputeBackward(handle, reinterpret_cast<float*>(out.data()));
+    }
+
+    if (take_measurement) timer.stop();
+  }
+  DftiFreeDescriptor(&handle);
+  return timer.avg_usec();
+}
+
+// Time PrunedFft. Returns the average time per transform.
+double pruned_fft(const std::vector<complex_float>& in,
+                  std::vector<complex_float>& out, bool forward) {
+  TscTimer timer(FLAGS_n_iters, freq_ghz);
+  const size_t data_start = (FLAGS_fft_size - FLAGS_data_num) / 2;
+  PrunedFft fft(FLAGS_fft_size, data_start, data_start + FLAGS_data_num);
+
+  for (size_t iter = 0; iter < FLAGS_n_iters; iter++) {
+    const bool take_measurement = (iter >= FLAGS_n_iters * warmup_fraction);
+    if (take_measurement) timer.start();
+
+    if (forward) {
+      fft.Forward(in.data(), out.data());
+    } else {
+      fft.Backward(in.data(), out.data());
+    }
+
+    if (take_measurement) timer.stop();
+  }
+  return timer.avg_usec();
+}
+
+// Largest difference between a and b over [start, stop)
+static double max_diff(const std::vector<complex_float>& a,
+                       const std::vector<complex_float>& b, size_t start,
+                       size_t stop) {
+  double ret = 0.0;
+  for (size_t i = start; i < stop; i++) {
+    ret = std::max(ret, std::hypot(static_cast<double>(a[i].re - b[i].re),
+                                   static_cast<double>(a[i].im - b[i].im)));
+  }
+  return ret;
+}
+
+int main(int argc, char** argv) {
+  mkl_set_num_threads(1);
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  if ((FLAGS_fft_size % PrunedFft::kRadix != 0) ||
+      (FLAGS_data_num == 0) || (FLAGS_data_num > FLAGS_fft_size)) {
+    std::fprintf(stderr, "Invalid fft_size or data_num\n");
+    return -1;
+  }
+  freq_ghz = measure_rdtsc_freq();
+  nano_sleep(100 * 1000 * 1000, freq_ghz);  // Trigger turbo for 100 ms
+
+  std::mt19937 gen(0);
+  std::normal_distribution<float> dist(0.0, 1.0);
+  std::vector<complex_float> in(FLAGS_fft_size);
+  for (auto& x : in) {
+    x = {dist(gen), dist(gen)};
+  }
+  std::vector<complex_float> out_full(FLAGS_fft_size);
+  std::vector<complex_float> out_pruned(FLAGS_fft_size);
+  const size_t data_start = (FLAGS_fft_size - FLAGS_data_num) / 2;
+  const size_t data_stop = data_start + FLAGS_data_num;
+
+  const double full_fft_us = full_fft(in, out_full, true);
+  const double pruned_fft_us = pruned_fft(in, out_pruned, true);
+  const double fft_diff = max_diff(out_full, out_pruned, data_start, data_stop);
+
+  const double full_ifft_us = full_fft(in, out_full, false);
+  const double pruned_ifft_us = pruned_fft(in, out_pruned, false);
+  const double ifft_diff = max_diff(out_full, out_pruned, 0, FLAGS_fft_size);
+
+  // Header: "<FFT size> <Data subcarriers> <Microseconds per full FFT>
+  // <Microseconds per pruned FFT> <Microseconds per full IFFT>
+  // <Microseconds per pruned IFFT>"
+  std::printf("%zu %zu %.3f %.3f %.3f %.3f\n", FLAGS_fft_size, FLAGS_data_num,
+              full_fft_us, pruned_fft_us, full_ifft_us, pruned_ifft_us);
+  std::fprintf(stderr, "Max difference: FFT %.6f, IFFT %.6f\n", fft_diff,
+               ifft_diff);
+}
@@ -0,0 +1,8 @@
+#!/bin/bash
+echo "FFT_size Data_subcarriers Full_fft_us Pruned_fft_us Full_ifft_us Pruned_ifft_us"
+for fft_size in 2048 4096; do
+  for occupancy in 50 60 75 90; do
+    data_num=$(( fft_size * occupancy / 100 / 16 * 16 ))
+    numactl --physcpubind=0 --membind=0 ./bench --fft_size ${fft_size} --data_num ${data_num} --n_iters 10000 2>/dev/null
+  done
+done
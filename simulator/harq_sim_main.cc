@@ -0,0 +1,243 @@
+/**
+ * @file harq_sim_main.cc
+ * @brief Main file for the harq_sim executable, an offline simulation of
+ * HARQ with incremental redundancy over AWGN
+ *
+ * Each of num_ues users sends one LDPC code block (its transport block) per
+ * slot, on its HARQ processes in turn. The code block is rate matched to the
+ * bits of the first transmission's code rate with the redundancy version of
+ * the transmission, modulated with Agora's QAM tables, and soft demapped with
+ * Agora's demappers. The receiver combines the LLRs with the soft bits of
+ * the earlier transmissions of the transport block (HarqManager), decodes
+ * them with Agora's LdpcDecoder, and NACKs a failed code block, which its
+ * process retransmits in its next slot, up to max_tx transmissions. The
+ * decoded bits are compared with the sent ones, standing in for the CRC.
+ *
+ * For each SNR, the simulator prints the BLER of first transmissions, which
+ * is the BLER without HARQ, the residual BLER after max_tx transmissions, and
+ * the throughput, in information bits per QAM symbol, with and without HARQ.
+ */
+#include <gflags/gflags.h>
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "harq_manager.h"
+#include "ldpc_decoder.h"
+#include "memory_manage.h"
+#include "modulation.h"
+#include "rate_matching.h"
+#include "utils.h"
+#include "utils_ldpc.h"
+
+DEFINE_uint64(base_graph, 1, "LDPC base graph");
+DEFINE_uint64(zc, 64, "LDPC expansion factor");
+DEFINE_uint64(num_rows, 8,
+              "Number of LDPC rows of a transmission, which set its code rate");
+DEFINE_uint64(mod_order_bits, 4, "Bits per QAM symbol: 2, 4, 6, or 8");
+DEFINE_uint64(max_tx, 4, "Most transmissions of a transport block");
+DEFINE_uint64(num_ues, 4, "Number of users");
+DEFINE_uint64(num_processes, 8, "Number of HARQ processes per user");
+DEFINE_uint64(num_soft_buffers, 32,
+              "Number of soft buffers shared by all HARQ processes");
+DEFINE_uint64(num_tbs, 2000, "Number of transport blocks per SNR");
+DEFINE_uint64(max_decoder_iter, 10, "Most LDPC decoder iterations");
+DEFINE_double(snr_min_db, 0.0, "Lowest simulated SNR (Es/N0) in dB");
+DEFINE_double(snr_max_db, 12.0, "Highest simulated SNR (Es/N0) in dB");
+DEFINE_double(snr_step_db, 1.0, "SNR step in dB");
+DEFINE_uint64(seed, 0, "Seed of the random bits and noise");
+
+// The AVX2 soft demappers handle 16 symbols at a time
+static constexpr size_t kDemodBlockSymbols = 16;
+
+// Transport block of a HARQ process waiting for an ACK
+struct HarqProcess {
+  bool active_ = false;
+  size_t num_tx_ = 0;
+  std::vector<int8_t> input_;
+  std::vector<int8_t> encoded_;
+};
+
+struct HarqSimStats {
+  size_t num_tbs_ = 0;
+  size_t first_tx_errors_ = 0;
+  size_t residual_errors_ = 0;
+  size_t num_tx_ = 0;
+};
+
+// Soft demap num_symbols symbols (a multiple of kDemodBlockSymbols) with the
+// saturating demappers of DoDemul
+static void DemodSoft(float* rx, int8_t* llrs, size_t num_symbols,
+                      size_t mod_order_bits, float llr_scale) {
+  switch (mod_order_bits) {
+    case 2:
+      DemodQpskSoftSse(rx, llrs, 2 * num_symbols, llr_scale);
+      break;
+    case 4:
+      Demod16qamSoftAvx2(rx, llrs, num_symbols, llr_scale);
+      break;
+    case 6:
+      Demod64qamSoftAvx2(rx, llrs, num_symbols, llr_scale);
+      break;
+    case 8:
+      Demod256qamSoftAvx2(rx, llrs, num_symbols, llr_scale);
+      break;
+    default:
+      throw std::runtime_error("Unsupported modulation order bits " +
+                               std::to_string(mod_order_bits));
+  }
+}
+
+int main(int argc, char* argv[]) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  const size_t base_graph = FLAGS_base_graph;
+  const size_t zc = FLAGS_zc;
+  const size_t mod_order_bits = FLAGS_mod_order_bits;
+  RtAssert(FLAGS_num_rows >= HarqManager::kMinDecodeRows &&
+               FLAGS_num_rows <= LdpcMaxNumRows(base_graph),
+           "Invalid number of LDPC rows");
+  RtAssert(FLAGS_max_tx > 0 && FLAGS_num_processes > 0 && FLAGS_num_ues > 0,
+           "Invalid HARQ configuration");
+
+  const size_t num_info_bits = LdpcNumInputBits(base_graph, zc);
+  size_t num_tx_bits = LdpcNumEncodedBits(base_graph, zc, FLAGS_num_rows);
+  num_tx_bits -= num_tx_bits % mod_order_bits;
+  const size_t num_symbols = num_tx_bits / mod_order_bits;
+  const size_t num_demod_symbols = Roundup<kDemodBlockSymbols>(num_symbols);
+
+  Table<complex_float> mod_table;
+  InitModulationTable(mod_table, size_t(1) << mod_order_bits);
+  HarqManager harq(FLAGS_num_ues, FLAGS_num_processes, FLAGS_num_soft_buffers,
+                   1, base_graph, zc);
+  LdpcDecoder decoder(LdpcDecoder::Isa::kAvx2);
+
+  std::vector<uint8_t> tx_bits(BitsToBytes(num_tx_bits));
+  // AdaptBitsForMod writes one symbol per mod_order_bits of the padded bytes
+  std::vector<uint8_t> mod_input(BitsToBytes(num_tx_bits) * 8 / mod_order_bits +
+                                 1);
+  auto* rx = static_cast<complex_float*>(Agora_memory::PaddedAlignedAlloc(
+      Agora_memory::Alignment_t::kAlign64,
+      num_demod_symbols * sizeof(complex_float)));
+  std::memset(rx, 0, num_demod_symbols * sizeof(complex_float));
+  auto* llrs = static_cast<int8_t*>(Agora_memory::PaddedAlignedAlloc(
+      Agora_memory::Alignment_t::kAlign64,
+      num_demod_symbols * mod_order_bits));
+  std::vector<int8_t> decoder_llrs(harq.SoftBufferLen());
+  std::vector<uint8_t> decoded(BitsToBytes(num_info_bits) + kMaxProcBytes);
+  std::vector<int8_t> parity(LdpcEncodingParityBufSize(base_graph, zc));
+
+  std::mt19937 gen(FLAGS_seed);
+  std::printf(
+      "BG %zu, Zc %zu, %zu-bit symbols, code rate %.3f, %zu users x %zu HARQ "
+      "processes, %zu soft buffers, at most %zu transmissions\n",
+      base_graph, zc, mod_order_bits,
+      static_cast<double>(num_info_bits) / num_tx_bits, FLAGS_num_ues,
+      FLAGS_num_processes, FLAGS_num_soft_buffers, FLAGS_max_tx);
+  std::printf(
+      "SNR (dB) | BLER 1st tx | residual BLER | avg tx | bits/symbol without "
+      "HARQ | with HARQ\n");
+  for (double snr_db = FLAGS_snr_min_db; snr_db <= FLAGS_snr_max_db + 1e-6;
+       snr_db += FLAGS_snr_step_db) {
+    const float snr = std::pow(10.0f, static_cast<float>(snr_db) / 10);
+    const float llr_scale = SoftDemodLlrScale(mod_order_bits, snr);
+    std::normal_distribution<float> noise(0.0f, std::sqrt(0.5f / snr));
+    std::vector<HarqProcess> processes(FLAGS_num_ues * FLAGS_num_processes);
+    for (size_t i = 0; i < processes.size(); i++) {
+      harq.Release(i / FLAGS_num_processes, i % FLAGS_num_processes);
+    }
+    HarqSimStats stats;
+
+    for (size_t slot = 0; stats.num_tbs_ < FLAGS_num_tbs; slot++) {
+      const size_t process_id = slot % FLAGS_num_processes;
+      for (size_t ue_id = 0; ue_id < FLAGS_num_ues; ue_id++) {
+        HarqProcess& p = processes[ue_id * FLAGS_num_processes + process_id];
+        if (!p.active_) {
+          p.active_ = true;
+          p.num_tx_ = 0;
+          p.input_.assign(LdpcEncodingInputBufSize(base_graph, zc), 0);
+          p.encoded_.assign(LdpcEncodingEncodedBufSize(base_graph, zc), 0);
+          for (size_t i = 0; i < BitsToBytes(num_info_bits); i++) {
+            p.input_[i] = static_cast<int8_t>(gen());
+          }
+          LdpcEncodeHelper(base_graph, zc, LdpcMaxNumRows(base_graph),
+                           p.encoded_.data(), parity.data(), p.input_.data());
+        }
+
+        const size_t rv =
+            HarqManager::kRvSequence[p.num_tx_ % kNumRedundancyVersions];
+        LdpcRateMatch(base_graph, zc, rv, mod_order_bits,
+                      reinterpret_cast<const uint8_t*>(p.encoded_.data()),
+                      num_tx_bits, tx_bits.data());
+        AdaptBitsForMod(tx_bits.data(), mod_input.data(),
+                        BitsToBytes(num_tx_bits), mod_order_bits);
+        for (size_t i = 0; i < num_symbols; i++) {
+          const complex_float x = ModSingleUint8(mod_input[i], mod_table);
+          rx[i] = {x.re + noise(gen), x.im + noise(gen)};
+        }
+        DemodSoft(reinterpret_cast<float*>(rx), llrs, num_demod_symbols,
+                  mod_order_bits, llr_scale);
+
+        const size_t num_rows = harq.Combine(
+            ue_id, process_id, 0, p.num_tx_ == 0, rv, mod_order_bits, llrs,
+            num_tx_bits, decoder_llrs.data());
+        bblib_ldpc_decoder_5gnr_request request = {};
+        request.varNodes = decoder_llrs.data();
+        request.numChannelLlrs = LdpcNumEncodedBits(base_graph, zc, num_rows);
+        request.numFillerBits = 0;
+        request.maxIterations = FLAGS_max_decoder_iter;
+        request.enableEarlyTermination = 1;
+        request.Zc = zc;
+        request.baseGraph = base_graph;
+        request.nRows = num_rows;
+        bblib_ldpc_decoder_5gnr_response response = {};
+        response.numMsgBits = num_info_bits;
+        response.compactedMessageBytes = decoded.data();
+        decoder.Decode(&request, &response);
+
+        bool ack = true;
+        for (size_t i = 0; i < num_info_bits; i++) {
+          if (((decoded[i / 8] ^ static_cast<uint8_t>(p.input_[i / 8])) >>
+               (i % 8)) &
+              1) {
+            ack = false;
+            break;
+          }
+        }
+        p.num_tx_++;
+        if (ack || p.num_tx_ == FLAGS_max_tx) {
+          stats.first_tx_errors_ += (p.num_tx_ == 1 && ack) ? 0 : 1;
+          stats.residual_errors_ += ack ? 0 : 1;
+          stats.num_tx_ += p.num_tx_;
+          stats.num_tbs_++;
+          p.active_ = false;
+          harq.Release(ue_id, process_id);
+        }
+      }
+    }
+
+    const double first_tx_bler =
+        static_cast<double>(stats.first_tx_errors_) / stats.num_tbs_;
+    const double residual_bler =
+        static_cast<double>(stats.residual_errors_) / stats.num_tbs_;
+    std::printf("%8.1f | %11.4f | %13.4f | %6.2f | %24.3f | %9.3f\n", snr_db,
+                first_tx_bler, residual_bler,
+                static_cast<double>(stats.num_tx_) / stats.num_tbs_,
+                (1 - first_tx_bler) * num_info_bits / num_symbols,
+                (stats.num_tbs_ - stats.residual_errors_) *
+                    static_cast<double>(num_info_bits) /
+                    (stats.num_tx_ * num_symbols));
+  }
+  std::printf("Combined transmissions %zu, evicted soft buffers %zu\n",
+              harq.NumCombined(), harq.NumEvictions());
+
+  std::free(rx);
+  std::free(llrs);
+  gflags::ShutDownCommandLineFlags();
+  return 0;
+}
@@ -19,8 +19,12 @@ Agora::Agora(Config* const cfg)
       phy_stats_(std::make_unique<PhyStats>(cfg, Direction::kUplink)),
       csi_buffers_(kFrameWnd, cfg->UeAntNum(),
                    cfg->BsAntNum() * cfg->OfdmDataNum()),
-      ul_zf_matrices_(kFrameWnd, cfg->OfdmDataNum(),
-                      cfg->BsAntNum() * cfg->UeAntNum()),
+      ul_zf_matrices_(
+          kFrameWnd, cfg->OfdmDataNum(),
+          cfg->BsAntNum() * cfg->UeAntNum() +
+              (cfg->FixedPointDemul()
+                   ? Q15ZfEntries(cfg->BsAntNum(), cfg->UeAntNum())
+                   : 0)),
       demod_buffers_(kFrameWnd, cfg->Frame().NumULSyms(), cfg->UeAntNum(),
                      kMaxModType * cfg->OfdmDataNum()),
       decoded_buffer_(kFrameWnd, cfg->Frame().NumULSyms(), cfg->UeAntNum(),
@@ -72,6 +76,9 @@ Agora::Agora(Config* const cfg)
       cfg->CoreOffset() + 1 + cfg->SocketThreadNum() - 1,
       base_worker_core_offset_,
       base_worker_core_offset_ + cfg->WorkerThreadNum() - 1);
+  if (cfg->MasterThreadNum() > 1) {
+    MLPD_INFO("Master shard threads: %zu\n", cfg->MasterThreadNum() - 1);
+  }
 }
 
 Agora::~Agora() {
@@ -83,6 +90,10 @@ Agora::~Agora() {
     MLPD_SYMBOL("Agora: Joining worker thread\n");
     worker_thread.join();
   }
+  for (auto& shard_thread : master_shards_) {
+    MLPD_SYMBOL("Agora: Joining master shard thread\n");
+    shard_thread.join();
+  }
   FreeUplinkBuffers();
   FreeDownlinkBuffers();
 
@@ -131,8 +142,59 @@ void Agora::ScheduleDownlinkProcessing(size_t frame_id) {
   }
 }
 
+void Agora::ScheduleTask(EventType event_type, size_t qid,
+                         const EventData& event, size_t task_idx,
+                         bool from_worker) {
+  if (work_stealing_ != nullptr) {
+    work_stealing_->Push(task_idx % work_stealing_->NumWorkers(), qid, event);
+  } else if (edf_ != nullptr) {
+    edf_->Push(TaskDeadline(event), qid, event);
+  } else if (from_worker) {
+    TryEnqueueFallback(GetConq(event_type, qid), event);
+  } else {
+    TryEnqueueFallback(GetConq(event_type, qid), GetPtok(event_type, qid),
+                       event);
+  }
+}
+
+size_t Agora::TaskDeadline(const EventData& event) const {
+  size_t frame_id;
+  size_t symbol_id;
+  if (event.event_type_ == EventType::kFFT) {
+    const Packet* pkt = rx_tag_t(event.tags_[0]).rx_packet_->RawPacket();
+    frame_id = pkt->frame_id_;
+    symbol_id = pkt->symbol_id_;
+  } else {
+    frame_id = gen_tag_t(event.tags_[0]).frame_id_;
+    symbol_id = gen_tag_t(event.tags_[0]).symbol_id_;
+  }
+  const double frame_ns = config_->GetFrameDurationSec() * 1e9;
+  const double symbol_ns = frame_ns / config_->Frame().NumTotalSyms();
+
+  switch (event.event_type_) {
+    case EventType::kZF:
+      // ZF tasks carry no symbol and are due with the frame's last pilot
+      symbol_id = (config_->Frame().NumPilotSyms() > 0)
+                      ? config_->Frame().GetPilotSymbol(
+                            config_->Frame().NumPilotSyms() - 1)
+                      : 0;
+      break;
+    case EventType::kEncode:
+    case EventType::kPrecode:
+    case EventType::kIFFT:
+      // Downlink symbols are due when they are transmitted, at the start of
+      // the symbol TX_FRAME_DELTA frames later
+      return static_cast<size_t>((frame_id + TX_FRAME_DELTA) * frame_ns +
+                                 symbol_id * symbol_ns);
+    default:
+      break;
+  }
+  // Uplink tasks are due at the end of their symbol
+  return static_cast<size_t>(frame_id * frame_ns + (symbol_id + 1) * symbol_ns);
+}
+
 void Agora::ScheduleAntennas(EventType event_type, size_t frame_id,
-                             size_t symbol_id) {
+                             size_t symbol_id, bool from_worker) {
   assert(event_type == EventType::kFFT or event_type == EventType::kIFFT);
   auto base_tag = gen_tag_t::FrmSymAnt(frame_id, symbol_id, 0);
 
@@ -153,8 +215,7 @@ void Agora::ScheduleAntennas(EventType event_type, size_t frame_id,
       event.tags_[j] = base_tag.tag_;
       base_tag.ant_id_++;
     }
-    TryEnqueueFallback(GetConq(event_type, qid), GetPtok(event_type, qid),
-                       event);
+    ScheduleTask(event_type, qid, event, i, from_worker);
   }
 }
 
@@ -234,21 +295,31 @@ void Agora::ScheduleSubcarriers(EventType event_type, size_t frame_id,
                                 block_size * (i * event.num_tags_ + j))
                 .tag_;
       }
-      TryEnqueueFallback(GetConq(event_type, qid), GetPtok(event_type, qid),
-                         event);
+      ScheduleTask(event_type, qid, event, i);
     }
   } else {
     for (size_t i = 0; i < num_events; i++) {
-      TryEnqueueFallback(GetConq(event_type, qid), GetPtok(event_type, qid),
-                         EventData(event_type, base_tag.tag_));
+      ScheduleTask(event_type, qid, EventData(event_type, base_tag.tag_), i);
       base_tag.sc_id_ += block_size;
     }
   }
 }
 
 void Agora::ScheduleCodeblocks(EventType event_type, size_t frame_id,
-                               size_t symbol_idx) {
+                               size_t symbol_idx, bool from_worker) {
   auto base_tag = gen_tag_t::FrmSymCb(frame_id, symbol_idx, 0);
+  size_t qid = frame_id & 0x1;
+  if (event_type == EventType::kDecode) {
+    // A decode event decodes DecodeBlockSize() code blocks, starting at the
+    // code block of its tag
+    for (size_t i = 0; i < config_->DecodeEventsPerSymbol(); i++) {
+      ScheduleTask(event_type, qid, EventData(event_type, base_tag.tag_), i,
+                   from_worker);
+      base_tag.cb_id_ += config_->DecodeBlockSize();
+    }
+    return;
+  }
+
   const size_t num_tasks =
       config_->UeAntNum() * config_->LdpcConfig().NumBlocksInSymbol();
   size_t num_blocks = num_tasks / config_->EncodeBlockSize();
@@ -259,7 +330,6 @@ void Agora::ScheduleCodeblocks(EventType event_type, size_t frame_id,
   EventData event;
   event.num_tags_ = config_->EncodeBlockSize();
   event.event_type_ = event_type;
-  size_t qid = frame_id & 0x1;
   for (size_t i = 0; i < num_blocks; i++) {
     if ((i == num_blocks - 1) && num_remainder > 0) {
       event.num_tags_ = num_remainder;
@@ -268,8 +338,7 @@ void Agora::ScheduleCodeblocks(EventType event_type, size_t frame_id,
       event.tags_[j] = base_tag.tag_;
       base_tag.cb_id_++;
     }
-    TryEnqueueFallback(GetConq(event_type, qid), GetPtok(event_type, qid),
-                       event);
+    ScheduleTask(event_type, qid, event, i, from_worker);
   }
 }
 
@@ -291,7 +360,7 @@ void Agora::Start() {
 
   // Start packet I/O
   if (packet_tx_rx_->StartTxRx(socket_buffer_,
-                               socket_buffer_size_ / cfg->PacketLength(),
+                               socket_buffer_size_ / socket_pkt_stride_,
                                this->stats_->FrameStart(), dl_socket_buffer_,
                                calib_dl_buffer_, calib_ul_buffer_) == false) {
     this->Stop();
@@ -305,15 +374,24 @@ void Agora::Start() {
   double tx_begin = GetTime::GetTimeUs();
 
   bool is_turn_to_dequeue_from_io = true;
+  // With master shards, worker completions are counted by the shards and only
+  // the ones that complete a symbol reach this thread. In dataflow mode, the
+  // workers do the same for demodulation and precoding.
+  const bool use_master_shards = (cfg->MasterThreadNum() > 1);
+  const bool use_symbol_complete_queue =
+      use_master_shards || cfg->DataflowMode();
   const size_t max_events_needed =
       std::max(kDequeueBulkSizeTXRX * (cfg->SocketThreadNum() + 1 /* MAC */),
                kDequeueBulkSizeWorker * cfg->WorkerThreadNum());
-  EventData events_list[max_events_needed];
+  // Symbol completions are placed in front of the worker completions
+  EventData events_list[2 * max_events_needed];
 
   while ((config_->Running() == true) &&
          (SignalHandler::GotExitSignal() == false)) {
     // Get a batch of events
     size_t num_events = 0;
+    // Events before this index were already counted
+    size_t num_counted_events = 0;
     if (is_turn_to_dequeue_from_io) {
       for (size_t i = 0; i < cfg->SocketThreadNum(); i++) {
         num_events += message_queue_.try_dequeue_bulk_from_producer(
@@ -326,15 +404,32 @@ void Agora::Start() {
             events_list + num_events, kDequeueBulkSizeTXRX);
       }
     } else {
-      num_events +=
-          complete_task_queue_[(this->cur_proc_frame_id_ & 0x1)]
-              .try_dequeue_bulk(events_list + num_events, max_events_needed);
+      // In dataflow mode, a worker queues the completion of a demodulated or
+      // precoded symbol before it schedules the symbol's decode or IFFT
+      // tasks. Dequeuing the worker completions first and handling the symbol
+      // completions first ensures that the master sees a symbol complete
+      // before any of the tasks that depend on it.
+      EventData* worker_events = events_list + max_events_needed;
+      size_t num_worker_events = 0;
+      if (use_master_shards == false) {
+        num_worker_events =
+            complete_task_queue_[(this->cur_proc_frame_id_ & 0x1)]
+                .try_dequeue_bulk(worker_events, max_events_needed);
+      }
+      if (use_symbol_complete_queue) {
+        num_counted_events = symbol_complete_queue_.try_dequeue_bulk(
+            events_list, max_events_needed);
+      }
+      std::move(worker_events, worker_events + num_worker_events,
+                events_list + num_counted_events);
+      num_events = num_counted_events + num_worker_events;
     }
     is_turn_to_dequeue_from_io = !is_turn_to_dequeue_from_io;
 
     // Handle each event
     for (size_t ev_i = 0; ev_i < num_events; ev_i++) {
       EventData& event = events_list[ev_i];
+      const bool tasks_counted = (ev_i < num_counted_events);
 
       // FFT processing is scheduled after falling through the switch
       switch (event.event_type_) {
@@ -346,7 +441,7 @@ void Agora::Start() {
                 "Error: Received packet for future frame %u beyond "
                 "frame window (= %zu + %zu). This can happen if "
                 "Agora is running slowly, e.g., in debug mode\n",
-                pkt->frame_id_, this->cur_sche_frame_id_, kFrameWnd);
+                pkt->frame_id_, this->cur_sche_frame_id_.load(), kFrameWnd);
             cfg->Running(false);
             break;
           }
@@ -358,7 +453,7 @@ void Agora::Start() {
 
         case EventType::kFFT: {
           for (size_t i = 0; i < event.num_tags_; i++) {
-            HandleEventFft(event.tags_[i]);
+            HandleEventFft(event.tags_[i], tasks_counted);
           }
         } break;
 
@@ -367,7 +462,8 @@ void Agora::Start() {
             size_t frame_id = gen_tag_t(event.tags_[tag_id]).frame_id_;
             PrintPerTaskDone(PrintType::kZF, frame_id, 0,
                              zf_counters_.GetTaskCount(frame_id));
-            bool last_zf_task = this->zf_counters_.CompleteTask(frame_id);
+            bool last_zf_task =
+                tasks_counted || this->zf_counters_.CompleteTask(frame_id);
             if (last_zf_task == true) {
               this->stats_->MasterSetTsc(TsType::kZFDone, frame_id);
               zf_last_frame_ = frame_id;
@@ -404,10 +500,14 @@ void Agora::Start() {
 
           PrintPerTaskDone(PrintType::kDemul, frame_id, symbol_id, base_sc_id);
           bool last_demul_task =
+              tasks_counted ||
               this->demul_counters_.CompleteTask(frame_id, symbol_id);
 
           if (last_demul_task == true) {
-            ScheduleCodeblocks(EventType::kDecode, frame_id, symbol_id);
+            // In dataflow mode, the worker already scheduled decoding
+            if (cfg->DataflowMode() == false) {
+              ScheduleCodeblocks(EventType::kDecode, frame_id, symbol_id);
+            }
             PrintPerSymbolDone(PrintType::kDemul, frame_id, symbol_id);
             bool last_demul_symbol =
                 this->demul_counters_.CompleteSymbol(frame_id);
@@ -431,6 +531,7 @@ void Agora::Start() {
           size_t symbol_id = gen_tag_t(event.tags_[0]).symbol_id_;
 
           bool last_decode_task =
+              tasks_counted ||
               this->decode_counters_.CompleteTask(frame_id, symbol_id);
           if (last_decode_task == true) {
             if (kEnableMac == true) {
@@ -458,6 +559,8 @@ void Agora::Start() {
           rc.n_antennas_ = event.tags_[0];
           rc.mod_order_bits_ = event.tags_[1];
           rc.frame_id_ = event.tags_[2];
+          rc.ue_id_ = event.tags_[3];
+          rc.ldpc_num_rows_ = event.tags_[4];
           UpdateRanConfig(rc);
         } break;
 
@@ -514,6 +617,7 @@ void Agora::Start() {
             size_t symbol_id = gen_tag_t(event.tags_[i]).symbol_id_;
 
             bool last_encode_task =
+                tasks_counted ||
                 encode_counters_.CompleteTask(frame_id, symbol_id);
             if (last_encode_task == true) {
               this->encode_cur_frame_for_symbol_.at(
@@ -542,12 +646,16 @@ void Agora::Start() {
           size_t symbol_id = gen_tag_t(event.tags_[0]).symbol_id_;
           PrintPerTaskDone(PrintType::kPrecode, frame_id, symbol_id, sc_id);
           bool last_precode_task =
+              tasks_counted ||
               this->precode_counters_.CompleteTask(frame_id, symbol_id);
 
           if (last_precode_task == true) {
             // precode_cur_frame_for_symbol_.at(
             //    this->config_->Frame().GetDLSymbolIdx(symbol_id)) = frame_id;
-            ScheduleAntennas(EventType::kIFFT, frame_id, symbol_id);
+            // In dataflow mode, the worker already scheduled IFFT
+            if (cfg->DataflowMode() == false) {
+              ScheduleAntennas(EventType::kIFFT, frame_id, symbol_id);
+            }
             PrintPerSymbolDone(PrintType::kPrecode, frame_id, symbol_id);
 
             bool last_precode_symbol =
@@ -570,6 +678,7 @@ void Agora::Start() {
             PrintPerTaskDone(PrintType::kIFFT, frame_id, symbol_id, ant_id);
 
             bool last_ifft_task =
+                tasks_counted ||
                 this->ifft_counters_.CompleteTask(frame_id, symbol_id);
             if (last_ifft_task == true) {
               ifft_cur_frame_for_symbol_.at(symbol_idx_dl) = frame_id;
@@ -672,6 +781,8 @@ void Agora::Start() {
       if (cur_fftq.size() >= config_->FftBlockSize()) {
         size_t num_fft_blocks = cur_fftq.size() / config_->FftBlockSize();
         for (size_t i = 0; i < num_fft_blocks; i++) {
+          const size_t fft_block_idx =
+              this->fft_created_count_ / config_->FftBlockSize();
           EventData do_fft_task;
           do_fft_task.num_tags_ = config_->FftBlockSize();
           do_fft_task.event_type_ = EventType::kFFT;
@@ -693,8 +804,7 @@ void Agora::Start() {
               }
             }
           }
-          TryEnqueueFallback(GetConq(EventType::kFFT, qid),
-                             GetPtok(EventType::kFFT, qid), do_fft_task);
+          ScheduleTask(EventType::kFFT, qid, do_fft_task, fft_block_idx);
         }
       }
     } /* End of for */
@@ -718,13 +828,14 @@ finish:
   this->Stop();
 }
 
-void Agora::HandleEventFft(size_t tag) {
+void Agora::HandleEventFft(size_t tag, bool task_counted) {
   size_t frame_id = gen_tag_t(tag).frame_id_;
   size_t symbol_id = gen_tag_t(tag).symbol_id_;
   SymbolType sym_type = config_->GetSymbolType(symbol_id);
 
   if (sym_type == SymbolType::kPilot) {
-    bool last_fft_task = pilot_fft_counters_.CompleteTask(frame_id, symbol_id);
+    bool last_fft_task =
+        task_counted || pilot_fft_counters_.CompleteTask(frame_id, symbol_id);
     if (last_fft_task == true) {
       PrintPerSymbolDone(PrintType::kFFTPilots, frame_id, symbol_id);
 
@@ -759,7 +870,7 @@ void Agora::HandleEventFft(size_t tag) {
     size_t symbol_idx_ul = config_->Frame().GetULSymbolIdx(symbol_id);
 
     bool last_fft_per_symbol =
-        uplink_fft_counters_.CompleteTask(frame_id, symbol_id);
+        task_counted || uplink_fft_counters_.CompleteTask(frame_id, symbol_id);
 
     if (last_fft_per_symbol == true) {
       fft_cur_frame_for_symbol_.at(symbol_idx_ul) = frame_id;
@@ -778,7 +889,8 @@ void Agora::HandleEventFft(size_t tag) {
              (sym_type == SymbolType::kCalUL)) {
     PrintPerSymbolDone(PrintType::kFFTCal, frame_id, symbol_id);
 
-    bool last_rc_task = this->rc_counters_.CompleteTask(frame_id);
+    bool last_rc_task =
+        task_counted || this->rc_counters_.CompleteTask(frame_id);
     if (last_rc_task == true) {
       PrintPerFrameDone(PrintType::kFFTCal, frame_id);
       this->rc_counters_.Reset(frame_id);
@@ -796,7 +908,7 @@ void Agora::Worker(int tid) {
       this->config_, tid, this->csi_buffers_, calib_dl_buffer_,
       calib_ul_buffer_, this->calib_dl_msum_buffer_,
       this->calib_ul_msum_buffer_, this->ul_zf_matrices_, this->dl_zf_matrices_,
-      this->phy_stats_.get(), this->stats_.get());
+      this->phy_stats_.get(), this->stats_.get(), this->zf_reuse_state_.get());
 
   auto compute_fft = std::make_unique<DoFFT>(
       this->config_, tid, this->data_buffer_, this->csi_buffers_,
@@ -852,14 +964,34 @@ void Agora::Worker(int tid) {
     events_vec.push_back(EventType::kEncode);
   }
 
+  if ((work_stealing_ != nullptr) || (edf_ != nullptr)) {
+    SchedulerLoop(tid, computers_vec, events_vec);
+    MLPD_SYMBOL("Agora worker %d exit\n", tid);
+    return;
+  }
+
   size_t cur_qid = 0;
   size_t empty_queue_itrs = 0;
   bool empty_queue = true;
+  const bool dataflow = config_->DataflowMode();
   while (this->config_->Running() == true) {
     for (size_t i = 0; i < computers_vec.size(); i++) {
-      if (computers_vec.at(i)->TryLaunch(*GetConq(events_vec.at(i), cur_qid),
-                                         complete_task_queue_[cur_qid],
-                                         worker_ptoks_ptr_[tid][cur_qid])) {
+      const EventType event_type = events_vec.at(i);
+      bool launched;
+      if (dataflow && ((event_type == EventType::kDemul) ||
+                       (event_type == EventType::kPrecode))) {
+        EventData resp_event;
+        launched = computers_vec.at(i)->TryLaunch(
+            *GetConq(event_type, cur_qid), resp_event);
+        if (launched) {
+          CompleteDataflowTask(resp_event);
+        }
+      } else {
+        launched = computers_vec.at(i)->TryLaunch(
+            *GetConq(event_type, cur_qid), complete_task_queue_[cur_qid],
+            worker_ptoks_ptr_[tid][cur_qid]);
+      }
+      if (launched) {
         empty_queue = false;
         break;
       }
@@ -869,10 +1001,13 @@ void Agora::Worker(int tid) {
     if (empty_queue == true) {
       empty_queue_itrs++;
       if (empty_queue_itrs == 5) {
-        if (this->cur_sche_frame_id_ != this->cur_proc_frame_id_) {
+        const size_t cur_sche_frame_id =
+            this->cur_sche_frame_id_.load(std::memory_order_acquire);
+        if (cur_sche_frame_id !=
+            this->cur_proc_frame_id_.load(std::memory_order_acquire)) {
           cur_qid ^= 0x1;
         } else {
-          cur_qid = (this->cur_sche_frame_id_ & 0x1);
+          cur_qid = (cur_sche_frame_id & 0x1);
         }
         empty_queue_itrs = 0;
       }
@@ -883,6 +1018,85 @@ void Agora::Worker(int tid) {
   MLPD_SYMBOL("Agora worker %d exit\n", tid);
 }
 
+void Agora::SchedulerLoop(int tid, const std::vector<Doer*>& computers_vec,
+                          const std::vector<EventType>& events_vec) {
+  std::array<Doer*, kNumEventTypes> doers{};
+  for (size_t i = 0; i < computers_vec.size(); i++) {
+    doers.at(static_cast<size_t>(events_vec.at(i))) = computers_vec.at(i);
+  }
+
+  const bool dataflow = config_->DataflowMode();
+  SchedulerStat* sched_stat = this->stats_->GetSchedulerStat(tid);
+  size_t idle_start_tsc = 0;
+  while (this->config_->Running() == true) {
+    EventData req_event;
+    size_t qid;
+    bool stolen = false;
+    bool found;
+    if (work_stealing_ != nullptr) {
+      // Frames are processed in order, so the tasks of the frame being
+      // processed have the earliest deadline
+      found = work_stealing_->Pop(
+          tid, (this->cur_proc_frame_id_.load(std::memory_order_acquire) & 0x1),
+          req_event, qid, stolen);
+    } else {
+      found = edf_->Pop(req_event, qid);
+    }
+    if (found == false) {
+      if (idle_start_tsc == 0) {
+        idle_start_tsc = GetTime::Rdtsc();
+      }
+      continue;
+    }
+    if (idle_start_tsc != 0) {
+      sched_stat->idle_tsc_ += GetTime::Rdtsc() - idle_start_tsc;
+      idle_start_tsc = 0;
+    }
+    sched_stat->task_count_++;
+    if (stolen == true) {
+      sched_stat->steal_count_++;
+    }
+
+    Doer* doer = doers.at(static_cast<size_t>(req_event.event_type_));
+    RtAssert(doer != nullptr, "Worker has no Doer for the scheduled task");
+    EventData resp_event = doer->LaunchEvent(req_event);
+    if (dataflow && ((resp_event.event_type_ == EventType::kDemul) ||
+                     (resp_event.event_type_ == EventType::kPrecode))) {
+      CompleteDataflowTask(resp_event);
+    } else {
+      TryEnqueueFallback(&complete_task_queue_[qid],
+                         worker_ptoks_ptr_[tid][qid], resp_event);
+    }
+  }
+}
+
+void Agora::CompleteDataflowTask(const EventData& event) {
+  // The master only looks at the first tag of these events
+  const size_t frame_id = gen_tag_t(event.tags_[0]).frame_id_;
+  const size_t symbol_id = gen_tag_t(event.tags_[0]).symbol_id_;
+
+  const bool is_demul = (event.event_type_ == EventType::kDemul);
+  assert(is_demul || (event.event_type_ == EventType::kPrecode));
+  const bool last_task =
+      is_demul ? demul_counters_.CompleteTask(frame_id, symbol_id)
+               : precode_counters_.CompleteTask(frame_id, symbol_id);
+  if (last_task == false) {
+    return;
+  }
+
+  // Symbol and frame completion is handled by the master. Queue it before
+  // the downstream tasks, whose completions the master must see after it.
+  TryEnqueueFallback(&symbol_complete_queue_,
+                     EventData(event.event_type_, event.tags_[0]));
+  if (is_demul) {
+    ScheduleCodeblocks(EventType::kDecode, frame_id, symbol_id,
+                       true /* from_worker */);
+  } else {
+    ScheduleAntennas(EventType::kIFFT, frame_id, symbol_id,
+                     true /* from_worker */);
+  }
+}
+
 void Agora::WorkerFft(int tid) {
   PinToCoreWithOffset(ThreadType::kWorkerFFT, base_worker_core_offset_, tid);
 
@@ -915,7 +1129,8 @@ void Agora::WorkerZf(int tid) {
   std::unique_ptr<DoZF> compute_zf(
       new DoZF(config_, tid, csi_buffers_, calib_dl_buffer_, calib_ul_buffer_,
                calib_dl_msum_buffer_, calib_ul_msum_buffer_, ul_zf_matrices_,
-               dl_zf_matrices_, this->phy_stats_.get(), this->stats_.get()));
+               dl_zf_matrices_, this->phy_stats_.get(), this->stats_.get(),
+               this->zf_reuse_state_.get()));
 
   while (this->config_->Running() == true) {
     compute_zf->TryLaunch(*GetConq(EventType::kZF, 0), complete_task_queue_[0],
@@ -977,8 +1192,105 @@ void Agora::WorkerDecode(int tid) {
   }
 }
 
+void Agora::MasterShard(size_t shard_id) {
+  // Master shards run on the cores following the workers and the MAC thread
+  const size_t base_shard_core_offset =
+      base_worker_core_offset_ + config_->WorkerThreadNum() +
+      static_cast<size_t>(kEnableMac);
+  PinToCoreWithOffset(ThreadType::kMasterShard, base_shard_core_offset,
+                      shard_id);
+
+  // With at least kScheduleQueues shards, each shard owns the completion
+  // queue of one frame parity. Otherwise every shard serves all queues.
+  const size_t num_shards = config_->MasterThreadNum() - 1;
+  const bool own_queue = (num_shards >= kScheduleQueues);
+  const size_t max_events_needed =
+      kDequeueBulkSizeWorker * config_->WorkerThreadNum();
+  std::vector<EventData> events_list(max_events_needed);
+  std::vector<EventData> done_list(max_events_needed * EventData::kMaxTags);
+  moodycamel::ProducerToken* ptok = shard_ptoks_ptr_[shard_id];
+
+  while (config_->Running() == true) {
+    for (size_t qid = 0; qid < kScheduleQueues; qid++) {
+      if (own_queue && (qid != (shard_id % kScheduleQueues))) {
+        continue;
+      }
+      const size_t num_events = complete_task_queue_[qid].try_dequeue_bulk(
+          events_list.data(), max_events_needed);
+
+      size_t num_done = 0;
+      for (size_t ev_i = 0; ev_i < num_events; ev_i++) {
+        const EventData& event = events_list.at(ev_i);
+
+        for (size_t i = 0; i < event.num_tags_; i++) {
+          const size_t frame_id = gen_tag_t(event.tags_[i]).frame_id_;
+          const size_t symbol_id = gen_tag_t(event.tags_[i]).symbol_id_;
+          bool last_task = false;
+
+          switch (event.event_type_) {
+            case EventType::kFFT: {
+              const SymbolType sym_type = config_->GetSymbolType(symbol_id);
+              if (sym_type == SymbolType::kPilot) {
+                last_task =
+                    pilot_fft_counters_.CompleteTask(frame_id, symbol_id);
+              } else if (sym_type == SymbolType::kUL) {
+                last_task =
+                    uplink_fft_counters_.CompleteTask(frame_id, symbol_id);
+              } else if ((sym_type == SymbolType::kCalDL) ||
+                         (sym_type == SymbolType::kCalUL)) {
+                last_task = rc_counters_.CompleteTask(frame_id);
+              }
+            } break;
+            case EventType::kZF:
+              last_task = zf_counters_.CompleteTask(frame_id);
+              break;
+            case EventType::kEncode:
+              last_task = encode_counters_.CompleteTask(frame_id, symbol_id);
+              break;
+            case EventType::kIFFT:
+              last_task = ifft_counters_.CompleteTask(frame_id, symbol_id);
+              break;
+            // The master only looks at the first tag of these events
+            case EventType::kDemul:
+              last_task = (i == 0) &&
+                          demul_counters_.CompleteTask(frame_id, symbol_id);
+              break;
+            case EventType::kDecode:
+              last_task = (i == 0) &&
+                          decode_counters_.CompleteTask(frame_id, symbol_id);
+              break;
+            case EventType::kPrecode:
+              last_task = (i == 0) &&
+                          precode_counters_.CompleteTask(frame_id, symbol_id);
+              break;
+            default:
+              MLPD_ERROR("Wrong event type in complete task queue!");
+              std::exit(0);
+          }
+
+          if (last_task == true) {
+            done_list.at(num_done) =
+                EventData(event.event_type_, event.tags_[i]);
+            num_done++;
+          }
+        }
+      }
+
+      if (num_done > 0) {
+        TryEnqueueBulkFallback(&symbol_complete_queue_, ptok, done_list.data(),
+                               num_done);
+      }
+    }
+  }
+  MLPD_SYMBOL("Agora master shard %zu exit\n", shard_id);
+}
+
 void Agora::CreateThreads() {
   const auto& cfg = config_;
+  for (size_t i = 0; i + 1 < cfg->MasterThreadNum(); i++) {
+    master_shards_.emplace_back(&Agora::MasterShard, this, i);
+  }
+
   if (cfg->BigstationMode() == true) {
     for (size_t i = 0; i < cfg->FftThreadNum(); i++) {
       workers_.emplace_back(&Agora::WorkerFft, this, i);
@@ -1006,7 +1318,35 @@ void Agora::CreateThreads() {
 }
 
 void Agora::UpdateRanConfig(RanConfig rc) {
-  config_->UpdateModCfgs(rc.mod_order_bits_);
+  ran_config_updates_.emplace(rc.frame_id_, rc);
+}
+
+void Agora::StartFrameMcs(size_t frame_id) {
+  for (; next_mcs_frame_ <= frame_id; next_mcs_frame_++) {
+    // The MCS of a frame is set once, before its tasks are scheduled, so the
+    // frames in flight keep the MCS they started with
+    if (next_mcs_frame_ > 0) {
+      for (size_t ue_id = 0; ue_id < config_->UeAntNum(); ue_id++) {
+        const UeMcs& prev = config_->GetUeMcs(next_mcs_frame_ - 1, ue_id);
+        config_->UpdateUeMcs(next_mcs_frame_, ue_id, prev.mod_order_bits_,
+                             prev.ldpc_num_rows_);
+      }
+    }
+    while ((ran_config_updates_.empty() == false) &&
+           (ran_config_updates_.begin()->first <= next_mcs_frame_)) {
+      const RanConfig& rc = ran_config_updates_.begin()->second;
+      if (rc.ue_id_ == RanConfig::kAllUes) {
+        for (size_t ue_id = 0; ue_id < config_->UeAntNum(); ue_id++) {
+          config_->UpdateUeMcs(next_mcs_frame_, ue_id, rc.mod_order_bits_,
+                               rc.ldpc_num_rows_);
+        }
+      } else {
+        config_->UpdateUeMcs(next_mcs_frame_, rc.ue_id_, rc.mod_order_bits_,
+                             rc.ldpc_num_rows_);
+      }
+      ran_config_updates_.erase(ran_config_updates_.begin());
+    }
+  }
 }
 
 void Agora::UpdateRxCounters(size_t frame_id, size_t symbol_id) {
@@ -1029,6 +1369,7 @@ void Agora::UpdateRxCounters(size_t frame_id, size_t symbol_id) {
   }
   // Receive first packet in a frame
   if (rx_counters_.num_pkts_[frame_slot] == 0) {
+    StartFrameMcs(frame_id);
     if (kEnableMac == false) {
       // schedule this frame's encoding
       // Defer the schedule.  If frames are already deferred or the current
@@ -1316,6 +1657,18 @@ void Agora::InitializeQueues() {
     }
   }
 
+  if (config_->GetWorkerScheduler() == WorkerScheduler::kWorkStealing) {
+    // Same priorities as the polling order of the queues scheduler
+    work_stealing_ = std::make_unique<WorkStealingScheduler>(
+        config_->WorkerThreadNum(),
+        std::vector<EventType>{EventType::kZF, EventType::kFFT,
+                               EventType::kDecode, EventType::kDemul,
+                               EventType::kIFFT, EventType::kPrecode,
+                               EventType::kEncode});
+  } else if (config_->GetWorkerScheduler() == WorkerScheduler::kEdf) {
+    edf_ = std::make_unique<EdfScheduler>();
+  }
+
   for (size_t i = 0; i < config_->SocketThreadNum(); i++) {
     rx_ptoks_ptr_[i] = new moodycamel::ProducerToken(message_queue_);
     tx_ptoks_ptr_[i] =
@@ -1328,6 +1681,15 @@ void Agora::InitializeQueues() {
           new moodycamel::ProducerToken(complete_task_queue_[j]);
     }
   }
+
+  RtAssert(config_->MasterThreadNum() <= kMaxMasterThreads,
+           "Too many master threads");
+  // Written by the master shards and by the workers in dataflow mode
+  symbol_complete_queue_ =
+      mt_queue_t(kDefaultWorkerQueueSize * data_symbol_num_perframe);
+  for (size_t i = 0; i + 1 < config_->MasterThreadNum(); i++) {
+    shard_ptoks_ptr_[i] = new moodycamel::ProducerToken(symbol_complete_queue_);
+  }
 }
 
 void Agora::FreeQueues() {
@@ -1348,20 +1710,39 @@ void Agora::FreeQueues() {
       delete worker_ptoks_ptr_[i][j];
     }
   }
+
+  for (size_t i = 0; i + 1 < config_->MasterThreadNum(); i++) {
+    delete shard_ptoks_ptr_[i];
+  }
 }
 
 void Agora::InitializeUplinkBuffers() {
   const auto& cfg = config_;
   const size_t task_buffer_symbol_num_ul = cfg->Frame().NumULSyms() * kFrameWnd;
 
-  socket_buffer_size_ = cfg->PacketLength() * cfg->BsAntNum() * kFrameWnd *
+#if defined(USE_AF_XDP)
+  // Each row is registered as the UMEM of one AF_XDP socket, which holds one
+  // packet per UMEM frame and must be page aligned
+  socket_pkt_stride_ = cfg->XdpFrameSize();
+  socket_buffer_size_ = Roundup<4096>(socket_pkt_stride_ * cfg->BsAntNum() *
+                                      kFrameWnd * cfg->Frame().NumTotalSyms());
+
+  socket_buffer_.Malloc(cfg->SocketThreadNum() /* RX */, socket_buffer_size_,
+                        Agora_memory::Alignment_t::kAlign4096);
+#else
+  socket_pkt_stride_ = cfg->PacketLength();
+  socket_buffer_size_ = socket_pkt_stride_ * cfg->BsAntNum() * kFrameWnd *
                         cfg->Frame().NumTotalSyms();
 
   socket_buffer_.Malloc(cfg->SocketThreadNum() /* RX */, socket_buffer_size_,
                         Agora_memory::Alignment_t::kAlign64);
+#endif  // defined(USE_AF_XDP)
 
+  // Two half-precision samples fit in one complex_float
   data_buffer_.Malloc(task_buffer_symbol_num_ul,
-                      cfg->OfdmDataNum() * cfg->BsAntNum(),
+                      cfg->DataBufferFp16()
+                          ? cfg->OfdmDataNum() * cfg->BsAntNum() / 2
+                          : cfg->OfdmDataNum() * cfg->BsAntNum(),
                       Agora_memory::Alignment_t::kAlign64);
 
   equal_buffer_.Malloc(task_buffer_symbol_num_ul,
@@ -1388,12 +1769,16 @@ void Agora::InitializeUplinkBuffers() {
   rc_counters_.Init(cfg->BsAntNum());
 
   zf_counters_.Init(cfg->ZfEventsPerSymbol());
+  if (cfg->ZfReuseThreshold() > 0) {
+    RtAssert(cfg->FreqOrthogonalPilot() == false,
+             "Reusing ZF matrices requires time-orthogonal pilots");
+    zf_reuse_state_ = std::make_unique<ZfReuseState>(cfg->ZfEventsPerSymbol());
+  }
 
   demul_counters_.Init(cfg->Frame().NumULSyms(), cfg->DemulEventsPerSymbol());
 
-  decode_counters_.Init(
-      cfg->Frame().NumULSyms(),
-      cfg->LdpcConfig().NumBlocksInSymbol() * cfg->UeAntNum());
+  decode_counters_.Init(cfg->Frame().NumULSyms(),
+                        cfg->DecodeEventsPerSymbol());
 
   tomac_counters_.Init(cfg->Frame().NumULSyms(), cfg->UeAntNum());
 }
@@ -1542,7 +1927,7 @@ void Agora::CheckIncrementScheduleFrame(size_t frame_id,
 
   if (this->schedule_process_flags_ ==
       static_cast<uint8_t>(ScheduleProcessingFlags::kProcessingComplete)) {
-    this->cur_sche_frame_id_++;
+    this->cur_sche_frame_id_.fetch_add(1, std::memory_order_release);
     this->schedule_process_flags_ = ScheduleProcessingFlags::kNone;
     if (this->config_->Frame().NumULSyms() == 0) {
       this->schedule_process_flags_ += ScheduleProcessingFlags::kUplinkComplete;
@@ -1584,7 +1969,7 @@ bool Agora::CheckFrameComplete(size_t frame_id) {
         this->dl_bits_buffer_status_[ue_id][frame_id % kFrameWnd] = 0;
       }
     }
-    this->cur_proc_frame_id_++;
+    this->cur_proc_frame_id_.fetch_add(1, std::memory_order_release);
 
     if (this->encode_deferral_.empty() == false) {
       for (size_t encode = 0; encode < kScheduleQueues; encode++) {
@@ -1592,7 +1977,7 @@ bool Agora::CheckFrameComplete(size_t frame_id) {
         if (deferred_frame < (this->cur_proc_frame_id_ + kScheduleQueues)) {
           if (kDebugDeferral) {
             std::printf("   +++ Scheduling deferred frame %zu : %zu \n",
-                        deferred_frame, cur_proc_frame_id_);
+                        deferred_frame, cur_proc_frame_id_.load());
           }
           RtAssert(deferred_frame >= this->cur_proc_frame_id_,
                    "Error scheduling encoding because deferral frame is less "
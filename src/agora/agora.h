@@ -9,7 +9,9 @@
 #include <unistd.h>
 
 #include <algorithm>
+#include <atomic>
 #include <iostream>
+#include <map>
 #include <memory>
 #include <queue>
 #include <system_error>
@@ -26,6 +28,7 @@
 #include "doifft.h"
 #include "doprecode.h"
 #include "dozf.h"
+#include "edf_scheduler.h"
 #include "mac_thread_basestation.h"
 #include "memory_manage.h"
 #include "phy_stats.h"
@@ -33,6 +36,7 @@
 #include "stats.h"
 #include "txrx.h"
 #include "utils.h"
+#include "work_stealing_scheduler.h"
 
 class Agora {
  public:
@@ -42,6 +46,8 @@ class Agora {
   // Max number of worker threads allowed
   static const size_t kMaxWorkerNum = 50;
   static const size_t kScheduleQueues = 2;
+  // Max number of master threads allowed
+  static const size_t kMaxMasterThreads = 8;
 
   explicit Agora(
       Config* /*cfg*/);  /// Create an Agora object and start the worker threads
@@ -87,6 +93,19 @@ class Agora {
   void WorkerDemul(int tid);
   void WorkerDecode(int tid);
   void Worker(int tid);
+  /// Task loop of worker tid with the work stealing or EDF scheduler
+  void SchedulerLoop(int tid, const std::vector<Doer*>& computers_vec,
+                     const std::vector<EventType>& events_vec);
+
+  /// Master thread other than the first one. It counts the tasks completed by
+  /// workers and forwards the completions that finish a symbol (or a frame,
+  /// for per-frame counters) to the first master thread.
+  void MasterShard(size_t shard_id);
+
+  /// Dataflow mode: count the demodulation or precoding tasks completed by a
+  /// worker. The worker that completes the last task of a symbol schedules
+  /// the symbol's decoding or IFFT and notifies the master.
+  void CompleteDataflowTask(const EventData& event);
 
   void CreateThreads();  /// Launch worker threads
 
@@ -100,7 +119,9 @@ class Agora {
   void SaveDecodeDataToFile(int frame_id);
   void SaveTxDataToFile(int frame_id);
 
-  void HandleEventFft(size_t tag);
+  /// Handle a completed FFT task. If task_counted is true, the task was
+  /// already counted by a master shard and completed its symbol.
+  void HandleEventFft(size_t tag, bool task_counted = false);
   void UpdateRxCounters(size_t frame_id, size_t symbol_id);
   void PrintPerFrameDone(PrintType print_type, size_t frame_id);
   void PrintPerSymbolDone(PrintType print_type, size_t frame_id,
@@ -108,13 +129,40 @@ class Agora {
   void PrintPerTaskDone(PrintType print_type, size_t frame_id, size_t symbol_id,
                         size_t ant_or_sc_id);
 
-  /// Update Agora's RAN config parameters
+  /// Queue a RAN config update, which sets the MCS of its UEs from its
+  /// frame on, or from the next frame to start if its frame already started
   void UpdateRanConfig(RanConfig rc);
 
+  /// Set the MCS of the frames up to frame_id that have not started yet: each
+  /// frame keeps the MCS of the previous frame, changed by the RAN config
+  /// updates that are due
+  void StartFrameMcs(size_t frame_id);
+
   void ScheduleSubcarriers(EventType event_type, size_t frame_id,
                            size_t symbol_id);
-  void ScheduleAntennas(EventType event_type, size_t frame_id,
-                        size_t symbol_id);
+  /**
+   * @brief Enqueue a task for the workers
+   * @param qid The schedule queue of the task's frame
+   * @param task_idx Index of the task among the tasks of its symbol. With the
+   * work stealing scheduler, it selects the worker owning the task, so that
+   * tasks over the same antennas, subcarriers, or code blocks go to the same
+   * worker in every symbol.
+   * @param from_worker Enqueue without the master's producer tokens, so that
+   * this can be called from worker threads
+   */
+  void ScheduleTask(EventType event_type, size_t qid, const EventData& event,
+                    size_t task_idx, bool from_worker = false);
+
+  /// Deadline of a task for the EDF scheduler, in nanoseconds on the TDD
+  /// timeline, with frames starting every frame duration: the end of the
+  /// frame's last pilot symbol for ZF, the transmission time of the symbol
+  /// for downlink tasks, and the end of the task's symbol otherwise
+  size_t TaskDeadline(const EventData& event) const;
+
+  /// If from_worker is true, the tasks are enqueued without the master's
+  /// producer tokens so that this can be called from worker threads
+  void ScheduleAntennas(EventType event_type, size_t frame_id, size_t symbol_id,
+                        bool from_worker = false);
   void ScheduleAntennasTX(size_t frame_id, size_t symbol_id);
   void ScheduleDownlinkProcessing(size_t frame_id);
 
@@ -124,9 +172,11 @@ class Agora {
    * @param frame_id The monotonically increasing frame ID
    * @param symbol_idx The index of the symbol among uplink symbols for LDPC
    * decoding, and among downlink symbols for LDPC encoding
+   * @param from_worker Enqueue without the master's producer tokens, so that
+   * this can be called from worker threads
    */
   void ScheduleCodeblocks(EventType event_type, size_t frame_id,
-                          size_t symbol_idx);
+                          size_t symbol_idx, bool from_worker = false);
 
   void ScheduleUsers(EventType event_type, size_t frame_id, size_t symbol_id);
 
@@ -168,6 +218,7 @@ class Agora {
   // Handle for the MAC thread
   std::thread mac_std_thread_;
   std::vector<std::thread> workers_;
+  std::vector<std::thread> master_shards_;
 
   std::unique_ptr<Stats> stats_;
   std::unique_ptr<PhyStats> phy_stats_;
@@ -179,6 +230,8 @@ class Agora {
   /* Uplink */
   // RX buffer size per socket RX thread
   size_t socket_buffer_size_;
+  // Distance in bytes between consecutive packets in a socket buffer row
+  size_t socket_pkt_stride_;
 
   // Received data buffers
   // 1st dimension: number of socket RX threads
@@ -202,6 +255,10 @@ class Agora {
   // [number of antennas] rows and [number of UEs] columns.
   PtrGrid<kFrameWnd, kMaxDataSCs, complex_float> ul_zf_matrices_;
 
+  // Tracks which ZF matrices can be reused by the next frame. Null if ZF
+  // matrices are not reused.
+  std::unique_ptr<ZfReuseState> zf_reuse_state_;
+
   // Data after equalization
   // 1st dimension: kFrameWnd * uplink data symbols per frame
   // 2nd dimension: number of OFDM data subcarriers * number of UEs
@@ -239,8 +296,9 @@ class Agora {
   // cur_sche_frame_id is the frame that is currently being scheduled.
   // A frame's schduling finishes before processing ends, so the two
   // variables are possible to have different values.
-  size_t cur_proc_frame_id_ = 0;
-  size_t cur_sche_frame_id_ = 0;
+  // Only the master writes them; workers read them to pick their queues.
+  std::atomic<size_t> cur_proc_frame_id_ = 0;
+  std::atomic<size_t> cur_sche_frame_id_ = 0;
 
   // The frame index for a symbol whose FFT is done
   std::vector<size_t> fft_cur_frame_for_symbol_;
@@ -305,6 +363,13 @@ class Agora {
   };
   SchedInfoT sched_info_arr_[kScheduleQueues][kNumEventTypes];
 
+  // Per-worker task deques, replacing sched_info_arr_ when the work stealing
+  // scheduler is used
+  std::unique_ptr<WorkStealingScheduler> work_stealing_;
+  // Task queue shared by all workers, replacing sched_info_arr_ when the EDF
+  // scheduler is used
+  std::unique_ptr<EdfScheduler> edf_;
+
   // Master thread's message queue for receiving packets
   moodycamel::ConcurrentQueue<EventData> message_queue_;
 
@@ -318,12 +383,22 @@ class Agora {
   moodycamel::ConcurrentQueue<EventData> complete_task_queue_[kScheduleQueues];
   moodycamel::ProducerToken* worker_ptoks_ptr_[kMaxThreads][kScheduleQueues];
 
+  // Queue for task completions that were already counted, by the master
+  // shards or by the workers in dataflow mode, and complete a symbol
+  moodycamel::ConcurrentQueue<EventData> symbol_complete_queue_;
+  moodycamel::ProducerToken* shard_ptoks_ptr_[kMaxMasterThreads];
+
   moodycamel::ProducerToken* rx_ptoks_ptr_[kMaxThreads];
   moodycamel::ProducerToken* tx_ptoks_ptr_[kMaxThreads];
 
   uint8_t schedule_process_flags_;
 
   std::queue<size_t> encode_deferral_;
+
+  // RAN config updates not applied yet, by frame, in arrival order
+  std::multimap<size_t, RanConfig> ran_config_updates_;
+  // Next frame whose MCS is not set yet
+  size_t next_mcs_frame_ = 0;
 };
 
 #endif  // AGORA_H_
@@ -0,0 +1,42 @@
+/**
+ * @file decoder_iter_policy.cc
+ * @brief Implementation file for the DecoderIterPolicy class
+ */
+#include "decoder_iter_policy.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "utils.h"
+
+DecoderIterPolicy::DecoderIterPolicy(size_t min_iter, size_t max_iter)
+    : min_iter_(min_iter), max_iter_(max_iter) {
+  RtAssert((min_iter_ > 0) && (min_iter_ <= max_iter_),
+           "DecoderIterPolicy: Invalid iteration range");
+}
+
+size_t DecoderIterPolicy::Cap(float snr_margin_db, double slack) const {
+  size_t cap = max_iter_;
+  if (snr_margin_db < kLowMarginDb) {
+    cap = min_iter_;
+  } else if (snr_margin_db >= kHighMarginDb) {
+    cap = std::max(min_iter_, (max_iter_ + 1) / 2);
+  }
+
+  if (slack <= 0) {
+    return min_iter_;
+  } else if (slack < kRelaxedSlack) {
+    const double extra_iter = (cap - min_iter_) * slack / kRelaxedSlack;
+    cap = min_iter_ + static_cast<size_t>(std::ceil(extra_iter));
+  }
+  return cap;
+}
+
+float DecoderIterPolicy::SnrMarginDb(float snr, double spectral_efficiency) {
+  if (snr <= 0) {
+    return std::numeric_limits<float>::quiet_NaN();
+  }
+  const double shannon_snr = std::pow(2.0, spectral_efficiency) - 1;
+  return static_cast<float>(10 * std::log10(snr / shannon_snr));
+}
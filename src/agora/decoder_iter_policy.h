@@ -0,0 +1,45 @@
+/**
+ * @file decoder_iter_policy.h
+ * @brief Declaration file for the DecoderIterPolicy class, which picks the
+ * LDPC decoder iteration cap of a code block from the SNR of its user and the
+ * time left before the deadline of its frame
+ */
+#ifndef DECODER_ITER_POLICY_H_
+#define DECODER_ITER_POLICY_H_
+
+#include <cstddef>
+
+class DecoderIterPolicy {
+ public:
+  /// Below this margin of the post-equalization SNR over the Shannon limit
+  /// of the user's MCS, code blocks hardly ever decode, and get min_iter
+  static constexpr float kLowMarginDb = 0.0f;
+  /// Above this margin, code blocks that decode at all converge within half
+  /// of max_iter
+  static constexpr float kHighMarginDb = 6.0f;
+  /// Fraction of the frame deadline left below which the caps are lowered
+  /// linearly, reaching min_iter at the deadline
+  static constexpr double kRelaxedSlack = 0.1;
+
+  DecoderIterPolicy(size_t min_iter, size_t max_iter);
+
+  /// Iteration cap of a code block. snr_margin_db is the SNR margin of its
+  /// user (see SnrMarginDb), NaN if unknown. slack is the time left before
+  /// the deadline of its frame as a fraction of the deadline, negative if
+  /// the frame is late.
+  size_t Cap(float snr_margin_db, double slack) const;
+
+  /// Margin in dB of the linear SNR [snr] over the Shannon limit of a
+  /// transmission of spectral_efficiency bits per symbol, NaN if the SNR is
+  /// not known (zero)
+  static float SnrMarginDb(float snr, double spectral_efficiency);
+
+  inline size_t MinIter() const { return this->min_iter_; }
+  inline size_t MaxIter() const { return this->max_iter_; }
+
+ private:
+  const size_t min_iter_;
+  const size_t max_iter_;
+};
+
+#endif  // DECODER_ITER_POLICY_H_
@@ -22,82 +22,90 @@ DoDecode::DoDecode(
       demod_buffers_(demod_buffers),
       decoded_buffers_(decoded_buffers),
       phy_stats_(in_phy_stats),
+      stats_(in_stats_manager),
       scrambler_(std::make_unique<AgoraScrambler::Scrambler>()) {
   duration_stat_ = in_stats_manager->GetDurationStat(DoerType::kDecode, in_tid);
   resp_var_nodes_ = static_cast<int16_t*>(Agora_memory::PaddedAlignedAlloc(
       Agora_memory::Alignment_t::kAlign64, kVarNodesSize));
+  if (cfg_->GetLdpcDecoderType() != LdpcDecoderType::kFlexRan) {
+    ldpc_decoder_ = std::make_unique<LdpcDecoder>(
+        cfg_->GetLdpcDecoderType() == LdpcDecoderType::kAgoraAvx512
+            ? LdpcDecoder::Isa::kAvx512
+            : LdpcDecoder::Isa::kAvx2);
+  }
+  iter_stat_ = in_stats_manager->GetDecoderIterStat(in_tid);
+  if (cfg_->AdaptiveDecoderIter()) {
+    iter_policy_ = std::make_unique<DecoderIterPolicy>(
+        cfg_->MinDecoderIter(), cfg_->LdpcConfig().MaxDecoderIter());
+  }
+  cb_ids_.reserve(cfg_->DecodeBlockSize());
+  requests_.resize(cfg_->DecodeBlockSize());
+  responses_.resize(cfg_->DecodeBlockSize());
 }
 
 DoDecode::~DoDecode() { std::free(resp_var_nodes_); }
 
-EventData DoDecode::Launch(size_t tag) {
+bool DoDecode::SetupCodeblock(size_t frame_id, size_t symbol_idx_ul,
+                              size_t cb_id,
+                              bblib_ldpc_decoder_5gnr_request& request,
+                              bblib_ldpc_decoder_5gnr_response& response) {
   const LDPCconfig& ldpc_config = cfg_->LdpcConfig();
-  const size_t frame_id = gen_tag_t(tag).frame_id_;
-  const size_t symbol_id = gen_tag_t(tag).symbol_id_;
-  const size_t symbol_idx_ul = cfg_->Frame().GetULSymbolIdx(symbol_id);
-  const size_t cb_id = gen_tag_t(tag).cb_id_;
-  const size_t symbol_offset =
-      cfg_->GetTotalDataSymbolIdxUl(frame_id, symbol_idx_ul);
   const size_t cur_cb_id = (cb_id % cfg_->LdpcConfig().NumBlocksInSymbol());
   const size_t ue_id = (cb_id / cfg_->LdpcConfig().NumBlocksInSymbol());
   const size_t frame_slot = (frame_id % kFrameWnd);
-  if (kDebugPrintInTask == true) {
-    std::printf(
-        "In doDecode thread %d: frame: %zu, symbol: %zu, code block: "
-        "%zu, ue: %zu offset %zu\n",
-        tid_, frame_id, symbol_id, cur_cb_id, ue_id, symbol_offset);
-  }
+  const UeMcs& mcs = cfg_->GetUeMcs(frame_id, ue_id);
 
-  size_t start_tsc = GetTime::WorkerRdtsc();
+  // The MCS of the user fills fewer code blocks than the symbol can hold
+  if (cur_cb_id >= mcs.num_blocks_in_symbol_) {
+    return false;
+  }
 
-  struct bblib_ldpc_decoder_5gnr_request ldpc_decoder_5gnr_request {};
-  struct bblib_ldpc_decoder_5gnr_response ldpc_decoder_5gnr_response {};
+  request = {};
+  response = {};
 
   // Decoder setup
   int16_t num_filler_bits = 0;
-  int16_t num_channel_llrs = ldpc_config.NumCbCodewLen();
+  int16_t num_channel_llrs = mcs.num_cb_codew_len_;
 
-  ldpc_decoder_5gnr_request.numChannelLlrs = num_channel_llrs;
-  ldpc_decoder_5gnr_request.numFillerBits = num_filler_bits;
-  ldpc_decoder_5gnr_request.maxIterations = ldpc_config.MaxDecoderIter();
-  ldpc_decoder_5gnr_request.enableEarlyTermination =
-      ldpc_config.EarlyTermination();
-  ldpc_decoder_5gnr_request.Zc = ldpc_config.ExpansionFactor();
-  ldpc_decoder_5gnr_request.baseGraph = ldpc_config.BaseGraph();
-  ldpc_decoder_5gnr_request.nRows = ldpc_config.NumRows();
+  request.numChannelLlrs = num_channel_llrs;
+  request.numFillerBits = num_filler_bits;
+  request.maxIterations = ldpc_config.MaxDecoderIter();
+  request.enableEarlyTermination = ldpc_config.EarlyTermination();
+  request.Zc = ldpc_config.ExpansionFactor();
+  request.baseGraph = ldpc_config.BaseGraph();
+  request.nRows = mcs.ldpc_num_rows_;
 
   int num_msg_bits = ldpc_config.NumCbLen() - num_filler_bits;
-  ldpc_decoder_5gnr_response.numMsgBits = num_msg_bits;
-  ldpc_decoder_5gnr_response.varNodes = resp_var_nodes_;
+  response.numMsgBits = num_msg_bits;
+  response.varNodes = resp_var_nodes_;
 
-  int8_t* llr_buffer_ptr =
-      demod_buffers_[frame_slot][symbol_idx_ul][ue_id] +
-      (cfg_->ModOrderBits() * (ldpc_config.NumCbCodewLen() * cur_cb_id));
-
-  uint8_t* decoded_buffer_ptr =
+  request.varNodes = demod_buffers_[frame_slot][symbol_idx_ul][ue_id] +
+                     (mcs.num_cb_codew_len_ * cur_cb_id);
+  response.compactedMessageBytes =
       (uint8_t*)decoded_buffers_[frame_slot][symbol_idx_ul][ue_id] +
       (cur_cb_id * Roundup<64>(cfg_->NumBytesPerCb()));
+  return true;
+}
 
-  ldpc_decoder_5gnr_request.varNodes = llr_buffer_ptr;
-  ldpc_decoder_5gnr_response.compactedMessageBytes = decoded_buffer_ptr;
-
-  size_t start_tsc1 = GetTime::WorkerRdtsc();
-  duration_stat_->task_duration_[1] += start_tsc1 - start_tsc;
-
-  bblib_ldpc_decoder_5gnr(&ldpc_decoder_5gnr_request,
-                          &ldpc_decoder_5gnr_response);
+void DoDecode::FinishCodeblock(
+    size_t frame_id, size_t symbol_idx_ul, size_t cb_id,
+    const bblib_ldpc_decoder_5gnr_request& request,
+    const bblib_ldpc_decoder_5gnr_response& response) {
+  const LDPCconfig& ldpc_config = cfg_->LdpcConfig();
+  const size_t symbol_offset =
+      cfg_->GetTotalDataSymbolIdxUl(frame_id, symbol_idx_ul);
+  const size_t cur_cb_id = (cb_id % cfg_->LdpcConfig().NumBlocksInSymbol());
+  const size_t ue_id = (cb_id / cfg_->LdpcConfig().NumBlocksInSymbol());
+  uint8_t* decoded_buffer_ptr = response.compactedMessageBytes;
 
   if (cfg_->ScrambleEnabled()) {
     scrambler_->Descramble(decoded_buffer_ptr, cfg_->NumBytesPerCb());
   }
 
-  size_t start_tsc2 = GetTime::WorkerRdtsc();
-  duration_stat_->task_duration_[2] += start_tsc2 - start_tsc1;
-
   if (kPrintLLRData) {
     std::printf("LLR data, symbol_offset: %zu\n", symbol_offset);
-    for (size_t i = 0; i < ldpc_config.NumCbCodewLen(); i++) {
-      std::printf("%d ", *(llr_buffer_ptr + i));
+    for (int16_t i = 0; i < request.numChannelLlrs; i++) {
+      std::printf("%d ", *(request.varNodes + i));
     }
     std::printf("\n");
   }
@@ -127,13 +135,119 @@ EventData DoDecode::Launch(size_t tag) {
     }
     phy_stats_->UpdateBlockErrors(ue_id, symbol_offset, block_error);
   }
+}
+
+void DoDecode::SetIterationCaps(size_t frame_id) {
+  const LDPCconfig& ldpc_config = cfg_->LdpcConfig();
+  // Fraction of the frame deadline left
+  const double slack = 1.0 - stats_->WorkerGetMsSinceFrameStart(frame_id) /
+                                 cfg_->FrameDeadlineMs();
+  for (size_t i = 0; i < cb_ids_.size(); i++) {
+    const size_t ue_id = cb_ids_[i] / ldpc_config.NumBlocksInSymbol();
+    const UeMcs& mcs = cfg_->GetUeMcs(frame_id, ue_id);
+    // Information bits per modulated symbol
+    const double spectral_efficiency =
+        static_cast<double>(mcs.mod_order_bits_ * ldpc_config.NumCbLen()) /
+        mcs.num_cb_codew_len_;
+    const float snr_margin_db = DecoderIterPolicy::SnrMarginDb(
+        phy_stats_->GetUePostEqSnr(frame_id, ue_id), spectral_efficiency);
+    requests_[i].maxIterations = iter_policy_->Cap(snr_margin_db, slack);
+  }
+}
+
+void DoDecode::UpdateIterStat() {
+  for (size_t i = 0; i < cb_ids_.size(); i++) {
+    const size_t cap = requests_[i].maxIterations;
+    const bool failed = (responses_[i].parityPassedAtTermination == 0);
+    iter_stat_->cap_count_.at(std::min(cap, DecoderIterStat::kMaxCap))++;
+    iter_stat_->iterations_ += responses_[i].iterationAtTermination;
+    if (cap < iter_policy_->MaxIter()) {
+      iter_stat_->reduced_count_++;
+      iter_stat_->reduced_failed_ += failed;
+    } else {
+      iter_stat_->full_count_++;
+      iter_stat_->full_failed_ += failed;
+    }
+  }
+}
+
+EventData DoDecode::Launch(size_t tag) {
+  const size_t frame_id = gen_tag_t(tag).frame_id_;
+  const size_t symbol_id = gen_tag_t(tag).symbol_id_;
+  const size_t symbol_idx_ul = cfg_->Frame().GetULSymbolIdx(symbol_id);
+  const size_t base_cb_id = gen_tag_t(tag).cb_id_;
+  const size_t num_cbs = std::min(
+      cfg_->DecodeBlockSize(),
+      cfg_->UeAntNum() * cfg_->LdpcConfig().NumBlocksInSymbol() - base_cb_id);
+  if (kDebugPrintInTask == true) {
+    std::printf(
+        "In doDecode thread %d: frame: %zu, symbol: %zu, code blocks: "
+        "%zu to %zu\n",
+        tid_, frame_id, symbol_id, base_cb_id, base_cb_id + num_cbs - 1);
+  }
+
+  size_t start_tsc = GetTime::WorkerRdtsc();
+
+  cb_ids_.clear();
+  for (size_t cb_id = base_cb_id; cb_id < base_cb_id + num_cbs; cb_id++) {
+    const size_t i = cb_ids_.size();
+    if (SetupCodeblock(frame_id, symbol_idx_ul, cb_id, requests_[i],
+                       responses_[i])) {
+      cb_ids_.push_back(cb_id);
+    }
+  }
+  if (cb_ids_.empty()) {
+    return EventData(EventType::kDecode, tag);
+  }
+  if (iter_policy_ != nullptr) {
+    SetIterationCaps(frame_id);
+  }
+
+  size_t start_tsc1 = GetTime::WorkerRdtsc();
+  duration_stat_->task_duration_[1] += start_tsc1 - start_tsc;
+
+  if (ldpc_decoder_ == nullptr) {
+    for (size_t i = 0; i < cb_ids_.size(); i++) {
+      bblib_ldpc_decoder_5gnr(&requests_[i], &responses_[i]);
+    }
+  } else if (cb_ids_.size() == 1) {
+    ldpc_decoder_->Decode(&requests_[0], &responses_[0]);
+  } else {
+    // Consecutive code blocks with the same number of rows (of users with
+    // the same code rate) and iteration cap are decoded together
+    for (size_t i = 0; i < cb_ids_.size();) {
+      size_t j = i + 1;
+      while ((j < cb_ids_.size()) && (j - i < ldpc_decoder_->BatchSize()) &&
+             (requests_[j].nRows == requests_[i].nRows) &&
+             (requests_[j].maxIterations == requests_[i].maxIterations)) {
+        j++;
+      }
+      ldpc_decoder_->DecodeBatch(&requests_[i], &responses_[i], j - i);
+      i = j;
+    }
+  }
+
+  size_t start_tsc2 = GetTime::WorkerRdtsc();
+  duration_stat_->task_duration_[2] += start_tsc2 - start_tsc1;
+
+  if (iter_policy_ != nullptr) {
+    UpdateIterStat();
+  }
+
+  for (size_t i = 0; i < cb_ids_.size(); i++) {
+    FinishCodeblock(frame_id, symbol_idx_ul, cb_ids_[i], requests_[i],
+                    responses_[i]);
+  }
 
   size_t duration = GetTime::WorkerRdtsc() - start_tsc;
   duration_stat_->task_duration_[0] += duration;
-  duration_stat_->task_count_++;
-  if (GetTime::CyclesToUs(duration, cfg_->FreqGhz()) > 500) {
-    std::printf("Thread %d Decode takes %.2f\n", tid_,
-                GetTime::CyclesToUs(duration, cfg_->FreqGhz()));
+  duration_stat_->task_count_ += cb_ids_.size();
+  // An event decodes up to decode_block_size code blocks
+  const double us_per_cb =
+      GetTime::CyclesToUs(duration, cfg_->FreqGhz()) / cb_ids_.size();
+  if (us_per_cb > 500) {
+    std::printf("Thread %d Decode takes %.2f per code block\n", tid_,
+                us_per_cb);
   }
 
   return EventData(EventType::kDecode, tag);
@@ -7,10 +7,13 @@
 #define DODECODE_H_
 
 #include <memory>
+#include <vector>
 
 #include "buffer.h"
 #include "config.h"
+#include "decoder_iter_policy.h"
 #include "doer.h"
+#include "ldpc_decoder.h"
 #include "memory_manage.h"
 #include "phy_stats.h"
 #include "scrambler.h"
@@ -24,15 +27,48 @@ class DoDecode : public Doer {
            PhyStats* in_phy_stats, Stats* in_stats_manager);
   ~DoDecode() override;
 
+  /// Decode the DecodeBlockSize() code blocks of the symbol starting at the
+  /// code block of [tag]. With Agora's decoder, code blocks with the same
+  /// number of LDPC rows are decoded in batches of LdpcDecoder::BatchSize().
+  /// With "adaptive_decoder_iter", the iteration cap of each code block comes
+  /// from the SNR of its user and the time left before the frame deadline.
   EventData Launch(size_t tag) override;
 
  private:
+  /// Fill the decoder request and response of code block cb_id of a symbol.
+  /// Returns false if the MCS of its user does not use the code block.
+  bool SetupCodeblock(size_t frame_id, size_t symbol_idx_ul, size_t cb_id,
+                      bblib_ldpc_decoder_5gnr_request& request,
+                      bblib_ldpc_decoder_5gnr_response& response);
+  /// Descramble the decoded bits of code block cb_id of a symbol and update
+  /// the PHY stats
+  void FinishCodeblock(size_t frame_id, size_t symbol_idx_ul, size_t cb_id,
+                       const bblib_ldpc_decoder_5gnr_request& request,
+                       const bblib_ldpc_decoder_5gnr_response& response);
+  /// Set the iteration caps of the code blocks of the current event
+  void SetIterationCaps(size_t frame_id);
+  /// Count the iterations and parity check results of the code blocks of the
+  /// current event in iter_stat_
+  void UpdateIterStat();
+
   int16_t* resp_var_nodes_;
   PtrCube<kFrameWnd, kMaxSymbols, kMaxUEs, int8_t>& demod_buffers_;
   PtrCube<kFrameWnd, kMaxSymbols, kMaxUEs, int8_t>& decoded_buffers_;
   PhyStats* phy_stats_;
+  Stats* stats_;
   DurationStat* duration_stat_;
   std::unique_ptr<AgoraScrambler::Scrambler> scrambler_;
+  // Agora's decoder, if the config selects it over FlexRAN's
+  std::unique_ptr<LdpcDecoder> ldpc_decoder_;
+  // Iteration caps and their stats, if "adaptive_decoder_iter" is enabled
+  std::unique_ptr<DecoderIterPolicy> iter_policy_;
+  DecoderIterStat* iter_stat_;
+
+  // Code blocks of the current event that are decoded, and their decoder
+  // requests and responses
+  std::vector<size_t> cb_ids_;
+  std::vector<bblib_ldpc_decoder_5gnr_request> requests_;
+  std::vector<bblib_ldpc_decoder_5gnr_response> responses_;
 };
 
 #endif  // DODECODE_H_
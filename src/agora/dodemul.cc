@@ -4,9 +4,144 @@
  */
 #include "dodemul.h"
 
+#include <cstring>
+
 #include "concurrent_queue_wrapper.h"
+#include "datatype_conversion.h"
 
 static constexpr bool kUseSIMDGather = true;
+// Equalize directly from data_buffer_ and the ZF matrices with the fused
+// SIMD kernel instead of the gather and per-subcarrier matrix multiply
+static constexpr bool kUseFusedDemul = true;
+
+#ifdef __AVX512F__
+using SimdCx = __m512;
+// Number of complex floats per SIMD register
+static constexpr size_t kCxPerSimd = 8;
+static inline SimdCx SimdZero() { return _mm512_setzero_ps(); }
+static inline SimdCx SimdSet1(float val) { return _mm512_set1_ps(val); }
+static inline SimdCx SimdLoadPartial(const float* ptr, size_t num_cx) {
+  return _mm512_maskz_loadu_ps(static_cast<__mmask16>((1u << (2 * num_cx)) - 1),
+                               ptr);
+}
+static inline SimdCx SimdFmadd(SimdCx a, SimdCx b, SimdCx c) {
+  return _mm512_fmadd_ps(a, b, c);
+}
+static inline SimdCx SimdFmaddsub(SimdCx a, SimdCx b, SimdCx c) {
+  return _mm512_fmaddsub_ps(a, b, c);
+}
+static inline SimdCx SimdSwapReIm(SimdCx a) {
+  return _mm512_permute_ps(a, 0xb1);
+}
+static inline SimdCx SimdLoad(const float* ptr) { return _mm512_loadu_ps(ptr); }
+static inline void SimdStore(float* ptr, SimdCx a) { _mm512_store_ps(ptr, a); }
+static inline void SimdStoreu(float* ptr, SimdCx a) {
+  _mm512_storeu_ps(ptr, a);
+}
+static inline SimdCx SimdMul(SimdCx a, SimdCx b) { return _mm512_mul_ps(a, b); }
+static inline SimdCx SimdDupRe(SimdCx a) { return _mm512_moveldup_ps(a); }
+static inline SimdCx SimdDupIm(SimdCx a) { return _mm512_movehdup_ps(a); }
+#else
+using SimdCx = __m256;
+// Number of complex floats per SIMD register
+static constexpr size_t kCxPerSimd = 4;
+static inline SimdCx SimdZero() { return _mm256_setzero_ps(); }
+static inline SimdCx SimdSet1(float val) { return _mm256_set1_ps(val); }
+static inline SimdCx SimdLoadPartial(const float* ptr, size_t num_cx) {
+  const __m256i lane = _mm256_setr_epi32(0, 0, 1, 1, 2, 2, 3, 3);
+  const __m256i mask =
+      _mm256_cmpgt_epi32(_mm256_set1_epi32(static_cast<int>(num_cx)), lane);
+  return _mm256_maskload_ps(ptr, mask);
+}
+static inline SimdCx SimdFmadd(SimdCx a, SimdCx b, SimdCx c) {
+  return _mm256_fmadd_ps(a, b, c);
+}
+static inline SimdCx SimdFmaddsub(SimdCx a, SimdCx b, SimdCx c) {
+  return _mm256_fmaddsub_ps(a, b, c);
+}
+static inline SimdCx SimdSwapReIm(SimdCx a) {
+  return _mm256_permute_ps(a, 0xb1);
+}
+static inline SimdCx SimdLoad(const float* ptr) { return _mm256_loadu_ps(ptr); }
+static inline void SimdStore(float* ptr, SimdCx a) { _mm256_store_ps(ptr, a); }
+static inline void SimdStoreu(float* ptr, SimdCx a) {
+  _mm256_storeu_ps(ptr, a);
+}
+static inline SimdCx SimdMul(SimdCx a, SimdCx b) { return _mm256_mul_ps(a, b); }
+static inline SimdCx SimdDupRe(SimdCx a) { return _mm256_moveldup_ps(a); }
+static inline SimdCx SimdDupIm(SimdCx a) { return _mm256_movehdup_ps(a); }
+#endif
+
+// Max number of SIMD registers of users equalized in one pass, which keeps
+// the two accumulators of each register in the 16 AVX2 registers
+static constexpr size_t kMaxFusedSimds = 4;
+
+/// Multiply the [num] complex floats of [data] element-wise by those of
+/// [phase]
+static inline void MultiplyPhase(complex_float* data,
+                                 const complex_float* phase, size_t num) {
+  size_t i = 0;
+  for (; i + kCxPerSimd <= num; i += kCxPerSimd) {
+    auto* data_ptr = reinterpret_cast<float*>(&data[i]);
+    const SimdCx d = SimdLoad(data_ptr);
+    const SimdCx p = SimdLoad(reinterpret_cast<const float*>(&phase[i]));
+    SimdStoreu(data_ptr, SimdFmaddsub(d, SimdDupRe(p),
+                                      SimdMul(SimdSwapReIm(d), SimdDupIm(p))));
+  }
+  for (; i < num; i++) {
+    const complex_float d = data[i];
+    data[i] = {d.re * phase[i].re - d.im * phase[i].im,
+               d.re * phase[i].im + d.im * phase[i].re};
+  }
+}
+
+/// Equalize users [ue_start, ue_start + ue_num) of one subcarrier with
+/// kNumSimds = ceil(ue_num / kCxPerSimd). [zf] is the column-major ZF matrix
+/// of the subcarrier, [data] the sample of antenna 0 with the samples of the
+/// other antennas [data_stride] complex floats apart. The equalized sample of
+/// user u is written to out[u * out_stride].
+template <size_t kNumSimds>
+static inline void EqualizeUsers(const complex_float* zf,
+                                 const complex_float* data, size_t data_stride,
+                                 size_t bs_ant_num, size_t ue_ant_num,
+                                 size_t ue_start, size_t ue_num,
+                                 complex_float* out, size_t out_stride) {
+  // For each antenna a, acc_re += W(:, a) * re(x(a)) and
+  // acc_im += W(:, a) * im(x(a)), so W * x = acc_re + swap(acc_im) * (-1, 1)
+  SimdCx acc_re[kNumSimds];
+  SimdCx acc_im[kNumSimds];
+  for (size_t v = 0; v < kNumSimds; v++) {
+    acc_re[v] = SimdZero();
+    acc_im[v] = SimdZero();
+  }
+  const size_t last_num = ue_num - (kNumSimds - 1) * kCxPerSimd;
+  for (size_t ant = 0; ant < bs_ant_num; ant++) {
+    const SimdCx x_re = SimdSet1(data[ant * data_stride].re);
+    const SimdCx x_im = SimdSet1(data[ant * data_stride].im);
+    const auto* zf_col =
+        reinterpret_cast<const float*>(&zf[ant * ue_ant_num + ue_start]);
+    for (size_t v = 0; v < kNumSimds; v++) {
+      // Only the last register may cover fewer than kCxPerSimd users
+      const SimdCx w = (v == kNumSimds - 1 && last_num < kCxPerSimd)
+                           ? SimdLoadPartial(&zf_col[v * kCxPerSimd * 2],
+                                             last_num)
+                           : SimdLoad(&zf_col[v * kCxPerSimd * 2]);
+      acc_re[v] = SimdFmadd(w, x_re, acc_re[v]);
+      acc_im[v] = SimdFmadd(w, x_im, acc_im[v]);
+    }
+  }
+
+  alignas(64) complex_float result[kCxPerSimd];
+  const SimdCx one = SimdSet1(1.0f);
+  for (size_t v = 0; v < kNumSimds; v++) {
+    SimdStore(reinterpret_cast<float*>(result),
+              SimdFmaddsub(acc_re[v], one, SimdSwapReIm(acc_im[v])));
+    const size_t num = (v == kNumSimds - 1) ? last_num : kCxPerSimd;
+    for (size_t k = 0; k < num; k++) {
+      out[(ue_start + v * kCxPerSimd + k) * out_stride] = result[k];
+    }
+  }
+}
 
 DoDemul::DoDemul(
     Config* config, int tid, Table<complex_float>& data_buffer,
@@ -28,6 +163,16 @@ DoDemul::DoDemul(
       static_cast<complex_float*>(Agora_memory::PaddedAlignedAlloc(
           Agora_memory::Alignment_t::kAlign64,
           kSCsPerCacheline * kMaxAntennas * sizeof(complex_float)));
+  data_fp32_buffer_ =
+      static_cast<complex_float*>(Agora_memory::PaddedAlignedAlloc(
+          Agora_memory::Alignment_t::kAlign64,
+          kSCsPerCacheline * kMaxAntennas * sizeof(complex_float)));
+  data_q15_buffer_ = static_cast<int16_t*>(Agora_memory::PaddedAlignedAlloc(
+      Agora_memory::Alignment_t::kAlign64,
+      kSCsPerCacheline * kMaxAntennas * 4 * sizeof(int16_t)));
+  q15_symbols_buffer_ = static_cast<int8_t*>(Agora_memory::PaddedAlignedAlloc(
+      Agora_memory::Alignment_t::kAlign64,
+      cfg_->DemulBlockSize() * kMaxUEs * 2 * sizeof(int8_t)));
   equaled_buffer_temp_ =
       static_cast<complex_float*>(Agora_memory::PaddedAlignedAlloc(
           Agora_memory::Alignment_t::kAlign64,
@@ -37,6 +182,10 @@ DoDemul::DoDemul(
           Agora_memory::Alignment_t::kAlign64,
           cfg_->DemulBlockSize() * kMaxUEs * sizeof(complex_float)));
 
+  phase_correct_.resize(cfg_->UeAntNum());
+  llr_scales_.assign(kFrameWnd * cfg_->UeAntNum(), 1.0f);
+  llr_scales_frame_.fill(SIZE_MAX);
+
   // phase offset calibration data
   auto* ue_pilot_ptr =
       reinterpret_cast<arma::cx_float*>(cfg_->UeSpecificPilot()[0]);
@@ -48,30 +197,39 @@ DoDemul::DoDemul(
   MKL_Complex8 alpha = {1, 0};
   MKL_Complex8 beta = {0, 0};
 
-  mkl_jit_status_t status = mkl_jit_create_cgemm(
-      &jitter_, MKL_COL_MAJOR, MKL_NOTRANS, MKL_NOTRANS, cfg_->UeAntNum(), 1,
-      cfg_->BsAntNum(), &alpha, cfg_->UeAntNum(), cfg_->BsAntNum(), &beta,
-      cfg_->UeAntNum());
-  if (MKL_JIT_ERROR == status) {
-    std::fprintf(
-        stderr,
-        "Error: insufficient memory to JIT and store the DGEMM kernel\n");
-    throw std::runtime_error(
-        "DoDemul: insufficient memory to JIT and store the DGEMM kernel");
+  // One kernel for each number of subcarriers sharing a precoder in a cache
+  // line
+  for (size_t i = 0; i < kSCsPerCacheline; i++) {
+    mkl_jit_status_t status = mkl_jit_create_cgemm(
+        &jitters_.at(i), MKL_COL_MAJOR, MKL_NOTRANS, MKL_NOTRANS,
+        cfg_->UeAntNum(), i + 1, cfg_->BsAntNum(), &alpha, cfg_->UeAntNum(),
+        cfg_->BsAntNum(), &beta, cfg_->UeAntNum());
+    if (MKL_JIT_ERROR == status) {
+      std::fprintf(
+          stderr,
+          "Error: insufficient memory to JIT and store the DGEMM kernel\n");
+      throw std::runtime_error(
+          "DoDemul: insufficient memory to JIT and store the DGEMM kernel");
+    }
+    mkl_jit_cgemms_.at(i) = mkl_jit_get_cgemm_ptr(jitters_.at(i));
   }
-  mkl_jit_cgemm_ = mkl_jit_get_cgemm_ptr(jitter_);
 #endif
 }
 
 DoDemul::~DoDemul() {
   std::free(data_gather_buffer_);
+  std::free(data_fp32_buffer_);
+  std::free(data_q15_buffer_);
+  std::free(q15_symbols_buffer_);
   std::free(equaled_buffer_temp_);
   std::free(equaled_buffer_temp_transposed_);
 
 #if USE_MKL_JIT
-  mkl_jit_status_t status = mkl_jit_destroy(jitter_);
-  if (MKL_JIT_ERROR == status) {
-    std::fprintf(stderr, "!!!!Error: Error while destorying MKL JIT\n");
+  for (void* jitter : jitters_) {
+    mkl_jit_status_t status = mkl_jit_destroy(jitter);
+    if (MKL_JIT_ERROR == status) {
+      std::fprintf(stderr, "!!!!Error: Error while destorying MKL JIT\n");
+    }
   }
 #endif
 }
@@ -100,8 +258,48 @@ EventData DoDemul::Launch(size_t tag) {
   size_t max_sc_ite =
       std::min(cfg_->DemulBlockSize(), cfg_->OfdmDataNum() - base_sc_id);
   assert(max_sc_ite % kSCsPerCacheline == 0);
+  // The fused and Q15 kernels do not track the phase with UE-specific
+  // pilots or export the constellation. Subcarriers sharing a precoder are
+  // equalized with matrix-matrix products instead of the fused kernel.
+  const bool fixed_point = cfg_->FixedPointDemul() && !kExportConstellation &&
+                           cfg_->Frame().ClientUlPilotSymbols() == 0;
+  const bool fused = !fixed_point && kUseFusedDemul && !kExportConstellation &&
+                     cfg_->Frame().ClientUlPilotSymbols() == 0 &&
+                     !cfg_->FreqOrthogonalPilot();
+  // Location of the equalized data of subcarrier cur_sc_id
+  auto get_equal_ptr = [&](size_t cur_sc_id) {
+    return kExportConstellation
+               ? reinterpret_cast<arma::cx_float*>(
+                     &equal_buffer_[total_data_symbol_idx_ul]
+                                   [cur_sc_id * cfg_->UeAntNum()])
+               : reinterpret_cast<arma::cx_float*>(
+                     &equaled_buffer_temp_[(cur_sc_id - base_sc_id) *
+                                           cfg_->UeAntNum()]);
+  };
+  // Phase correction of this symbol for each user
+  const complex_float* phase_correct = nullptr;
+  if (!fused && symbol_idx_ul >= cfg_->Frame().ClientUlPilotSymbols() &&
+      cfg_->Frame().ClientUlPilotSymbols() > 0) {
+    phase_correct = PhaseCorrection(frame_id, symbol_idx_ul);
+  }
   // Iterate through cache lines
   for (size_t i = 0; i < max_sc_ite; i += kSCsPerCacheline) {
+    if (fused || fixed_point) {
+      size_t start_tsc1 = GetTime::WorkerRdtsc();
+      if (cfg_->DataBufferFp16()) {
+        ConvertFp16Cacheline(data_buf, base_sc_id + i);
+      }
+      size_t start_tsc2 = GetTime::WorkerRdtsc();
+      duration_stat_->task_duration_[1] += start_tsc2 - start_tsc1;
+      if (fixed_point) {
+        EqualizeFixedPoint(data_buf, frame_slot, base_sc_id, i);
+      } else {
+        EqualizeFused(data_buf, frame_slot, base_sc_id, i);
+      }
+      duration_stat_->task_duration_[2] += GetTime::WorkerRdtsc() - start_tsc2;
+      duration_stat_->task_count_ += kSCsPerCacheline;
+      continue;
+    }
     size_t start_tsc0 = GetTime::WorkerRdtsc();
 
     // Step 1: Populate data_gather_buffer as a row-major matrix with
@@ -121,7 +319,16 @@ EventData DoDemul::Launch(size_t tag) {
 #endif
 
     size_t ant_start = 0;
-    if (kUseSIMDGather && kUsePartialTrans &&
+    if (cfg_->DataBufferFp16()) {
+      ConvertFp16Cacheline(data_buf, base_sc_id + i);
+      for (size_t j = 0; j < kSCsPerCacheline; j++) {
+        for (size_t ant_i = 0; ant_i < cfg_->BsAntNum(); ant_i++) {
+          data_gather_buffer_[j * cfg_->BsAntNum() + ant_i] =
+              data_fp32_buffer_[ant_i * kSCsPerCacheline + j];
+        }
+      }
+      ant_start = cfg_->BsAntNum();
+    } else if (kUseSIMDGather && kUsePartialTrans &&
         (cfg_->BsAntNum() % kAntNumPerSimd) == 0) {
       // Gather data for all antennas and 8 subcarriers in the same cache
       // line, 1 subcarrier and 4 (AVX2) or 8 (AVX512) ants per iteration
@@ -192,41 +399,49 @@ EventData DoDemul::Launch(size_t tag) {
     }
     duration_stat_->task_duration_[1] += GetTime::WorkerRdtsc() - start_tsc0;
 
-    // Step 2: For each subcarrier, perform equalization by multiplying the
-    // subcarrier's data from each antenna with the subcarrier's precoder
-    for (size_t j = 0; j < kSCsPerCacheline; j++) {
-      const size_t cur_sc_id = base_sc_id + i + j;
-
-      arma::cx_float* equal_ptr = nullptr;
-      if (kExportConstellation) {
-        equal_ptr =
-            (arma::cx_float*)(&equal_buffer_[total_data_symbol_idx_ul]
-                                            [cur_sc_id * cfg_->UeAntNum()]);
-      } else {
-        equal_ptr =
-            (arma::cx_float*)(&equaled_buffer_temp_[(cur_sc_id - base_sc_id) *
-                                                    cfg_->UeAntNum()]);
+    // Step 2: Perform equalization by multiplying the data of each run of
+    // subcarriers that share a precoder (e.g., with frequency-orthogonal
+    // pilots) with the precoder in a single matrix-matrix product. Runs end
+    // at the cache line, whose gathered data stays in L1: longer runs were
+    // at most 11% faster (microbench/demul_gemm_perf).
+    for (size_t j = 0; j < kSCsPerCacheline;) {
+      const size_t zf_sc_id = cfg_->GetZfScId(base_sc_id + i + j);
+      size_t num_sc = 1;
+      while ((j + num_sc < kSCsPerCacheline) &&
+             (cfg_->GetZfScId(base_sc_id + i + j + num_sc) == zf_sc_id)) {
+        num_sc++;
       }
-      arma::cx_fmat mat_equaled(equal_ptr, cfg_->UeAntNum(), 1, false);
 
+      arma::cx_float* equal_ptr = get_equal_ptr(base_sc_id + i + j);
       auto* data_ptr = reinterpret_cast<arma::cx_float*>(
           &data_gather_buffer_[j * cfg_->BsAntNum()]);
-      // size_t start_tsc2 = worker_rdtsc();
       auto* ul_zf_ptr = reinterpret_cast<arma::cx_float*>(
-          ul_zf_matrices_[frame_slot][cfg_->GetZfScId(cur_sc_id)]);
+          ul_zf_matrices_[frame_slot][zf_sc_id]);
 
       size_t start_tsc2 = GetTime::WorkerRdtsc();
 #if USE_MKL_JIT
-      mkl_jit_cgemm_(jitter_, (MKL_Complex8*)ul_zf_ptr, (MKL_Complex8*)data_ptr,
-                     (MKL_Complex8*)equal_ptr);
+      mkl_jit_cgemms_.at(num_sc - 1)(
+          jitters_.at(num_sc - 1), (MKL_Complex8*)ul_zf_ptr,
+          (MKL_Complex8*)data_ptr, (MKL_Complex8*)equal_ptr);
 #else
-      arma::cx_fmat mat_data(data_ptr, cfg_->BsAntNum(), 1, false);
-
+      arma::cx_fmat mat_equaled(equal_ptr, cfg_->UeAntNum(), num_sc, false);
+      arma::cx_fmat mat_data(data_ptr, cfg_->BsAntNum(), num_sc, false);
       arma::cx_fmat mat_ul_zf(ul_zf_ptr, cfg_->UeAntNum(), cfg_->BsAntNum(),
                               false);
       mat_equaled = mat_ul_zf * mat_data;
 #endif
+      duration_stat_->task_duration_[2] += GetTime::WorkerRdtsc() - start_tsc2;
+      j += num_sc;
+    }
+
+    // Step 3: For each subcarrier, track the phase with the UE-specific
+    // pilots and correct it in data symbols
+    for (size_t j = 0; j < kSCsPerCacheline; j++) {
+      const size_t cur_sc_id = base_sc_id + i + j;
+      arma::cx_fmat mat_equaled(get_equal_ptr(cur_sc_id), cfg_->UeAntNum(), 1,
+                                false);
 
+      size_t start_tsc2 = GetTime::WorkerRdtsc();
       if (symbol_idx_ul <
           cfg_->Frame().ClientUlPilotSymbols()) {  // Calc new phase shift
         if (symbol_idx_ul == 0 && cur_sc_id == 0) {
@@ -249,25 +464,8 @@ EventData DoDemul::Launch(size_t tag) {
       }
       // apply previously calc'ed phase shift to data
       else if (cfg_->Frame().ClientUlPilotSymbols() > 0) {
-        auto* pilot_corr_ptr = reinterpret_cast<arma::cx_float*>(
-            ue_spec_pilot_buffer_[frame_id % kFrameWnd]);
-        arma::cx_fmat pilot_corr_mat(pilot_corr_ptr, cfg_->UeAntNum(),
-                                     cfg_->Frame().ClientUlPilotSymbols(),
-                                     false);
-        arma::fmat theta_mat = arg(pilot_corr_mat);
-        arma::fmat theta_inc = arma::zeros<arma::fmat>(cfg_->UeAntNum(), 1);
-        for (size_t s = 1; s < cfg_->Frame().ClientUlPilotSymbols(); s++) {
-          arma::fmat theta_diff = theta_mat.col(s) - theta_mat.col(s - 1);
-          theta_inc += theta_diff;
-        }
-        theta_inc /= (float)std::max(
-            1, static_cast<int>(cfg_->Frame().ClientUlPilotSymbols() - 1));
-        arma::fmat cur_theta = theta_mat.col(0) + (symbol_idx_ul * theta_inc);
-        arma::cx_fmat mat_phase_correct =
-            arma::zeros<arma::cx_fmat>(size(cur_theta));
-        mat_phase_correct.set_real(cos(-cur_theta));
-        mat_phase_correct.set_imag(sin(-cur_theta));
-        mat_equaled %= mat_phase_correct;
+        MultiplyPhase(reinterpret_cast<complex_float*>(mat_equaled.memptr()),
+                      phase_correct, cfg_->UeAntNum());
 
         // Measure EVM from ground truth
         if (symbol_idx_ul == cfg_->Frame().ClientUlPilotSymbols()) {
@@ -288,40 +486,61 @@ EventData DoDemul::Launch(size_t tag) {
       _mm256_setr_epi32(0, 1, cfg_->UeAntNum() * 2, cfg_->UeAntNum() * 2 + 1,
                         cfg_->UeAntNum() * 4, cfg_->UeAntNum() * 4 + 1,
                         cfg_->UeAntNum() * 6, cfg_->UeAntNum() * 6 + 1);
-  auto* equal_t_ptr = reinterpret_cast<float*>(equaled_buffer_temp_transposed_);
+  const float* llr_scales = LlrScales(frame_id);
   for (size_t i = 0; i < cfg_->UeAntNum(); i++) {
-    float* equal_ptr = nullptr;
-    if (kExportConstellation) {
-      equal_ptr = reinterpret_cast<float*>(
-          &equal_buffer_[total_data_symbol_idx_ul]
-                        [base_sc_id * cfg_->UeAntNum() + i]);
-    } else {
-      equal_ptr = reinterpret_cast<float*>(equaled_buffer_temp_ + i);
+    const size_t mod_order_bits = cfg_->UeModOrderBits(frame_id, i);
+    int8_t* demod_ptr = demod_buffers_[frame_slot][symbol_idx_ul][i] +
+                        (mod_order_bits * base_sc_id);
+    if (fixed_point) {
+      Q15DemodSoft(q15_symbols_buffer_ + 2 * i * cfg_->DemulBlockSize(),
+                   demod_ptr, max_sc_ite, mod_order_bits, llr_scales[i]);
+      continue;
     }
-    size_t k_num_double_in_sim_d256 = sizeof(__m256) / sizeof(double);  // == 4
-    for (size_t j = 0; j < max_sc_ite / k_num_double_in_sim_d256; j++) {
-      __m256 equal_t_temp = _mm256_i32gather_ps(equal_ptr, index2, 4);
-      _mm256_store_ps(equal_t_ptr, equal_t_temp);
-      equal_t_ptr += 8;
-      equal_ptr += cfg_->UeAntNum() * k_num_double_in_sim_d256 * 2;
+    // Equalized data of user i for all subcarriers in the block
+    auto* equal_t_ptr = reinterpret_cast<float*>(
+        equaled_buffer_temp_transposed_ + i * cfg_->DemulBlockSize());
+    if (!fused) {
+      float* equal_ptr = nullptr;
+      if (kExportConstellation) {
+        equal_ptr = reinterpret_cast<float*>(
+            &equal_buffer_[total_data_symbol_idx_ul]
+                          [base_sc_id * cfg_->UeAntNum() + i]);
+      } else {
+        equal_ptr = reinterpret_cast<float*>(equaled_buffer_temp_ + i);
+      }
+      size_t k_num_double_in_sim_d256 =
+          sizeof(__m256) / sizeof(double);  // == 4
+      float* dst = equal_t_ptr;
+      for (size_t j = 0; j < max_sc_ite / k_num_double_in_sim_d256; j++) {
+        __m256 equal_t_temp = _mm256_i32gather_ps(equal_ptr, index2, 4);
+        _mm256_store_ps(dst, equal_t_temp);
+        dst += 8;
+        equal_ptr += cfg_->UeAntNum() * k_num_double_in_sim_d256 * 2;
+      }
     }
-    equal_t_ptr = (float*)(equaled_buffer_temp_transposed_);
-    int8_t* demod_ptr = demod_buffers_[frame_slot][symbol_idx_ul][i] +
-                        (cfg_->ModOrderBits() * base_sc_id);
 
-    switch (cfg_->ModOrderBits()) {
+    switch (mod_order_bits) {
       case (CommsLib::kQpsk):
-        DemodQpskSoftSse(equal_t_ptr, demod_ptr, max_sc_ite);
+        DemodQpskSoftSse(equal_t_ptr, demod_ptr, max_sc_ite, llr_scales[i]);
         break;
       case (CommsLib::kQaM16):
-        Demod16qamSoftAvx2(equal_t_ptr, demod_ptr, max_sc_ite);
+        Demod16qamSoftAvx2(equal_t_ptr, demod_ptr, max_sc_ite, llr_scales[i]);
         break;
       case (CommsLib::kQaM64):
-        Demod64qamSoftAvx2(equal_t_ptr, demod_ptr, max_sc_ite);
+        Demod64qamSoftAvx2(equal_t_ptr, demod_ptr, max_sc_ite, llr_scales[i]);
+        break;
+      case (CommsLib::kQaM256):
+#ifdef __AVX512F__
+        Demod256qamSoftAvx512(equal_t_ptr, demod_ptr, max_sc_ite,
+                              llr_scales[i]);
+#else
+        Demod256qamSoftAvx2(equal_t_ptr, demod_ptr, max_sc_ite,
+                            llr_scales[i]);
+#endif
         break;
       default:
-        std::printf("Demodulation: modulation type %s not supported!\n",
-                    cfg_->Modulation().c_str());
+        std::printf("Demodulation: modulation order bits %zu not supported!\n",
+                    mod_order_bits);
     }
     // std::printf("In doDemul thread %d: frame: %d, symbol: %d, sc_id: %d \n",
     //     tid, frame_id, symbol_idx_ul, base_sc_id);
@@ -336,3 +555,158 @@ EventData DoDemul::Launch(size_t tag) {
   duration_stat_->task_duration_[0] += GetTime::WorkerRdtsc() - start_tsc;
   return EventData(EventType::kDemul, tag);
 }
+
+void DoDemul::EqualizeFused(const complex_float* data_buf, size_t frame_slot,
+                            size_t base_sc_id, size_t sc_offset) {
+  const size_t ue_ant_num = cfg_->UeAntNum();
+  static constexpr size_t kMaxFusedUes = kMaxFusedSimds * kCxPerSimd;
+  for (size_t j = 0; j < kSCsPerCacheline; j++) {
+    const size_t cur_sc_id = base_sc_id + sc_offset + j;
+    // Sample of antenna 0 and distance between antennas in data_buf
+    const complex_float* data_ptr = nullptr;
+    size_t data_stride = 0;
+    if (cfg_->DataBufferFp16()) {
+      data_ptr = &data_fp32_buffer_[j];
+      data_stride = kSCsPerCacheline;
+    } else if (kUsePartialTrans) {
+      data_ptr = &data_buf[(cur_sc_id / kTransposeBlockSize) *
+                               (kTransposeBlockSize * cfg_->BsAntNum()) +
+                           (cur_sc_id % kTransposeBlockSize)];
+      data_stride = kTransposeBlockSize;
+    } else {
+      data_ptr = &data_buf[cur_sc_id];
+      data_stride = cfg_->OfdmDataNum();
+    }
+    const complex_float* zf_ptr =
+        ul_zf_matrices_[frame_slot][cfg_->GetZfScId(cur_sc_id)];
+    complex_float* out_ptr = equaled_buffer_temp_transposed_ + sc_offset + j;
+
+    for (size_t ue = 0; ue < ue_ant_num; ue += kMaxFusedUes) {
+      const size_t ue_num = std::min(kMaxFusedUes, ue_ant_num - ue);
+      switch ((ue_num + kCxPerSimd - 1) / kCxPerSimd) {
+        case 1:
+          EqualizeUsers<1>(zf_ptr, data_ptr, data_stride, cfg_->BsAntNum(),
+                           ue_ant_num, ue, ue_num, out_ptr,
+                           cfg_->DemulBlockSize());
+          break;
+        case 2:
+          EqualizeUsers<2>(zf_ptr, data_ptr, data_stride, cfg_->BsAntNum(),
+                           ue_ant_num, ue, ue_num, out_ptr,
+                           cfg_->DemulBlockSize());
+          break;
+        case 3:
+          EqualizeUsers<3>(zf_ptr, data_ptr, data_stride, cfg_->BsAntNum(),
+                           ue_ant_num, ue, ue_num, out_ptr,
+                           cfg_->DemulBlockSize());
+          break;
+        default:
+          EqualizeUsers<kMaxFusedSimds>(zf_ptr, data_ptr, data_stride,
+                                        cfg_->BsAntNum(), ue_ant_num, ue,
+                                        ue_num, out_ptr,
+                                        cfg_->DemulBlockSize());
+      }
+    }
+  }
+}
+
+void DoDemul::EqualizeFixedPoint(const complex_float* data_buf,
+                                 size_t frame_slot, size_t base_sc_id,
+                                 size_t sc_offset) {
+  const size_t sc_id = base_sc_id + sc_offset;
+  // Samples of the cache line with kSCsPerCacheline subcarriers for each
+  // antenna. They are contiguous in the data buffer when each partial
+  // transpose block is one cache line, and are copied out otherwise.
+  const complex_float* samples = data_fp32_buffer_;
+  if (cfg_->DataBufferFp16()) {
+    // Already converted to data_fp32_buffer_
+  } else if (kUsePartialTrans && kTransposeBlockSize == kSCsPerCacheline) {
+    samples = &data_buf[(sc_id / kTransposeBlockSize) *
+                        (kTransposeBlockSize * cfg_->BsAntNum())];
+  } else {
+    for (size_t ant_i = 0; ant_i < cfg_->BsAntNum(); ant_i++) {
+      const size_t offset =
+          kUsePartialTrans
+              ? (sc_id / kTransposeBlockSize) *
+                        (kTransposeBlockSize * cfg_->BsAntNum()) +
+                    (ant_i * kTransposeBlockSize) +
+                    (sc_id % kTransposeBlockSize)
+              : (ant_i * cfg_->OfdmDataNum()) + sc_id;
+      std::memcpy(&data_fp32_buffer_[ant_i * kSCsPerCacheline],
+                  &data_buf[offset], kSCsPerCacheline * sizeof(complex_float));
+    }
+  }
+
+  // All samples of the cache line share one block exponent
+  const size_t num_floats = kSCsPerCacheline * cfg_->BsAntNum() * 2;
+  const auto* samples_float = reinterpret_cast<const float*>(samples);
+  const int exponent = Q15BlockExponent(samples_float, num_floats,
+                                        Q15OperandBits(cfg_->BsAntNum()));
+  int16_t* data_rot = &data_q15_buffer_[num_floats];
+  FloatToQ15(samples_float, data_q15_buffer_, num_floats, exponent);
+  Q15RotateMinusJ(data_q15_buffer_, data_rot, num_floats / 2);
+
+  for (size_t j = 0; j < kSCsPerCacheline; j++) {
+    Q15Equalize(ul_zf_matrices_[frame_slot][cfg_->GetZfScId(sc_id + j)],
+                cfg_->BsAntNum(), cfg_->UeAntNum(), &data_q15_buffer_[j * 2],
+                &data_rot[j * 2], kSCsPerCacheline, exponent,
+                &q15_symbols_buffer_[(sc_offset + j) * 2],
+                cfg_->DemulBlockSize());
+  }
+}
+
+const complex_float* DoDemul::PhaseCorrection(size_t frame_id,
+                                              size_t symbol_idx_ul) {
+  // Not cached across tasks: the demul tasks of the pilot symbols may still be
+  // adding to ue_spec_pilot_buffer_ when the first data symbols are equalized
+  const size_t frame_slot = frame_id % kFrameWnd;
+  complex_float* phase_correct = phase_correct_.data();
+
+  // Phase of the UE-specific pilot symbols, which advances linearly over the
+  // symbols of the frame
+  const size_t num_pilots = cfg_->Frame().ClientUlPilotSymbols();
+  const complex_float* pilot_corr = ue_spec_pilot_buffer_[frame_slot];
+  for (size_t ue = 0; ue < cfg_->UeAntNum(); ue++) {
+    float theta_inc = 0;
+    for (size_t s = 1; s < num_pilots; s++) {
+      const complex_float cur = pilot_corr[s * cfg_->UeAntNum() + ue];
+      const complex_float prev = pilot_corr[(s - 1) * cfg_->UeAntNum() + ue];
+      theta_inc += std::atan2(cur.im, cur.re) - std::atan2(prev.im, prev.re);
+    }
+    theta_inc /= static_cast<float>(std::max(size_t(1), num_pilots - 1));
+    const float cur_theta =
+        std::atan2(pilot_corr[ue].im, pilot_corr[ue].re) +
+        static_cast<float>(symbol_idx_ul) * theta_inc;
+    phase_correct[ue] = {std::cos(-cur_theta), std::sin(-cur_theta)};
+  }
+  return phase_correct;
+}
+
+const float* DoDemul::LlrScales(size_t frame_id) {
+  const size_t frame_slot = frame_id % kFrameWnd;
+  float* llr_scales = &llr_scales_.at(frame_slot * cfg_->UeAntNum());
+  if (llr_scales_frame_.at(frame_slot) != frame_id) {
+    for (size_t i = 0; i < cfg_->UeAntNum(); i++) {
+      llr_scales[i] = phy_stats_->GetLlrScale(
+          frame_id, i, cfg_->UeModOrderBits(frame_id, i));
+    }
+    llr_scales_frame_.at(frame_slot) = frame_id;
+  }
+  return llr_scales;
+}
+
+void DoDemul::ConvertFp16Cacheline(const complex_float* data_buf,
+                                   size_t sc_id) {
+  const auto* data_fp16 = reinterpret_cast<const uint16_t*>(data_buf);
+  for (size_t ant_i = 0; ant_i < cfg_->BsAntNum(); ant_i++) {
+    const size_t offset =
+        kUsePartialTrans
+            ? (sc_id / kTransposeBlockSize) *
+                      (kTransposeBlockSize * cfg_->BsAntNum()) +
+                  (ant_i * kTransposeBlockSize) + (sc_id % kTransposeBlockSize)
+            : (ant_i * cfg_->OfdmDataNum()) + sc_id;
+    SimdConvertFloat16ToFloat32(
+        reinterpret_cast<float*>(&data_fp32_buffer_[ant_i * kSCsPerCacheline]),
+        reinterpret_cast<const float*>(&data_fp16[2 * offset]),
+        kSCsPerCacheline * 2);
+  }
+}
@@ -6,6 +6,7 @@
 #define DODEMUL_H_
 
 #include <armadillo>
+#include <array>
 #include <iostream>
 #include <vector>
 
@@ -13,6 +14,7 @@
 #include "concurrentqueue.h"
 #include "config.h"
 #include "doer.h"
+#include "fixed_point.h"
 #include "gettime.h"
 #include "modulation.h"
 #include "phy_stats.h"
@@ -58,6 +60,33 @@ class DoDemul : public Doer {
   EventData Launch(size_t tag) override;
 
  private:
+  /// Equalize the kSCsPerCacheline subcarriers starting at
+  /// (base_sc_id + sc_offset) with the fused SIMD kernel, reading the samples
+  /// from data_buf and writing the equalized data of each user to its row of
+  /// equaled_buffer_temp_transposed_
+  void EqualizeFused(const complex_float* data_buf, size_t frame_slot,
+                     size_t base_sc_id, size_t sc_offset);
+
+  /// Equalize the kSCsPerCacheline subcarriers starting at
+  /// (base_sc_id + sc_offset) with the Q15 kernels, quantizing their samples
+  /// with one block exponent, and write the int8 symbols of each user to its
+  /// row of q15_symbols_buffer_
+  void EqualizeFixedPoint(const complex_float* data_buf, size_t frame_slot,
+                          size_t base_sc_id, size_t sc_offset);
+
+  /// Convert the half-precision samples of the kSCsPerCacheline subcarriers
+  /// starting at sc_id from data_buf to data_fp32_buffer_, with the samples of
+  /// each antenna stored together
+  void ConvertFp16Cacheline(const complex_float* data_buf, size_t sc_id);
+
+  /// Return the phase correction of each user in UL symbol symbol_idx_ul of
+  /// frame_id, computed from the UE-specific pilots once per task
+  const complex_float* PhaseCorrection(size_t frame_id, size_t symbol_idx_ul);
+
+  /// Return the llr_scale of the soft demappers for each user in frame_id,
+  /// computed from the pilot SNRs the first time it is needed by this worker
+  const float* LlrScales(size_t frame_id);
+
   Table<complex_float>& data_buffer_;
   PtrGrid<kFrameWnd, kMaxDataSCs, complex_float>& ul_zf_matrices_;
   Table<complex_float>& ue_spec_pilot_buffer_;
@@ -70,15 +99,39 @@ class DoDemul : public Doer {
   /// times number of antennas
   complex_float* data_gather_buffer_;
 
-  // Intermediate buffers for equalized data
+  /// Samples of one cache line of subcarriers converted from half precision
+  /// or gathered for the Q15 kernels, with kSCsPerCacheline subcarriers for
+  /// each antenna
+  complex_float* data_fp32_buffer_;
+
+  /// Q15 samples of one cache line of subcarriers, with kSCsPerCacheline
+  /// subcarriers for each antenna, followed by the samples rotated by -j
+  int16_t* data_q15_buffer_;
+
+  /// Equalized int8 symbols of the Q15 kernels, with one row of
+  /// demul_block_size subcarriers per user
+  int8_t* q15_symbols_buffer_;
+
+  // Intermediate buffers for equalized data. The transposed buffer has one
+  // row of demul_block_size subcarriers per user.
   complex_float* equaled_buffer_temp_;
   complex_float* equaled_buffer_temp_transposed_;
   arma::cx_fmat ue_pilot_data_;
+
+  // Phase correction of each user in the symbol of the current task
+  std::vector<complex_float> phase_correct_;
+
+  // LLR scale of each user in each frame slot, and the frame it was computed
+  // for
+  std::vector<float> llr_scales_;
+  std::array<size_t, kFrameWnd> llr_scales_frame_;
   int ue_num_simd256_;
 
 #if USE_MKL_JIT
-  void* jitter_;
-  cgemm_jit_kernel_t mkl_jit_cgemm_;
+  // JIT kernels multiplying a precoder with the data of 1 to
+  // kSCsPerCacheline subcarriers, indexed by the number of subcarriers - 1
+  std::array<void*, kSCsPerCacheline> jitters_;
+  std::array<cgemm_jit_kernel_t, kSCsPerCacheline> mkl_jit_cgemms_;
 #endif
 };
 
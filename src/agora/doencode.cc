@@ -23,20 +23,26 @@ DoEncode::DoEncode(Config* in_config, int in_tid, Direction dir,
       encoded_buffer_(in_encoded_buffer),
       scrambler_(std::make_unique<AgoraScrambler::Scrambler>()) {
   duration_stat_ = in_stats_manager->GetDurationStat(DoerType::kEncode, in_tid);
+  parity_buffer_size_ = Roundup<64>(
+      LdpcEncodingParityBufSize(cfg_->LdpcConfig().BaseGraph(),
+                                cfg_->LdpcConfig().ExpansionFactor()));
   parity_buffer_ = static_cast<int8_t*>(Agora_memory::PaddedAlignedAlloc(
       Agora_memory::Alignment_t::kAlign64,
-      LdpcEncodingParityBufSize(cfg_->LdpcConfig().BaseGraph(),
-                                cfg_->LdpcConfig().ExpansionFactor())));
+      EventData::kMaxTags * parity_buffer_size_));
   assert(parity_buffer_ != nullptr);
+  encoded_buffer_temp_size_ = Roundup<64>(
+      LdpcEncodingEncodedBufSize(cfg_->LdpcConfig().BaseGraph(),
+                                 cfg_->LdpcConfig().ExpansionFactor()));
   encoded_buffer_temp_ = static_cast<int8_t*>(Agora_memory::PaddedAlignedAlloc(
       Agora_memory::Alignment_t::kAlign64,
-      LdpcEncodingEncodedBufSize(cfg_->LdpcConfig().BaseGraph(),
-                                 cfg_->LdpcConfig().ExpansionFactor())));
+      EventData::kMaxTags * encoded_buffer_temp_size_));
   assert(encoded_buffer_temp_ != nullptr);
 
+  scrambler_buffer_size_ = Roundup<64>(
+      cfg_->NumBytesPerCb() + kLdpcHelperFunctionInputBufferSizePaddingBytes);
   scrambler_buffer_ = static_cast<int8_t*>(Agora_memory::PaddedAlignedAlloc(
       Agora_memory::Alignment_t::kAlign64,
-      cfg_->NumBytesPerCb() + kLdpcHelperFunctionInputBufferSizePaddingBytes));
+      EventData::kMaxTags * scrambler_buffer_size_));
 
   assert(scrambler_buffer_ != nullptr);
 }
@@ -47,15 +53,18 @@ DoEncode::~DoEncode() {
   std::free(scrambler_buffer_);
 }
 
-EventData DoEncode::Launch(size_t tag) {
-  const LDPCconfig& ldpc_config = cfg_->LdpcConfig();
+int8_t* DoEncode::GetInput(size_t tag, size_t i) {
   size_t frame_id = gen_tag_t(tag).frame_id_;
   size_t symbol_id = gen_tag_t(tag).symbol_id_;
   size_t cb_id = gen_tag_t(tag).cb_id_;
   size_t cur_cb_id = cb_id % cfg_->LdpcConfig().NumBlocksInSymbol();
   size_t ue_id = cb_id / cfg_->LdpcConfig().NumBlocksInSymbol();
+  const UeMcs& mcs = cfg_->GetUeMcs(frame_id, ue_id);
 
-  size_t start_tsc = GetTime::WorkerRdtsc();
+  // The MCS of the user fills fewer code blocks than the symbol can hold
+  if (cur_cb_id >= mcs.num_blocks_in_symbol_) {
+    return nullptr;
+  }
 
   size_t symbol_idx;
   size_t symbol_idx_data;
@@ -105,19 +114,26 @@ EventData DoEncode::Launch(size_t tag) {
         cfg_->GetInfoBits(raw_data_buffer_, symbol_idx, ue_id, cur_cb_id);
   }
 
-  int8_t* ldpc_input = nullptr;
-
   if (this->cfg_->ScrambleEnabled()) {
-    std::memcpy(scrambler_buffer_, tx_data_ptr, cfg_->NumBytesPerCb());
-    scrambler_->Scramble(scrambler_buffer_, cfg_->NumBytesPerCb());
-    ldpc_input = scrambler_buffer_;
-  } else {
-    ldpc_input = tx_data_ptr;
+    int8_t* scrambler_buffer = ScramblerBuffer(i);
+    std::memcpy(scrambler_buffer, tx_data_ptr, cfg_->NumBytesPerCb());
+    scrambler_->Scramble(scrambler_buffer, cfg_->NumBytesPerCb());
+    return scrambler_buffer;
   }
+  return tx_data_ptr;
+}
+
+void DoEncode::StoreEncoded(size_t tag, size_t i) {
+  size_t frame_id = gen_tag_t(tag).frame_id_;
+  size_t symbol_id = gen_tag_t(tag).symbol_id_;
+  size_t cb_id = gen_tag_t(tag).cb_id_;
+  size_t cur_cb_id = cb_id % cfg_->LdpcConfig().NumBlocksInSymbol();
+  size_t ue_id = cb_id / cfg_->LdpcConfig().NumBlocksInSymbol();
+  const UeMcs& mcs = cfg_->GetUeMcs(frame_id, ue_id);
+  const size_t symbol_idx = (dir_ == Direction::kDownlink)
+                                ? cfg_->Frame().GetDLSymbolIdx(symbol_id)
+                                : cfg_->Frame().GetULSymbolIdx(symbol_id);
 
-  LdpcEncodeHelper(ldpc_config.BaseGraph(), ldpc_config.ExpansionFactor(),
-                   ldpc_config.NumRows(), encoded_buffer_temp_, parity_buffer_,
-                   ldpc_input);
   int8_t* final_output_ptr = cfg_->GetEncodedBuf(
       encoded_buffer_, dir_, frame_id, symbol_idx, ue_id, cur_cb_id);
 
@@ -125,26 +141,83 @@ EventData DoEncode::Launch(size_t tag) {
     std::printf("Encoded data - placed at location (%zu %zu %zu) %zu\n",
                 frame_id, symbol_idx, ue_id, (size_t)final_output_ptr);
   }
-  AdaptBitsForMod(reinterpret_cast<uint8_t*>(encoded_buffer_temp_),
+  AdaptBitsForMod(reinterpret_cast<uint8_t*>(EncodedBufferTemp(i)),
                   reinterpret_cast<uint8_t*>(final_output_ptr),
-                  BitsToBytes(ldpc_config.NumCbCodewLen()),
-                  cfg_->ModOrderBits());
+                  BitsToBytes(mcs.num_cb_codew_len_), mcs.mod_order_bits_);
 
   if (kPrintEncodedData == true) {
     std::printf("Encoded data\n");
-    size_t num_mod = cfg_->LdpcConfig().NumCbCodewLen() / cfg_->ModOrderBits();
-    for (size_t i = 0; i < num_mod; i++) {
-      std::printf("%u ", *(final_output_ptr + i));
+    size_t num_mod = mcs.num_cb_codew_len_ / mcs.mod_order_bits_;
+    for (size_t j = 0; j < num_mod; j++) {
+      std::printf("%u ", *(final_output_ptr + j));
     }
     std::printf("\n");
   }
+}
+
+EventData DoEncode::Launch(size_t tag) {
+  return LaunchEvent(EventData(EventType::kEncode, tag));
+}
+
+EventData DoEncode::LaunchEvent(const EventData& req_event) {
+  const LDPCconfig& ldpc_config = cfg_->LdpcConfig();
+  size_t start_tsc = GetTime::WorkerRdtsc();
+
+  // Tags of the code blocks of the event that are encoded, their inputs, and
+  // their numbers of LDPC rows
+  std::array<size_t, EventData::kMaxTags> tags;
+  std::array<int8_t*, EventData::kMaxTags> inputs;
+  std::array<size_t, EventData::kMaxTags> num_rows;
+  std::array<int8_t*, EventData::kMaxTags> encoded;
+  std::array<int8_t*, EventData::kMaxTags> parity;
+  size_t num_cbs = 0;
+  for (size_t i = 0; i < req_event.num_tags_; i++) {
+    const size_t tag = req_event.tags_[i];
+    int8_t* input = GetInput(tag, num_cbs);
+    if (input != nullptr) {
+      const size_t ue_id =
+          gen_tag_t(tag).cb_id_ / ldpc_config.NumBlocksInSymbol();
+      tags[num_cbs] = tag;
+      inputs[num_cbs] = input;
+      num_rows[num_cbs] =
+          cfg_->GetUeMcs(gen_tag_t(tag).frame_id_, ue_id).ldpc_num_rows_;
+      encoded[num_cbs] = EncodedBufferTemp(num_cbs);
+      parity[num_cbs] = ParityBuffer(num_cbs);
+      num_cbs++;
+    }
+  }
+
+  // Consecutive code blocks with the same number of rows (of users with the
+  // same code rate) are encoded together
+  for (size_t i = 0; i < num_cbs;) {
+    size_t j = i + 1;
+    while ((j < num_cbs) && (num_rows[j] == num_rows[i])) {
+      j++;
+    }
+    LdpcEncodeHelperBatch(ldpc_config.BaseGraph(),
+                          ldpc_config.ExpansionFactor(), num_rows[i], j - i,
+                          &encoded[i], &parity[i], &inputs[i]);
+    i = j;
+  }
+
+  for (size_t i = 0; i < num_cbs; i++) {
+    StoreEncoded(tags[i], i);
+  }
+
+  EventData resp_event = req_event;
+  resp_event.event_type_ = EventType::kEncode;
+  if (num_cbs == 0) {
+    return resp_event;
+  }
 
   size_t duration = GetTime::WorkerRdtsc() - start_tsc;
   duration_stat_->task_duration_[0] += duration;
-  duration_stat_->task_count_++;
-  if (GetTime::CyclesToUs(duration, cfg_->FreqGhz()) > 500) {
-    std::printf("Thread %d Encode takes %.2f\n", tid_,
-                GetTime::CyclesToUs(duration, cfg_->FreqGhz()));
+  duration_stat_->task_count_ += num_cbs;
+  const double us_per_cb =
+      GetTime::CyclesToUs(duration, cfg_->FreqGhz()) / num_cbs;
+  if (us_per_cb > 500) {
+    std::printf("Thread %d Encode takes %.2f per code block\n", tid_,
+                us_per_cb);
   }
-  return EventData(EventType::kEncode, tag);
+  return resp_event;
 }
@@ -25,7 +25,30 @@ class DoEncode : public Doer {
 
   EventData Launch(size_t tag) override;
 
+  /// Encode the code blocks of all tags of an encode event. Consecutive code
+  /// blocks with the same number of LDPC rows are encoded together by
+  /// LdpcEncodeHelperBatch.
+  EventData LaunchEvent(const EventData& req_event) override;
+
  private:
+  /// Input bits of the code block of [tag], scrambled into scrambler buffer
+  /// i if scrambling is enabled, or nullptr if the MCS of its user does not
+  /// use the code block
+  int8_t* GetInput(size_t tag, size_t i);
+  /// Adapt the code block of [tag] in intermediate encoded buffer i to the
+  /// modulation of its user, into the encoded buffer
+  void StoreEncoded(size_t tag, size_t i);
+
+  inline int8_t* ParityBuffer(size_t i) {
+    return parity_buffer_ + i * parity_buffer_size_;
+  }
+  inline int8_t* EncodedBufferTemp(size_t i) {
+    return encoded_buffer_temp_ + i * encoded_buffer_temp_size_;
+  }
+  inline int8_t* ScramblerBuffer(size_t i) {
+    return scrambler_buffer_ + i * scrambler_buffer_size_;
+  }
+
   Direction dir_;
 
   // References to buffers allocated pre-construction
@@ -33,14 +56,18 @@ class DoEncode : public Doer {
   size_t raw_buffer_rollover_;
   Table<int8_t>& encoded_buffer_;
 
+  // The intermediate buffers hold one code block for each tag of an event
   // Intermediate buffer to hold LDPC encoding parity
   int8_t* parity_buffer_;
+  size_t parity_buffer_size_;
 
   // Intermediate buffer to hold LDPC encoding output
   int8_t* encoded_buffer_temp_;
+  size_t encoded_buffer_temp_size_;
 
   // Intermediate buffer to hold pre/post scrambled data
   int8_t* scrambler_buffer_;
+  size_t scrambler_buffer_size_;
 
   DurationStat* duration_stat_;
   std::unique_ptr<AgoraScrambler::Scrambler> scrambler_;
@@ -18,26 +18,45 @@ class Doer {
       moodycamel::ConcurrentQueue<EventData>& task_queue,
       moodycamel::ConcurrentQueue<EventData>& complete_task_queue,
       moodycamel::ProducerToken* worker_ptok) {
+    // We will enqueue one response event containing results for all
+    // request tags in the request event
+    EventData resp_event;
+    if (TryLaunch(task_queue, resp_event)) {
+      TryEnqueueFallback(&complete_task_queue, worker_ptok, resp_event);
+      return true;
+    }
+    return false;
+  }
+
+  /// Launch one request event from task_queue if there is one, without
+  /// reporting its completion. On success, resp_event contains the results
+  /// for all request tags in the request event.
+  bool TryLaunch(moodycamel::ConcurrentQueue<EventData>& task_queue,
+                 EventData& resp_event) {
     EventData req_event;
     if (task_queue.try_dequeue(req_event)) {
-      // We will enqueue one response event containing results for all
-      // request tags in the request event
-      EventData resp_event;
-      resp_event.num_tags_ = req_event.num_tags_;
-
-      for (size_t i = 0; i < req_event.num_tags_; i++) {
-        EventData resp_i = Launch(req_event.tags_[i]);
-        RtAssert(resp_i.num_tags_ == 1, "Invalid num_tags in resp");
-        resp_event.tags_[i] = resp_i.tags_[0];
-        resp_event.event_type_ = resp_i.event_type_;
-      }
-
-      TryEnqueueFallback(&complete_task_queue, worker_ptok, resp_event);
+      resp_event = LaunchEvent(req_event);
       return true;
     }
     return false;
   }
 
+  /// Launch all request tags in req_event and return one response event
+  /// containing the results for all of them. Doers that process the tags of
+  /// an event together override this.
+  virtual EventData LaunchEvent(const EventData& req_event) {
+    EventData resp_event;
+    resp_event.num_tags_ = req_event.num_tags_;
+
+    for (size_t i = 0; i < req_event.num_tags_; i++) {
+      EventData resp_i = Launch(req_event.tags_[i]);
+      RtAssert(resp_i.num_tags_ == 1, "Invalid num_tags in resp");
+      resp_event.tags_[i] = resp_i.tags_[0];
+      resp_event.event_type_ = resp_i.event_type_;
+    }
+    return resp_event;
+  }
+
   /// The main event handling function that performs Doer-specific work.
   /// Doers that handle only one event type use this signature.
   virtual EventData Launch(size_t tag) {
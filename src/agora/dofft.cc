@@ -4,6 +4,8 @@
  */
 #include "dofft.h"
 
+#include <array>
+
 #include "concurrent_queue_wrapper.h"
 #include "datatype_conversion.h"
 
@@ -32,6 +34,34 @@ DoFFT::DoFFT(Config* config, size_t tid, Table<complex_float>& data_buffer,
   fft_inout_ = static_cast<complex_float*>(Agora_memory::PaddedAlignedAlloc(
       Agora_memory::Alignment_t::kAlign64,
       cfg_->OfdmCaNum() * sizeof(complex_float)));
+
+  if (cfg_->FftPruning()) {
+    pruned_fft_ = std::make_unique<PrunedFft>(
+        cfg_->OfdmCaNum(), cfg_->OfdmDataStart(), cfg_->OfdmDataStop());
+  }
+
+  // Pruned FFTs are computed one antenna at a time, and samples that the RRU
+  // already transformed take the per-antenna path, which skips the FFT
+  if (cfg_->BatchedFft() && (cfg_->FftBlockSize() > 1) &&
+      !cfg_->FftPruning() && !cfg_->FftInRru()) {
+    // Each transform of the staging buffer must stay cache line aligned
+    RtAssert(cfg_->OfdmCaNum() % kSCsPerCacheline == 0,
+             "Batched FFT requires whole cache lines of subcarriers");
+    DftiCreateDescriptor(&mkl_batch_handle_, DFTI_SINGLE, DFTI_COMPLEX, 1,
+                         cfg_->OfdmCaNum());
+    DftiSetValue(mkl_batch_handle_, DFTI_NUMBER_OF_TRANSFORMS,
+                 static_cast<MKL_LONG>(cfg_->FftBlockSize()));
+    DftiSetValue(mkl_batch_handle_, DFTI_INPUT_DISTANCE,
+                 static_cast<MKL_LONG>(cfg_->OfdmCaNum()));
+    DftiSetValue(mkl_batch_handle_, DFTI_OUTPUT_DISTANCE,
+                 static_cast<MKL_LONG>(cfg_->OfdmCaNum()));
+    DftiCommitDescriptor(mkl_batch_handle_);
+
+    fft_batch_inout_ =
+        static_cast<complex_float*>(Agora_memory::PaddedAlignedAlloc(
+            Agora_memory::Alignment_t::kAlign64,
+            cfg_->FftBlockSize() * cfg_->OfdmCaNum() * sizeof(complex_float)));
+  }
   temp_16bits_iq_ = static_cast<uint16_t*>(Agora_memory::PaddedAlignedAlloc(
       Agora_memory::Alignment_t::kAlign64, 32 * sizeof(uint16_t)));
   rx_samps_tmp_ =
@@ -43,6 +73,10 @@ DoFFT::DoFFT(Config* config, size_t tid, Table<complex_float>& data_buffer,
 DoFFT::~DoFFT() {
   DftiFreeDescriptor(&mkl_handle_);
   std::free(fft_inout_);
+  if (fft_batch_inout_ != nullptr) {
+    DftiFreeDescriptor(&mkl_batch_handle_);
+    std::free(fft_batch_inout_);
+  }
   std::free(rx_samps_tmp_);
   std::free(temp_16bits_iq_);
 }
@@ -80,26 +114,22 @@ static inline void CalibRegressionEstimate(const arma::cx_fvec& in_vec,
   out_vec *= arma::mean(in_mag);
 }
 
-EventData DoFFT::Launch(size_t tag) {
-  size_t start_tsc = GetTime::WorkerRdtsc();
-  Packet* pkt = fft_req_tag_t(tag).rx_packet_->RawPacket();
+void DoFFT::LoadInput(Packet* pkt, complex_float* fft_out) {
   size_t frame_id = pkt->frame_id_;
-  size_t frame_slot = frame_id % kFrameWnd;
   size_t symbol_id = pkt->symbol_id_;
   size_t ant_id = pkt->ant_id_;
-  size_t cell_id = pkt->cell_id_;
   SymbolType sym_type = cfg_->GetSymbolType(symbol_id);
 
   if (cfg_->FftInRru() == true) {
     SimdConvertFloat16ToFloat32(
-        reinterpret_cast<float*>(fft_inout_),
+        reinterpret_cast<float*>(fft_out),
         reinterpret_cast<float*>(&pkt->data_[2 * cfg_->OfdmRxZeroPrefixBs()]),
         cfg_->OfdmCaNum() * 2);
   } else {
     if (kUse12BitIQ) {
       SimdConvert12bitIqToFloat(
           (uint8_t*)pkt->data_ + 3 * cfg_->OfdmRxZeroPrefixBs(),
-          reinterpret_cast<float*>(fft_inout_), temp_16bits_iq_,
+          reinterpret_cast<float*>(fft_out), temp_16bits_iq_,
           cfg_->OfdmCaNum() * 3);
     } else {
       size_t sample_offset = cfg_->OfdmRxZeroPrefixBs();
@@ -109,7 +139,7 @@ EventData DoFFT::Launch(size_t tag) {
         sample_offset = cfg_->OfdmRxZeroPrefixCalUl();
       }
       SimdConvertShortToFloat(&pkt->data_[2 * sample_offset],
-                              reinterpret_cast<float*>(fft_inout_),
+                              reinterpret_cast<float*>(fft_out),
                               cfg_->OfdmCaNum() * 2);
     }
     if (kDebugPrintInTask) {
@@ -152,46 +182,37 @@ EventData DoFFT::Launch(size_t tag) {
       ss << "FFT_input_" << symbol_id << "_" << ant_id << "=[";
       for (size_t i = 0; i < cfg_->OfdmCaNum(); i++) {
         ss << std::fixed << std::setw(5) << std::setprecision(3)
-           << fft_inout_[i].re << "+1j*" << fft_inout_[i].im << " ";
+           << fft_out[i].re << "+1j*" << fft_out[i].im << " ";
       }
       ss << "];" << std::endl;
       std::cout << ss.str();
     }
   }
+}
 
-  DurationStat dummy_duration_stat;  // TODO: timing for calibration symbols
-  DurationStat* duration_stat = nullptr;
-  if (sym_type == SymbolType::kUL) {
-    duration_stat = duration_stat_fft_;
-  } else if (sym_type == SymbolType::kPilot) {
-    duration_stat = duration_stat_csi_;
-  } else {
-    duration_stat = &dummy_duration_stat;  // For calibration symbols
-  }
-
-  size_t start_tsc1 = GetTime::WorkerRdtsc();
-  duration_stat->task_duration_[1] += start_tsc1 - start_tsc;
-
-  if (!cfg_->FftInRru() == true) {
-    DftiComputeForward(
-        mkl_handle_,
-        reinterpret_cast<float*>(fft_inout_));  // Compute FFT in-place
-  }
-
-  size_t start_tsc2 = GetTime::WorkerRdtsc();
-  duration_stat->task_duration_[2] += start_tsc2 - start_tsc1;
+void DoFFT::ProcessOutput(const Packet* pkt, complex_float* fft_out,
+                          size_t num_ant) {
+  size_t frame_id = pkt->frame_id_;
+  size_t frame_slot = frame_id % kFrameWnd;
+  size_t symbol_id = pkt->symbol_id_;
+  size_t ant_id = pkt->ant_id_;
+  size_t cell_id = pkt->cell_id_;
+  SymbolType sym_type = cfg_->GetSymbolType(symbol_id);
 
   if (sym_type == SymbolType::kPilot) {
     size_t pilot_symbol_id = cfg_->Frame().GetPilotSymbolIdx(symbol_id);
     if (kCollectPhyStats) {
-      phy_stats_->UpdatePilotSnr(frame_id, pilot_symbol_id, ant_id, fft_inout_);
+      for (size_t i = 0; i < num_ant; i++) {
+        phy_stats_->UpdatePilotSnr(frame_id, pilot_symbol_id, ant_id + i,
+                                   &fft_out[i * cfg_->OfdmCaNum()]);
+      }
     }
     const size_t ue_id = pilot_symbol_id;
-    PartialTranspose(csi_buffers_[frame_slot][ue_id], ant_id,
-                     SymbolType::kPilot);
+    PartialTranspose(csi_buffers_[frame_slot][ue_id], fft_out, ant_id,
+                     SymbolType::kPilot, num_ant);
   } else if (sym_type == SymbolType::kUL) {
     PartialTranspose(cfg_->GetDataBuf(data_buffer_, frame_id, symbol_id),
-                     ant_id, SymbolType::kUL);
+                     fft_out, ant_id, SymbolType::kUL, num_ant);
   } else if (sym_type == SymbolType::kCalUL &&
              ant_id != cfg_->RefAnt(cell_id)) {
     // Only process uplink for antennas that also do downlink in this frame
@@ -203,8 +224,8 @@ EventData DoFFT::Launch(size_t tag) {
       size_t frame_grp_slot = frame_grp_id % kFrameWnd;
       PartialTranspose(
           &calib_ul_buffer_[frame_grp_slot][ant_id * cfg_->OfdmDataNum()],
-          ant_id, sym_type);
-      phy_stats_->UpdateCalibPilotSnr(frame_grp_id, 1, ant_id, fft_inout_);
+          fft_out, ant_id, sym_type);
+      phy_stats_->UpdateCalibPilotSnr(frame_grp_id, 1, ant_id, fft_out);
     }
   } else if (sym_type == SymbolType::kCalDL &&
              ant_id == cfg_->RefAnt(cell_id)) {
@@ -217,8 +238,8 @@ EventData DoFFT::Launch(size_t tag) {
                        cal_dl_symbol_id;
       complex_float* calib_dl_ptr =
           &calib_dl_buffer_[frame_grp_slot][cur_ant * cfg_->OfdmDataNum()];
-      PartialTranspose(calib_dl_ptr, ant_id, sym_type);
-      phy_stats_->UpdateCalibPilotSnr(frame_grp_id, 0, cur_ant, fft_inout_);
+      PartialTranspose(calib_dl_ptr, fft_out, ant_id, sym_type);
+      phy_stats_->UpdateCalibPilotSnr(frame_grp_id, 0, cur_ant, fft_out);
     }
   } else {
     std::string error_message =
@@ -229,6 +250,44 @@ EventData DoFFT::Launch(size_t tag) {
         std::to_string(ant_id) + "\n";
     RtAssert(false, error_message);
   }
+}
+
+DurationStat* DoFFT::GetDurationStat(SymbolType sym_type) {
+  if (sym_type == SymbolType::kUL) {
+    return duration_stat_fft_;
+  } else if (sym_type == SymbolType::kPilot) {
+    return duration_stat_csi_;
+  }
+  return &duration_stat_calib_;  // For calibration symbols
+}
+
+EventData DoFFT::Launch(size_t tag) {
+  size_t start_tsc = GetTime::WorkerRdtsc();
+  Packet* pkt = fft_req_tag_t(tag).rx_packet_->RawPacket();
+  const SymbolType sym_type = cfg_->GetSymbolType(pkt->symbol_id_);
+  DurationStat* duration_stat = GetDurationStat(sym_type);
+
+  LoadInput(pkt, fft_inout_);
+
+  size_t start_tsc1 = GetTime::WorkerRdtsc();
+  duration_stat->task_duration_[1] += start_tsc1 - start_tsc;
+
+  if (!cfg_->FftInRru() == true) {
+    if ((pruned_fft_ != nullptr) && (sym_type == SymbolType::kUL)) {
+      // Pilot and calibration symbols keep the full FFT, whose guard bands
+      // are used to estimate their SNR
+      pruned_fft_->Forward(fft_inout_, fft_inout_);
+    } else {
+      DftiComputeForward(
+          mkl_handle_,
+          reinterpret_cast<float*>(fft_inout_));  // Compute FFT in-place
+    }
+  }
+
+  size_t start_tsc2 = GetTime::WorkerRdtsc();
+  duration_stat->task_duration_[2] += start_tsc2 - start_tsc1;
+
+  ProcessOutput(pkt, fft_inout_);
 
   duration_stat->task_duration_[3] += GetTime::WorkerRdtsc() - start_tsc2;
 
@@ -239,75 +298,158 @@ EventData DoFFT::Launch(size_t tag) {
                    gen_tag_t::FrmSym(pkt->frame_id_, pkt->symbol_id_).tag_);
 }
 
-void DoFFT::PartialTranspose(complex_float* out_buf, size_t ant_id,
-                             SymbolType symbol_type) const {
+EventData DoFFT::LaunchEvent(const EventData& req_event) {
+  const size_t num_ffts = req_event.num_tags_;
+  // The remainder event of a symbol has fewer antennas than the descriptor
+  if ((fft_batch_inout_ == nullptr) || (num_ffts != cfg_->FftBlockSize())) {
+    return Doer::LaunchEvent(req_event);
+  }
+
+  size_t start_tsc = GetTime::WorkerRdtsc();
+  std::array<Packet*, EventData::kMaxTags> pkts;
+  for (size_t i = 0; i < num_ffts; i++) {
+    pkts[i] = fft_req_tag_t(req_event.tags_[i]).rx_packet_->RawPacket();
+    LoadInput(pkts[i], &fft_batch_inout_[i * cfg_->OfdmCaNum()]);
+  }
+
+  size_t start_tsc1 = GetTime::WorkerRdtsc();
+  // One multi-transform call computes the FFTs of all antennas in-place
+  DftiComputeForward(mkl_batch_handle_,
+                     reinterpret_cast<float*>(fft_batch_inout_));
+  size_t start_tsc2 = GetTime::WorkerRdtsc();
+
+  // Packets of consecutive antennas of one pilot or uplink symbol, as
+  // scheduled when they arrive in order, are transposed together
+  const SymbolType sym_type = cfg_->GetSymbolType(pkts[0]->symbol_id_);
+  bool same_symbol =
+      (sym_type == SymbolType::kPilot) || (sym_type == SymbolType::kUL);
+  for (size_t i = 1; i < num_ffts && same_symbol; i++) {
+    same_symbol = (pkts[i]->frame_id_ == pkts[0]->frame_id_) &&
+                  (pkts[i]->symbol_id_ == pkts[0]->symbol_id_) &&
+                  (pkts[i]->ant_id_ == pkts[0]->ant_id_ + i);
+  }
+  if (same_symbol) {
+    ProcessOutput(pkts[0], fft_batch_inout_, num_ffts);
+  } else {
+    for (size_t i = 0; i < num_ffts; i++) {
+      ProcessOutput(pkts[i], &fft_batch_inout_[i * cfg_->OfdmCaNum()]);
+    }
+  }
+  size_t end_tsc = GetTime::WorkerRdtsc();
+
+  // The time of the batch is split evenly among its antennas
+  EventData resp_event;
+  resp_event.num_tags_ = num_ffts;
+  resp_event.event_type_ = EventType::kFFT;
+  for (size_t i = 0; i < num_ffts; i++) {
+    DurationStat* duration_stat =
+        GetDurationStat(cfg_->GetSymbolType(pkts[i]->symbol_id_));
+    duration_stat->task_duration_[1] += (start_tsc1 - start_tsc) / num_ffts;
+    duration_stat->task_duration_[2] += (start_tsc2 - start_tsc1) / num_ffts;
+    duration_stat->task_duration_[3] += (end_tsc - start_tsc2) / num_ffts;
+    duration_stat->task_duration_[0] += (end_tsc - start_tsc) / num_ffts;
+    duration_stat->task_count_++;
+    resp_event.tags_[i] =
+        gen_tag_t::FrmSym(pkts[i]->frame_id_, pkts[i]->symbol_id_).tag_;
+    fft_req_tag_t(req_event.tags_[i]).rx_packet_->Free();
+  }
+  return resp_event;
+}
+
+void DoFFT::PartialTranspose(complex_float* out_buf,
+                             const complex_float* fft_out, size_t ant_id,
+                             SymbolType symbol_type, size_t num_ant) const {
   // We have OfdmDataNum() % kTransposeBlockSize == 0
   const size_t num_blocks = cfg_->OfdmDataNum() / kTransposeBlockSize;
+  // Uplink data may be stored in half precision, with the same layout
+  const bool store_fp16 =
+      (symbol_type == SymbolType::kUL) && cfg_->DataBufferFp16();
 
   for (size_t block_idx = 0; block_idx < num_blocks; block_idx++) {
     const size_t block_base_offset =
         block_idx * (kTransposeBlockSize * cfg_->BsAntNum());
-    // We have kTransposeBlockSize % kSCsPerCacheline == 0
-    for (size_t sc_j = 0; sc_j < kTransposeBlockSize;
-         sc_j += kSCsPerCacheline) {
-      const size_t sc_idx = (block_idx * kTransposeBlockSize) + sc_j;
-      const complex_float* src = &fft_inout_[sc_idx + cfg_->OfdmDataStart()];
-
-      complex_float* dst = nullptr;
-      if ((symbol_type == SymbolType::kCalDL) ||
-          (symbol_type == SymbolType::kCalUL)) {
-        dst = &out_buf[sc_idx];
-      } else {
-        dst = kUsePartialTrans
-                  ? &out_buf[block_base_offset +
-                             (ant_id * kTransposeBlockSize) + sc_j]
-                  : &out_buf[(cfg_->OfdmDataNum() * ant_id) + sc_j +
-                             block_idx * kTransposeBlockSize];
-      }
+    // The antennas of a batch are adjacent in each block of the output
+    for (size_t i = 0; i < num_ant; i++) {
+      const size_t cur_ant = ant_id + i;
+      const complex_float* ant_fft_out = &fft_out[i * cfg_->OfdmCaNum()];
+      // We have kTransposeBlockSize % kSCsPerCacheline == 0
+      for (size_t sc_j = 0; sc_j < kTransposeBlockSize;
+           sc_j += kSCsPerCacheline) {
+        const size_t sc_idx = (block_idx * kTransposeBlockSize) + sc_j;
+        const complex_float* src =
+            &ant_fft_out[sc_idx + cfg_->OfdmDataStart()];
+        const complex_float* pilots_sgn = &cfg_->PilotsSgn()[sc_idx];
+
+        size_t dst_offset = 0;
+        if ((symbol_type == SymbolType::kCalDL) ||
+            (symbol_type == SymbolType::kCalUL)) {
+          dst_offset = sc_idx;
+        } else {
+          dst_offset = kUsePartialTrans
+                           ? block_base_offset +
+                                 (cur_ant * kTransposeBlockSize) + sc_j
+                           : (cfg_->OfdmDataNum() * cur_ant) + sc_j +
+                                 block_idx * kTransposeBlockSize;
+        }
+        complex_float* dst = &out_buf[dst_offset];
+        uint16_t* dst_fp16 =
+            reinterpret_cast<uint16_t*>(out_buf) + (2 * dst_offset);
 
-      // With either of AVX-512 or AVX2, load one cacheline =
-      // 16 float values = 8 subcarriers = kSCsPerCacheline
+        // With either of AVX-512 or AVX2, load one cacheline =
+        // 16 float values = 8 subcarriers = kSCsPerCacheline
 
 #ifdef __AVX512F__
-      // AVX-512.
-      __m512 fft_result = _mm512_load_ps(reinterpret_cast<const float*>(src));
-      if (symbol_type == SymbolType::kPilot) {
-        __m512 pilot_tx = _mm512_set_ps(
-            cfg_->PilotsSgn()[sc_idx + 7].im, cfg_->PilotsSgn()[sc_idx + 7].re,
-            cfg_->PilotsSgn()[sc_idx + 6].im, cfg_->PilotsSgn()[sc_idx + 6].re,
-            cfg_->PilotsSgn()[sc_idx + 5].im, cfg_->PilotsSgn()[sc_idx + 5].re,
-            cfg_->PilotsSgn()[sc_idx + 4].im, cfg_->PilotsSgn()[sc_idx + 4].re,
-            cfg_->PilotsSgn()[sc_idx + 3].im, cfg_->PilotsSgn()[sc_idx + 3].re,
-            cfg_->PilotsSgn()[sc_idx + 2].im, cfg_->PilotsSgn()[sc_idx + 2].re,
-            cfg_->PilotsSgn()[sc_idx + 1].im, cfg_->PilotsSgn()[sc_idx + 1].re,
-            cfg_->PilotsSgn()[sc_idx].im, cfg_->PilotsSgn()[sc_idx].re);
-        fft_result = CommsLib::M512ComplexCf32Mult(fft_result, pilot_tx, true);
-      }
-      _mm512_stream_ps(reinterpret_cast<float*>(dst), fft_result);
+        // AVX-512.
+        __m512 fft_result =
+            _mm512_load_ps(reinterpret_cast<const float*>(src));
+        if (symbol_type == SymbolType::kPilot) {
+          __m512 pilot_tx = _mm512_set_ps(
+              pilots_sgn[7].im, pilots_sgn[7].re, pilots_sgn[6].im,
+              pilots_sgn[6].re, pilots_sgn[5].im, pilots_sgn[5].re,
+              pilots_sgn[4].im, pilots_sgn[4].re, pilots_sgn[3].im,
+              pilots_sgn[3].re, pilots_sgn[2].im, pilots_sgn[2].re,
+              pilots_sgn[1].im, pilots_sgn[1].re, pilots_sgn[0].im,
+              pilots_sgn[0].re);
+          fft_result =
+              CommsLib::M512ComplexCf32Mult(fft_result, pilot_tx, true);
+        }
+        if (store_fp16) {
+          _mm256_stream_si256(reinterpret_cast<__m256i*>(dst_fp16),
+                              _mm512_cvtps_ph(fft_result, _MM_FROUND_NO_EXC));
+        } else {
+          _mm512_stream_ps(reinterpret_cast<float*>(dst), fft_result);
+        }
 #else
-      __m256 fft_result0 = _mm256_load_ps(reinterpret_cast<const float*>(src));
-      __m256 fft_result1 =
-          _mm256_load_ps(reinterpret_cast<const float*>(src + 4));
-      if (symbol_type == SymbolType::kPilot) {
-        __m256 pilot_tx0 = _mm256_set_ps(
-            cfg_->PilotsSgn()[sc_idx + 3].im, cfg_->PilotsSgn()[sc_idx + 3].re,
-            cfg_->PilotsSgn()[sc_idx + 2].im, cfg_->PilotsSgn()[sc_idx + 2].re,
-            cfg_->PilotsSgn()[sc_idx + 1].im, cfg_->PilotsSgn()[sc_idx + 1].re,
-            cfg_->PilotsSgn()[sc_idx].im, cfg_->PilotsSgn()[sc_idx].re);
-        fft_result0 =
-            CommsLib::M256ComplexCf32Mult(fft_result0, pilot_tx0, true);
-
-        __m256 pilot_tx1 = _mm256_set_ps(
-            cfg_->PilotsSgn()[sc_idx + 7].im, cfg_->PilotsSgn()[sc_idx + 7].re,
-            cfg_->PilotsSgn()[sc_idx + 6].im, cfg_->PilotsSgn()[sc_idx + 6].re,
-            cfg_->PilotsSgn()[sc_idx + 5].im, cfg_->PilotsSgn()[sc_idx + 5].re,
-            cfg_->PilotsSgn()[sc_idx + 4].im, cfg_->PilotsSgn()[sc_idx + 4].re);
-        fft_result1 =
-            CommsLib::M256ComplexCf32Mult(fft_result1, pilot_tx1, true);
-      }
-      _mm256_stream_ps(reinterpret_cast<float*>(dst), fft_result0);
-      _mm256_stream_ps(reinterpret_cast<float*>(dst + 4), fft_result1);
+        __m256 fft_result0 =
+            _mm256_load_ps(reinterpret_cast<const float*>(src));
+        __m256 fft_result1 =
+            _mm256_load_ps(reinterpret_cast<const float*>(src + 4));
+        if (symbol_type == SymbolType::kPilot) {
+          __m256 pilot_tx0 = _mm256_set_ps(
+              pilots_sgn[3].im, pilots_sgn[3].re, pilots_sgn[2].im,
+              pilots_sgn[2].re, pilots_sgn[1].im, pilots_sgn[1].re,
+              pilots_sgn[0].im, pilots_sgn[0].re);
+          fft_result0 =
+              CommsLib::M256ComplexCf32Mult(fft_result0, pilot_tx0, true);
+
+          __m256 pilot_tx1 = _mm256_set_ps(
+              pilots_sgn[7].im, pilots_sgn[7].re, pilots_sgn[6].im,
+              pilots_sgn[6].re, pilots_sgn[5].im, pilots_sgn[5].re,
+              pilots_sgn[4].im, pilots_sgn[4].re);
+          fft_result1 =
+              CommsLib::M256ComplexCf32Mult(fft_result1, pilot_tx1, true);
+        }
+        if (store_fp16) {
+          _mm_stream_si128(reinterpret_cast<__m128i*>(dst_fp16),
+                           _mm256_cvtps_ph(fft_result0, _MM_FROUND_NO_EXC));
+          _mm_stream_si128(reinterpret_cast<__m128i*>(dst_fp16 + 8),
+                           _mm256_cvtps_ph(fft_result1, _MM_FROUND_NO_EXC));
+        } else {
+          _mm256_stream_ps(reinterpret_cast<float*>(dst), fft_result0);
+          _mm256_stream_ps(reinterpret_cast<float*>(dst + 4), fft_result1);
+        }
 #endif
+      }
     }
   }
 }
@@ -7,6 +7,7 @@
 
 #include <armadillo>
 #include <iostream>
+#include <memory>
 #include <vector>
 
 #include "buffer.h"
@@ -16,6 +17,7 @@
 #include "gettime.h"
 #include "mkl_dfti.h"
 #include "phy_stats.h"
+#include "pruned_fft.h"
 #include "stats.h"
 #include "symbols.h"
 
@@ -63,8 +65,18 @@ class DoFFT : public Doer {
   EventData Launch(size_t tag) override;
 
   /**
-   * Fill-in the partial transpose of the computed FFT for this antenna into
-   * out_buf.
+   * Do the FFT tasks of all antennas in an FFT event. With "batched_fft",
+   * the packets of an event of FftBlockSize() antennas are converted into
+   * one staging buffer and transformed with a single multi-transform MKL
+   * call, and the outputs of consecutive antennas of one symbol are
+   * partially transposed together. Other events are launched tag by tag.
+   */
+  EventData LaunchEvent(const EventData& req_event) override;
+
+  /**
+   * Fill-in the partial transpose of the computed FFT fft_out for this
+   * antenna into out_buf. With num_ant > 1, fft_out holds the FFTs of
+   * num_ant consecutive antennas starting at ant_id, OfdmCaNum() apart.
    *
    * The fully-transposed matrix after FFT is a subcarriers x antennas matrix
    * that should look like so (using the notation subcarrier/antenna, and
@@ -92,10 +104,22 @@ class DoFFT : public Doer {
    * of the fully-transposed matrix, but laid out in memory in column-major
    * order.
    */
-  void PartialTranspose(complex_float* out_buf, size_t ant_id,
-                        SymbolType symbol_type) const;
+  void PartialTranspose(complex_float* out_buf, const complex_float* fft_out,
+                        size_t ant_id, SymbolType symbol_type,
+                        size_t num_ant = 1) const;
 
  private:
+  /// Convert the time-domain samples of pkt to floats in fft_out
+  void LoadInput(Packet* pkt, complex_float* fft_out);
+
+  /// Write the FFT outputs of num_ant consecutive antennas of the symbol of
+  /// pkt, starting at its antenna, to the CSI, data, or calibration buffers.
+  /// Calibration symbols are processed one antenna at a time.
+  void ProcessOutput(const Packet* pkt, complex_float* fft_out,
+                     size_t num_ant = 1);
+
+  DurationStat* GetDurationStat(SymbolType sym_type);
+
   Table<complex_float>& data_buffer_;
   PtrGrid<kFrameWnd, kMaxUEs, complex_float>& csi_buffers_;
   Table<complex_float>& calib_dl_buffer_;
@@ -103,12 +127,22 @@ class DoFFT : public Doer {
   DFTI_DESCRIPTOR_HANDLE mkl_handle_;
   complex_float* fft_inout_;  // Buffer for both FFT input and output
 
+  // Multi-transform descriptor and staging buffer of FftBlockSize()
+  // antennas, used with "batched_fft"
+  DFTI_DESCRIPTOR_HANDLE mkl_batch_handle_{nullptr};
+  complex_float* fft_batch_inout_{nullptr};
+
+  // Output-pruned FFT of the data subcarriers, used for uplink data symbols
+  // with "fft_pruning"
+  std::unique_ptr<PrunedFft> pruned_fft_;
+
   // Buffer for store 16-bit IQ converted from 12-bit IQ
   uint16_t* temp_16bits_iq_;
   std::complex<float>* rx_samps_tmp_;  // Temp buffer for received samples
 
   DurationStat* duration_stat_fft_;
   DurationStat* duration_stat_csi_;
+  DurationStat duration_stat_calib_;  // TODO: timing for calibration symbols
   PhyStats* phy_stats_;
 };
 
@@ -25,6 +25,10 @@ DoIFFT::DoIFFT(Config* in_config, int in_tid,
     DftiSetValue(mkl_handle_, DFTI_PLACEMENT, DFTI_NOT_INPLACE);
   }
   DftiCommitDescriptor(mkl_handle_);
+  if (cfg_->FftPruning()) {
+    pruned_ifft_ = std::make_unique<PrunedFft>(
+        cfg_->OfdmCaNum(), cfg_->OfdmDataStart(), cfg_->OfdmDataStop());
+  }
 
   // Aligned for SIMD
   ifft_out_ = static_cast<float*>(
@@ -60,10 +64,17 @@ EventData DoIFFT::Launch(size_t tag) {
   duration_stat_->task_duration_[1] += start_tsc1 - start_tsc;
 
   auto* ifft_in_ptr = reinterpret_cast<float*>(dl_ifft_buffer_[offset]);
-  auto* ifft_out_ptr =
-      (kUseOutOfPlaceIFFT || kMemcpyBeforeIFFT) ? ifft_out_ : ifft_in_ptr;
-
-  if (kMemcpyBeforeIFFT) {
+  auto* ifft_out_ptr = (kUseOutOfPlaceIFFT || kMemcpyBeforeIFFT ||
+                        (pruned_ifft_ != nullptr))
+                           ? ifft_out_
+                           : ifft_in_ptr;
+
+  if (pruned_ifft_ != nullptr) {
+    // Only the data subcarriers are read, so the guard bands of the input
+    // need neither zeroing nor copying
+    pruned_ifft_->Backward(reinterpret_cast<complex_float*>(ifft_in_ptr),
+                           reinterpret_cast<complex_float*>(ifft_out_ptr));
+  } else if (kMemcpyBeforeIFFT) {
     std::memset(ifft_out_ptr, 0, sizeof(float) * cfg_->OfdmDataStart() * 2);
     std::memset(ifft_out_ptr + (cfg_->OfdmDataStop() * 2), 0,
                 sizeof(float) * cfg_->OfdmDataStart() * 2);
@@ -7,6 +7,7 @@
 
 #include <armadillo>
 #include <iostream>
+#include <memory>
 #include <vector>
 
 #include "buffer.h"
@@ -16,6 +17,7 @@
 #include "gettime.h"
 #include "mkl_dfti.h"
 #include "phy_stats.h"
+#include "pruned_fft.h"
 #include "stats.h"
 #include "symbols.h"
 
@@ -55,6 +57,8 @@ class DoIFFT : public Doer {
   char* dl_socket_buffer_;
   DurationStat* duration_stat_;
   DFTI_DESCRIPTOR_HANDLE mkl_handle_;
+  // Input-pruned IFFT of the data subcarriers, used with "fft_pruning"
+  std::unique_ptr<PrunedFft> pruned_ifft_;
   float* ifft_out_;  // Buffer for IFFT output
   float ifft_scale_factor_;
 };
@@ -103,8 +103,8 @@ EventData DoPrecode::Launch(size_t tag) {
       size_t start_tsc1 = GetTime::WorkerRdtsc();
       for (size_t user_id = 0; user_id < cfg_->UeAntNum(); user_id++) {
         for (size_t j = 0; j < kSCsPerCacheline; j++) {
-          LoadInputData(symbol_idx_dl, total_data_symbol_idx, user_id,
-                        base_sc_id + i + j, j);
+          LoadInputData(frame_id, symbol_idx_dl, total_data_symbol_idx,
+                        user_id, base_sc_id + i + j, j);
         }
       }
 
@@ -122,8 +122,8 @@ EventData DoPrecode::Launch(size_t tag) {
       size_t start_tsc1 = GetTime::WorkerRdtsc();
       int cur_sc_id = base_sc_id + i;
       for (size_t user_id = 0; user_id < cfg_->UeAntNum(); user_id++) {
-        LoadInputData(symbol_idx_dl, total_data_symbol_idx, user_id, cur_sc_id,
-                      0);
+        LoadInputData(frame_id, symbol_idx_dl, total_data_symbol_idx, user_id,
+                      cur_sc_id, 0);
       }
       size_t start_tsc2 = GetTime::WorkerRdtsc();
       duration_stat_->task_duration_[1] += start_tsc2 - start_tsc1;
@@ -163,7 +163,7 @@ EventData DoPrecode::Launch(size_t tag) {
   return EventData(EventType::kPrecode, tag);
 }
 
-void DoPrecode::LoadInputData(size_t symbol_idx_dl,
+void DoPrecode::LoadInputData(size_t frame_id, size_t symbol_idx_dl,
                               size_t total_data_symbol_idx, size_t user_id,
                               size_t sc_id, size_t sc_id_in_block) {
   complex_float* data_ptr =
@@ -175,8 +175,9 @@ void DoPrecode::LoadInputData(size_t symbol_idx_dl,
     int8_t* raw_data_ptr =
         &dl_raw_data_[total_data_symbol_idx]
                      [sc_id + Roundup<64>(cfg_->OfdmDataNum()) * user_id];
-    data_ptr[user_id] =
-        ModSingleUint8((uint8_t)(*raw_data_ptr), cfg_->ModTable());
+    data_ptr[user_id] = ModSingleUint8(
+        (uint8_t)(*raw_data_ptr),
+        cfg_->ModTable(cfg_->UeModOrderBits(frame_id, user_id)));
   }
 }
 
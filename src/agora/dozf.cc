@@ -5,6 +5,8 @@
  */
 #include "dozf.h"
 
+#include <cfloat>
+
 #include "concurrent_queue_wrapper.h"
 #include "doer.h"
 
@@ -13,6 +15,14 @@ static constexpr bool kUseSIMDGather = true;
 // This is faster but less accurate than using an SVD-based pseudoinverse.
 static constexpr size_t kUseInverseForZF = 1u;
 static constexpr bool kUseUlZfForDownlink = true;
+// Compute the uplink zeroforcing detectors of a ZF block with BatchedZf, a
+// Cholesky solve vectorized across subcarriers, instead of one Armadillo
+// inverse per subcarrier
+static constexpr bool kUseBatchedZf = true;
+// Maximum age of the CSI that reused ZF matrices were computed from. This
+// refreshes the matrices of slowly drifting channels, and keeps the CSI they
+// are compared against inside the frame window.
+static constexpr size_t kMaxZfReuseFrames = 8;
 
 DoZF::DoZF(Config* config, int tid,
            PtrGrid<kFrameWnd, kMaxUEs, complex_float>& csi_buffers,
@@ -22,7 +32,8 @@ DoZF::DoZF(Config* config, int tid,
            Table<complex_float>& calib_ul_msum_buffer,
            PtrGrid<kFrameWnd, kMaxDataSCs, complex_float>& ul_zf_matrices,
            PtrGrid<kFrameWnd, kMaxDataSCs, complex_float>& dl_zf_matrices,
-           PhyStats* in_phy_stats, Stats* stats_manager)
+           PhyStats* in_phy_stats, Stats* stats_manager,
+           ZfReuseState* zf_reuse_state)
     : Doer(config, tid),
       csi_buffers_(csi_buffers),
       calib_dl_buffer_(calib_dl_buffer),
@@ -31,8 +42,10 @@ DoZF::DoZF(Config* config, int tid,
       calib_ul_msum_buffer_(calib_ul_msum_buffer),
       ul_zf_matrices_(ul_zf_matrices),
       dl_zf_matrices_(dl_zf_matrices),
-      phy_stats_(in_phy_stats) {
+      phy_stats_(in_phy_stats),
+      zf_reuse_state_(zf_reuse_state) {
   duration_stat_ = stats_manager->GetDurationStat(DoerType::kZF, tid);
+  zf_reuse_stat_ = stats_manager->GetZfReuseStat(tid);
   pred_csi_buffer_ =
       static_cast<complex_float*>(Agora_memory::PaddedAlignedAlloc(
           Agora_memory::Alignment_t::kAlign64,
@@ -64,6 +77,12 @@ DoZF::DoZF(Config* config, int tid,
       }
     }
   }
+
+  if (kUseBatchedZf && (kUseInverseForZF != 0u) && kUseUlZfForDownlink &&
+      (cfg_->FreqOrthogonalPilot() == false) && (num_ext_ref_ == 0)) {
+    batched_zf_ = std::make_unique<BatchedZf>(
+        cfg_->BsAntNum(), cfg_->UeAntNum(), cfg_->ZfBlockSize());
+  }
 }
 
 DoZF::~DoZF() {
@@ -75,6 +94,8 @@ DoZF::~DoZF() {
 EventData DoZF::Launch(size_t tag) {
   if (cfg_->FreqOrthogonalPilot()) {
     ZfFreqOrthogonal(tag);
+  } else if (zf_reuse_state_ != nullptr) {
+    ZfTimeOrthogonalReuse(tag);
   } else {
     ZfTimeOrthogonal(tag);
   }
@@ -82,15 +103,39 @@ EventData DoZF::Launch(size_t tag) {
   return EventData(EventType::kZF, tag);
 }
 
+float DoZF::Regularization(size_t frame_id) {
+  if (cfg_->GetBeamformerType() == BeamformerType::kZF) {
+    return 0;
+  }
+  const float snr = phy_stats_->GetMeanPilotSnr(frame_id);
+  if (snr <= 0) {
+    return 0;
+  }
+  // The mean diagonal entry of H' * H sums the gains of BfAntNum() antennas,
+  // and the noise variance is one gain divided by the SNR
+  float regularization = 1.0f / (cfg_->BfAntNum() * snr);
+  if (cfg_->GetBeamformerType() == BeamformerType::kRZF) {
+    regularization *= cfg_->UeAntNum();
+  }
+  return regularization;
+}
+
 float DoZF::ComputePrecoder(const arma::cx_fmat& mat_csi,
                             complex_float* calib_ptr, complex_float* _mat_ul_zf,
-                            complex_float* _mat_dl_zf) {
+                            complex_float* _mat_dl_zf, float regularization) {
   arma::cx_fmat mat_ul_zf(reinterpret_cast<arma::cx_float*>(_mat_ul_zf),
                           cfg_->UeAntNum(), cfg_->BsAntNum(), false);
   arma::cx_fmat mat_ul_zf_tmp;
-  if (kUseInverseForZF != 0u) {
+  if ((kUseInverseForZF != 0u) || (regularization > 0)) {
     try {
-      mat_ul_zf_tmp = arma::inv_sympd(mat_csi.t() * mat_csi) * mat_csi.t();
+      arma::cx_fmat mat_gram = mat_csi.t() * mat_csi;
+      if (regularization > 0) {
+        mat_gram.diag() += arma::cx_float(
+            regularization * std::real(arma::trace(mat_gram)) /
+                cfg_->UeAntNum(),
+            0);
+      }
+      mat_ul_zf_tmp = arma::inv_sympd(mat_gram) * mat_csi.t();
     } catch (std::runtime_error&) {
       MLPD_WARN("Failed to invert channel matrix, falling back to pinv()\n");
       arma::pinv(mat_ul_zf_tmp, mat_csi, 1e-2, "dc");
@@ -100,42 +145,7 @@ float DoZF::ComputePrecoder(const arma::cx_fmat& mat_csi,
   }
 
   if (cfg_->Frame().NumDLSyms() > 0) {
-    arma::cx_fvec calib_vec(reinterpret_cast<arma::cx_float*>(calib_ptr),
-                            cfg_->BfAntNum(), false);
-    arma::cx_fmat mat_dl_zf_tmp;
-    if (kUseUlZfForDownlink == true) {
-      // With orthonormal calib matrix:
-      // pinv(calib * csi) = pinv(csi)*inv(calib)
-      // This probably causes a performance hit since we are throwing
-      // magnitude info away by taking the sign of the calibration matrix
-      arma::cx_fmat calib_mat = arma::diagmat(arma::sign(calib_vec));
-      mat_dl_zf_tmp = mat_ul_zf_tmp * inv(calib_mat);
-    } else {
-      arma::cx_fmat mat_dl_csi = arma::diagmat(calib_vec) * mat_csi;
-      try {
-        mat_dl_zf_tmp =
-            arma::inv_sympd(mat_dl_csi.t() * mat_dl_csi) * mat_dl_csi.t();
-      } catch (std::runtime_error&) {
-        arma::pinv(mat_dl_zf_tmp, mat_dl_csi, 1e-2, "dc");
-      }
-    }
-    // We should be scaling the beamforming matrix, so the IFFT
-    // output can be scaled with OfdmCaNum() across all antennas.
-    // See Argos paper (Mobicom 2012) Sec. 3.4 for details.
-    float scale = 1 / (abs(mat_dl_zf_tmp).max());
-    mat_dl_zf_tmp *= scale;
-
-    for (size_t i = 0; i < cfg_->NumCells(); i++) {
-      if (cfg_->ExternalRefNode(i) == true) {
-        mat_dl_zf_tmp.insert_cols(
-            cfg_->RefAnt(i),
-            arma::cx_fmat(cfg_->UeAntNum(), cfg_->NumChannels(),
-                          arma::fill::zeros));
-      }
-    }
-    arma::cx_fmat mat_dl_zf(reinterpret_cast<arma::cx_float*>(_mat_dl_zf),
-                            cfg_->BsAntNum(), cfg_->UeAntNum(), false);
-    mat_dl_zf = mat_dl_zf_tmp.st();
+    ComputeDlPrecoder(mat_csi, mat_ul_zf_tmp, calib_ptr, _mat_dl_zf);
   }
   for (int i = (int)cfg_->NumCells() - 1; i >= 0; i--) {
     if (cfg_->ExternalRefNode(i) == true) {
@@ -152,6 +162,47 @@ float DoZF::ComputePrecoder(const arma::cx_fmat& mat_csi,
   return rcond;
 }
 
+void DoZF::ComputeDlPrecoder(const arma::cx_fmat& mat_csi,
+                             const arma::cx_fmat& mat_ul_zf,
+                             complex_float* calib_ptr,
+                             complex_float* _mat_dl_zf) {
+  arma::cx_fvec calib_vec(reinterpret_cast<arma::cx_float*>(calib_ptr),
+                          cfg_->BfAntNum(), false);
+  arma::cx_fmat mat_dl_zf_tmp;
+  if (kUseUlZfForDownlink == true) {
+    // With orthonormal calib matrix:
+    // pinv(calib * csi) = pinv(csi)*inv(calib)
+    // This probably causes a performance hit since we are throwing
+    // magnitude info away by taking the sign of the calibration matrix
+    arma::cx_fmat calib_mat = arma::diagmat(arma::sign(calib_vec));
+    mat_dl_zf_tmp = mat_ul_zf * inv(calib_mat);
+  } else {
+    arma::cx_fmat mat_dl_csi = arma::diagmat(calib_vec) * mat_csi;
+    try {
+      mat_dl_zf_tmp =
+          arma::inv_sympd(mat_dl_csi.t() * mat_dl_csi) * mat_dl_csi.t();
+    } catch (std::runtime_error&) {
+      arma::pinv(mat_dl_zf_tmp, mat_dl_csi, 1e-2, "dc");
+    }
+  }
+  // We should be scaling the beamforming matrix, so the IFFT
+  // output can be scaled with OfdmCaNum() across all antennas.
+  // See Argos paper (Mobicom 2012) Sec. 3.4 for details.
+  float scale = 1 / (abs(mat_dl_zf_tmp).max());
+  mat_dl_zf_tmp *= scale;
+
+  for (size_t i = 0; i < cfg_->NumCells(); i++) {
+    if (cfg_->ExternalRefNode(i) == true) {
+      mat_dl_zf_tmp.insert_cols(
+          cfg_->RefAnt(i), arma::cx_fmat(cfg_->UeAntNum(), cfg_->NumChannels(),
+                                         arma::fill::zeros));
+    }
+  }
+  arma::cx_fmat mat_dl_zf(reinterpret_cast<arma::cx_float*>(_mat_dl_zf),
+                          cfg_->BsAntNum(), cfg_->UeAntNum(), false);
+  mat_dl_zf = mat_dl_zf_tmp.st();
+}
+
 void DoZF::ComputeCalib(size_t frame_id, size_t sc_id) {
   arma::cx_fvec calib_vec(
       reinterpret_cast<arma::cx_float*>(calib_gather_buffer_), cfg_->BfAntNum(),
@@ -301,6 +352,172 @@ static inline void TransposeGather(size_t cur_sc_id, float* src, float*& dst,
   }
 }
 
+void DoZF::GatherCsi(size_t frame_slot, size_t sc_id) {
+  // Gather CSI matrices of each pilot from partially-transposed CSIs.
+  for (size_t ue_idx = 0; ue_idx < cfg_->UeAntNum(); ue_idx++) {
+    auto* dst_csi_ptr = reinterpret_cast<float*>(csi_gather_buffer_ +
+                                                 cfg_->BsAntNum() * ue_idx);
+    if (kUsePartialTrans) {
+      PartialTransposeGather(sc_id, (float*)csi_buffers_[frame_slot][ue_idx],
+                             dst_csi_ptr, cfg_->BsAntNum());
+    } else {
+      TransposeGather(sc_id, (float*)csi_buffers_[frame_slot][ue_idx],
+                      dst_csi_ptr, cfg_->BsAntNum(), cfg_->OfdmDataNum());
+    }
+  }
+}
+
+// Offset of antenna ant of subcarrier sc_id in a CSI buffer
+static inline size_t CsiOffset(size_t sc_id, size_t ant, size_t bs_ant_num,
+                               size_t ofdm_data_num) {
+  if (kUsePartialTrans) {
+    return (sc_id / kTransposeBlockSize) * (kTransposeBlockSize * bs_ant_num) +
+           ant * kTransposeBlockSize + (sc_id % kTransposeBlockSize);
+  }
+  return ant * ofdm_data_num + sc_id;
+}
+
+float DoZF::CsiChange(size_t frame_id, size_t ref_frame_id, size_t base_sc_id,
+                      size_t num_sc) {
+  float diff_norm = 0;
+  float ref_norm = 0;
+  for (size_t ue_idx = 0; ue_idx < cfg_->UeAntNum(); ue_idx++) {
+    const complex_float* csi = csi_buffers_[frame_id % kFrameWnd][ue_idx];
+    const complex_float* ref_csi =
+        csi_buffers_[ref_frame_id % kFrameWnd][ue_idx];
+    for (size_t i = 0; i < num_sc; i++) {
+      for (size_t ant = 0; ant < cfg_->BsAntNum(); ant++) {
+        const size_t offset = CsiOffset(base_sc_id + i, ant, cfg_->BsAntNum(),
+                                        cfg_->OfdmDataNum());
+        const float diff_re = csi[offset].re - ref_csi[offset].re;
+        const float diff_im = csi[offset].im - ref_csi[offset].im;
+        diff_norm += diff_re * diff_re + diff_im * diff_im;
+        ref_norm += ref_csi[offset].re * ref_csi[offset].re +
+                    ref_csi[offset].im * ref_csi[offset].im;
+      }
+    }
+  }
+  return (ref_norm > 0) ? diff_norm / ref_norm : FLT_MAX;
+}
+
+void DoZF::ZfTimeOrthogonalReuse(size_t tag) {
+  const size_t frame_id = gen_tag_t(tag).frame_id_;
+  const size_t base_sc_id = gen_tag_t(tag).sc_id_;
+  const size_t block = base_sc_id / cfg_->ZfBlockSize();
+  const size_t num_subcarriers =
+      std::min(cfg_->ZfBlockSize(), cfg_->OfdmDataNum() - base_sc_id);
+  size_t start_tsc1 = GetTime::WorkerRdtsc();
+
+  const size_t ref_frame_id =
+      (frame_id > 0) ? zf_reuse_state_->GetCsiFrame(frame_id - 1, block)
+                     : SIZE_MAX;
+  if ((ref_frame_id != SIZE_MAX) &&
+      (frame_id - ref_frame_id <= kMaxZfReuseFrames) &&
+      (CsiChange(frame_id, ref_frame_id, base_sc_id, num_subcarriers) <
+       cfg_->ZfReuseThreshold())) {
+    const size_t frame_slot = frame_id % kFrameWnd;
+    const size_t prev_frame_slot = (frame_id - 1) % kFrameWnd;
+    const size_t mat_size =
+        cfg_->BsAntNum() * cfg_->UeAntNum() * sizeof(complex_float);
+    for (size_t i = 0; i < num_subcarriers; i++) {
+      const size_t cur_sc_id = base_sc_id + i;
+      std::memcpy(ul_zf_matrices_[frame_slot][cur_sc_id],
+                  ul_zf_matrices_[prev_frame_slot][cur_sc_id], mat_size);
+      if (cfg_->Frame().NumDLSyms() > 0) {
+        std::memcpy(dl_zf_matrices_[frame_slot][cur_sc_id],
+                    dl_zf_matrices_[prev_frame_slot][cur_sc_id], mat_size);
+      }
+      if (kPrintZfStats) {
+        phy_stats_->UpdateCsiCond(
+            frame_id, cur_sc_id,
+            phy_stats_->GetCsiCond(frame_id - 1, cur_sc_id));
+      }
+    }
+    // The MCS of the users may have changed since the previous frame
+    QuantizeZf(frame_id, base_sc_id, num_subcarriers);
+    zf_reuse_state_->SetDone(frame_id, block, ref_frame_id);
+
+    const size_t duration = GetTime::WorkerRdtsc() - start_tsc1;
+    zf_reuse_stat_->reused_count_++;
+    zf_reuse_stat_->check_tsc_ += duration;
+    duration_stat_->task_count_ += num_subcarriers;
+    duration_stat_->task_duration_[0] += duration;
+    return;
+  }
+
+  size_t start_tsc2 = GetTime::WorkerRdtsc();
+  zf_reuse_stat_->check_tsc_ += start_tsc2 - start_tsc1;
+  ZfTimeOrthogonal(tag);
+  zf_reuse_state_->SetDone(frame_id, block, frame_id);
+  zf_reuse_stat_->computed_count_++;
+  zf_reuse_stat_->computed_tsc_ += GetTime::WorkerRdtsc() - start_tsc2;
+}
+
+void DoZF::ZfBatched(size_t frame_id, size_t base_sc_id, size_t num_sc,
+                     float regularization) {
+  const size_t frame_slot = frame_id % kFrameWnd;
+  size_t start_tsc1 = GetTime::WorkerRdtsc();
+
+  // Gather the CSI matrices of all subcarriers into the batch
+  for (size_t ue_idx = 0; ue_idx < cfg_->UeAntNum(); ue_idx++) {
+    const complex_float* csi = csi_buffers_[frame_slot][ue_idx];
+    for (size_t i = 0; i < num_sc; i++) {
+      const size_t cur_sc_id = base_sc_id + i;
+      for (size_t ant = 0; ant < cfg_->BsAntNum(); ant++) {
+        batched_zf_->SetCsi(i, ant, ue_idx,
+                            csi[CsiOffset(cur_sc_id, ant, cfg_->BsAntNum(),
+                                          cfg_->OfdmDataNum())]);
+      }
+    }
+  }
+
+  size_t start_tsc2 = GetTime::WorkerRdtsc();
+  duration_stat_->task_duration_[1] += start_tsc2 - start_tsc1;
+
+  const size_t num_failed = batched_zf_->Compute(num_sc, regularization);
+  if (num_failed > 0) {
+    MLPD_WARN("Failed to invert %zu channel matrices, falling back to pinv()\n",
+              num_failed);
+  }
+
+  size_t start_tsc3 = GetTime::WorkerRdtsc();
+  duration_stat_->task_duration_[3] += start_tsc3 - start_tsc2;
+
+  for (size_t i = 0; i < num_sc; i++) {
+    const size_t cur_sc_id = base_sc_id + i;
+    complex_float* ul_zf = ul_zf_matrices_[frame_slot][cur_sc_id];
+    complex_float* dl_zf = dl_zf_matrices_[frame_slot][cur_sc_id];
+    if (cfg_->Frame().NumDLSyms() > 0) {
+      ComputeCalib(frame_id, cur_sc_id);
+    }
+
+    float rcond;
+    if (batched_zf_->Failed(i)) {
+      GatherCsi(frame_slot, cur_sc_id);
+      arma::cx_fmat mat_csi((arma::cx_float*)csi_gather_buffer_,
+                            cfg_->BsAntNum(), cfg_->UeAntNum(), false);
+      rcond = ComputePrecoder(mat_csi, calib_gather_buffer_, ul_zf, dl_zf,
+                              regularization);
+    } else {
+      batched_zf_->GetZf(i, ul_zf);
+      if (cfg_->Frame().NumDLSyms() > 0) {
+        arma::cx_fmat mat_ul_zf(reinterpret_cast<arma::cx_float*>(ul_zf),
+                                cfg_->UeAntNum(), cfg_->BsAntNum(), false);
+        ComputeDlPrecoder(arma::cx_fmat(), mat_ul_zf, calib_gather_buffer_,
+                          dl_zf);
+      }
+      rcond = batched_zf_->Rcond(i);
+    }
+    if (kPrintZfStats) {
+      phy_stats_->UpdateCsiCond(frame_id, cur_sc_id, rcond);
+    }
+  }
+
+  duration_stat_->task_duration_[2] += GetTime::WorkerRdtsc() - start_tsc3;
+  duration_stat_->task_count_ += num_sc;
+  duration_stat_->task_duration_[0] += GetTime::WorkerRdtsc() - start_tsc1;
+}
+
 void DoZF::ZfTimeOrthogonal(size_t tag) {
   const size_t frame_id = gen_tag_t(tag).frame_id_;
   const size_t base_sc_id = gen_tag_t(tag).sc_id_;
@@ -311,25 +528,20 @@ void DoZF::ZfTimeOrthogonal(size_t tag) {
   }
   size_t num_subcarriers =
       std::min(cfg_->ZfBlockSize(), cfg_->OfdmDataNum() - base_sc_id);
+  const float regularization = Regularization(frame_id);
+
+  if (batched_zf_ != nullptr) {
+    ZfBatched(frame_id, base_sc_id, num_subcarriers, regularization);
+    QuantizeZf(frame_id, base_sc_id, num_subcarriers);
+    return;
+  }
 
   // Handle each subcarrier one by one
   for (size_t i = 0; i < num_subcarriers; i++) {
     size_t start_tsc1 = GetTime::WorkerRdtsc();
     const size_t cur_sc_id = base_sc_id + i;
 
-    // Gather CSI matrices of each pilot from partially-transposed CSIs.
-    for (size_t ue_idx = 0; ue_idx < cfg_->UeAntNum(); ue_idx++) {
-      auto* dst_csi_ptr = reinterpret_cast<float*>(csi_gather_buffer_ +
-                                                   cfg_->BsAntNum() * ue_idx);
-      if (kUsePartialTrans) {
-        PartialTransposeGather(cur_sc_id,
-                               (float*)csi_buffers_[frame_slot][ue_idx],
-                               dst_csi_ptr, cfg_->BsAntNum());
-      } else {
-        TransposeGather(cur_sc_id, (float*)csi_buffers_[frame_slot][ue_idx],
-                        dst_csi_ptr, cfg_->BsAntNum(), cfg_->OfdmDataNum());
-      }
-    }
+    GatherCsi(frame_slot, cur_sc_id);
 
     size_t start_tsc2 = GetTime::WorkerRdtsc();
     duration_stat_->task_duration_[1] += start_tsc2 - start_tsc1;
@@ -347,9 +559,9 @@ void DoZF::ZfTimeOrthogonal(size_t tag) {
     double start_tsc3 = GetTime::WorkerRdtsc();
     duration_stat_->task_duration_[2] += start_tsc3 - start_tsc2;
 
-    auto rcond = ComputePrecoder(mat_csi, calib_gather_buffer_,
-                                 ul_zf_matrices_[frame_slot][cur_sc_id],
-                                 dl_zf_matrices_[frame_slot][cur_sc_id]);
+    auto rcond = ComputePrecoder(
+        mat_csi, calib_gather_buffer_, ul_zf_matrices_[frame_slot][cur_sc_id],
+        dl_zf_matrices_[frame_slot][cur_sc_id], regularization);
     if (kPrintZfStats) {
       phy_stats_->UpdateCsiCond(frame_id, cur_sc_id, rcond);
     }
@@ -361,6 +573,7 @@ void DoZF::ZfTimeOrthogonal(size_t tag) {
     //     std::printf("Thread %d ZF takes %.2f\n", tid, duration);
     // }
   }
+  QuantizeZf(frame_id, base_sc_id, num_subcarriers);
 }
 
 void DoZF::ZfFreqOrthogonal(size_t tag) {
@@ -433,7 +646,9 @@ void DoZF::ZfFreqOrthogonal(size_t tag) {
 
   ComputePrecoder(mat_csi, calib_gather_buffer_,
                   ul_zf_matrices_[frame_slot][cfg_->GetZfScId(base_sc_id)],
-                  dl_zf_matrices_[frame_slot][cfg_->GetZfScId(base_sc_id)]);
+                  dl_zf_matrices_[frame_slot][cfg_->GetZfScId(base_sc_id)],
+                  Regularization(frame_id));
+  QuantizeZf(frame_id, cfg_->GetZfScId(base_sc_id), 1);
 
   duration_stat_->task_duration_[3] += GetTime::WorkerRdtsc() - start_tsc3;
   duration_stat_->task_count_++;
@@ -444,6 +659,26 @@ void DoZF::ZfFreqOrthogonal(size_t tag) {
   // }
 }
 
+void DoZF::QuantizeZf(size_t frame_id, size_t base_sc_id, size_t num_sc) {
+  if (!cfg_->FixedPointDemul()) {
+    return;
+  }
+  const size_t frame_slot = frame_id % kFrameWnd;
+  // Each user's rows are scaled for the modulation of its MCS in this frame,
+  // and by the llr_scale DoDemul passes to Q15DemodSoft
+  std::array<float, kMaxUEs> llr_scales;
+  for (size_t ue_id = 0; ue_id < cfg_->UeAntNum(); ue_id++) {
+    const size_t mod_order_bits = cfg_->UeModOrderBits(frame_id, ue_id);
+    llr_scales.at(ue_id) =
+        Q15LlrScale(mod_order_bits) *
+        phy_stats_->GetLlrScale(frame_id, ue_id, mod_order_bits);
+  }
+  for (size_t i = 0; i < num_sc; i++) {
+    Q15QuantizeZf(ul_zf_matrices_[frame_slot][base_sc_id + i],
+                  cfg_->BsAntNum(), cfg_->UeAntNum(), llr_scales.data());
+  }
+}
+
 // Currently unused
 /*
 void DoZF::Predict(size_t tag)
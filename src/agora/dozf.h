@@ -7,16 +7,20 @@
 
 #include <armadillo>
 #include <iostream>
+#include <memory>
 
+#include "batched_zf.h"
 #include "buffer.h"
 #include "concurrentqueue.h"
 #include "config.h"
 #include "doer.h"
+#include "fixed_point.h"
 #include "gettime.h"
 #include "phy_stats.h"
 #include "stats.h"
 #include "symbols.h"
 #include "utils.h"
+#include "zf_reuse_state.h"
 
 class DoZF : public Doer {
  public:
@@ -28,7 +32,8 @@ class DoZF : public Doer {
        Table<complex_float>& calib_ul_msum_buffer,
        PtrGrid<kFrameWnd, kMaxDataSCs, complex_float>& ul_zf_matrices_,
        PtrGrid<kFrameWnd, kMaxDataSCs, complex_float>& dl_zf_matrices_,
-       PhyStats* in_phy_stats, Stats* stats_manager);
+       PhyStats* in_phy_stats, Stats* stats_manager,
+       ZfReuseState* zf_reuse_state = nullptr);
   ~DoZF() override;
 
   /**
@@ -52,13 +57,48 @@ class DoZF : public Doer {
  private:
   void ZfTimeOrthogonal(size_t tag);
 
+  /// Copy the ZF matrices of the previous frame for the block of tag if its
+  /// CSI barely changed since they were computed, or run ZfTimeOrthogonal
+  void ZfTimeOrthogonalReuse(size_t tag);
+
+  /// Relative change of the CSI of num_sc subcarriers starting at base_sc_id
+  /// from frame ref_frame_id to frame_id, |H - H_ref|^2 / |H_ref|^2
+  float CsiChange(size_t frame_id, size_t ref_frame_id, size_t base_sc_id,
+                  size_t num_sc);
+
   /// Compute the uplink zeroforcing detector matrix and/or the downlink
-  /// zeroforcing precoder using this CSI matrix and calibration buffer
+  /// zeroforcing precoder using this CSI matrix and calibration buffer.
+  /// A nonzero regularization adds regularization * trace(H' * H) / UeAntNum
+  /// to the diagonal of H' * H.
   float ComputePrecoder(const arma::cx_fmat& mat_csi, complex_float* calib_ptr,
-                        complex_float* mat_ul_zf, complex_float* mat_dl_zf);
+                        complex_float* mat_ul_zf, complex_float* mat_dl_zf,
+                        float regularization);
+
+  /// Regularization of H' * H for the configured beamformer, relative to its
+  /// mean diagonal entry, using the pilot SNR of this frame
+  float Regularization(size_t frame_id);
+
+  /// Compute the downlink zeroforcing precoder from the uplink detector
+  /// before the insertion of reference antennas. mat_csi is used only if the
+  /// uplink detector is not reused for the downlink.
+  void ComputeDlPrecoder(const arma::cx_fmat& mat_csi,
+                         const arma::cx_fmat& mat_ul_zf,
+                         complex_float* calib_ptr, complex_float* mat_dl_zf);
+
+  /// Gather the CSI matrix of subcarrier sc_id into csi_gather_buffer_
+  void GatherCsi(size_t frame_slot, size_t sc_id);
+
+  /// Compute the zeroforcing matrices of num_sc subcarriers starting at
+  /// base_sc_id with batched_zf_
+  void ZfBatched(size_t frame_id, size_t base_sc_id, size_t num_sc,
+                 float regularization);
   void ComputeCalib(size_t frame_id, size_t sc_id);
   void ZfFreqOrthogonal(size_t tag);
 
+  /// Quantize the uplink ZF matrices of num_sc subcarriers starting at
+  /// base_sc_id to the Q15 copies used by DoDemul with "fixed_point_demul"
+  void QuantizeZf(size_t frame_id, size_t base_sc_id, size_t num_sc);
+
   /**
    * Do prediction task for one subcarrier
    * @param tid: task thread index, used for selecting task ptok
@@ -99,6 +139,12 @@ class DoZF : public Doer {
   PhyStats* phy_stats_;
   arma::uvec ext_ref_id_;
   size_t num_ext_ref_;
+  // Computes the uplink detectors of a whole ZF block at once. Null if the
+  // per-subcarrier path is used.
+  std::unique_ptr<BatchedZf> batched_zf_;
+  // Null if ZF matrices are not reused across frames
+  ZfReuseState* zf_reuse_state_;
+  ZfReuseStat* zf_reuse_stat_;
 };
 
 #endif  // DOZF_H_
@@ -0,0 +1,28 @@
+/**
+ * @file edf_scheduler.cc
+ * @brief Implementation file for the EdfScheduler class
+ */
+#include "edf_scheduler.h"
+
+void EdfScheduler::Push(size_t deadline, size_t qid, const EventData& event) {
+  std::scoped_lock lock(mutex_);
+  tasks_.push(Task{deadline, next_seq_, qid, event});
+  next_seq_++;
+  num_tasks_++;
+}
+
+bool EdfScheduler::Pop(EventData& event, size_t& qid) {
+  if (num_tasks_.load(std::memory_order_relaxed) == 0) {
+    return false;
+  }
+
+  std::scoped_lock lock(mutex_);
+  if (tasks_.empty() == true) {
+    return false;
+  }
+  event = tasks_.top().event_;
+  qid = tasks_.top().qid_;
+  tasks_.pop();
+  num_tasks_--;
+  return true;
+}
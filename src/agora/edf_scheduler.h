@@ -0,0 +1,51 @@
+/**
+ * @file edf_scheduler.h
+ * @brief Declaration file for the EdfScheduler class, a task queue shared by
+ * all workers that hands out the task with the earliest deadline first
+ */
+#ifndef EDF_SCHEDULER_H_
+#define EDF_SCHEDULER_H_
+
+#include <atomic>
+#include <mutex>
+#include <queue>
+#include <vector>
+
+#include "buffer.h"
+
+class EdfScheduler {
+ public:
+  EdfScheduler() : num_tasks_(0), next_seq_(0) {}
+
+  /// Add [event] of schedule queue [qid] with [deadline]. Safe to call from
+  /// any thread.
+  void Push(size_t deadline, size_t qid, const EventData& event);
+
+  /// Take the task with the earliest deadline, or the oldest one among tasks
+  /// with the same deadline. Returns false if there are no tasks.
+  bool Pop(EventData& event, size_t& qid);
+
+  inline size_t Size() const { return this->num_tasks_.load(); }
+
+ private:
+  struct Task {
+    size_t deadline_;
+    size_t seq_;  // Push order, to keep tasks with equal deadlines in order
+    size_t qid_;
+    EventData event_;
+
+    // std::priority_queue puts the largest element on top
+    bool operator<(const Task& other) const {
+      return (deadline_ != other.deadline_) ? (deadline_ > other.deadline_)
+                                            : (seq_ > other.seq_);
+    }
+  };
+
+  std::mutex mutex_;
+  std::priority_queue<Task> tasks_;
+  // Number of tasks, read without the lock to skip an empty queue
+  std::atomic<size_t> num_tasks_;
+  size_t next_seq_;
+};
+
+#endif  // EDF_SCHEDULER_H_
@@ -7,6 +7,8 @@
 #include <cfloat>
 #include <cmath>
 
+#include "modulation.h"
+
 PhyStats::PhyStats(Config* const cfg, Direction dir) : config_(cfg), dir_(dir) {
   if (dir_ == Direction::kDownlink) {
     num_rx_symbols_ = cfg->Frame().NumDLSyms();
@@ -122,6 +124,59 @@ float PhyStats::GetEvmSnr(size_t frame_id, size_t ue_id) {
   return -10 * std::log10(evm);
 }
 
+float PhyStats::GetMeanPilotSnr(size_t frame_id) {
+  const float* frame_snr = pilot_snr_[frame_id % kFrameWnd];
+  float snr_sum = 0;
+  size_t snr_count = 0;
+  // Frequency-orthogonal pilots are all in the first pilot symbol
+  const size_t num_pilots =
+      std::min(config_->Frame().NumPilotSyms(), config_->UeAntNum());
+  for (size_t i = 0; i < num_pilots * config_->BsAntNum(); i++) {
+    // Entries of reference antennas and all-noise pilots are not finite
+    if (std::isfinite(frame_snr[i])) {
+      snr_sum += std::pow(10, frame_snr[i] / 10);
+      snr_count++;
+    }
+  }
+  return (snr_count == 0) ? 0 : snr_sum / snr_count;
+}
+
+float PhyStats::GetUePilotSnr(size_t frame_id, size_t ue_id) {
+  // Frequency-orthogonal pilots of all users are in the first pilot symbol
+  const size_t pilot_id = config_->FreqOrthogonalPilot() ? 0 : ue_id;
+  const float* ue_snr =
+      &pilot_snr_[frame_id % kFrameWnd][pilot_id * config_->BsAntNum()];
+  float snr_db_sum = 0;
+  size_t snr_count = 0;
+  for (size_t i = 0; i < config_->BsAntNum(); i++) {
+    if (std::isfinite(ue_snr[i])) {
+      snr_db_sum += ue_snr[i];
+      snr_count++;
+    }
+  }
+  return (snr_count == 0) ? 0 : std::pow(10, snr_db_sum / snr_count / 10);
+}
+
+float PhyStats::GetUePostEqSnr(size_t frame_id, size_t ue_id) {
+  const size_t array_gain =
+      (config_->BfAntNum() > config_->UeAntNum())
+          ? config_->BfAntNum() - config_->UeAntNum() + 1
+          : 1;
+  return GetUePilotSnr(frame_id, ue_id) * array_gain;
+}
+
+float PhyStats::GetLlrScale(size_t frame_id, size_t ue_id,
+                            size_t mod_order_bits) {
+  if (!config_->LlrScaling()) {
+    return 1;
+  }
+  const float snr = GetUePostEqSnr(frame_id, ue_id);
+  if (snr <= 0) {
+    return 1;
+  }
+  return SoftDemodLlrScale(mod_order_bits, snr);
+}
+
 void PhyStats::PrintSnrStats(size_t frame_id) {
   std::stringstream ss;
   ss << "Frame " << frame_id
@@ -261,6 +316,10 @@ void PhyStats::UpdateCsiCond(size_t frame_id, size_t sc_id, float cond) {
   csi_cond_[frame_id % kFrameWnd][sc_id] = cond;
 }
 
+float PhyStats::GetCsiCond(size_t frame_id, size_t sc_id) {
+  return csi_cond_[frame_id % kFrameWnd][sc_id];
+}
+
 void PhyStats::UpdateEvmStats(size_t frame_id, size_t sc_id,
                               const arma::cx_fmat& eq) {
   if (num_rx_symbols_ > 0) {
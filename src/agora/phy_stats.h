@@ -32,6 +32,20 @@ class PhyStats {
                       const arma::cx_fmat& /*eq*/);
   void PrintEvmStats(size_t /*frame_id*/);
   float GetEvmSnr(size_t frame_id, size_t ue_id);
+  /// Linear pilot SNR averaged over the users and BS antennas of a frame,
+  /// or 0 if it is not known
+  float GetMeanPilotSnr(size_t frame_id);
+  /// Linear pilot SNR of a user in a frame, averaged in dB over the BS
+  /// antennas, or 0 if it is not known
+  float GetUePilotSnr(size_t frame_id, size_t ue_id);
+  /// Linear post-equalization SNR of a user in a frame, estimated as its
+  /// pilot SNR times the array gain of zeroforcing, BfAntNum() - UeAntNum() +
+  /// 1, or 0 if the pilot SNR is not known
+  float GetUePostEqSnr(size_t frame_id, size_t ue_id);
+  /// llr_scale of the soft demappers for a user in a frame, from its
+  /// post-equalization SNR. It is 1 if the pilot SNR is not known or
+  /// "llr_scaling" is disabled.
+  float GetLlrScale(size_t frame_id, size_t ue_id, size_t mod_order_bits);
   void UpdatePilotSnr(size_t /*frame_id*/, size_t /*ue_id*/, size_t /*ant_id*/,
                       complex_float* /*fft_data*/);
   void PrintSnrStats(size_t /*frame_id*/);
@@ -40,6 +54,7 @@ class PhyStats {
   void PrintCalibSnrStats(size_t /*frame_id*/);
   void UpdateCsiCond(size_t /*frame_id*/, size_t /*subcarrier_id*/,
                      float /*condition number*/);
+  float GetCsiCond(size_t /*frame_id*/, size_t /*subcarrier_id*/);
   void PrintZfStats(size_t /*frame_id*/);
 
  private:
@@ -17,6 +17,9 @@ Stats::Stats(const Config* const cfg)
       creation_tsc_(GetTime::Rdtsc()) {
   frame_start_.Calloc(config_->SocketThreadNum(), kNumStatsFrames,
                       Agora_memory::Alignment_t::kAlign64);
+  for (auto& tsc : frame_start_tsc_) {
+    tsc.store(0);
+  }
 }
 
 Stats::~Stats() { frame_start_.Free(); }
@@ -84,6 +87,11 @@ void Stats::UpdateStats(size_t frame_id) {
   this->last_frame_id_ = frame_id;
   size_t frame_slot = (frame_id % kNumStatsFrames);
 
+  if (MasterGetMsSince(TsType::kFirstSymbolRX, frame_id) >
+      config_->FrameDeadlineMs()) {
+    this->missed_deadline_count_++;
+  }
+
   if (kIsWorkerTimingEnabled == true) {
     std::vector<FrameSummary> work_summary(kAllDoerTypes.size());
     for (size_t i = 0u; i < task_thread_num_; i++) {
@@ -330,8 +338,129 @@ size_t Stats::GetTotalTaskCount(DoerType doer_type, size_t thread_num) {
   return total_count;
 }
 
+void Stats::PrintSchedulerSummary() {
+  for (size_t i = 0; i < task_thread_num_; i++) {
+    const SchedulerStat& s = scheduler_stats_.at(i).scheduler_stat_;
+    std::printf(
+        "Thread %zu scheduler: %zu tasks, %zu stolen (%.2f%%), idle %.2f ms\n",
+        i, s.task_count_, s.steal_count_,
+        (s.task_count_ > 0) ? (s.steal_count_ * 100.0) / s.task_count_ : 0.0,
+        GetTime::CyclesToMs(s.idle_tsc_, freq_ghz_));
+  }
+}
+
+void Stats::PrintZfReuseSummary() {
+  ZfReuseStat total;
+  for (size_t i = 0; i < task_thread_num_; i++) {
+    const ZfReuseStat& s = zf_reuse_stats_.at(i).zf_reuse_stat_;
+    total.reused_count_ += s.reused_count_;
+    total.computed_count_ += s.computed_count_;
+    total.computed_tsc_ += s.computed_tsc_;
+    total.check_tsc_ += s.check_tsc_;
+  }
+  const size_t num_blocks = total.reused_count_ + total.computed_count_;
+  if (num_blocks == 0) {
+    return;
+  }
+  // Reused blocks would have taken as long as the computed ones on average
+  const double avg_compute_ms =
+      (total.computed_count_ > 0)
+          ? GetTime::CyclesToMs(total.computed_tsc_, freq_ghz_) /
+                total.computed_count_
+          : 0.0;
+  std::printf(
+      "Stats: ZF matrices reused for %zu of %zu blocks (%.2f%%), saving %.2f "
+      "ms of ZF time (%.2f ms spent comparing CSI)\n",
+      total.reused_count_, num_blocks,
+      (total.reused_count_ * 100.0) / num_blocks,
+      total.reused_count_ * avg_compute_ms -
+          GetTime::CyclesToMs(total.check_tsc_, freq_ghz_),
+      GetTime::CyclesToMs(total.check_tsc_, freq_ghz_));
+}
+
+void Stats::PrintDecoderIterSummary() {
+  DecoderIterStat total;
+  for (size_t i = 0; i < task_thread_num_; i++) {
+    const DecoderIterStat& s = decoder_iter_stats_.at(i).decoder_iter_stat_;
+    for (size_t cap = 0; cap <= DecoderIterStat::kMaxCap; cap++) {
+      total.cap_count_.at(cap) += s.cap_count_.at(cap);
+    }
+    total.iterations_ += s.iterations_;
+    total.reduced_count_ += s.reduced_count_;
+    total.reduced_failed_ += s.reduced_failed_;
+    total.full_count_ += s.full_count_;
+    total.full_failed_ += s.full_failed_;
+  }
+  const size_t num_blocks = total.reduced_count_ + total.full_count_;
+  if (num_blocks == 0) {
+    return;
+  }
+  std::string caps;
+  size_t cap_sum = 0;
+  for (size_t cap = 0; cap <= DecoderIterStat::kMaxCap; cap++) {
+    if (total.cap_count_.at(cap) > 0) {
+      caps += " " + std::to_string(cap) + ": " +
+              std::to_string(total.cap_count_.at(cap));
+      cap_sum += cap * total.cap_count_.at(cap);
+    }
+  }
+  std::printf(
+      "Stats: LDPC iteration caps (code blocks per cap){%s }, average cap "
+      "%.2f, average iterations %.2f\n",
+      caps.c_str(), cap_sum * 1.0 / num_blocks,
+      total.iterations_ * 1.0 / num_blocks);
+  // Parity check failures estimate the block error rate without ground truth
+  std::printf(
+      "Stats: LDPC parity check failures: %zu of %zu code blocks with reduced "
+      "caps (%.2f%%), %zu of %zu with the full cap (%.2f%%)\n",
+      total.reduced_failed_, total.reduced_count_,
+      (total.reduced_count_ > 0)
+          ? (total.reduced_failed_ * 100.0) / total.reduced_count_
+          : 0.0,
+      total.full_failed_, total.full_count_,
+      (total.full_count_ > 0) ? (total.full_failed_ * 100.0) / total.full_count_
+                              : 0.0);
+}
+
+void Stats::PrintDemulBreakdown() {
+  DurationStat total;
+  for (size_t i = 0; i < task_thread_num_; i++) {
+    const DurationStat* ds = GetDurationStat(DoerType::kDemul, i);
+    total.task_count_ += ds->task_count_;
+    for (size_t j = 0; j < total.task_duration_.size(); j++) {
+      total.task_duration_.at(j) += ds->task_duration_.at(j);
+    }
+  }
+  if (total.task_count_ == 0) {
+    return;
+  }
+  // Demul task counts are in subcarriers
+  std::printf(
+      "Stats: Demul per subcarrier: %.1f ns (gather %.1f ns, equalize %.1f "
+      "ns, demodulate %.1f ns)\n",
+      GetTime::CyclesToNs(total.task_duration_.at(0), freq_ghz_) /
+          total.task_count_,
+      GetTime::CyclesToNs(total.task_duration_.at(1), freq_ghz_) /
+          total.task_count_,
+      GetTime::CyclesToNs(total.task_duration_.at(2), freq_ghz_) /
+          total.task_count_,
+      GetTime::CyclesToNs(total.task_duration_.at(3), freq_ghz_) /
+          total.task_count_);
+}
+
 void Stats::PrintSummary() {
   std::printf("Stats: total processed frames %zu\n", this->last_frame_id_ + 1);
+  std::printf("Stats: %zu frames missed the %.3f ms processing deadline\n",
+              this->missed_deadline_count_, config_->FrameDeadlineMs());
+  if (config_->GetWorkerScheduler() != WorkerScheduler::kQueues) {
+    PrintSchedulerSummary();
+  }
+  if (config_->ZfReuseThreshold() > 0) {
+    PrintZfReuseSummary();
+  }
+  if (config_->AdaptiveDecoderIter()) {
+    PrintDecoderIterSummary();
+  }
   if (kIsWorkerTimingEnabled == false) {
     std::printf("Stats: Worker timing is disabled. Not printing summary\n");
   } else {
@@ -429,5 +558,8 @@ void Stats::PrintSummary() {
       }
       std::printf("\n");
     }
+    if (config_->Frame().NumULSyms() > 0) {
+      PrintDemulBreakdown();
+    }
   }  // kIsWorkerTimingEnabled == true
 }
@@ -6,6 +6,7 @@
 #ifndef STATS_H_
 #define STATS_H_
 
+#include <atomic>
 #include <iostream>
 
 #include "config.h"
@@ -23,6 +24,40 @@ struct DurationStat {
   void Reset() { std::memset(this, 0, sizeof(DurationStat)); }
 };
 
+// Task scheduling statistics of a worker thread using the work stealing or
+// the EDF scheduler
+struct SchedulerStat {
+  size_t task_count_;   // Tasks run by this worker
+  size_t steal_count_;  // Tasks taken from other workers
+  size_t idle_tsc_;     // TSC cycles spent looking for a task
+  SchedulerStat() { Reset(); }
+  void Reset() { std::memset(this, 0, sizeof(SchedulerStat)); }
+};
+
+// ZF matrix reuse statistics of a worker thread
+struct ZfReuseStat {
+  size_t reused_count_;    // ZF blocks whose previous matrices were reused
+  size_t computed_count_;  // ZF blocks that were computed
+  size_t computed_tsc_;    // TSC cycles spent computing ZF blocks
+  size_t check_tsc_;       // TSC cycles spent comparing CSI and copying
+  ZfReuseStat() { Reset(); }
+  void Reset() { std::memset(this, 0, sizeof(ZfReuseStat)); }
+};
+
+// LDPC decoder iteration caps picked with "adaptive_decoder_iter", and the
+// code blocks decoded with them
+struct DecoderIterStat {
+  static constexpr size_t kMaxCap = 32;  // Larger caps are counted as kMaxCap
+  std::array<size_t, kMaxCap + 1> cap_count_;  // Code blocks per cap
+  size_t iterations_;      // Iterations run by all code blocks
+  size_t reduced_count_;   // Code blocks with a cap below decoderIter
+  size_t reduced_failed_;  // Of them, code blocks that failed parity checks
+  size_t full_count_;      // Code blocks with a cap of decoderIter
+  size_t full_failed_;     // Of them, code blocks that failed parity checks
+  DecoderIterStat() { Reset(); }
+  void Reset() { std::memset(this, 0, sizeof(DecoderIterStat)); }
+};
+
 // Temporary summary statistics assembled from per-thread runtime stats
 struct FrameSummary {
   std::array<double, kMaxStatBreakdown> us_this_thread_;
@@ -62,8 +97,9 @@ class Stats {
   explicit Stats(const Config* const cfg);
   ~Stats();
 
-  /// If worker stats collection is enabled, combine and update per-worker
-  /// stats for all uplink and donwlink Doer types. Else return immediately.
+  /// Count the frame if its processing missed the deadline. If worker stats
+  /// collection is enabled, combine and update per-worker stats for all
+  /// uplink and donwlink Doer types.
   void UpdateStats(size_t frame_id);
 
   /// Save master timestamps to a file. If worker stats collection is enabled,
@@ -76,8 +112,13 @@ class Stats {
   /// From the master, set the RDTSC timestamp for a frame ID and timestamp
   /// type
   void MasterSetTsc(TsType timestamp_type, size_t frame_id) {
+    const size_t tsc = GetTime::Rdtsc();
     this->master_timestamps_.at(static_cast<size_t>(timestamp_type))
-        .at(frame_id % kNumStatsFrames) = GetTime::Rdtsc();
+        .at(frame_id % kNumStatsFrames) = tsc;
+    if (timestamp_type == TsType::kFirstSymbolRX) {
+      this->frame_start_tsc_.at(frame_id % kNumStatsFrames)
+          .store(tsc, std::memory_order_release);
+    }
   }
 
   /// From the master, get the RDTSC timestamp for a frame ID and timestamp
@@ -95,6 +136,15 @@ class Stats {
         this->freq_ghz_);
   }
 
+  /// From a worker, get the milliseconds elapsed since the first symbol of
+  /// frame_id was received (the kFirstSymbolRX timestamp)
+  double WorkerGetMsSinceFrameStart(size_t frame_id) const {
+    return GetTime::CyclesToMs(
+        GetTime::Rdtsc() - this->frame_start_tsc_.at(frame_id % kNumStatsFrames)
+                               .load(std::memory_order_acquire),
+        this->freq_ghz_);
+  }
+
   /// From the master, get the microseconds elapsed since the timestamp of
   /// timestamp_type was taken for frame_id
   double MasterGetUsSince(TsType timestamp_type, size_t frame_id) const {
@@ -163,7 +213,25 @@ class Stats {
                 .duration_stat_[static_cast<size_t>(doer_type)];
   }
 
+  /// Get the SchedulerStat object updated by worker thread thread_id
+  SchedulerStat* GetSchedulerStat(size_t thread_id) {
+    return &this->scheduler_stats_.at(thread_id).scheduler_stat_;
+  }
+
+  /// Get the ZfReuseStat object updated by worker thread thread_id
+  ZfReuseStat* GetZfReuseStat(size_t thread_id) {
+    return &this->zf_reuse_stats_.at(thread_id).zf_reuse_stat_;
+  }
+
+  /// Get the DecoderIterStat object updated by worker thread thread_id
+  DecoderIterStat* GetDecoderIterStat(size_t thread_id) {
+    return &this->decoder_iter_stats_.at(thread_id).decoder_iter_stat_;
+  }
+
   inline size_t LastFrameId() const { return this->last_frame_id_; }
+  inline size_t MissedDeadlineCount() const {
+    return this->missed_deadline_count_;
+  }
   /// Dimensions = number of packet RX threads x kNumStatsFrames.
   /// frame_start[i][j] is the RDTSC timestamp taken by thread i when it
   /// starts receiving frame j.
@@ -181,6 +249,10 @@ class Stats {
                                     FrameSummary const& s);
   static void PrintPerFrame(std::string const& doer_string,
                             FrameSummary const& frame_summary);
+  void PrintSchedulerSummary();
+  void PrintZfReuseSummary();
+  void PrintDecoderIterSummary();
+  void PrintDemulBreakdown();
 
   size_t GetTotalTaskCount(DoerType doer_type, size_t thread_num);
 
@@ -200,6 +272,10 @@ class Stats {
   std::array<std::array<double, kNumStatsFrames>, kNumTimestampTypes>
       master_timestamps_;
 
+  /// The kFirstSymbolRX timestamps, which workers read while the master
+  /// writes them
+  std::array<std::atomic<size_t>, kNumStatsFrames> frame_start_tsc_;
+
   /// Running time duration statistics. Each worker thread has one
   /// DurationStat object for every Doer type. The master thread keeps stale
   /// ("old") copies of all DurationStat objects.
@@ -211,6 +287,24 @@ class Stats {
   std::array<TimeDurationsStats, kMaxThreads> worker_durations_;
   std::array<TimeDurationsStats, kMaxThreads> worker_durations_old_;
 
+  struct SchedulerStats {
+    SchedulerStat scheduler_stat_;
+    std::array<uint8_t, 64> false_sharing_padding_;
+  };
+  std::array<SchedulerStats, kMaxThreads> scheduler_stats_;
+
+  struct ZfReuseStats {
+    ZfReuseStat zf_reuse_stat_;
+    std::array<uint8_t, 64> false_sharing_padding_;
+  };
+  std::array<ZfReuseStats, kMaxThreads> zf_reuse_stats_;
+
+  struct DecoderIterStats {
+    DecoderIterStat decoder_iter_stat_;
+    std::array<uint8_t, 64> false_sharing_padding_;
+  };
+  std::array<DecoderIterStats, kMaxThreads> decoder_iter_stats_;
+
   std::array<std::array<double, kNumStatsFrames>, kNumDoerTypes> doer_us_;
   std::array<std::array<std::array<double, kNumStatsFrames>, kMaxStatBreakdown>,
              kNumDoerTypes>
@@ -218,6 +312,10 @@ class Stats {
 
   size_t last_frame_id_;
 
+  /// Frames whose processing completed later than config_->FrameDeadlineMs()
+  /// after their first packet was received
+  size_t missed_deadline_count_ = 0;
+
   /// Dimensions = number of packet RX threads x kNumStatsFrames.
   /// frame_start[i][j] is the RDTSC timestamp taken by thread i when it
   /// starts receiving frame j.
@@ -13,6 +13,8 @@
 static constexpr bool kEnableSlowStart = true;
 static constexpr bool kEnableSlowSending = false;
 static constexpr bool kDebugPrintBeacon = false;
+static constexpr bool kDebugPrintRxRate = false;
+static constexpr double kRxRatePrintIntervalSec = 1.0;
 
 static constexpr size_t kSlowStartMulStage1 = 32;
 static constexpr size_t kSlowStartMulStage2 = 8;
@@ -87,7 +89,21 @@ bool PacketTXRX::StartTxRx(Table<char>& buffer, size_t packet_num_in_buffer,
   assert(buffers_per_socket_ % cfg_->NumChannels() == 0);
 
   rx_packets_.resize(socket_thread_num_);
+  rx_batch_bufs_.resize(socket_thread_num_);
+  rx_batch_lens_.resize(socket_thread_num_);
+  rx_batch_events_.resize(socket_thread_num_);
+  tx_events_.resize(socket_thread_num_);
+  tx_batch_msgs_.resize(socket_thread_num_);
+  tx_batch_ports_.resize(socket_thread_num_);
+  const size_t max_tx_items = std::max(
+      (cfg_->BsAntNum() / socket_thread_num_) + 1, cfg_->SocketTxBatchSize());
   for (size_t i = 0; i < socket_thread_num_; i++) {
+    rx_batch_bufs_.at(i).resize(cfg_->SocketRxBatchSize());
+    rx_batch_lens_.at(i).resize(cfg_->SocketRxBatchSize());
+    rx_batch_events_.at(i).resize(cfg_->SocketRxBatchSize());
+    tx_events_.at(i).resize(max_tx_items);
+    tx_batch_msgs_.at(i).resize(max_tx_items);
+    tx_batch_ports_.at(i).resize(max_tx_items);
     rx_packets_.at(i).reserve(buffers_per_socket_);
     for (size_t number_packets = 0; number_packets < buffers_per_socket_;
          number_packets++) {
@@ -200,6 +216,14 @@ void PacketTXRX::LoopTxRx(size_t tid) {
 
   int prev_frame_id = -1;
   size_t radio_id = radio_lo;
+  const bool batch_rx = cfg_->SocketRxBatchSize() > 1;
+  // Received packet counters used to report the per-core packet rate
+  size_t rx_pkts_total = 0;
+  size_t rx_pkts_interval = 0;
+  const size_t rx_rate_start_tsc = GetTime::Rdtsc();
+  size_t rx_rate_interval_tsc = rx_rate_start_tsc;
+  const size_t rx_rate_print_ticks =
+      kRxRatePrintIntervalSec * 1e9f * rdtsc_freq;
   size_t tx_frame_start = GetTime::Rdtsc();
   size_t tx_frame_id = 0;
   size_t send_time = delay_tsc + tx_frame_start;
@@ -229,10 +253,21 @@ void PacketTXRX::LoopTxRx(size_t tid) {
     const size_t send_result = DequeueSend(tid);
     if (0 == send_result) {
       // receive data
+      Packet* pkt = nullptr;
+      size_t rx_count = 0;
+      if (batch_rx) {
+        rx_count = RecvEnqueueBatch(tid, radio_id, rx_slot);
+        if (rx_count > 0) {
+          pkt = rx_packets_.at(tid).at(rx_slot + rx_count - 1).RawPacket();
+        }
+      } else {
+        pkt = RecvEnqueue(tid, radio_id, rx_slot);
+        rx_count = (pkt != nullptr) ? 1 : 0;
+      }
 
-      Packet* pkt = RecvEnqueue(tid, radio_id, rx_slot);
       if (pkt != nullptr) {
-        rx_slot = (rx_slot + 1) % buffers_per_socket_;
+        rx_slot = (rx_slot + rx_count) % buffers_per_socket_;
+        rx_pkts_interval += rx_count;
 
         if (kIsWorkerTimingEnabled) {
           int frame_id = pkt->frame_id_;
@@ -247,7 +282,27 @@ void PacketTXRX::LoopTxRx(size_t tid) {
         }
       }
     }  // end if -1 == send_result
-  }    // end while
+
+    if (kDebugPrintRxRate &&
+        (rdtsc_now - rx_rate_interval_tsc) > rx_rate_print_ticks) {
+      const double interval_sec =
+          GetTime::CyclesToSec(rdtsc_now - rx_rate_interval_tsc, rdtsc_freq);
+      std::printf("LoopTxRx[%zu]: %.3f Mpps\n", tid,
+                  rx_pkts_interval / interval_sec / 1e6);
+      rx_pkts_total += rx_pkts_interval;
+      rx_pkts_interval = 0;
+      rx_rate_interval_tsc = rdtsc_now;
+    }
+  }  // end while
+
+  rx_pkts_total += rx_pkts_interval;
+  const double rx_sec =
+      GetTime::CyclesToSec(GetTime::Rdtsc() - rx_rate_start_tsc, rdtsc_freq);
+  MLPD_INFO(
+      "LoopTxRx[%zu]: received %zu packets in %.2f sec, %.3f Mpps per core "
+      "(rx batch size %zu)\n",
+      tid, rx_pkts_total, rx_sec, rx_pkts_total / rx_sec / 1e6,
+      cfg_->SocketRxBatchSize());
 }
 
 Packet* PacketTXRX::RecvEnqueue(size_t tid, size_t radio_id, size_t rx_slot) {
@@ -305,11 +360,76 @@ Packet* PacketTXRX::RecvEnqueue(size_t tid, size_t radio_id, size_t rx_slot) {
   return pkt;
 }
 
+size_t PacketTXRX::RecvEnqueueBatch(size_t tid, size_t radio_id,
+                                    size_t rx_slot) {
+  const size_t packet_length = cfg_->PacketLength();
+  std::vector<RxPacket>& rx_packets = rx_packets_.at(tid);
+  std::vector<uint8_t*>& bufs = rx_batch_bufs_.at(tid);
+  std::vector<size_t>& msg_lens = rx_batch_lens_.at(tid);
+  std::vector<EventData>& events = rx_batch_events_.at(tid);
+
+  // Do not wrap around the end of the rx ring within one batch, and receive
+  // only into the free slots that follow rx_slot
+  const size_t max_batch_size =
+      std::min(cfg_->SocketRxBatchSize(), buffers_per_socket_ - rx_slot);
+  size_t batch_size = 0;
+  while (batch_size < max_batch_size) {
+    RxPacket& rx = rx_packets.at(rx_slot + batch_size);
+    if (rx.Empty() == false) {
+      break;
+    }
+    bufs.at(batch_size) = reinterpret_cast<uint8_t*>(rx.RawPacket());
+    batch_size++;
+  }
+  // if rx_buffer is full, exit
+  if (batch_size == 0) {
+    MLPD_ERROR("TXRX thread %zu rx_buffer full, offset: %zu\n", tid, rx_slot);
+    cfg_->Running(false);
+    return 0;
+  }
+
+  const ssize_t rx_count = udp_servers_.at(radio_id)->RecvBatch(
+      bufs.data(), packet_length, batch_size, msg_lens.data());
+  if (0 > rx_count) {
+    MLPD_ERROR("RecvEnqueueBatch: Udp RecvBatch failed with error\n");
+    throw std::runtime_error("PacketTXRX: recvmmsg failed");
+  }
+
+  for (ssize_t i = 0; i < rx_count; i++) {
+    if (msg_lens.at(i) != packet_length) {
+      MLPD_ERROR(
+          "RecvEnqueueBatch: Udp RecvBatch failed to receive all expected "
+          "bytes");
+      throw std::runtime_error(
+          "PacketTXRX::RecvEnqueueBatch: Udp RecvBatch failed to receive all "
+          "expected bytes");
+    }
+    RxPacket& rx = rx_packets.at(rx_slot + i);
+    Packet* pkt = rx.RawPacket();
+    if (kDebugPrintInTask) {
+      std::printf("In TXRX thread %zu: Received frame %d, symbol %d, ant %d\n",
+                  tid, pkt->frame_id_, pkt->symbol_id_, pkt->ant_id_);
+    }
+    pkt->ant_id_ += pkt->cell_id_ * ant_per_cell_;
+    rx.Use();
+    events.at(i) = EventData(EventType::kPacketRX, rx_tag_t(rx).tag_);
+  }
+
+  // Push all kPacketRX events into the queue at once
+  if ((rx_count > 0) &&
+      (message_queue_->enqueue_bulk(*rx_ptoks_[tid], events.data(),
+                                    rx_count) == false)) {
+    MLPD_ERROR("socket message enqueue failed\n");
+    throw std::runtime_error("PacketTXRX: socket message enqueue failed");
+  }
+  return static_cast<size_t>(rx_count);
+}
+
 size_t PacketTXRX::DequeueSend(int tid) {
-  const size_t max_dequeue_items =
-      (cfg_->BsAntNum() / cfg_->SocketThreadNum()) + 1;
-  // can pull this into the class
-  std::vector<EventData> events(max_dequeue_items);
+  std::vector<EventData>& events = tx_events_.at(tid);
+  std::vector<const uint8_t*>& msgs = tx_batch_msgs_.at(tid);
+  std::vector<uint16_t>& ports = tx_batch_ports_.at(tid);
+  const bool batch_tx = cfg_->SocketTxBatchSize() > 1;
 
   // Single producer ordering in q is preserved
   const size_t dequeued_items = task_queue_->try_dequeue_bulk_from_producer(
@@ -344,14 +464,36 @@ size_t PacketTXRX::DequeueSend(int tid) {
         reinterpret_cast<Packet*>(&tx_buffer_[offset * cfg_->DlPacketLength()]);
     new (pkt) Packet(frame_id, symbol_id, 0 /* cell_id */, ant_id);
 
-    // Send data (one OFDM symbol)
-    udp_clients_.at(ant_id)->Send(cfg_->BsRruAddr(), cfg_->BsRruPort() + ant_id,
-                                  reinterpret_cast<uint8_t*>(pkt),
-                                  cfg_->DlPacketLength());
+    if (batch_tx) {
+      // Stage the packet, all staged packets are sent below
+      msgs.at(item) = reinterpret_cast<uint8_t*>(pkt);
+      ports.at(item) = cfg_->BsRruPort() + ant_id;
+    } else {
+      // Send data (one OFDM symbol)
+      udp_clients_.at(ant_id)->Send(
+          cfg_->BsRruAddr(), cfg_->BsRruPort() + ant_id,
+          reinterpret_cast<uint8_t*>(pkt), cfg_->DlPacketLength());
+    }
+    current_event = EventData(EventType::kPacketTX, current_event.tags_[0]);
+  }
+
+  if (batch_tx && (dequeued_items > 0)) {
+    // The remote port selects the antenna, so every staged packet can go out
+    // through the socket of the first dequeued antenna
+    const size_t first_ant_id = gen_tag_t(events.at(0).tags_[0]).ant_id_;
+    for (size_t sent = 0; sent < dequeued_items;
+         sent += cfg_->SocketTxBatchSize()) {
+      const size_t num_msgs =
+          std::min(cfg_->SocketTxBatchSize(), dequeued_items - sent);
+      udp_clients_.at(first_ant_id)
+          ->SendBatch(cfg_->BsRruAddr(), &ports.at(sent), &msgs.at(sent),
+                      cfg_->DlPacketLength(), num_msgs);
+    }
+  }
 
-    RtAssert(message_queue_->enqueue(
-                 *rx_ptoks_[tid],
-                 EventData(EventType::kPacketTX, current_event.tags_[0])),
+  if (dequeued_items > 0) {
+    RtAssert(message_queue_->enqueue_bulk(*rx_ptoks_[tid], events.data(),
+                                          dequeued_items),
              "Socket message enqueue failed\n");
   }
   return dequeued_items;
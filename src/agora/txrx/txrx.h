@@ -8,6 +8,7 @@
 #define PACKETTXRX_H_
 
 #include <algorithm>
+#include <array>
 #include <cassert>
 #include <chrono>
 #include <ctime>
@@ -55,6 +56,10 @@ class DPDKRxPacket : public RxPacket {
 #endif  // defined(USE_DPDK_MEMORY)
 #endif  //  defined(USE_DPDK)
 
+#if defined(USE_AF_XDP)
+#include "xdp_transport.h"
+#endif  // defined(USE_AF_XDP)
+
 /**
  * @brief Implementations of this class provide packet I/O for Agora.
  *
@@ -85,6 +90,12 @@ class PacketTXRX {
                     size_t& prev_frame_id, size_t& rx_slot);
 #endif
 
+#if defined(USE_AF_XDP)
+  // At thread [tid], receive packets from the AF_XDP socket and enqueue them
+  // to the master thread, return the number of packets enqueued
+  size_t XdpRecv(size_t tid, int& prev_frame_id);
+#endif
+
   /**
    * @brief Start the network I/O threads
    *
@@ -108,6 +119,10 @@ class PacketTXRX {
   void LoopTxRx(size_t tid);  // The thread function for thread [tid]
   size_t DequeueSend(int tid);
   Packet* RecvEnqueue(size_t tid, size_t radio_id, size_t rx_slot);
+  // Receive up to SocketRxBatchSize() packets from one radio with a single
+  // recvmmsg() into the consecutive free rx slots from rx_slot, return the
+  // number received. Only a full ring (no free slot at rx_slot) is an error.
+  size_t RecvEnqueueBatch(size_t tid, size_t radio_id, size_t rx_slot);
 
   void LoopTxRxArgos(size_t tid);
   size_t DequeueSendArgos(int tid, long long time0);
@@ -166,6 +181,42 @@ class PacketTXRX {
   std::vector<std::vector<RxPacket>> rx_packets_;
 #endif  // defined(USE_DPDK)
 
+  // Per socket_thread scratch space for batched receive
+  std::vector<std::vector<uint8_t*>> rx_batch_bufs_;
+  std::vector<std::vector<size_t>> rx_batch_lens_;
+  std::vector<std::vector<EventData>> rx_batch_events_;
+
+  // Per socket_thread scratch space for dequeued tx events and batched send
+  std::vector<std::vector<EventData>> tx_events_;
+  std::vector<std::vector<const uint8_t*>> tx_batch_msgs_;
+  std::vector<std::vector<uint16_t>> tx_batch_ports_;
+
+#if defined(USE_AF_XDP)
+  // Give the kernel free rx slots of thread [tid] to receive into
+  void XdpFill(size_t tid);
+  // Copy one payload into a tx frame of thread [tid] and queue it
+  void XdpStage(size_t tid, const uint8_t* payload, size_t len,
+                uint16_t src_port, uint16_t dst_port);
+  // Submit the staged tx frames of thread [tid]
+  void XdpFlush(size_t tid);
+
+  std::unique_ptr<XdpRedirectProgram> xdp_program_;
+  // Dimension 1: socket_thread
+  std::vector<std::unique_ptr<XdpTransport>> xdp_sockets_;
+  struct sockaddr_storage xdp_server_addr_;
+  struct sockaddr_storage xdp_rru_addr_;
+  size_t xdp_hdr_len_;
+  uint8_t xdp_local_mac_[kMacAddrLen];
+  // Learned from received packets, broadcast until the first packet arrives
+  std::vector<std::array<uint8_t, kMacAddrLen>> xdp_remote_macs_;
+  // Next rx slot to give to the kernel and number of slots it holds
+  std::vector<size_t> xdp_fill_slot_;
+  std::vector<size_t> xdp_filled_;
+  std::vector<std::vector<struct xdp_desc>> xdp_rx_descs_;
+  std::vector<std::vector<struct xdp_desc>> xdp_tx_descs_;
+  std::vector<std::vector<uint64_t>> xdp_tx_free_frames_;
+#endif  // defined(USE_AF_XDP)
+
   std::unique_ptr<RadioConfig> radioconfig_;  // Used only in Argos mode
 };
 
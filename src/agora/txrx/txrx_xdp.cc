@@ -0,0 +1,393 @@
+/**
+ * @file txrx_xdp.cc
+ * @brief Implementation of PacketTXRX datapath functions for communicating
+ * with simulators over AF_XDP sockets. Each socket thread's row of the
+ * socket buffer is registered as the UMEM of its AF_XDP socket, so received
+ * packets are placed directly in the RxPacket slots handed to the master.
+ */
+
+#include <chrono>
+
+#include "logger.h"
+#include "txrx.h"
+
+static constexpr bool kEnableSlowStart = true;
+static constexpr bool kDebugPrintBeacon = false;
+
+static constexpr size_t kSlowStartMulStage1 = 32;
+static constexpr size_t kSlowStartMulStage2 = 8;
+
+PacketTXRX::PacketTXRX(Config* cfg, size_t core_offset)
+    : cfg_(cfg),
+      core_offset_(core_offset),
+      ant_per_cell_(cfg->BsAntNum() / cfg->NumCells()),
+      socket_thread_num_(cfg->SocketThreadNum()) {
+  RtAssert(cfg_->XdpInterface().empty() == false,
+           "xdp_interface must be set in AF_XDP mode");
+  xdp_server_addr_ = XdpTransport::ParseAddr(cfg_->BsServerAddr());
+  xdp_rru_addr_ = XdpTransport::ParseAddr(cfg_->BsRruAddr());
+  RtAssert(xdp_server_addr_.ss_family == xdp_rru_addr_.ss_family,
+           "Server and RRU addresses must be of the same IP version");
+  xdp_hdr_len_ =
+      (xdp_server_addr_.ss_family == AF_INET) ? kXdpIpv4HdrLen : kXdpIpv6HdrLen;
+  XdpTransport::GetMacAddr(cfg_->XdpInterface(), xdp_local_mac_);
+}
+
+PacketTXRX::PacketTXRX(Config* cfg, size_t core_offset,
+                       moodycamel::ConcurrentQueue<EventData>* queue_message,
+                       moodycamel::ConcurrentQueue<EventData>* queue_task,
+                       moodycamel::ProducerToken** rx_ptoks,
+                       moodycamel::ProducerToken** tx_ptoks)
+    : PacketTXRX(cfg, core_offset) {
+  message_queue_ = queue_message;
+  task_queue_ = queue_task;
+  rx_ptoks_ = rx_ptoks;
+  tx_ptoks_ = tx_ptoks;
+}
+
+PacketTXRX::~PacketTXRX() {
+  for (auto& worker : socket_std_threads_) {
+    if (worker.joinable() == true) {
+      worker.join();
+    }
+  }
+  // Release the UMEMs before Agora frees the socket buffer
+  xdp_sockets_.clear();
+  xdp_program_.reset();
+  MLPD_INFO("PacketTXRX workers joined\n");
+}
+
+bool PacketTXRX::StartTxRx(Table<char>& buffer, size_t packet_num_in_buffer,
+                           Table<size_t>& frame_start, char* tx_buffer,
+                           Table<complex_float>& calib_dl_buffer,
+                           Table<complex_float>& calib_ul_buffer) {
+  unused(calib_dl_buffer);
+  unused(calib_ul_buffer);
+
+  frame_start_ = &frame_start;
+  tx_buffer_ = tx_buffer;
+  threads_started_ = 0;
+
+  const size_t frame_size = cfg_->XdpFrameSize();
+  // Place received packets so that Packet::data_ is 64-byte aligned
+  const size_t rx_offset =
+      Roundup<64>(XDP_PACKET_HEADROOM + xdp_hdr_len_) - xdp_hdr_len_;
+  const size_t frame_headroom = rx_offset - XDP_PACKET_HEADROOM;
+  RtAssert(rx_offset + xdp_hdr_len_ + cfg_->PacketLength() <= frame_size,
+           "Packet length " + std::to_string(cfg_->PacketLength()) +
+               " does not fit in an XDP frame of " +
+               std::to_string(frame_size) + " bytes");
+  RtAssert(xdp_hdr_len_ + cfg_->DlPacketLength() <= frame_size,
+           "Downlink packet length does not fit in an XDP frame");
+  RtAssert(packet_num_in_buffer > kXdpTxFrames,
+           "Socket buffer is too small for AF_XDP");
+
+  RtAssert(cfg_->XdpQueueOffset() + socket_thread_num_ <= kXdpMaxQueues,
+           "AF_XDP queues beyond " + std::to_string(kXdpMaxQueues) +
+               " are not supported");
+
+  // The last kXdpTxFrames frames of each UMEM are used for transmission
+  buffers_per_socket_ = packet_num_in_buffer - kXdpTxFrames;
+
+  // Only Agora's packets are redirected to the sockets, the kernel still
+  // answers ARP and neighbor discovery on the interface
+  xdp_program_ = std::make_unique<XdpRedirectProgram>(
+      cfg_->XdpInterface(), cfg_->XdpGenericMode(), cfg_->BsServerPort(),
+      cfg_->NumRadios());
+
+  rx_packets_.resize(socket_thread_num_);
+  rx_batch_events_.resize(socket_thread_num_);
+  tx_events_.resize(socket_thread_num_);
+  xdp_remote_macs_.resize(socket_thread_num_);
+  xdp_fill_slot_.assign(socket_thread_num_, 0);
+  xdp_filled_.assign(socket_thread_num_, 0);
+  xdp_rx_descs_.resize(socket_thread_num_);
+  xdp_tx_descs_.resize(socket_thread_num_);
+  xdp_tx_free_frames_.resize(socket_thread_num_);
+  for (size_t i = 0; i < socket_thread_num_; i++) {
+    xdp_sockets_.emplace_back(std::make_unique<XdpTransport>(
+        cfg_->XdpInterface(), cfg_->XdpQueueOffset() + i, buffer[i],
+        packet_num_in_buffer * frame_size, frame_size, frame_headroom,
+        xdp_program_->XsksMapFd(), cfg_->XdpZeroCopy()));
+
+    rx_packets_.at(i).reserve(buffers_per_socket_);
+    for (size_t number_packets = 0; number_packets < buffers_per_socket_;
+         number_packets++) {
+      auto* pkt_loc = reinterpret_cast<Packet*>(
+          buffer[i] + (number_packets * frame_size) + rx_offset +
+          xdp_hdr_len_);
+      rx_packets_.at(i).emplace_back(pkt_loc);
+    }
+    for (size_t frame = buffers_per_socket_; frame < packet_num_in_buffer;
+         frame++) {
+      xdp_tx_free_frames_.at(i).push_back(frame * frame_size);
+    }
+    xdp_remote_macs_.at(i).fill(0xff);
+    rx_batch_events_.at(i).resize(kXdpBatchSize);
+    tx_events_.at(i).resize((cfg_->BsAntNum() / socket_thread_num_) + 1);
+    xdp_rx_descs_.at(i).resize(kXdpBatchSize);
+    xdp_tx_descs_.at(i).reserve(kXdpTxFrames);
+
+    MLPD_SYMBOL("LoopTXRX: Starting AF_XDP thread %zu\n", i);
+    socket_std_threads_.emplace_back(&PacketTXRX::LoopTxRx, this, i);
+  }
+
+  while (threads_started_.load() != socket_std_threads_.size()) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  MLPD_INFO("LoopTXRX: AF_XDP socket threads are waiting for events\n");
+  return true;
+}
+
+void PacketTXRX::TxBeacon(int tid, size_t frame_id) {
+  size_t radio_lo = tid * cfg_->NumRadios() / socket_thread_num_;
+  size_t radio_hi = (tid + 1) * cfg_->NumRadios() / socket_thread_num_;
+
+  // Send a beacon packet in the downlink to trigger user pilot
+  std::vector<uint8_t> udp_pkt_buf(cfg_->PacketLength(), 0);
+  auto* pkt = reinterpret_cast<Packet*>(&udp_pkt_buf[0]);
+
+  if (kDebugPrintBeacon) {
+    std::printf("TXRX [%d]: Sending beacon for frame %zu\n", tid, frame_id);
+  }
+
+  for (size_t beacon_sym = 0; beacon_sym < cfg_->Frame().NumBeaconSyms();
+       beacon_sym++) {
+    for (size_t ant_id = radio_lo; ant_id < radio_hi; ant_id++) {
+      new (pkt) Packet(frame_id, cfg_->Frame().GetBeaconSymbol(beacon_sym),
+                       0 /* cell_id */, ant_id);
+      XdpStage(tid, udp_pkt_buf.data(), cfg_->PacketLength(),
+               cfg_->BsServerPort() + ant_id, cfg_->BsRruPort() + ant_id);
+    }
+  }
+  XdpFlush(tid);
+}
+
+void PacketTXRX::LoopTxRx(size_t tid) {
+  PinToCoreWithOffset(ThreadType::kWorkerTXRX, core_offset_, tid);
+
+  const double rdtsc_freq = GetTime::MeasureRdtscFreq();
+  const size_t frame_tsc_delta =
+      cfg_->GetFrameDurationSec() * 1e9f * rdtsc_freq;
+  const size_t two_hundred_ms_ticks = (0.2f /* 200 ms */ * 1e9f * rdtsc_freq);
+
+  // Slow start variables (Start with no less than 200 ms)
+  const size_t slow_start_tsc1 =
+      std::max(kSlowStartMulStage1 * frame_tsc_delta, two_hundred_ms_ticks);
+  const size_t slow_start_thresh1 = kFrameWnd;
+  const size_t slow_start_tsc2 = kSlowStartMulStage2 * frame_tsc_delta;
+  const size_t slow_start_thresh2 = kFrameWnd * 4;
+  size_t delay_tsc = kEnableSlowStart ? slow_start_tsc1 : frame_tsc_delta;
+
+  threads_started_.fetch_add(1);
+
+  int prev_frame_id = -1;
+  size_t rx_pkts_total = 0;
+  const size_t rx_rate_start_tsc = GetTime::Rdtsc();
+  size_t tx_frame_id = 0;
+  size_t send_time = delay_tsc + GetTime::Rdtsc();
+  while (cfg_->Running() == true) {
+    if (GetTime::Rdtsc() > send_time) {
+      TxBeacon(tid, tx_frame_id++);
+
+      if (kEnableSlowStart) {
+        if (tx_frame_id == slow_start_thresh1) {
+          delay_tsc = slow_start_tsc2;
+        } else if (tx_frame_id == slow_start_thresh2) {
+          delay_tsc = frame_tsc_delta;
+        }
+      }
+      send_time += delay_tsc;
+    }
+
+    if (0 == DequeueSend(tid)) {
+      rx_pkts_total += XdpRecv(tid, prev_frame_id);
+    }
+  }
+
+  const double rx_sec =
+      GetTime::CyclesToSec(GetTime::Rdtsc() - rx_rate_start_tsc, rdtsc_freq);
+  MLPD_INFO(
+      "LoopTxRx[%zu]: received %zu packets in %.2f sec, %.3f Mpps per core "
+      "(AF_XDP)\n",
+      tid, rx_pkts_total, rx_sec, rx_pkts_total / rx_sec / 1e6);
+}
+
+void PacketTXRX::XdpFill(size_t tid) {
+  size_t& fill_slot = xdp_fill_slot_.at(tid);
+  size_t& filled = xdp_filled_.at(tid);
+  std::array<uint64_t, kXdpBatchSize> addrs;
+
+  // Slots are handed to the kernel in ring order. A slot is refilled once
+  // the workers are done with it and the fill cursor comes back around.
+  size_t num = 0;
+  while ((num < kXdpBatchSize) && (filled + num < kXdpRingSize)) {
+    if (rx_packets_.at(tid).at(fill_slot).Empty() == false) {
+      if (filled + num == 0) {
+        // The kernel has nowhere to receive into
+        MLPD_ERROR("TXRX thread %zu rx_buffer full, offset: %zu\n", tid,
+                   fill_slot);
+        cfg_->Running(false);
+      }
+      break;
+    }
+    addrs.at(num) = fill_slot * cfg_->XdpFrameSize();
+    num++;
+    fill_slot = (fill_slot + 1) % buffers_per_socket_;
+  }
+  if (num > 0) {
+    RtAssert(xdp_sockets_.at(tid)->Fill(addrs.data(), num) == num,
+             "AF_XDP fill ring overflow");
+    filled += num;
+  }
+}
+
+size_t PacketTXRX::XdpRecv(size_t tid, int& prev_frame_id) {
+  XdpFill(tid);
+
+  XdpTransport* xsk = xdp_sockets_.at(tid).get();
+  std::vector<struct xdp_desc>& descs = xdp_rx_descs_.at(tid);
+  std::vector<EventData>& events = rx_batch_events_.at(tid);
+  const size_t num_rx = xsk->Recv(descs.data(), descs.size());
+  xdp_filled_.at(tid) -= num_rx;
+
+  size_t num_events = 0;
+  for (size_t i = 0; i < num_rx; i++) {
+    const struct xdp_desc& desc = descs.at(i);
+    RxPacket& rx = rx_packets_.at(tid).at(desc.addr / cfg_->XdpFrameSize());
+    uint8_t* frame = xsk->Data(desc.addr);
+
+    uint16_t dst_port;
+    size_t payload_len;
+    const uint8_t* payload = XdpTransport::ParseUdp(
+        frame, desc.len, xdp_server_addr_, &dst_port, &payload_len);
+    // Frames that are not Agora packets (e.g., sent to another address)
+    // leave their slot empty, it is given back to the kernel on the next pass
+    // of the fill cursor
+    if ((payload != reinterpret_cast<uint8_t*>(rx.RawPacket())) ||
+        (payload_len != cfg_->PacketLength()) ||
+        (dst_port < cfg_->BsServerPort()) ||
+        (dst_port >= cfg_->BsServerPort() + cfg_->NumRadios())) {
+      continue;
+    }
+    std::memcpy(xdp_remote_macs_.at(tid).data(),
+                reinterpret_cast<struct ethhdr*>(frame)->h_source, kMacAddrLen);
+
+    Packet* pkt = rx.RawPacket();
+    if (kDebugPrintInTask) {
+      std::printf("In TXRX thread %zu: Received frame %d, symbol %d, ant %d\n",
+                  tid, pkt->frame_id_, pkt->symbol_id_, pkt->ant_id_);
+    }
+    pkt->ant_id_ += pkt->cell_id_ * ant_per_cell_;
+
+    if (kIsWorkerTimingEnabled) {
+      const int frame_id = pkt->frame_id_;
+      if (frame_id > prev_frame_id) {
+        (*frame_start_)[tid][frame_id % kNumStatsFrames] = GetTime::Rdtsc();
+        prev_frame_id = frame_id;
+      }
+    }
+
+    rx.Use();
+    events.at(num_events) = EventData(EventType::kPacketRX, rx_tag_t(rx).tag_);
+    num_events++;
+  }
+
+  if ((num_events > 0) &&
+      (message_queue_->enqueue_bulk(*rx_ptoks_[tid], events.data(),
+                                    num_events) == false)) {
+    MLPD_ERROR("socket message enqueue failed\n");
+    throw std::runtime_error("PacketTXRX: socket message enqueue failed");
+  }
+  return num_events;
+}
+
+void PacketTXRX::XdpStage(size_t tid, const uint8_t* payload, size_t len,
+                          uint16_t src_port, uint16_t dst_port) {
+  XdpTransport* xsk = xdp_sockets_.at(tid).get();
+  std::vector<uint64_t>& free_frames = xdp_tx_free_frames_.at(tid);
+  while (free_frames.empty()) {
+    // All tx frames are staged or in flight
+    XdpFlush(tid);
+    if (cfg_->Running() == false) {
+      return;
+    }
+  }
+  const uint64_t addr = free_frames.back();
+  free_frames.pop_back();
+
+  uint8_t* frame = xsk->Data(addr);
+  std::memcpy(frame + xdp_hdr_len_, payload, len);
+  struct xdp_desc desc;
+  desc.addr = addr;
+  desc.len = XdpTransport::WriteUdpHeaders(
+      frame, xdp_local_mac_, xdp_remote_macs_.at(tid).data(), xdp_server_addr_,
+      xdp_rru_addr_, src_port, dst_port, len);
+  desc.options = 0;
+  xdp_tx_descs_.at(tid).push_back(desc);
+}
+
+void PacketTXRX::XdpFlush(size_t tid) {
+  XdpTransport* xsk = xdp_sockets_.at(tid).get();
+  std::vector<struct xdp_desc>& descs = xdp_tx_descs_.at(tid);
+  std::vector<uint64_t>& free_frames = xdp_tx_free_frames_.at(tid);
+  std::array<uint64_t, kXdpBatchSize> done;
+
+  size_t num_sent = 0;
+  do {
+    num_sent += xsk->Send(descs.data() + num_sent, descs.size() - num_sent);
+    // Recycle the frames the kernel has finished sending
+    const size_t num_done = xsk->Complete(done.data(), done.size());
+    free_frames.insert(free_frames.end(), done.begin(),
+                       done.begin() + num_done);
+  } while ((num_sent < descs.size()) && (cfg_->Running() == true));
+  descs.clear();
+}
+
+size_t PacketTXRX::DequeueSend(int tid) {
+  std::vector<EventData>& events = tx_events_.at(tid);
+
+  // Single producer ordering in q is preserved
+  const size_t dequeued_items = task_queue_->try_dequeue_bulk_from_producer(
+      *tx_ptoks_[tid], events.data(), events.size());
+  if (dequeued_items == 0) {
+    return 0;
+  }
+
+  for (size_t item = 0; item < dequeued_items; item++) {
+    EventData& current_event = events.at(item);
+    assert(current_event.event_type_ == EventType::kPacketTX);
+
+    const size_t ant_id = gen_tag_t(current_event.tags_[0]).ant_id_;
+    const size_t frame_id = gen_tag_t(current_event.tags_[0]).frame_id_;
+    const size_t symbol_id = gen_tag_t(current_event.tags_[0]).symbol_id_;
+
+    const size_t data_symbol_idx_dl = cfg_->Frame().GetDLSymbolIdx(symbol_id);
+    const size_t offset =
+        (cfg_->GetTotalDataSymbolIdxDl(frame_id, data_symbol_idx_dl) *
+         cfg_->BsAntNum()) +
+        ant_id;
+
+    if (kDebugPrintInTask) {
+      std::printf(
+          "PacketTXRX[%d]: Transmitted frame %zu, symbol %zu, ant %zu, "
+          "offset: %zu\n",
+          tid, frame_id, symbol_id, ant_id, offset);
+    }
+
+    auto* pkt =
+        reinterpret_cast<Packet*>(&tx_buffer_[offset * cfg_->DlPacketLength()]);
+    new (pkt) Packet(frame_id, symbol_id, 0 /* cell_id */, ant_id);
+
+    // Stage data (one OFDM symbol), all staged packets are sent below
+    XdpStage(tid, reinterpret_cast<uint8_t*>(pkt), cfg_->DlPacketLength(),
+             cfg_->BsServerPort() + ant_id, cfg_->BsRruPort() + ant_id);
+    current_event = EventData(EventType::kPacketTX, current_event.tags_[0]);
+  }
+  XdpFlush(tid);
+
+  RtAssert(message_queue_->enqueue_bulk(*rx_ptoks_[tid], events.data(),
+                                        dequeued_items),
+           "Socket message enqueue failed\n");
+  return dequeued_items;
+}
@@ -0,0 +1,84 @@
+/**
+ * @file work_stealing_scheduler.cc
+ * @brief Implementation file for the WorkStealingScheduler class
+ */
+#include "work_stealing_scheduler.h"
+
+#include "utils.h"
+
+WorkStealingScheduler::WorkStealingScheduler(
+    size_t num_workers, const std::vector<EventType>& priorities)
+    : num_workers_(num_workers), priorities_(priorities) {
+  RtAssert(num_workers_ > 0, "Work stealing scheduler needs workers");
+  priority_.fill(SIZE_MAX);
+  for (size_t i = 0; i < priorities_.size(); i++) {
+    priority_.at(static_cast<size_t>(priorities_.at(i))) = i;
+  }
+
+  for (size_t i = 0; i < num_workers_; i++) {
+    workers_.push_back(std::make_unique<WorkerDeques>());
+  }
+
+  // Visit the workers at distance 1, 2, ... alternating between the higher
+  // and the lower worker IDs
+  steal_order_.resize(num_workers_);
+  for (size_t i = 0; i < num_workers_; i++) {
+    for (size_t dist = 1; dist < num_workers_; dist++) {
+      if (i + dist < num_workers_) {
+        steal_order_.at(i).push_back(i + dist);
+      }
+      if (i >= dist) {
+        steal_order_.at(i).push_back(i - dist);
+      }
+    }
+  }
+}
+
+void WorkStealingScheduler::Push(size_t worker_id, size_t qid,
+                                 const EventData& event) {
+  const size_t priority = priority_.at(static_cast<size_t>(event.event_type_));
+  RtAssert(priority != SIZE_MAX, "Event type not handled by the scheduler");
+
+  WorkerDeques& worker = *workers_.at(worker_id % num_workers_);
+  std::scoped_lock lock(worker.mutex_);
+  worker.deques_.at(qid).at(priority).push_back(event);
+  worker.num_tasks_.at(qid)++;
+}
+
+bool WorkStealingScheduler::PopFrom(size_t worker_id, size_t qid,
+                                    EventData& event) {
+  WorkerDeques& worker = *workers_.at(worker_id);
+  if (worker.num_tasks_.at(qid).load(std::memory_order_relaxed) == 0) {
+    return false;
+  }
+
+  std::scoped_lock lock(worker.mutex_);
+  for (size_t priority = 0; priority < priorities_.size(); priority++) {
+    auto& deque = worker.deques_.at(qid).at(priority);
+    if (deque.empty() == false) {
+      event = deque.front();
+      deque.pop_front();
+      worker.num_tasks_.at(qid)--;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool WorkStealingScheduler::Pop(size_t worker_id, size_t first_qid,
+                                EventData& event, size_t& qid, bool& stolen) {
+  for (size_t i = 0; i < kNumQueueSets; i++) {
+    qid = (first_qid + i) % kNumQueueSets;
+    if (PopFrom(worker_id, qid, event) == true) {
+      stolen = false;
+      return true;
+    }
+    for (size_t victim : steal_order_.at(worker_id)) {
+      if (PopFrom(victim, qid, event) == true) {
+        stolen = true;
+        return true;
+      }
+    }
+  }
+  return false;
+}
@@ -0,0 +1,79 @@
+/**
+ * @file work_stealing_scheduler.h
+ * @brief Declaration file for the WorkStealingScheduler class. Each worker
+ * owns a set of task deques, and idle workers steal tasks from the deques of
+ * the nearest workers first.
+ */
+#ifndef WORK_STEALING_SCHEDULER_H_
+#define WORK_STEALING_SCHEDULER_H_
+
+#include <array>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "buffer.h"
+#include "symbols.h"
+
+class WorkStealingScheduler {
+ public:
+  // One set of deques per frame parity, as with the Agora schedule queues
+  static constexpr size_t kNumQueueSets = 2;
+
+  /**
+   * @brief Create the deques of [num_workers] workers
+   * @param priorities Event types from the highest priority to the lowest.
+   * Workers run tasks of higher priority event types first.
+   */
+  WorkStealingScheduler(size_t num_workers,
+                        const std::vector<EventType>& priorities);
+
+  /// Add [event] to the deque of worker [worker_id] for queue set [qid].
+  /// Safe to call from any thread.
+  void Push(size_t worker_id, size_t qid, const EventData& event);
+
+  /**
+   * @brief Get a task for worker [worker_id], looking at queue set
+   * [first_qid] before the other one. Within a queue set, the worker's own
+   * deques come first, then the deques of the other workers by distance.
+   *
+   * @param event The task
+   * @param qid The queue set of the task
+   * @param stolen Set to true if the task was taken from another worker
+   * @return False if there are no tasks
+   */
+  bool Pop(size_t worker_id, size_t first_qid, EventData& event, size_t& qid,
+           bool& stolen);
+
+  inline size_t NumWorkers() const { return this->num_workers_; }
+
+ private:
+  struct alignas(64) WorkerDeques {
+    std::mutex mutex_;
+    // Number of tasks in each queue set, read without the lock to skip
+    // empty workers
+    std::array<std::atomic<size_t>, kNumQueueSets> num_tasks_;
+    std::array<std::array<std::deque<EventData>, kNumEventTypes>,
+               kNumQueueSets>
+        deques_;
+
+    WorkerDeques() : num_tasks_() {}
+  };
+
+  /// Take the oldest task of the highest priority from worker [worker_id]
+  bool PopFrom(size_t worker_id, size_t qid, EventData& event);
+
+  const size_t num_workers_;
+  // Priority level of each event type, 0 is the highest
+  std::array<size_t, kNumEventTypes> priority_;
+  // Event types ordered by priority
+  std::vector<EventType> priorities_;
+  std::vector<std::unique_ptr<WorkerDeques>> workers_;
+  // steal_order_[i] lists the other workers by distance from worker i.
+  // Workers run on consecutive cores, so near workers share caches.
+  std::vector<std::vector<size_t>> steal_order_;
+};
+
+#endif  // WORK_STEALING_SCHEDULER_H_
@@ -0,0 +1,59 @@
+/**
+ * @file zf_reuse_state.h
+ * @brief Declaration file for the ZfReuseState class, which lets ZF tasks
+ * reuse the ZF matrices of the previous frame when the CSI barely changed
+ */
+#ifndef ZF_REUSE_STATE_H_
+#define ZF_REUSE_STATE_H_
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "symbols.h"
+
+/// State shared by the ZF tasks of all workers. For each frame slot and ZF
+/// block, it records which frame's ZF task completed the block and which
+/// frame's CSI its matrices were computed from.
+class ZfReuseState {
+ public:
+  explicit ZfReuseState(size_t num_blocks) {
+    for (size_t i = 0; i < kFrameWnd; i++) {
+      done_frame_.at(i) = std::vector<std::atomic<size_t>>(num_blocks);
+      csi_frame_.at(i) = std::vector<std::atomic<size_t>>(num_blocks);
+      for (size_t j = 0; j < num_blocks; j++) {
+        done_frame_.at(i).at(j) = SIZE_MAX;
+        csi_frame_.at(i).at(j) = SIZE_MAX;
+      }
+    }
+  }
+
+  /// Record that the ZF matrices of [block] in [frame_id] are ready, and
+  /// were computed from the CSI of [csi_frame_id]
+  inline void SetDone(size_t frame_id, size_t block, size_t csi_frame_id) {
+    const size_t frame_slot = frame_id % kFrameWnd;
+    csi_frame_.at(frame_slot).at(block).store(csi_frame_id,
+                                              std::memory_order_relaxed);
+    done_frame_.at(frame_slot).at(block).store(frame_id,
+                                               std::memory_order_release);
+  }
+
+  /// Return the frame whose CSI the ZF matrices of [block] in [frame_id]
+  /// were computed from, or SIZE_MAX if they are not ready
+  inline size_t GetCsiFrame(size_t frame_id, size_t block) const {
+    const size_t frame_slot = frame_id % kFrameWnd;
+    if (done_frame_.at(frame_slot).at(block).load(std::memory_order_acquire) !=
+        frame_id) {
+      return SIZE_MAX;
+    }
+    return csi_frame_.at(frame_slot).at(block).load(std::memory_order_relaxed);
+  }
+
+ private:
+  std::array<std::vector<std::atomic<size_t>>, kFrameWnd> done_frame_;
+  std::array<std::vector<std::atomic<size_t>>, kFrameWnd> csi_frame_;
+};
+
+#endif  // ZF_REUSE_STATE_H_
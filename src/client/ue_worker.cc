@@ -434,6 +434,13 @@ void UeWorker::DoDemul(size_t tag) {
     case (CommsLib::kQaM64):
       Demod64qamSoftAvx2(equal_ptr, demod_ptr, config_.OfdmDataNum());
       break;
+    case (CommsLib::kQaM256):
+#ifdef __AVX512F__
+      Demod256qamSoftAvx512(equal_ptr, demod_ptr, config_.OfdmDataNum());
+#else
+      Demod256qamSoftAvx2(equal_ptr, demod_ptr, config_.OfdmDataNum());
+#endif
+      break;
     default:
       std::printf("UeWorker[%zu]: Demul - modulation type %s not supported!\n",
                   tid_, config_.Modulation().c_str());
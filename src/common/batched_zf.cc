@@ -0,0 +1,309 @@
+/**
+ * @file batched_zf.cc
+ * @brief Implementation file for the BatchedZf class
+ */
+#include "batched_zf.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+#include "memory_manage.h"
+
+// Pivots of the Cholesky factorization smaller than this fraction of the
+// Gram matrix diagonal mark a subcarrier as failed
+static constexpr float kMinRelativePivot = 1e-6f;
+
+#ifdef __AVX512F__
+using SimdFloat = __m512;
+static inline SimdFloat SimdLoad(const float* p) { return _mm512_load_ps(p); }
+static inline void SimdStore(float* p, SimdFloat v) { _mm512_store_ps(p, v); }
+static inline SimdFloat SimdSet1(float x) { return _mm512_set1_ps(x); }
+static inline SimdFloat SimdZero() { return _mm512_setzero_ps(); }
+static inline SimdFloat SimdMul(SimdFloat a, SimdFloat b) {
+  return _mm512_mul_ps(a, b);
+}
+static inline SimdFloat SimdAdd(SimdFloat a, SimdFloat b) {
+  return _mm512_add_ps(a, b);
+}
+static inline SimdFloat SimdSub(SimdFloat a, SimdFloat b) {
+  return _mm512_sub_ps(a, b);
+}
+static inline SimdFloat SimdDiv(SimdFloat a, SimdFloat b) {
+  return _mm512_div_ps(a, b);
+}
+static inline SimdFloat SimdSqrt(SimdFloat a) { return _mm512_sqrt_ps(a); }
+static inline SimdFloat SimdMin(SimdFloat a, SimdFloat b) {
+  return _mm512_min_ps(a, b);
+}
+static inline SimdFloat SimdMax(SimdFloat a, SimdFloat b) {
+  return _mm512_max_ps(a, b);
+}
+/// a * b + c
+static inline SimdFloat SimdFmadd(SimdFloat a, SimdFloat b, SimdFloat c) {
+  return _mm512_fmadd_ps(a, b, c);
+}
+/// c - a * b
+static inline SimdFloat SimdFnmadd(SimdFloat a, SimdFloat b, SimdFloat c) {
+  return _mm512_fnmadd_ps(a, b, c);
+}
+/// Bit mask of the lanes where a > b
+static inline size_t SimdGreater(SimdFloat a, SimdFloat b) {
+  return _mm512_cmp_ps_mask(a, b, _CMP_GT_OQ);
+}
+/// Take a in the lanes set in mask, and b elsewhere
+static inline SimdFloat SimdSelect(size_t mask, SimdFloat a, SimdFloat b) {
+  return _mm512_mask_blend_ps(static_cast<__mmask16>(mask), b, a);
+}
+#else
+using SimdFloat = __m256;
+static inline SimdFloat SimdLoad(const float* p) { return _mm256_load_ps(p); }
+static inline void SimdStore(float* p, SimdFloat v) { _mm256_store_ps(p, v); }
+static inline SimdFloat SimdSet1(float x) { return _mm256_set1_ps(x); }
+static inline SimdFloat SimdZero() { return _mm256_setzero_ps(); }
+static inline SimdFloat SimdMul(SimdFloat a, SimdFloat b) {
+  return _mm256_mul_ps(a, b);
+}
+static inline SimdFloat SimdAdd(SimdFloat a, SimdFloat b) {
+  return _mm256_add_ps(a, b);
+}
+static inline SimdFloat SimdSub(SimdFloat a, SimdFloat b) {
+  return _mm256_sub_ps(a, b);
+}
+static inline SimdFloat SimdDiv(SimdFloat a, SimdFloat b) {
+  return _mm256_div_ps(a, b);
+}
+static inline SimdFloat SimdSqrt(SimdFloat a) { return _mm256_sqrt_ps(a); }
+static inline SimdFloat SimdMin(SimdFloat a, SimdFloat b) {
+  return _mm256_min_ps(a, b);
+}
+static inline SimdFloat SimdMax(SimdFloat a, SimdFloat b) {
+  return _mm256_max_ps(a, b);
+}
+/// a * b + c
+static inline SimdFloat SimdFmadd(SimdFloat a, SimdFloat b, SimdFloat c) {
+  return _mm256_fmadd_ps(a, b, c);
+}
+/// c - a * b
+static inline SimdFloat SimdFnmadd(SimdFloat a, SimdFloat b, SimdFloat c) {
+  return _mm256_fnmadd_ps(a, b, c);
+}
+/// Bit mask of the lanes where a > b
+static inline size_t SimdGreater(SimdFloat a, SimdFloat b) {
+  return _mm256_movemask_ps(_mm256_cmp_ps(a, b, _CMP_GT_OQ));
+}
+/// Take a in the lanes set in mask, and b elsewhere
+static inline SimdFloat SimdSelect(size_t mask, SimdFloat a, SimdFloat b) {
+  const __m256i bits = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+  const __m256i sel = _mm256_and_si256(
+      _mm256_set1_epi32(static_cast<int>(mask)), bits);
+  return _mm256_blendv_ps(
+      b, a, _mm256_castsi256_ps(_mm256_cmpeq_epi32(sel, bits)));
+}
+#endif
+static constexpr size_t kAllLanes = (1ul << BatchedZf::kLanes) - 1;
+
+static float* AllocLanes(size_t num_vectors) {
+  const size_t size = num_vectors * BatchedZf::kLanes * sizeof(float);
+  auto* buf = static_cast<float*>(Agora_memory::PaddedAlignedAlloc(
+      Agora_memory::Alignment_t::kAlign64, size));
+  std::memset(buf, 0, size);
+  return buf;
+}
+
+BatchedZf::BatchedZf(size_t bs_ant_num, size_t ue_ant_num, size_t max_sc_num)
+    : bs_ant_num_(bs_ant_num),
+      ue_ant_num_(ue_ant_num),
+      max_sc_num_(max_sc_num),
+      min_pivot_(max_sc_num, 0.0f),
+      max_pivot_(max_sc_num, 0.0f),
+      failed_(max_sc_num, false) {
+  if (ue_ant_num_ > bs_ant_num_) {
+    throw std::runtime_error("BatchedZf: more user than BS antennas");
+  }
+  const size_t num_groups = (max_sc_num_ + kLanes - 1) / kLanes;
+  const size_t mat_size = num_groups * bs_ant_num_ * ue_ant_num_;
+  csi_re_ = AllocLanes(mat_size);
+  csi_im_ = AllocLanes(mat_size);
+  zf_re_ = AllocLanes(mat_size);
+  zf_im_ = AllocLanes(mat_size);
+  gram_re_ = AllocLanes(ue_ant_num_ * ue_ant_num_);
+  gram_im_ = AllocLanes(ue_ant_num_ * ue_ant_num_);
+  inv_diag_ = AllocLanes(ue_ant_num_);
+  sol_re_ = AllocLanes(ue_ant_num_);
+  sol_im_ = AllocLanes(ue_ant_num_);
+}
+
+BatchedZf::~BatchedZf() {
+  std::free(csi_re_);
+  std::free(csi_im_);
+  std::free(zf_re_);
+  std::free(zf_im_);
+  std::free(gram_re_);
+  std::free(gram_im_);
+  std::free(inv_diag_);
+  std::free(sol_re_);
+  std::free(sol_im_);
+}
+
+size_t BatchedZf::Compute(size_t sc_num, float regularization) {
+  if (sc_num > max_sc_num_) {
+    throw std::runtime_error("BatchedZf: too many subcarriers");
+  }
+  for (size_t group = 0; group < (sc_num + kLanes - 1) / kLanes; group++) {
+    ComputeGroup(group, regularization);
+  }
+  return std::count(failed_.begin(), failed_.begin() + sc_num, true);
+}
+
+void BatchedZf::ComputeGroup(size_t group, float regularization) {
+  const size_t num_elems = bs_ant_num_ * ue_ant_num_;
+  const float* h_re = csi_re_ + group * num_elems * kLanes;
+  const float* h_im = csi_im_ + group * num_elems * kLanes;
+  float* w_re = zf_re_ + group * num_elems * kLanes;
+  float* w_im = zf_im_ + group * num_elems * kLanes;
+  auto lane = [](size_t idx) { return idx * kLanes; };
+
+  // Lower triangle of the Gram matrix, G(i, j) = sum_b conj(H(b, i)) * H(b, j)
+  for (size_t i = 0; i < ue_ant_num_; i++) {
+    for (size_t j = 0; j <= i; j++) {
+      SimdFloat acc_re = SimdZero();
+      SimdFloat acc_im = SimdZero();
+      for (size_t b = 0; b < bs_ant_num_; b++) {
+        const SimdFloat hi_re = SimdLoad(h_re + lane(b * ue_ant_num_ + i));
+        const SimdFloat hi_im = SimdLoad(h_im + lane(b * ue_ant_num_ + i));
+        const SimdFloat hj_re = SimdLoad(h_re + lane(b * ue_ant_num_ + j));
+        const SimdFloat hj_im = SimdLoad(h_im + lane(b * ue_ant_num_ + j));
+        acc_re = SimdFmadd(hi_re, hj_re, SimdFmadd(hi_im, hj_im, acc_re));
+        acc_im = SimdFmadd(hi_re, hj_im, SimdFnmadd(hi_im, hj_re, acc_im));
+      }
+      SimdStore(gram_re_ + lane(i * ue_ant_num_ + j), acc_re);
+      SimdStore(gram_im_ + lane(i * ue_ant_num_ + j), acc_im);
+    }
+  }
+
+  if (regularization > 0) {
+    SimdFloat trace = SimdZero();
+    for (size_t j = 0; j < ue_ant_num_; j++) {
+      trace = SimdAdd(trace, SimdLoad(gram_re_ + lane(j * ue_ant_num_ + j)));
+    }
+    const SimdFloat diag_load =
+        SimdMul(trace, SimdSet1(regularization / ue_ant_num_));
+    for (size_t j = 0; j < ue_ant_num_; j++) {
+      float* g_jj = gram_re_ + lane(j * ue_ant_num_ + j);
+      SimdStore(g_jj, SimdAdd(SimdLoad(g_jj), diag_load));
+    }
+  }
+
+  // In-place Cholesky factorization G = L * L'. Failed lanes continue with a
+  // unit pivot so that they do not produce NaNs.
+  size_t ok_mask = kAllLanes;
+  SimdFloat min_pivot = SimdSet1(std::numeric_limits<float>::max());
+  SimdFloat max_pivot = SimdZero();
+  for (size_t j = 0; j < ue_ant_num_; j++) {
+    const SimdFloat g_jj = SimdLoad(gram_re_ + lane(j * ue_ant_num_ + j));
+    SimdFloat pivot = g_jj;
+    for (size_t k = 0; k < j; k++) {
+      const SimdFloat l_re = SimdLoad(gram_re_ + lane(j * ue_ant_num_ + k));
+      const SimdFloat l_im = SimdLoad(gram_im_ + lane(j * ue_ant_num_ + k));
+      pivot = SimdFnmadd(l_re, l_re, SimdFnmadd(l_im, l_im, pivot));
+    }
+    const size_t pivot_ok =
+        SimdGreater(pivot, SimdMul(g_jj, SimdSet1(kMinRelativePivot)));
+    ok_mask &= pivot_ok;
+    pivot = SimdSelect(pivot_ok, pivot, SimdSet1(1.0f));
+    min_pivot = SimdMin(min_pivot, pivot);
+    max_pivot = SimdMax(max_pivot, pivot);
+    const SimdFloat inv_diag = SimdDiv(SimdSet1(1.0f), SimdSqrt(pivot));
+    SimdStore(inv_diag_ + lane(j), inv_diag);
+
+    for (size_t i = j + 1; i < ue_ant_num_; i++) {
+      SimdFloat acc_re = SimdLoad(gram_re_ + lane(i * ue_ant_num_ + j));
+      SimdFloat acc_im = SimdLoad(gram_im_ + lane(i * ue_ant_num_ + j));
+      for (size_t k = 0; k < j; k++) {
+        // acc -= L(i, k) * conj(L(j, k))
+        const SimdFloat a_re = SimdLoad(gram_re_ + lane(i * ue_ant_num_ + k));
+        const SimdFloat a_im = SimdLoad(gram_im_ + lane(i * ue_ant_num_ + k));
+        const SimdFloat b_re = SimdLoad(gram_re_ + lane(j * ue_ant_num_ + k));
+        const SimdFloat b_im = SimdLoad(gram_im_ + lane(j * ue_ant_num_ + k));
+        acc_re = SimdFnmadd(a_re, b_re, SimdFnmadd(a_im, b_im, acc_re));
+        acc_im = SimdFnmadd(a_im, b_re, SimdFmadd(a_re, b_im, acc_im));
+      }
+      SimdStore(gram_re_ + lane(i * ue_ant_num_ + j),
+                SimdMul(acc_re, inv_diag));
+      SimdStore(gram_im_ + lane(i * ue_ant_num_ + j),
+                SimdMul(acc_im, inv_diag));
+    }
+  }
+
+  // Solve L * L' * W(:, b) = conj(H(b, :))' for each BS antenna b
+  for (size_t b = 0; b < bs_ant_num_; b++) {
+    // Forward substitution, L * y = conj(H(b, :))'
+    for (size_t i = 0; i < ue_ant_num_; i++) {
+      SimdFloat acc_re = SimdLoad(h_re + lane(b * ue_ant_num_ + i));
+      SimdFloat acc_im =
+          SimdSub(SimdZero(), SimdLoad(h_im + lane(b * ue_ant_num_ + i)));
+      for (size_t k = 0; k < i; k++) {
+        // acc -= L(i, k) * y(k)
+        const SimdFloat l_re = SimdLoad(gram_re_ + lane(i * ue_ant_num_ + k));
+        const SimdFloat l_im = SimdLoad(gram_im_ + lane(i * ue_ant_num_ + k));
+        const SimdFloat y_re = SimdLoad(sol_re_ + lane(k));
+        const SimdFloat y_im = SimdLoad(sol_im_ + lane(k));
+        acc_re = SimdFnmadd(l_re, y_re, SimdFmadd(l_im, y_im, acc_re));
+        acc_im = SimdFnmadd(l_re, y_im, SimdFnmadd(l_im, y_re, acc_im));
+      }
+      const SimdFloat inv_diag = SimdLoad(inv_diag_ + lane(i));
+      SimdStore(sol_re_ + lane(i), SimdMul(acc_re, inv_diag));
+      SimdStore(sol_im_ + lane(i), SimdMul(acc_im, inv_diag));
+    }
+    // Backward substitution, L' * x = y, in place
+    for (size_t i = ue_ant_num_; i-- > 0;) {
+      SimdFloat acc_re = SimdLoad(sol_re_ + lane(i));
+      SimdFloat acc_im = SimdLoad(sol_im_ + lane(i));
+      for (size_t k = i + 1; k < ue_ant_num_; k++) {
+        // acc -= conj(L(k, i)) * x(k)
+        const SimdFloat l_re = SimdLoad(gram_re_ + lane(k * ue_ant_num_ + i));
+        const SimdFloat l_im = SimdLoad(gram_im_ + lane(k * ue_ant_num_ + i));
+        const SimdFloat x_re = SimdLoad(sol_re_ + lane(k));
+        const SimdFloat x_im = SimdLoad(sol_im_ + lane(k));
+        acc_re = SimdFnmadd(l_re, x_re, SimdFnmadd(l_im, x_im, acc_re));
+        acc_im = SimdFnmadd(l_re, x_im, SimdFmadd(l_im, x_re, acc_im));
+      }
+      const SimdFloat inv_diag = SimdLoad(inv_diag_ + lane(i));
+      acc_re = SimdMul(acc_re, inv_diag);
+      acc_im = SimdMul(acc_im, inv_diag);
+      SimdStore(sol_re_ + lane(i), acc_re);
+      SimdStore(sol_im_ + lane(i), acc_im);
+      SimdStore(w_re + lane(b * ue_ant_num_ + i), acc_re);
+      SimdStore(w_im + lane(b * ue_ant_num_ + i), acc_im);
+    }
+  }
+
+  alignas(64) float min_pivot_lanes[kLanes];
+  alignas(64) float max_pivot_lanes[kLanes];
+  SimdStore(min_pivot_lanes, min_pivot);
+  SimdStore(max_pivot_lanes, max_pivot);
+  for (size_t l = 0; l < kLanes; l++) {
+    const size_t sc_idx = group * kLanes + l;
+    if (sc_idx >= max_sc_num_) {
+      break;
+    }
+    min_pivot_.at(sc_idx) = min_pivot_lanes[l];
+    max_pivot_.at(sc_idx) = max_pivot_lanes[l];
+    failed_.at(sc_idx) = ((ok_mask >> l) & 0x1) == 0;
+  }
+}
+
+float BatchedZf::Rcond(size_t sc_idx) const {
+  return failed_.at(sc_idx) ? 0.0f
+                            : min_pivot_.at(sc_idx) / max_pivot_.at(sc_idx);
+}
+
+void BatchedZf::GetZf(size_t sc_idx, complex_float* mat_zf) const {
+  for (size_t elem = 0; elem < bs_ant_num_ * ue_ant_num_; elem++) {
+    const size_t offset = CsiOffset(sc_idx, elem);
+    mat_zf[elem].re = zf_re_[offset];
+    mat_zf[elem].im = zf_im_[offset];
+  }
+}
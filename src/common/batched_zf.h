@@ -0,0 +1,97 @@
+/**
+ * @file batched_zf.h
+ * @brief Declaration file for the BatchedZf class, which computes the
+ * zeroforcing detectors W = inv(H' * H) * H' of a block of subcarriers at
+ * once with a Cholesky solve vectorized across subcarriers
+ */
+#ifndef BATCHED_ZF_H_
+#define BATCHED_ZF_H_
+
+#include <immintrin.h>
+
+#include <cstddef>
+#include <vector>
+
+#include "common_typedef_sdk.h"
+
+class BatchedZf {
+ public:
+  /// Number of subcarriers processed by one SIMD instruction
+#ifdef __AVX512F__
+  static constexpr size_t kLanes = 16;
+#else
+  static constexpr size_t kLanes = 8;
+#endif
+
+  /// Engine for channel matrices with bs_ant_num rows and ue_ant_num
+  /// columns, and up to max_sc_num subcarriers per batch
+  BatchedZf(size_t bs_ant_num, size_t ue_ant_num, size_t max_sc_num);
+  ~BatchedZf();
+
+  /// Set the channel of base station antenna [ant] and user antenna [ue] at
+  /// subcarrier [sc_idx] of the batch
+  inline void SetCsi(size_t sc_idx, size_t ant, size_t ue, complex_float val) {
+    const size_t offset = CsiOffset(sc_idx, ant * ue_ant_num_ + ue);
+    csi_re_[offset] = val.re;
+    csi_im_[offset] = val.im;
+  }
+
+  /// Compute the zeroforcing detectors of the first sc_num subcarriers of
+  /// the batch. Returns the number of subcarriers whose Gram matrix is not
+  /// numerically positive definite; those must be handled by the caller,
+  /// e.g., with a pseudo-inverse.
+  /// A nonzero regularization computes inv(H' * H + r * I) * H' instead, with
+  /// r = regularization * trace(H' * H) / ue_ant_num for each subcarrier.
+  size_t Compute(size_t sc_num, float regularization = 0.0f);
+
+  /// True if the detector of subcarrier [sc_idx] could not be computed
+  inline bool Failed(size_t sc_idx) const { return failed_.at(sc_idx); }
+
+  /// Estimated reciprocal condition number of the Gram matrix of subcarrier
+  /// [sc_idx], from the ratio of its smallest and largest Cholesky pivots
+  float Rcond(size_t sc_idx) const;
+
+  /// Write the detector of subcarrier [sc_idx] as a column-major
+  /// ue_ant_num x bs_ant_num matrix
+  void GetZf(size_t sc_idx, complex_float* mat_zf) const;
+
+ private:
+  /// Offset of matrix element [elem] of subcarrier [sc_idx] in a buffer with
+  /// (bs_ant_num * ue_ant_num) elements per subcarrier
+  inline size_t CsiOffset(size_t sc_idx, size_t elem) const {
+    return ((sc_idx / kLanes) * bs_ant_num_ * ue_ant_num_ + elem) * kLanes +
+           (sc_idx % kLanes);
+  }
+
+  /// Compute the detectors of one group of kLanes subcarriers
+  void ComputeGroup(size_t group, float regularization);
+
+  const size_t bs_ant_num_;
+  const size_t ue_ant_num_;
+  const size_t max_sc_num_;
+
+  // Structure-of-arrays buffers with kLanes consecutive subcarriers for each
+  // matrix element. The channel matrices are stored in row-major order and
+  // the detectors in column-major order, so both have the same layout.
+  float* csi_re_;
+  float* csi_im_;
+  float* zf_re_;
+  float* zf_im_;
+
+  // Lower triangle of the Gram matrix of one group, factored in place to the
+  // Cholesky factor L, with L * L' = H' * H
+  float* gram_re_;
+  float* gram_im_;
+  // Reciprocals of the diagonal of L of one group
+  float* inv_diag_;
+  // Solution vector of one group
+  float* sol_re_;
+  float* sol_im_;
+
+  // Smallest and largest Cholesky pivots of each subcarrier
+  std::vector<float> min_pivot_;
+  std::vector<float> max_pivot_;
+  std::vector<bool> failed_;
+};
+
+#endif  // BATCHED_ZF_H_
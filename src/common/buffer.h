@@ -348,24 +348,45 @@ class RxCounters {
  * @brief This class stores the counters corresponding to a frame.
  * Specifically, it contains a) the number of symbols per frame
  * and b) the number of tasks per symbol, per frame.
+ *
+ * The counters are atomic so that tasks of a frame can be completed from
+ * several threads (e.g., multiple master threads). Exactly one of the threads
+ * that complete tasks of a symbol sees the last task of that symbol.
  */
 class FrameCounters {
  public:
   FrameCounters() : task_count_(), symbol_count_() {}
 
+  FrameCounters(const FrameCounters &other) : FrameCounters() {
+    *this = other;
+  }
+
+  FrameCounters &operator=(const FrameCounters &other) {
+    this->max_symbol_count_ = other.max_symbol_count_;
+    this->max_task_count_ = other.max_task_count_;
+    for (size_t i = 0; i < kFrameWnd; i++) {
+      this->symbol_count_.at(i) = other.symbol_count_.at(i).load();
+      for (size_t j = 0; j < kMaxSymbols; j++) {
+        this->task_count_.at(i).at(j) = other.task_count_.at(i).at(j).load();
+      }
+    }
+    return *this;
+  }
+
   void Init(size_t max_symbol_count, size_t max_task_count = 0) {
     this->max_symbol_count_ = max_symbol_count;
     this->max_task_count_ = max_task_count;
-    this->symbol_count_.fill(0);
-    for (auto &frame : task_count_) {
-      frame.fill(0);
+    for (size_t i = 0; i < kFrameWnd; i++) {
+      this->Reset(i);
     }
   }
 
   void Reset(size_t frame_id) {
     const size_t frame_slot = (frame_id % kFrameWnd);
     this->symbol_count_.at(frame_slot) = 0;
-    this->task_count_.at(frame_slot).fill(0);
+    for (auto &task_count : this->task_count_.at(frame_slot)) {
+      task_count = 0;
+    }
   }
 
   /**
@@ -374,8 +395,8 @@ class FrameCounters {
    */
   bool CompleteSymbol(size_t frame_id) {
     const size_t frame_slot = (frame_id % kFrameWnd);
-    this->symbol_count_.at(frame_slot)++;
-    return this->IsLastSymbol(frame_slot);
+    const size_t symbol_count = ++this->symbol_count_.at(frame_slot);
+    return CheckLastSymbol(symbol_count);
   }
 
   /**
@@ -385,8 +406,8 @@ class FrameCounters {
    */
   bool CompleteTask(size_t frame_id, size_t symbol_id) {
     const size_t frame_slot = (frame_id % kFrameWnd);
-    this->task_count_.at(frame_slot).at(symbol_id)++;
-    return this->IsLastTask(frame_id, symbol_id);
+    const size_t task_count = ++this->task_count_.at(frame_slot).at(symbol_id);
+    return CheckLastTask(task_count, symbol_id);
   }
 
   /**
@@ -400,19 +421,7 @@ class FrameCounters {
    * @param frame id The frame id of the symbol to check
    */
   bool IsLastSymbol(size_t frame_id) const {
-    const size_t frame_slot = (frame_id % kFrameWnd);
-    bool is_last;
-    size_t symbol_count = this->symbol_count_.at(frame_slot);
-    if (symbol_count == this->max_symbol_count_) {
-      is_last = true;
-    } else if (symbol_count < this->max_symbol_count_) {
-      is_last = false;
-    } else {
-      is_last = true;
-      /* This should never happen */
-      assert(false);
-    }
-    return is_last;
+    return CheckLastSymbol(this->symbol_count_.at(frame_id % kFrameWnd));
   }
 
   /**
@@ -429,22 +438,8 @@ class FrameCounters {
    * @param symbol_id The symbol id to check
    */
   bool IsLastTask(size_t frame_id, size_t symbol_id) const {
-    const size_t frame_slot = frame_id % kFrameWnd;
-    bool is_last;
-    size_t task_count = this->task_count_.at(frame_slot).at(symbol_id);
-    if (task_count == this->max_task_count_) {
-      is_last = true;
-    } else if (task_count < this->max_task_count_) {
-      is_last = false;
-    } else {
-      is_last = true;
-      std::printf("Task Count %zu,  Max Count %zu, Symbol %zu\n", task_count,
-                  this->max_task_count_, symbol_id);
-      std::fflush(stdout);
-      // This should never happen
-      assert(false);
-    }
-    return is_last;
+    return CheckLastTask(
+        this->task_count_.at(frame_id % kFrameWnd).at(symbol_id), symbol_id);
   }
 
   size_t GetSymbolCount(size_t frame_id) const {
@@ -463,12 +458,44 @@ class FrameCounters {
   inline size_t MaxTaskCount() const { return this->max_task_count_; }
 
  private:
+  bool CheckLastSymbol(size_t symbol_count) const {
+    bool is_last;
+    if (symbol_count == this->max_symbol_count_) {
+      is_last = true;
+    } else if (symbol_count < this->max_symbol_count_) {
+      is_last = false;
+    } else {
+      is_last = true;
+      /* This should never happen */
+      assert(false);
+    }
+    return is_last;
+  }
+
+  bool CheckLastTask(size_t task_count, size_t symbol_id) const {
+    bool is_last;
+    if (task_count == this->max_task_count_) {
+      is_last = true;
+    } else if (task_count < this->max_task_count_) {
+      is_last = false;
+    } else {
+      is_last = true;
+      std::printf("Task Count %zu,  Max Count %zu, Symbol %zu\n", task_count,
+                  this->max_task_count_, symbol_id);
+      std::fflush(stdout);
+      // This should never happen
+      assert(false);
+    }
+    return is_last;
+  }
+
   // task_count[i][j] is the number of tasks completed for
   // frame (i % kFrameWnd) and symbol j
-  std::array<std::array<size_t, kMaxSymbols>, kFrameWnd> task_count_;
+  std::array<std::array<std::atomic<size_t>, kMaxSymbols>, kFrameWnd>
+      task_count_;
   // symbol_count[i] is the number of symbols completed for
   // frame (i % kFrameWnd)
-  std::array<size_t, kFrameWnd> symbol_count_;
+  std::array<std::atomic<size_t>, kFrameWnd> symbol_count_;
 
   // Maximum number of symbols in a frame
   size_t max_symbol_count_;
@@ -37,7 +37,7 @@ class CommsLib {
     kHadamard
   };
 
-  enum ModulationOrder { kQpsk = 2, kQaM16 = 4, kQaM64 = 6 };
+  enum ModulationOrder { kQpsk = 2, kQaM16 = 4, kQaM64 = 6, kQaM256 = 8 };
 
   explicit CommsLib(std::string);
   ~CommsLib();
@@ -11,6 +11,7 @@
 
 #include <boost/range/algorithm/count.hpp>
 
+#include "ldpc_decoder.h"
 #include "logger.h"
 #include "nlohmann/json.hpp"
 #include "scrambler.h"
@@ -218,6 +219,16 @@ Config::Config(const std::string& jsonfile)
   dpdk_num_ports_ = tdd_conf.value("dpdk_num_ports", 1);
   dpdk_port_offset_ = tdd_conf.value("dpdk_port_offset", 0);
 
+  xdp_interface_ = tdd_conf.value("xdp_interface", "");
+  xdp_queue_offset_ = tdd_conf.value("xdp_queue_offset", 0);
+  xdp_frame_size_ = tdd_conf.value("xdp_frame_size", 4096);
+  xdp_generic_mode_ = tdd_conf.value("xdp_generic_mode", true);
+  xdp_zero_copy_ = tdd_conf.value("xdp_zero_copy", false);
+  RtAssert((xdp_frame_size_ == 2048) || (xdp_frame_size_ == 4096),
+           "XDP frame size must be 2048 or 4096");
+  RtAssert(!(xdp_generic_mode_ && xdp_zero_copy_),
+           "XDP zero copy mode requires native (non-generic) XDP mode");
+
   ue_mac_tx_port_ = tdd_conf.value("ue_mac_tx_port", kMacUserRemotePort);
   ue_mac_rx_port_ = tdd_conf.value("ue_mac_rx_port", kMacUserLocalPort);
   bs_mac_tx_port_ = tdd_conf.value("bs_mac_tx_port", kMacBaseRemotePort);
@@ -451,6 +462,34 @@ Config::Config(const std::string& jsonfile)
   core_offset_ = tdd_conf.value("core_offset", 0);
   worker_thread_num_ = tdd_conf.value("worker_thread_num", 25);
   socket_thread_num_ = tdd_conf.value("socket_thread_num", 4);
+  socket_rx_batch_size_ = tdd_conf.value("socket_rx_batch_size", 1);
+  RtAssert(socket_rx_batch_size_ > 0,
+           "Socket rx batch size must be greater than 0");
+  socket_tx_batch_size_ = tdd_conf.value("socket_tx_batch_size", 1);
+  RtAssert(socket_tx_batch_size_ > 0,
+           "Socket tx batch size must be greater than 0");
+  master_thread_num_ = tdd_conf.value("master_thread_num", 1);
+  RtAssert(master_thread_num_ > 0,
+           "Master thread num must be greater than 0");
+  dataflow_mode_ = tdd_conf.value("dataflow_mode", false);
+  RtAssert((dataflow_mode_ == false) || (bigstation_mode_ == false),
+           "Dataflow mode is not supported in bigstation mode");
+  std::string worker_scheduler =
+      tdd_conf.value("worker_scheduler", "queues");
+  if (worker_scheduler == "queues") {
+    worker_scheduler_ = WorkerScheduler::kQueues;
+  } else if (worker_scheduler == "work_stealing") {
+    worker_scheduler_ = WorkerScheduler::kWorkStealing;
+  } else if (worker_scheduler == "edf") {
+    worker_scheduler_ = WorkerScheduler::kEdf;
+  } else {
+    throw std::runtime_error("Unknown worker scheduler " + worker_scheduler);
+  }
+  RtAssert((worker_scheduler_ == WorkerScheduler::kQueues) ||
+               (bigstation_mode_ == false),
+           "Only the queues worker scheduler is supported in bigstation mode");
+  // 0 selects one frame duration, which is computed later
+  frame_deadline_ms_ = tdd_conf.value("frame_deadline_ms", 0.0);
   ue_core_offset_ = tdd_conf.value("ue_core_offset", 0);
   ue_worker_thread_num_ = tdd_conf.value("ue_worker_thread_num", 25);
   ue_socket_thread_num_ = tdd_conf.value("ue_socket_thread_num", 4);
@@ -473,10 +512,33 @@ Config::Config(const std::string& jsonfile)
   zf_block_size_ =
       freq_orthogonal_pilot_ ? ue_ant_num_ : tdd_conf.value("zf_block_size", 1);
   zf_events_per_symbol_ = 1 + (ofdm_data_num_ - 1) / zf_block_size_;
+  std::string beamformer = tdd_conf.value("beamformer", "zf");
+  if (beamformer == "zf") {
+    beamformer_type_ = BeamformerType::kZF;
+  } else if (beamformer == "mmse") {
+    beamformer_type_ = BeamformerType::kMMSE;
+  } else if (beamformer == "rzf") {
+    beamformer_type_ = BeamformerType::kRZF;
+  } else {
+    throw std::runtime_error("Unknown beamformer " + beamformer);
+  }
+  // 0 disables reusing the ZF matrices of the previous frame
+  zf_reuse_threshold_ = tdd_conf.value("zf_reuse_threshold", 0.0);
+  data_buffer_fp16_ = tdd_conf.value("data_buffer_fp16", false);
+  fixed_point_demul_ = tdd_conf.value("fixed_point_demul", false);
+  llr_scaling_ = tdd_conf.value("llr_scaling", false);
 
   fft_block_size_ = tdd_conf.value("fft_block_size", 1);
   fft_block_size_ = std::max(fft_block_size_, num_channels_);
+  batched_fft_ = tdd_conf.value("batched_fft", false);
+  fft_pruning_ = tdd_conf.value("fft_pruning", false);
   encode_block_size_ = tdd_conf.value("encode_block_size", 1);
+  RtAssert((encode_block_size_ > 0) &&
+               (encode_block_size_ <= EventData::kMaxTags),
+           "encode_block_size must be between 1 and " +
+               std::to_string(EventData::kMaxTags));
+  decode_block_size_ = tdd_conf.value("decode_block_size", 1);
+  RtAssert(decode_block_size_ > 0, "decode_block_size must be positive");
 
   noise_level_ = tdd_conf.value("noise_level", 0.03);  // default: 30 dB
   MLPD_SYMBOL("Noise level: %.2f\n", noise_level_);
@@ -492,15 +554,44 @@ Config::Config(const std::string& jsonfile)
 
   ldpc_config_ = LDPCconfig(base_graph, zc, max_decoder_iter, early_term,
                             num_cb_len, num_cb_codew_len, num_rows, 0);
+  std::string ldpc_decoder =
+      tdd_conf.value("ldpc_decoder", kUseAgoraDecoder ? "agora" : "flexran");
+  if (ldpc_decoder == "flexran") {
+    ldpc_decoder_type_ = LdpcDecoderType::kFlexRan;
+  } else if (ldpc_decoder == "agora") {
+    ldpc_decoder_type_ = LdpcDecoder::kAvx512Available
+                             ? LdpcDecoderType::kAgoraAvx512
+                             : LdpcDecoderType::kAgoraAvx2;
+  } else if (ldpc_decoder == "agora_avx2") {
+    ldpc_decoder_type_ = LdpcDecoderType::kAgoraAvx2;
+  } else if (ldpc_decoder == "agora_avx512") {
+    RtAssert(LdpcDecoder::kAvx512Available,
+             "ldpc_decoder agora_avx512 requires an AVX-512 build");
+    ldpc_decoder_type_ = LdpcDecoderType::kAgoraAvx512;
+  } else {
+    throw std::runtime_error("Unknown LDPC decoder " + ldpc_decoder);
+  }
+  adaptive_decoder_iter_ = tdd_conf.value("adaptive_decoder_iter", false);
+  min_decoder_iter_ = tdd_conf.value("decoderMinIter", 1);
+  RtAssert((min_decoder_iter_ > 0) &&
+               (min_decoder_iter_ <= static_cast<size_t>(max_decoder_iter)),
+           "decoderMinIter must be between 1 and decoderIter");
 
   // Scrambler and descrambler configurations
   scramble_enabled_ = tdd_conf.value("wlan_scrambler", true);
 
   // Modulation configurations
-  mod_order_bits_ =
-      modulation_ == "64QAM"
-          ? CommsLib::kQaM64
-          : (modulation_ == "16QAM" ? CommsLib::kQaM16 : CommsLib::kQpsk);
+  auto mod_order_bits_of = [](const std::string& modulation) {
+    if (modulation == "256QAM") {
+      return static_cast<size_t>(CommsLib::kQaM256);
+    } else if (modulation == "64QAM") {
+      return static_cast<size_t>(CommsLib::kQaM64);
+    } else if (modulation == "16QAM") {
+      return static_cast<size_t>(CommsLib::kQaM16);
+    }
+    return static_cast<size_t>(CommsLib::kQpsk);
+  };
+  mod_order_bits_ = mod_order_bits_of(modulation_);
   // Updates num_block_in_sym
   UpdateModCfgs(mod_order_bits_);
 
@@ -508,6 +599,28 @@ Config::Config(const std::string& jsonfile)
            "LDPC expansion factor is too large for number of OFDM data "
            "subcarriers.");
 
+  // Per-UE MCS. Every UE starts with "modulation" and "nRows", and the
+  // buffers hold the code blocks of "max_modulation".
+  for (size_t i = 0; i < mod_tables_.size(); i++) {
+    InitModulationTable(mod_tables_.at(i), size_t(1) << (2 * (i + 1)));
+  }
+  max_mod_order_bits_ = std::max(
+      mod_order_bits_,
+      mod_order_bits_of(tdd_conf.value("max_modulation", modulation_)));
+  ldpc_config_.NumBlocksInSymbol(
+      (ofdm_data_num_ * max_mod_order_bits_) / ldpc_config_.NumCbCodewLen());
+  decode_events_per_symbol_ =
+      1 + (ue_ant_num_ * ldpc_config_.NumBlocksInSymbol() - 1) /
+              decode_block_size_;
+  for (auto& slot : ue_mcs_) {
+    slot.resize(ue_ant_num_);
+  }
+  for (size_t frame_slot = 0; frame_slot < kFrameWnd; frame_slot++) {
+    for (size_t ue_id = 0; ue_id < ue_ant_num_; ue_id++) {
+      UpdateUeMcs(frame_slot, ue_id, mod_order_bits_, num_rows);
+    }
+  }
+
   MLPD_INFO(
       "Config: LDPC: Zc: %d, %zu code blocks per symbol, %d information "
       "bits per encoding, %d bits per encoded code word, decoder "
@@ -820,7 +933,8 @@ void Config::GenData() {
 
   for (size_t i = 0; i < frame_.NumULSyms(); i++) {
     for (size_t j = 0; j < ue_ant_num_; j++) {
-      for (size_t k = 0; k < ldpc_config_.NumBlocksInSymbol(); k++) {
+      // Code blocks of the MCS of "modulation"
+      for (size_t k = 0; k < GetUeMcs(0, j).num_blocks_in_symbol_; k++) {
         int8_t* coded_bits_ptr =
             ul_encoded_bits_[i * num_blocks_per_symbol +
                              j * ldpc_config_.NumBlocksInSymbol() + k];
@@ -839,7 +953,7 @@ void Config::GenData() {
                          coded_bits_ptr, temp_parity_buffer, ldpc_input);
         AdaptBitsForMod(reinterpret_cast<uint8_t*>(coded_bits_ptr),
                         ul_mod_input_[i] + j * ofdm_data_num_ +
-                            k * encoded_bytes_per_block / mod_order_bits_,
+                            k * ldpc_config_.NumCbCodewLen() / mod_order_bits_,
                         encoded_bytes_per_block, mod_order_bits_);
       }
     }
@@ -875,7 +989,8 @@ void Config::GenData() {
 
   for (size_t i = 0; i < this->frame_.NumDLSyms(); i++) {
     for (size_t j = 0; j < this->ue_ant_num_; j++) {
-      for (size_t k = 0; k < ldpc_config_.NumBlocksInSymbol(); k++) {
+      // Code blocks of the MCS of "modulation"
+      for (size_t k = 0; k < GetUeMcs(0, j).num_blocks_in_symbol_; k++) {
         int8_t* coded_bits_ptr =
             dl_encoded_bits[i * num_blocks_per_symbol +
                             j * ldpc_config_.NumBlocksInSymbol() + k];
@@ -894,7 +1009,7 @@ void Config::GenData() {
                          coded_bits_ptr, temp_parity_buffer, ldpc_input);
         AdaptBitsForMod(reinterpret_cast<uint8_t*>(coded_bits_ptr),
                         dl_mod_input_[i] + j * ofdm_data_num_ +
-                            k * encoded_bytes_per_block / mod_order_bits_,
+                            k * ldpc_config_.NumCbCodewLen() / mod_order_bits_,
                         encoded_bytes_per_block, mod_order_bits_);
       }
     }
@@ -1043,6 +1158,9 @@ Config::~Config() {
     pilots_sgn_ = nullptr;
   }
   mod_table_.Free();
+  for (auto& mod_table : mod_tables_) {
+    mod_table.Free();
+  }
   dl_bits_.Free();
   ul_bits_.Free();
   dl_iq_f_.Free();
@@ -1055,6 +1173,28 @@ Config::~Config() {
 }
 
 /* TODO Inspect and document */
+void Config::UpdateUeMcs(size_t frame_id, size_t ue_id, size_t mod_order_bits,
+                         size_t ldpc_num_rows) {
+  RtAssert(mod_order_bits >= CommsLib::kQpsk &&
+               mod_order_bits <= max_mod_order_bits_ &&
+               mod_order_bits % 2 == 0,
+           "UE modulation order exceeds max_modulation");
+  RtAssert(ldpc_num_rows >= 4 &&
+               ldpc_num_rows <= LdpcMaxNumRows(ldpc_config_.BaseGraph()),
+           "UE LDPC nRows is out of range");
+  UeMcs& mcs = ue_mcs_[frame_id % kFrameWnd].at(ue_id);
+  mcs.mod_order_bits_ = mod_order_bits;
+  mcs.ldpc_num_rows_ = ldpc_num_rows;
+  mcs.num_cb_codew_len_ = LdpcNumEncodedBits(
+      ldpc_config_.BaseGraph(), ldpc_config_.ExpansionFactor(), ldpc_num_rows);
+  // Capped at the code blocks the buffers hold
+  mcs.num_blocks_in_symbol_ =
+      std::min((ofdm_data_num_ * mod_order_bits) / mcs.num_cb_codew_len_,
+               ldpc_config_.NumBlocksInSymbol());
+  RtAssert(mcs.num_blocks_in_symbol_ > 0,
+           "UE code word is too long for the number of OFDM data subcarriers");
+}
+
 size_t Config::GetSymbolId(size_t input_id) const {
   size_t symbol_id = SIZE_MAX;
 
@@ -14,6 +14,7 @@
 #include <immintrin.h>
 #include <unistd.h>
 
+#include <array>
 #include <boost/range/algorithm/count.hpp>
 #include <fstream>  // std::ifstream
 #include <iostream>
@@ -60,6 +61,9 @@ class Config {
   inline std::string Modulation() const { return this->modulation_; }
 
   inline size_t ModOrderBits() const { return this->mod_order_bits_; }
+  /// Highest modulation order bits of the per-UE MCS, which sets the
+  /// number of code blocks per symbol that the buffers are sized for
+  inline size_t MaxModOrderBits() const { return this->max_mod_order_bits_; }
   inline bool HwFramer() const { return this->hw_framer_; }
   inline bool UeHwFramer() const { return this->ue_hw_framer_; }
   inline double Freq() const { return this->freq_; }
@@ -119,6 +123,23 @@ class Config {
   inline size_t CoreOffset() const { return this->core_offset_; }
   inline size_t WorkerThreadNum() const { return this->worker_thread_num_; }
   inline size_t SocketThreadNum() const { return this->socket_thread_num_; }
+  inline size_t SocketRxBatchSize() const {
+    return this->socket_rx_batch_size_;
+  }
+  inline size_t SocketTxBatchSize() const {
+    return this->socket_tx_batch_size_;
+  }
+  inline size_t MasterThreadNum() const { return this->master_thread_num_; }
+  inline bool DataflowMode() const { return this->dataflow_mode_; }
+  inline WorkerScheduler GetWorkerScheduler() const {
+    return this->worker_scheduler_;
+  }
+  /// Time from the first packet of a frame until its processing must be
+  /// complete. Defaults to one frame duration.
+  inline double FrameDeadlineMs() const {
+    return (this->frame_deadline_ms_ > 0) ? this->frame_deadline_ms_
+                                          : GetFrameDurationSec() * 1e3;
+  }
   inline size_t UeCoreOffset() const { return this->ue_core_offset_; }
   inline size_t UeWorkerThreadNum() const {
     return this->ue_worker_thread_num_;
@@ -138,12 +159,32 @@ class Config {
   }
   inline size_t ZfBlockSize() const { return this->zf_block_size_; }
   inline size_t ZfBatchSize() const { return this->zf_batch_size_; }
+  inline BeamformerType GetBeamformerType() const {
+    return this->beamformer_type_;
+  }
+  inline LdpcDecoderType GetLdpcDecoderType() const {
+    return this->ldpc_decoder_type_;
+  }
+  inline bool AdaptiveDecoderIter() const {
+    return this->adaptive_decoder_iter_;
+  }
+  inline size_t MinDecoderIter() const { return this->min_decoder_iter_; }
+  inline double ZfReuseThreshold() const { return this->zf_reuse_threshold_; }
+  inline bool DataBufferFp16() const { return this->data_buffer_fp16_; }
+  inline bool FixedPointDemul() const { return this->fixed_point_demul_; }
+  inline bool LlrScaling() const { return this->llr_scaling_; }
   inline size_t ZfEventsPerSymbol() const {
     return this->zf_events_per_symbol_;
   }
   inline size_t FftBlockSize() const { return this->fft_block_size_; }
+  inline bool BatchedFft() const { return this->batched_fft_; }
+  inline bool FftPruning() const { return this->fft_pruning_; }
 
   inline size_t EncodeBlockSize() const { return this->encode_block_size_; }
+  inline size_t DecodeBlockSize() const { return this->decode_block_size_; }
+  inline size_t DecodeEventsPerSymbol() const {
+    return this->decode_events_per_symbol_;
+  }
   inline bool FreqOrthogonalPilot() const {
     return this->freq_orthogonal_pilot_;
   }
@@ -209,6 +250,14 @@ class Config {
   inline uint16_t DpdkNumPorts() const { return this->dpdk_num_ports_; }
   inline uint16_t DpdkPortOffset() const { return this->dpdk_port_offset_; }
 
+  inline const std::string& XdpInterface() const {
+    return this->xdp_interface_;
+  }
+  inline size_t XdpQueueOffset() const { return this->xdp_queue_offset_; }
+  inline size_t XdpFrameSize() const { return this->xdp_frame_size_; }
+  inline bool XdpGenericMode() const { return this->xdp_generic_mode_; }
+  inline bool XdpZeroCopy() const { return this->xdp_zero_copy_; }
+
   inline size_t BsMacRxPort() const { return this->bs_mac_rx_port_; }
   inline size_t BsMacTxPort() const { return this->bs_mac_tx_port_; }
 
@@ -268,6 +317,22 @@ class Config {
   inline Table<complex_float>& DlIqF() { return this->dl_iq_f_; }
   inline Table<std::complex<int16_t>>& DlIqT() { return this->dl_iq_t_; }
   inline Table<complex_float>& ModTable() { return this->mod_table_; };
+  /// Modulation lookup table of the given modulation order bits
+  inline Table<complex_float>& ModTable(size_t mod_order_bits) {
+    return this->mod_tables_.at(mod_order_bits / 2 - 1);
+  }
+
+  /// Return the MCS of UE ue_id in frame frame_id
+  inline const UeMcs& GetUeMcs(size_t frame_id, size_t ue_id) const {
+    return this->ue_mcs_[frame_id % kFrameWnd][ue_id];
+  }
+  inline size_t UeModOrderBits(size_t frame_id, size_t ue_id) const {
+    return GetUeMcs(frame_id, ue_id).mod_order_bits_;
+  }
+  /// Set the MCS of UE ue_id in the frame slot of frame_id. Agora sets the
+  /// slot of each frame when the frame starts (Agora::StartFrameMcs).
+  void UpdateUeMcs(size_t frame_id, size_t ue_id, size_t mod_order_bits,
+                   size_t ldpc_num_rows);
 
   // Public functions
   void GenData();
@@ -379,8 +444,10 @@ class Config {
       total_data_symbol_id = GetTotalDataSymbolIdxUl(frame_id, symbol_id);
     }
 
+    // One byte per modulated symbol of the MCS of the user
+    const UeMcs& mcs = GetUeMcs(frame_id, ue_id);
     size_t num_encoded_bytes_per_cb =
-        ldpc_config_.NumCbCodewLen() / this->mod_order_bits_;
+        mcs.num_cb_codew_len_ / mcs.mod_order_bits_;
 
     return &encoded_buffer[total_data_symbol_id]
                           [Roundup<64>(ofdm_data_num_) * ue_id +
@@ -443,6 +510,13 @@ class Config {
   size_t ofdm_pilot_spacing_;
 
   LDPCconfig ldpc_config_;  // LDPC parameters
+  // Decoder of the uplink code blocks
+  LdpcDecoderType ldpc_decoder_type_;
+  // True if DoDecode picks the iteration cap of each code block from the SNR
+  // of its user and the deadline slack of its frame, between
+  // min_decoder_iter_ and the decoderIter of ldpc_config_
+  bool adaptive_decoder_iter_;
+  size_t min_decoder_iter_;
 
   // A class that holds the frame configuration the id contains letters
   // representing the symbol types in the frame (e.g., 'P' for pilot symbols,
@@ -487,6 +561,13 @@ class Config {
 
   // Modulation lookup table for mapping binary bits to constellation points
   Table<complex_float> mod_table_;
+  // Modulation lookup tables of QPSK to 256QAM, for the per-UE MCS
+  std::array<Table<complex_float>, kMaxModType / 2> mod_tables_;
+
+  // Highest modulation order bits of the per-UE MCS ("max_modulation")
+  size_t max_mod_order_bits_;
+  // MCS of each UE in each frame slot, indexed by frame_id % kFrameWnd
+  std::array<std::vector<UeMcs>, kFrameWnd> ue_mcs_;
 
   std::vector<std::string> radio_id_;
   std::vector<std::string> hub_id_;
@@ -538,6 +619,22 @@ class Config {
   size_t core_offset_;
   size_t worker_thread_num_;
   size_t socket_thread_num_;
+  // Max number of packets received by one recvmmsg() call in PacketTXRX.
+  // A value of 1 selects the single recv() per packet path.
+  size_t socket_rx_batch_size_;
+  // Max number of packets sent by one sendmmsg() call in PacketTXRX.
+  // A value of 1 selects the single sendto() per packet path.
+  size_t socket_tx_batch_size_;
+  // Number of master threads. Threads beyond the first count completed worker
+  // tasks in parallel and forward only symbol completions to the first one.
+  size_t master_thread_num_;
+  // If true, the worker that completes the last demodulation (precoding) task
+  // of a symbol schedules the symbol's decoding (IFFT) tasks itself
+  bool dataflow_mode_;
+  // How the worker threads pick tasks
+  WorkerScheduler worker_scheduler_;
+  // Processing deadline of a frame, 0 for one frame duration
+  double frame_deadline_ms_;
   size_t fft_thread_num_;
   size_t demul_thread_num_;
   size_t decode_thread_num_;
@@ -557,12 +654,36 @@ class Config {
   // Number of doZF function call handled in on event
   size_t zf_batch_size_;
   size_t zf_events_per_symbol_;  // Derived from zf_block_size
+  // Detector and precoder computed by DoZF
+  BeamformerType beamformer_type_;
+  // Relative CSI change of a ZF block, |H - H_prev|^2 / |H_prev|^2, below
+  // which the ZF matrices of the previous frame are reused
+  double zf_reuse_threshold_;
+  // True if the FFT outputs of uplink data symbols are stored in half
+  // precision in data_buffer_
+  bool data_buffer_fp16_;
+  // True if DoDemul equalizes and demodulates with Q15 fixed-point kernels,
+  // using the Q15 copies of the uplink ZF matrices made by DoZF
+  bool fixed_point_demul_;
+  // True if the uplink soft demappers scale the LLRs of each user by its
+  // post-equalization SNR, estimated from its pilot SNR
+  bool llr_scaling_;
 
   // Number of antennas handled in one FFT event
   size_t fft_block_size_;
+  // True if DoFFT computes the FFTs of all antennas of an FFT event with one
+  // multi-transform MKL call
+  bool batched_fft_;
+  // True if DoFFT computes only the data subcarriers of uplink data symbols,
+  // and DoIFFT skips the zero guard bands, with pruned transforms
+  bool fft_pruning_;
 
   // Number of code blocks handled in one encode event
   size_t encode_block_size_;
+  // Number of consecutive code blocks of a symbol handled in one decode
+  // event, which Agora's LDPC decoder decodes in batches
+  size_t decode_block_size_;
+  size_t decode_events_per_symbol_;  // Derived from decode_block_size
 
   bool freq_orthogonal_pilot_;
 
@@ -663,6 +784,22 @@ class Config {
   // Offset of the first NIC port used by Agora's DPDK mode
   uint16_t dpdk_port_offset_;
 
+  // Network interface used by Agora's AF_XDP mode
+  std::string xdp_interface_;
+
+  // NIC queue of the AF_XDP socket of the first socket thread, socket
+  // thread i uses queue xdp_queue_offset + i
+  size_t xdp_queue_offset_;
+
+  // Size of one AF_XDP UMEM frame (2048 or 4096), each holds one packet
+  size_t xdp_frame_size_;
+
+  // Attach the XDP program in generic (skb) mode instead of native mode
+  bool xdp_generic_mode_;
+
+  // Bind AF_XDP sockets in zero copy mode (native mode only)
+  bool xdp_zero_copy_;
+
   // Port ID at BaseStation MAC layer side
   size_t bs_mac_rx_port_;
   size_t bs_mac_tx_port_;
@@ -0,0 +1,522 @@
+/**
+ * @file fixed_point.cc
+ * @brief Implementation file for the Q15 fixed-point equalization and soft
+ * demodulation kernels
+ */
+#include "fixed_point.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#include "comms-lib.h"
+#include "modulation.h"
+
+#ifdef __AVX512BW__
+using SimdQ15 = __m512i;
+static inline SimdQ15 SimdQ15Zero() { return _mm512_setzero_si512(); }
+static inline SimdQ15 SimdQ15Set1(int32_t val) {
+  return _mm512_set1_epi32(val);
+}
+static inline SimdQ15 SimdQ15Load(const int16_t* ptr) {
+  return _mm512_loadu_si512(ptr);
+}
+static inline SimdQ15 SimdQ15Add(SimdQ15 a, SimdQ15 b) {
+  return _mm512_add_epi32(a, b);
+}
+// Multiply the int16 pairs of a and b and add the two products of each pair
+// to the int32 lanes of acc
+static inline SimdQ15 SimdQ15MaddAcc(SimdQ15 acc, SimdQ15 a, SimdQ15 b) {
+#ifdef __AVX512VNNI__
+  return _mm512_dpwssd_epi32(acc, a, b);
+#else
+  return _mm512_add_epi32(acc, _mm512_madd_epi16(a, b));
+#endif
+}
+// Round the int32 lanes of a right-shifted by shift > 0
+static inline SimdQ15 SimdQ15RoundShift(SimdQ15 a, int shift) {
+  const SimdQ15 half = _mm512_set1_epi32(1 << (shift - 1));
+  return _mm512_sra_epi32(_mm512_add_epi32(a, half),
+                          _mm_cvtsi32_si128(shift));
+}
+// Clamp the int32 lanes of a to int8 and left-shift them by shift <= 8
+static inline SimdQ15 SimdQ15ClampShift(SimdQ15 a, int shift) {
+  a = _mm512_min_epi32(_mm512_max_epi32(a, _mm512_set1_epi32(INT8_MIN)),
+                       _mm512_set1_epi32(INT8_MAX));
+  return _mm512_sll_epi32(a, _mm_cvtsi32_si128(shift));
+}
+// Interleave the int32 lanes of re and im and saturate them to int8. The
+// (re, im) pairs of lanes 4 * k to 4 * k + 3 are in bytes 16 * k to
+// 16 * k + 7.
+static inline SimdQ15 SimdQ15PackPairs(SimdQ15 re, SimdQ15 im) {
+  const SimdQ15 pairs16 = _mm512_packs_epi32(_mm512_unpacklo_epi32(re, im),
+                                             _mm512_unpackhi_epi32(re, im));
+  return _mm512_packs_epi16(pairs16, pairs16);
+}
+static inline void SimdQ15Store(int8_t* ptr, SimdQ15 a) {
+  _mm512_store_si512(ptr, a);
+}
+#else
+using SimdQ15 = __m256i;
+static inline SimdQ15 SimdQ15Zero() { return _mm256_setzero_si256(); }
+static inline SimdQ15 SimdQ15Set1(int32_t val) {
+  return _mm256_set1_epi32(val);
+}
+static inline SimdQ15 SimdQ15Load(const int16_t* ptr) {
+  return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ptr));
+}
+static inline SimdQ15 SimdQ15Add(SimdQ15 a, SimdQ15 b) {
+  return _mm256_add_epi32(a, b);
+}
+// Multiply the int16 pairs of a and b and add the two products of each pair
+// to the int32 lanes of acc
+static inline SimdQ15 SimdQ15MaddAcc(SimdQ15 acc, SimdQ15 a, SimdQ15 b) {
+  return _mm256_add_epi32(acc, _mm256_madd_epi16(a, b));
+}
+// Round the int32 lanes of a right-shifted by shift > 0
+static inline SimdQ15 SimdQ15RoundShift(SimdQ15 a, int shift) {
+  const SimdQ15 half = _mm256_set1_epi32(1 << (shift - 1));
+  return _mm256_sra_epi32(_mm256_add_epi32(a, half),
+                          _mm_cvtsi32_si128(shift));
+}
+// Clamp the int32 lanes of a to int8 and left-shift them by shift <= 8
+static inline SimdQ15 SimdQ15ClampShift(SimdQ15 a, int shift) {
+  a = _mm256_min_epi32(_mm256_max_epi32(a, _mm256_set1_epi32(INT8_MIN)),
+                       _mm256_set1_epi32(INT8_MAX));
+  return _mm256_sll_epi32(a, _mm_cvtsi32_si128(shift));
+}
+// Interleave the int32 lanes of re and im and saturate them to int8. The
+// (re, im) pairs of lanes 4 * k to 4 * k + 3 are in bytes 16 * k to
+// 16 * k + 7.
+static inline SimdQ15 SimdQ15PackPairs(SimdQ15 re, SimdQ15 im) {
+  const SimdQ15 pairs16 = _mm256_packs_epi32(_mm256_unpacklo_epi32(re, im),
+                                             _mm256_unpackhi_epi32(re, im));
+  return _mm256_packs_epi16(pairs16, pairs16);
+}
+static inline void SimdQ15Store(int8_t* ptr, SimdQ15 a) {
+  _mm256_store_si256(reinterpret_cast<__m256i*>(ptr), a);
+}
+#endif
+
+// Max number of SIMD registers of users equalized in one pass
+static constexpr size_t kMaxQ15Simds = 4;
+
+// Block exponent of all-zero blocks relative to the magnitude bits, which
+// keeps them from lowering the exponent of the blocks they are combined with
+static constexpr int kQ15ZeroBlockExponent = 64;
+
+// Largest magnitude of an int16 operand, which leaves room to negate it
+static constexpr size_t kMaxQ15OperandBits = 14;
+
+static inline int32_t* Q15ZfExponent(complex_float* zf_cell, size_t bs_ant_num,
+                                     size_t ue_ant_num) {
+  return reinterpret_cast<int32_t*>(zf_cell + bs_ant_num * ue_ant_num);
+}
+
+// Q15 detector with the pair (re(w), -im(w)) for each element w, whose dot
+// products with the pairs (re(x), im(x)) and (im(x), -re(x)) are the real and
+// imaginary parts of w * x
+static inline int16_t* Q15ZfData(complex_float* zf_cell, size_t bs_ant_num,
+                                 size_t ue_ant_num) {
+  return reinterpret_cast<int16_t*>(zf_cell + bs_ant_num * ue_ant_num +
+                                    kQ15ZfHeaderEntries);
+}
+
+size_t Q15OperandBits(size_t bs_ant_num) {
+  // The sum of 2^log_terms products of magnitude 2^(2 * bits) must stay
+  // within 2^30
+  size_t log_terms = 0;
+  while ((size_t(1) << log_terms) < 2 * bs_ant_num) {
+    log_terms++;
+  }
+  return std::min(kMaxQ15OperandBits,
+                  (30 - std::min(log_terms, size_t(30))) / 2);
+}
+
+int Q15BlockExponent(const float* in, size_t num, size_t bits) {
+  size_t i = 0;
+  float max_abs = 0;
+#ifdef __AVX512F__
+  __m512 max_v512 = _mm512_setzero_ps();
+  for (; i + 16 <= num; i += 16) {
+    max_v512 = _mm512_max_ps(max_v512, _mm512_abs_ps(_mm512_loadu_ps(in + i)));
+  }
+  max_abs = _mm512_reduce_max_ps(max_v512);
+#endif
+  const __m256 abs_mask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+  __m256 max_v = _mm256_setzero_ps();
+  for (; i + 8 <= num; i += 8) {
+    max_v = _mm256_max_ps(max_v, _mm256_and_ps(_mm256_loadu_ps(in + i),
+                                               abs_mask));
+  }
+  alignas(32) float max_arr[8];
+  _mm256_store_ps(max_arr, max_v);
+  max_abs = std::max(max_abs, *std::max_element(max_arr, max_arr + 8));
+  for (; i < num; i++) {
+    max_abs = std::max(max_abs, std::fabs(in[i]));
+  }
+  if (!std::isfinite(max_abs)) {
+    return 0;
+  }
+  if (max_abs == 0) {
+    return static_cast<int>(bits) + kQ15ZeroBlockExponent;
+  }
+  // max_abs < 2^k, so max_abs * 2^(bits - k) < 2^bits
+  int k;
+  std::frexp(max_abs, &k);
+  return static_cast<int>(bits) - k;
+}
+
+// Round the [num] floats of [in] scaled by [scale] to int16
+static void FloatToQ15Scaled(const float* in, int16_t* out, size_t num,
+                             float scale) {
+  size_t i = 0;
+#ifdef __AVX512F__
+  const __m512 scale_v512 = _mm512_set1_ps(scale);
+  for (; i + 16 <= num; i += 16) {
+    const __m512i val = _mm512_cvtps_epi32(
+        _mm512_mul_ps(_mm512_loadu_ps(in + i), scale_v512));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i),
+                        _mm512_cvtsepi32_epi16(val));
+  }
+#endif
+  const __m256 scale_v = _mm256_set1_ps(scale);
+  for (; i + 16 <= num; i += 16) {
+    const __m256i lo = _mm256_cvtps_epi32(
+        _mm256_mul_ps(_mm256_loadu_ps(in + i), scale_v));
+    const __m256i hi = _mm256_cvtps_epi32(
+        _mm256_mul_ps(_mm256_loadu_ps(in + i + 8), scale_v));
+    // packs works within 128-bit lanes, so restore the order of the samples
+    _mm256_storeu_si256(
+        reinterpret_cast<__m256i*>(out + i),
+        _mm256_permute4x64_epi64(_mm256_packs_epi32(lo, hi), 0xd8));
+  }
+  for (; i < num; i++) {
+    out[i] = static_cast<int16_t>(std::lrint(in[i] * scale));
+  }
+}
+
+void FloatToQ15(const float* in, int16_t* out, size_t num, int exponent) {
+  FloatToQ15Scaled(in, out, num, std::ldexp(1.0f, exponent));
+}
+
+void Q15RotateMinusJ(const int16_t* in, int16_t* out, size_t num) {
+  size_t i = 0;
+  // Swap the real and imaginary parts, then negate the new imaginary parts
+  const __m256i swap = _mm256_setr_epi8(
+      2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13, 2, 3, 0, 1, 6, 7,
+      4, 5, 10, 11, 8, 9, 14, 15, 12, 13);
+  const __m256i sign = _mm256_set1_epi32(0xffff0001);
+  for (; i + 8 <= num; i += 8) {
+    const __m256i x =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&in[2 * i]));
+    _mm256_storeu_si256(
+        reinterpret_cast<__m256i*>(&out[2 * i]),
+        _mm256_sign_epi16(_mm256_shuffle_epi8(x, swap), sign));
+  }
+  for (; i < num; i++) {
+    const int16_t re = in[2 * i];
+    out[2 * i] = in[2 * i + 1];
+    out[2 * i + 1] = static_cast<int16_t>(-re);
+  }
+}
+
+float Q15LlrScale(size_t mod_order_bits) {
+  switch (mod_order_bits) {
+    case (CommsLib::kQpsk):
+      // DemodQpskSoftSse maps positive symbols to negative LLRs
+      return -SCALE_BYTE_CONV_QPSK * M_SQRT2;
+    case (CommsLib::kQaM16):
+      return SCALE_BYTE_CONV_QAM16;
+    case (CommsLib::kQaM64):
+      return SCALE_BYTE_CONV_QAM64;
+    case (CommsLib::kQaM256):
+      return SCALE_BYTE_CONV_QAM256;
+    default:
+      return 1.0f;
+  }
+}
+
+void Q15QuantizeZf(complex_float* zf_cell, size_t bs_ant_num,
+                   size_t ue_ant_num, const float* llr_scales) {
+  const auto* zf = reinterpret_cast<const float*>(zf_cell);
+  const size_t stride = Q15ZfStride(ue_ant_num);
+  int16_t* zf_q15 = Q15ZfData(zf_cell, bs_ant_num, ue_ant_num);
+
+  // All |llr_scales| < 2^k, so the exponent of the scaled detector is at
+  // least that of the detector minus k
+  int k = std::numeric_limits<int>::min();
+  for (size_t ue = 0; ue < ue_ant_num; ue++) {
+    int k_ue;
+    std::frexp(llr_scales[ue], &k_ue);
+    k = std::max(k, k_ue);
+  }
+  const int exponent = Q15BlockExponent(zf, 2 * bs_ant_num * ue_ant_num,
+                                        Q15OperandBits(bs_ant_num)) -
+                       k;
+  for (size_t ue = 0; ue < stride; ue++) {
+    const float scale =
+        ue < ue_ant_num ? std::ldexp(llr_scales[ue], exponent) : 0.0f;
+    for (size_t ant = 0; ant < bs_ant_num; ant++) {
+      int16_t re = 0;
+      int16_t im = 0;
+      if (ue < ue_ant_num) {
+        re = static_cast<int16_t>(
+            std::lrint(zf[2 * (ant * ue_ant_num + ue)] * scale));
+        im = static_cast<int16_t>(
+            std::lrint(zf[2 * (ant * ue_ant_num + ue) + 1] * scale));
+      }
+      zf_q15[2 * (ant * stride + ue)] = re;
+      zf_q15[2 * (ant * stride + ue) + 1] = static_cast<int16_t>(-im);
+    }
+  }
+  *Q15ZfExponent(zf_cell, bs_ant_num, ue_ant_num) = exponent;
+}
+
+// Number of independent accumulators of each register of users. The
+// multiply-accumulate of VNNI has a longer latency than the add of madd, so
+// few registers of users need several accumulators to keep it busy.
+#ifdef __AVX512VNNI__
+static constexpr size_t Q15NumChains(size_t num_simds) {
+  return num_simds >= 4 ? 1 : (num_simds == 1 ? 4 : 2);
+}
+#else
+static constexpr size_t Q15NumChains(size_t) { return 1; }
+#endif
+
+static inline SimdQ15 SimdQ15Broadcast(const int16_t* pair) {
+  int32_t val;
+  std::memcpy(&val, pair, sizeof(val));
+  return SimdQ15Set1(val);
+}
+
+// Equalize kNumSimds registers of users with the Q15 detector columns at
+// [zf], [zf_stride] complex samples apart, and write the int8 symbols of each
+// register to out. [data] and [data_rot] hold the sample x and -j * x of
+// antenna 0, with the other antennas data_stride complex samples apart.
+template <size_t kNumSimds>
+static inline void Q15EqualizeUsers(const int16_t* zf, size_t zf_stride,
+                                    const int16_t* data,
+                                    const int16_t* data_rot,
+                                    size_t data_stride, size_t bs_ant_num,
+                                    int shift, int8_t* out) {
+  static constexpr size_t kNumChains = Q15NumChains(kNumSimds);
+  SimdQ15 acc_re[kNumChains][kNumSimds];
+  SimdQ15 acc_im[kNumChains][kNumSimds];
+  for (size_t c = 0; c < kNumChains; c++) {
+    for (size_t v = 0; v < kNumSimds; v++) {
+      acc_re[c][v] = SimdQ15Zero();
+      acc_im[c][v] = SimdQ15Zero();
+    }
+  }
+  // (re(w), -im(w)) dotted with (re(x), im(x)) is re(w * x), and with
+  // (im(x), -re(x)), i.e., -j * x, is im(w * x)
+  const size_t ant_end = bs_ant_num - bs_ant_num % kNumChains;
+  for (size_t ant = 0; ant < ant_end; ant += kNumChains) {
+    for (size_t c = 0; c < kNumChains; c++) {
+      const size_t offset = 2 * (ant + c) * data_stride;
+      const SimdQ15 x_re = SimdQ15Broadcast(&data[offset]);
+      const SimdQ15 x_im = SimdQ15Broadcast(&data_rot[offset]);
+      const int16_t* zf_col = &zf[2 * (ant + c) * zf_stride];
+      for (size_t v = 0; v < kNumSimds; v++) {
+        const SimdQ15 w = SimdQ15Load(&zf_col[2 * v * kQ15CxPerSimd]);
+        acc_re[c][v] = SimdQ15MaddAcc(acc_re[c][v], w, x_re);
+        acc_im[c][v] = SimdQ15MaddAcc(acc_im[c][v], w, x_im);
+      }
+    }
+  }
+  for (size_t ant = ant_end; ant < bs_ant_num; ant++) {
+    const size_t offset = 2 * ant * data_stride;
+    const SimdQ15 x_re = SimdQ15Broadcast(&data[offset]);
+    const SimdQ15 x_im = SimdQ15Broadcast(&data_rot[offset]);
+    const int16_t* zf_col = &zf[2 * ant * zf_stride];
+    for (size_t v = 0; v < kNumSimds; v++) {
+      const SimdQ15 w = SimdQ15Load(&zf_col[2 * v * kQ15CxPerSimd]);
+      acc_re[0][v] = SimdQ15MaddAcc(acc_re[0][v], w, x_re);
+      acc_im[0][v] = SimdQ15MaddAcc(acc_im[0][v], w, x_im);
+    }
+  }
+
+  for (size_t v = 0; v < kNumSimds; v++) {
+    SimdQ15 re = acc_re[0][v];
+    SimdQ15 im = acc_im[0][v];
+    for (size_t c = 1; c < kNumChains; c++) {
+      re = SimdQ15Add(re, acc_re[c][v]);
+      im = SimdQ15Add(im, acc_im[c][v]);
+    }
+    if (shift > 0) {
+      // Accumulators stay below 2^30, so larger shifts round to zero
+      re = SimdQ15RoundShift(re, std::min(shift, 31));
+      im = SimdQ15RoundShift(im, std::min(shift, 31));
+    } else {
+      re = SimdQ15ClampShift(re, std::min(-shift, 8));
+      im = SimdQ15ClampShift(im, std::min(-shift, 8));
+    }
+    SimdQ15Store(&out[v * sizeof(SimdQ15)], SimdQ15PackPairs(re, im));
+  }
+}
+
+void Q15Equalize(const complex_float* zf_cell, size_t bs_ant_num,
+                 size_t ue_ant_num, const int16_t* data,
+                 const int16_t* data_rot, size_t data_stride,
+                 int data_exponent, int8_t* symbols, size_t symbols_stride) {
+  auto* cell = const_cast<complex_float*>(zf_cell);
+  const size_t zf_stride = Q15ZfStride(ue_ant_num);
+  const int16_t* zf_q15 = Q15ZfData(cell, bs_ant_num, ue_ant_num);
+  const int shift =
+      *Q15ZfExponent(cell, bs_ant_num, ue_ant_num) + data_exponent;
+
+  static constexpr size_t kMaxQ15Ues = kMaxQ15Simds * kQ15CxPerSimd;
+  alignas(64) int8_t out[kMaxQ15Simds * sizeof(SimdQ15)];
+  for (size_t ue = 0; ue < ue_ant_num; ue += kMaxQ15Ues) {
+    const size_t ue_num = std::min(kMaxQ15Ues, ue_ant_num - ue);
+    const int16_t* zf_ue = &zf_q15[2 * ue];
+    switch ((ue_num + kQ15CxPerSimd - 1) / kQ15CxPerSimd) {
+      case 1:
+        Q15EqualizeUsers<1>(zf_ue, zf_stride, data, data_rot, data_stride,
+                            bs_ant_num, shift, out);
+        break;
+      case 2:
+        Q15EqualizeUsers<2>(zf_ue, zf_stride, data, data_rot, data_stride,
+                            bs_ant_num, shift, out);
+        break;
+      case 3:
+        Q15EqualizeUsers<3>(zf_ue, zf_stride, data, data_rot, data_stride,
+                            bs_ant_num, shift, out);
+        break;
+      default:
+        Q15EqualizeUsers<kMaxQ15Simds>(zf_ue, zf_stride, data, data_rot,
+                                       data_stride, bs_ant_num, shift, out);
+    }
+    // The pairs of users 4 * k to 4 * k + 3 are in bytes 16 * k to
+    // 16 * k + 7
+    for (size_t k = 0; k < ue_num; k++) {
+      std::memcpy(&symbols[2 * (ue + k) * symbols_stride],
+                  &out[(k / 4) * 16 + (k % 4) * 2], 2);
+    }
+  }
+}
+
+// Thresholds of the recursive LLRs of the higher bits of each symbol, in the
+// order used by Demod16qamSoftLoop, Demod64qamSoftLoop and Demod256qamSoftLoop
+static size_t Q15DemodOffsets(size_t mod_order_bits, float llr_scale,
+                              int8_t* offsets) {
+  switch (mod_order_bits) {
+    case (CommsLib::kQaM16): {
+      const float scale = SCALE_BYTE_CONV_QAM16 * llr_scale;
+      offsets[0] = 2 * scale / std::sqrt(10);
+      return 1;
+    }
+    case (CommsLib::kQaM64): {
+      const float scale = SCALE_BYTE_CONV_QAM64 * llr_scale;
+      offsets[0] = 4 * scale / std::sqrt(42);
+      offsets[1] = 2 * scale / std::sqrt(42);
+      return 2;
+    }
+    case (CommsLib::kQaM256): {
+      const float scale = SCALE_BYTE_CONV_QAM256 * llr_scale;
+      offsets[0] = QAM256_THRESHOLD_4 * scale;
+      offsets[1] = QAM256_THRESHOLD_2 * scale;
+      offsets[2] = QAM256_THRESHOLD_1 * scale;
+      return 3;
+    }
+    default:
+      return 0;
+  }
+}
+
+// Shuffle masks that gather the 48 bytes of 64QAM LLRs of 8 symbols, in
+// chunks of 16 bytes, from the three vectors of (re, im) pairs of each level
+struct Q15Demod64qamMasks {
+  __m128i masks[3][3];
+  Q15Demod64qamMasks() {
+    alignas(16) int8_t bytes[3][3][16];
+    for (size_t i = 0; i < 48; i++) {
+      const size_t sym = i / 6;
+      const size_t level = (i % 6) / 2;
+      for (size_t src = 0; src < 3; src++) {
+        // Bytes with the top bit set are zeroed by the shuffle
+        bytes[i / 16][src][i % 16] =
+            src == level ? static_cast<int8_t>(2 * sym + i % 2) : -1;
+      }
+    }
+    for (size_t chunk = 0; chunk < 3; chunk++) {
+      for (size_t src = 0; src < 3; src++) {
+        masks[chunk][src] = _mm_load_si128(
+            reinterpret_cast<const __m128i*>(bytes[chunk][src]));
+      }
+    }
+  }
+};
+
+void Q15DemodSoft(const int8_t* symbols, int8_t* llr, size_t num,
+                  size_t mod_order_bits, float llr_scale) {
+  int8_t offsets[3] = {0, 0, 0};
+  const size_t num_levels =
+      Q15DemodOffsets(mod_order_bits, llr_scale, offsets);
+  if (num_levels == 0) {
+    std::memcpy(llr, symbols, 2 * num);
+    return;
+  }
+  // The 256QAM LLRs are negated, as in Demod256qamSoftLoop
+  const bool negate = (mod_order_bits == CommsLib::kQaM256);
+
+  // Eight symbols at a time. The int8 differences wrap exactly as the casts of
+  // the scalar loop below.
+  size_t i = 0;
+  for (; i + 8 <= num; i += 8) {
+    __m128i levels[4];
+    levels[0] =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(&symbols[2 * i]));
+    if (negate) {
+      levels[0] = _mm_subs_epi8(_mm_setzero_si128(), levels[0]);
+    }
+    for (size_t level = 0; level < num_levels; level++) {
+      const __m128i offset = _mm_set1_epi8(offsets[level]);
+      const __m128i distance = _mm_abs_epi8(levels[level]);
+      levels[level + 1] = negate ? _mm_sub_epi8(distance, offset)
+                                 : _mm_sub_epi8(offset, distance);
+    }
+    auto* out = reinterpret_cast<__m128i*>(&llr[i * mod_order_bits]);
+    if (num_levels == 1) {
+      _mm_storeu_si128(out, _mm_unpacklo_epi16(levels[0], levels[1]));
+      _mm_storeu_si128(out + 1, _mm_unpackhi_epi16(levels[0], levels[1]));
+    } else if (num_levels == 2) {
+      static const Q15Demod64qamMasks kMasks;
+      for (size_t chunk = 0; chunk < 3; chunk++) {
+        __m128i bytes = _mm_shuffle_epi8(levels[0], kMasks.masks[chunk][0]);
+        bytes = _mm_or_si128(
+            bytes, _mm_shuffle_epi8(levels[1], kMasks.masks[chunk][1]));
+        bytes = _mm_or_si128(
+            bytes, _mm_shuffle_epi8(levels[2], kMasks.masks[chunk][2]));
+        _mm_storeu_si128(out + chunk, bytes);
+      }
+    } else {
+      const __m128i lo01 = _mm_unpacklo_epi16(levels[0], levels[1]);
+      const __m128i hi01 = _mm_unpackhi_epi16(levels[0], levels[1]);
+      const __m128i lo23 = _mm_unpacklo_epi16(levels[2], levels[3]);
+      const __m128i hi23 = _mm_unpackhi_epi16(levels[2], levels[3]);
+      _mm_storeu_si128(out, _mm_unpacklo_epi32(lo01, lo23));
+      _mm_storeu_si128(out + 1, _mm_unpackhi_epi32(lo01, lo23));
+      _mm_storeu_si128(out + 2, _mm_unpacklo_epi32(hi01, hi23));
+      _mm_storeu_si128(out + 3, _mm_unpackhi_epi32(hi01, hi23));
+    }
+  }
+
+  for (; i < num; i++) {
+    int8_t* out = &llr[i * mod_order_bits];
+    // Negating saturates, as the float demapper saturates the negated symbols
+    const int sign = negate ? -1 : 1;
+    int re = std::min(sign * symbols[2 * i], INT8_MAX);
+    int im = std::min(sign * symbols[2 * i + 1], INT8_MAX);
+    out[0] = static_cast<int8_t>(re);
+    out[1] = static_cast<int8_t>(im);
+    for (size_t level = 0; level < num_levels; level++) {
+      re = sign * (offsets[level] - std::abs(re));
+      im = sign * (offsets[level] - std::abs(im));
+      out[2 * level + 2] = static_cast<int8_t>(re);
+      out[2 * level + 3] = static_cast<int8_t>(im);
+    }
+  }
+}
@@ -0,0 +1,88 @@
+/**
+ * @file fixed_point.h
+ * @brief Declaration file for the Q15 fixed-point equalization and soft
+ * demodulation kernels, which DoDemul uses instead of the float kernels when
+ * "fixed_point_demul" is enabled
+ */
+#ifndef FIXED_POINT_H_
+#define FIXED_POINT_H_
+
+#include <immintrin.h>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "common_typedef_sdk.h"
+
+/// Number of complex int16 samples per SIMD register, twice the number of
+/// complex floats
+#ifdef __AVX512BW__
+static constexpr size_t kQ15CxPerSimd = 16;
+#else
+static constexpr size_t kQ15CxPerSimd = 8;
+#endif
+
+/// Number of complex float entries at the start of a Q15 detector, which
+/// hold its block exponent and keep its samples aligned
+static constexpr size_t kQ15ZfHeaderEntries = 8;
+
+/// Number of users in each column of a Q15 detector, padded to whole SIMD
+/// registers
+inline size_t Q15ZfStride(size_t ue_ant_num) {
+  return ((ue_ant_num + kQ15CxPerSimd - 1) / kQ15CxPerSimd) * kQ15CxPerSimd;
+}
+
+/// Number of complex float entries appended to each cell of the uplink ZF
+/// matrices to hold the Q15 copy of its bs_ant_num x ue_ant_num detector
+inline size_t Q15ZfEntries(size_t bs_ant_num, size_t ue_ant_num) {
+  // Each complex float entry holds two complex int16 samples
+  return kQ15ZfHeaderEntries + bs_ant_num * Q15ZfStride(ue_ant_num) / 2;
+}
+
+/// Number of magnitude bits of the int16 operands of an inner product over
+/// bs_ant_num antennas, such that the int32 sum of its 2 * bs_ant_num
+/// products cannot overflow
+size_t Q15OperandBits(size_t bs_ant_num);
+
+/// Return the block exponent e of the [num] floats of [in], i.e., the
+/// largest e such that all of them scaled by 2^e have magnitudes below 2^bits.
+/// The block exponent of several blocks is the minimum of theirs.
+int Q15BlockExponent(const float* in, size_t num, size_t bits);
+
+/// Round the [num] floats of [in] scaled by 2^exponent to int16
+void FloatToQ15(const float* in, int16_t* out, size_t num, int exponent);
+
+/// Multiply the [num] complex Q15 samples of [in] by -j, i.e., write
+/// (im(x), -re(x)) for each sample x
+void Q15RotateMinusJ(const int16_t* in, int16_t* out, size_t num);
+
+/// Factor between the equalized symbols and the int8 values the soft
+/// demappers of modulation.h compute the LLRs from, with llr_scale 1
+float Q15LlrScale(size_t mod_order_bits);
+
+/// Quantize the column-major ue_ant_num x bs_ant_num detector at the start
+/// of [zf_cell], with the row of each user scaled by its entry of
+/// [llr_scales], to the Q15 detector stored after it
+void Q15QuantizeZf(complex_float* zf_cell, size_t bs_ant_num,
+                   size_t ue_ant_num, const float* llr_scales);
+
+/// Equalize one subcarrier with the Q15 detector of [zf_cell]. [data] holds
+/// the Q15 sample of antenna 0 with block exponent data_exponent, with the
+/// samples of the other antennas data_stride complex samples apart, and
+/// [data_rot] the same samples rotated by Q15RotateMinusJ. The
+/// equalized symbol of user u is rounded and saturated to int8, scaled by
+/// the LLR scale of the user, and written as (re, im) to
+/// symbols[2 * u * symbols_stride].
+void Q15Equalize(const complex_float* zf_cell, size_t bs_ant_num,
+                 size_t ue_ant_num, const int16_t* data,
+                 const int16_t* data_rot, size_t data_stride,
+                 int data_exponent, int8_t* symbols, size_t symbols_stride);
+
+/// Compute the int8 LLRs of the [num] symbols written by Q15Equalize, in the
+/// same layout as the float soft demappers of modulation.h. The LLR scale of
+/// the user passed to Q15QuantizeZf must be Q15LlrScale(mod_order_bits)
+/// times [llr_scale].
+void Q15DemodSoft(const int8_t* symbols, int8_t* llr, size_t num,
+                  size_t mod_order_bits, float llr_scale = 1.0f);
+
+#endif  // FIXED_POINT_H_
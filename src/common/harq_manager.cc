@@ -0,0 +1,110 @@
+/**
+ * @file harq_manager.cc
+ * @brief Implementation file for the HarqManager class
+ */
+#include "harq_manager.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#include "memory_manage.h"
+#include "utils.h"
+#include "utils_ldpc.h"
+
+HarqManager::HarqManager(size_t num_ues, size_t num_processes,
+                         size_t num_buffers, size_t max_cbs,
+                         size_t base_graph, size_t zc)
+    : num_processes_(num_processes),
+      max_cbs_(max_cbs),
+      base_graph_(base_graph),
+      zc_(zc),
+      ncb_(LdpcCircularBufferLen(base_graph, zc)),
+      process_buffer_(num_ues * num_processes, kNoBuffer),
+      buffer_owner_(num_buffers, kNoOwner),
+      buffer_last_use_(num_buffers, 0),
+      received_len_(num_buffers * max_cbs, 0),
+      use_count_(0),
+      num_combined_(0),
+      num_evictions_(0) {
+  RtAssert((num_buffers > 0) && (max_cbs > 0),
+           "HarqManager: The soft buffer pool must not be empty");
+  soft_bits_ = static_cast<int16_t*>(Agora_memory::PaddedAlignedAlloc(
+      Agora_memory::Alignment_t::kAlign64,
+      num_buffers * max_cbs * ncb_ * sizeof(int16_t)));
+}
+
+HarqManager::~HarqManager() { std::free(soft_bits_); }
+
+size_t HarqManager::Acquire() {
+  size_t buffer = 0;
+  for (size_t b = 0; b < buffer_owner_.size(); b++) {
+    if (buffer_owner_[b] == kNoOwner) {
+      buffer = b;
+      break;
+    }
+    if (buffer_last_use_[b] < buffer_last_use_[buffer]) {
+      buffer = b;
+    }
+  }
+
+  if (buffer_owner_[buffer] != kNoOwner) {
+    process_buffer_[buffer_owner_[buffer]] = kNoBuffer;
+    num_evictions_++;
+  }
+  std::fill_n(received_len_.begin() + buffer * max_cbs_, max_cbs_, 0);
+  return buffer;
+}
+
+size_t HarqManager::Combine(size_t ue_id, size_t process_id, size_t cb_id,
+                            bool new_data, size_t rv, size_t mod_order_bits,
+                            const int8_t* llrs, size_t num_llrs,
+                            int8_t* decoder_llrs) {
+  RtAssert(cb_id < max_cbs_, "HarqManager: Code block id out of range");
+  const size_t process = ue_id * num_processes_ + process_id;
+  size_t buffer = process_buffer_.at(process);
+  if (buffer == kNoBuffer) {
+    buffer = Acquire();
+    buffer_owner_[buffer] = process;
+    process_buffer_[process] = buffer;
+  } else if (new_data) {
+    std::fill_n(received_len_.begin() + buffer * max_cbs_, max_cbs_, 0);
+  }
+  buffer_last_use_[buffer] = ++use_count_;
+
+  size_t& received_len = received_len_[buffer * max_cbs_ + cb_id];
+  int16_t* soft_bits = soft_bits_ + (buffer * max_cbs_ + cb_id) * ncb_;
+  if (received_len == 0) {
+    std::memset(soft_bits, 0, ncb_ * sizeof(int16_t));
+  } else {
+    num_combined_++;
+  }
+  LdpcDeRateMatch(base_graph_, zc_, rv, mod_order_bits, llrs, num_llrs,
+                  soft_bits);
+  const size_t k0 = LdpcRvStart(base_graph_, zc_, rv);
+  received_len = std::max(received_len, std::min(ncb_, k0 + num_llrs));
+
+  // The two punctured columns are not in the circular buffer
+  const size_t num_cols = (received_len + zc_ - 1) / zc_ + 2;
+  const size_t num_input_cols = LdpcNumInputCols(base_graph_);
+  size_t num_rows = kMinDecodeRows;
+  if (num_cols > num_input_cols + kMinDecodeRows) {
+    num_rows = std::min(LdpcMaxNumRows(base_graph_), num_cols - num_input_cols);
+  }
+  const size_t num_decoder_llrs =
+      LdpcNumEncodedBits(base_graph_, zc_, num_rows);
+  for (size_t i = 0; i < num_decoder_llrs; i++) {
+    decoder_llrs[i] = static_cast<int8_t>(std::min<int16_t>(
+        INT8_MAX, std::max<int16_t>(-INT8_MAX, soft_bits[i])));
+  }
+  return num_rows;
+}
+
+void HarqManager::Release(size_t ue_id, size_t process_id) {
+  const size_t process = ue_id * num_processes_ + process_id;
+  const size_t buffer = process_buffer_.at(process);
+  if (buffer != kNoBuffer) {
+    buffer_owner_[buffer] = kNoOwner;
+    process_buffer_[process] = kNoBuffer;
+  }
+}
@@ -0,0 +1,97 @@
+/**
+ * @file harq_manager.h
+ * @brief Declaration file for the HarqManager class, which keeps the soft
+ * bits of the HARQ processes of the users waiting for a retransmission in a
+ * bounded pool of soft buffers, and combines each incremental redundancy
+ * retransmission with them before decoding
+ */
+#ifndef HARQ_MANAGER_H_
+#define HARQ_MANAGER_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "rate_matching.h"
+
+class HarqManager {
+ public:
+  /// Redundancy versions of the successive transmissions of a transport
+  /// block, in the usual order: the self-decodable ones first
+  static constexpr std::array<size_t, kNumRedundancyVersions> kRvSequence = {
+      0, 2, 3, 1};
+
+  /// Fewest LDPC rows passed to the decoder: the core rows of both base
+  /// graphs, which every code rate includes
+  static constexpr size_t kMinDecodeRows = 4;
+
+  /// num_buffers soft buffers, each for up to max_cbs code blocks of the
+  /// base_graph and zc code, shared by the num_processes HARQ processes of
+  /// each of num_ues users. A HarqManager is used by one thread.
+  HarqManager(size_t num_ues, size_t num_processes, size_t num_buffers,
+              size_t max_cbs, size_t base_graph, size_t zc);
+  ~HarqManager();
+
+  /// Add the num_llrs LLRs of a transmission of code block cb_id of a HARQ
+  /// process, with redundancy version rv and mod_order_bits bits per symbol
+  /// (see LdpcDeRateMatch), to its soft buffer. new_data starts a new
+  /// transport block, dropping the soft bits of the previous one. A process
+  /// without a soft buffer (new, or whose buffer was evicted) takes a free
+  /// one, or the least recently used one if the pool is full.
+  ///
+  /// The combined LLRs of the first LdpcNumEncodedBits(base_graph, zc, rows)
+  /// bits of the circular buffer, saturated to int8 and zero for bits not
+  /// received yet, are written to decoder_llrs, where rows is the returned
+  /// number of LDPC rows to decode with: the fewest that cover all bits
+  /// received.
+  size_t Combine(size_t ue_id, size_t process_id, size_t cb_id, bool new_data,
+                 size_t rv, size_t mod_order_bits, const int8_t* llrs,
+                 size_t num_llrs, int8_t* decoder_llrs);
+
+  /// Return the soft buffer of a HARQ process to the pool, once its
+  /// transport block is decoded or dropped
+  void Release(size_t ue_id, size_t process_id);
+
+  /// Number of circular buffer LLRs of a code block
+  inline size_t SoftBufferLen() const { return this->ncb_; }
+  /// Number of transmissions combined with the soft bits of earlier ones
+  inline size_t NumCombined() const { return this->num_combined_; }
+  /// Number of soft buffers taken from processes still waiting for a
+  /// retransmission, whose soft bits were lost
+  inline size_t NumEvictions() const { return this->num_evictions_; }
+
+ private:
+  static constexpr size_t kNoOwner = SIZE_MAX;
+  static constexpr size_t kNoBuffer = SIZE_MAX;
+
+  /// Index of a free soft buffer, evicting the least recently used one if
+  /// the pool is full
+  size_t Acquire();
+
+  const size_t num_processes_;
+  const size_t max_cbs_;
+  const size_t base_graph_;
+  const size_t zc_;
+  const size_t ncb_;
+
+  /// The LLRs of code block c of soft buffer b start at
+  /// soft_bits_ + (b * max_cbs_ + c) * ncb_
+  int16_t* soft_bits_;
+  /// Soft buffer of HARQ process p of user u at u * num_processes_ + p, or
+  /// kNoBuffer
+  std::vector<size_t> process_buffer_;
+  /// HARQ process of each soft buffer (as in process_buffer_), or kNoOwner
+  std::vector<size_t> buffer_owner_;
+  /// Value of use_count_ at the last use of each soft buffer
+  std::vector<size_t> buffer_last_use_;
+  /// Length of the prefix of the circular buffer of each code block of each
+  /// soft buffer that holds all its received bits, zero if none
+  std::vector<size_t> received_len_;
+
+  size_t use_count_;
+  size_t num_combined_;
+  size_t num_evictions_;
+};
+
+#endif  // HARQ_MANAGER_H_
@@ -0,0 +1,591 @@
+/**
+ * @file ldpc_decoder.cc
+ * @brief Implementation file for the LdpcDecoder class
+ */
+#include "ldpc_decoder.h"
+
+#include <immintrin.h>
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include "memory_manage.h"
+#include "utils_ldpc.h"
+
+// Lifted columns are padded to whole AVX-512 registers of int16 lanes
+static constexpr size_t kSimdLanes = 32;
+static constexpr size_t kAvx2Lanes = 16;
+static constexpr size_t kZcPaddedMax = Roundup<kSimdLanes>(size_t{ZC_MAX});
+// Largest number of nonzero circulants in a row of either base graph
+static constexpr size_t kMaxRowDegree = 32;
+
+// Circulants of the 4 x 4 double-diagonal parity block at the start of the
+// parity columns, which the encoder's tables leave out (38.212 Table
+// 5.3.2-2, rows 0 to 3 and columns 22 to 25 of base graph 1, or columns 10
+// to 13 of base graph 2). Shifts kShiftA and kShiftB depend on the set of
+// the lifting size.
+namespace {
+enum CoreShift : int16_t { kShift0, kShiftA, kShiftB };
+struct CoreEdge {
+  uint16_t row_;
+  uint16_t col_;  // Relative to the first parity column
+  CoreShift shift_;
+};
+constexpr size_t kNumCoreEdges = 9;
+constexpr CoreEdge kBg1CoreEdges[kNumCoreEdges] = {
+    {0, 0, kShiftA}, {0, 1, kShift0}, {1, 0, kShiftB},
+    {1, 1, kShift0}, {1, 2, kShift0}, {2, 2, kShift0},
+    {2, 3, kShift0}, {3, 0, kShiftA}, {3, 3, kShift0}};
+constexpr CoreEdge kBg2CoreEdges[kNumCoreEdges] = {
+    {0, 0, kShiftA}, {0, 1, kShift0}, {1, 1, kShift0},
+    {1, 2, kShift0}, {2, 0, kShiftB}, {2, 2, kShift0},
+    {2, 3, kShift0}, {3, 0, kShiftA}, {3, 3, kShift0}};
+}  // namespace
+
+// Offset-min-sum update of one SIMD register of lanes of a row with degree
+// edges. The APP LLRs of edge e are at q_ptrs[e], and its check-to-variable
+// messages from the previous iteration are at c2v + e * c2v_stride. Replaces
+// them with the updated APP LLRs and the new messages.
+static inline void UpdateLanesAvx2(int16_t* const* q_ptrs, int16_t* c2v,
+                                   size_t c2v_stride, size_t degree) {
+  const __m256i offset = _mm256_set1_epi16(LdpcDecoder::kMinSumOffset);
+  const __m256i one = _mm256_set1_epi16(1);
+  __m256i min1 = _mm256_set1_epi16(INT16_MAX);
+  __m256i min2 = min1;
+  __m256i sign = _mm256_setzero_si256();
+  for (size_t e = 0; e < degree; e++) {
+    auto* q_ptr = reinterpret_cast<__m256i*>(q_ptrs[e]);
+    auto* r_ptr = reinterpret_cast<__m256i*>(c2v + e * c2v_stride);
+    const __m256i q = _mm256_subs_epi16(_mm256_load_si256(q_ptr),
+                                        _mm256_load_si256(r_ptr));
+    _mm256_store_si256(q_ptr, q);
+    const __m256i mag = _mm256_abs_epi16(q);
+    min2 = _mm256_min_epu16(min2, _mm256_max_epu16(min1, mag));
+    min1 = _mm256_min_epu16(min1, mag);
+    sign = _mm256_xor_si256(sign, q);
+  }
+  const __m256i min1_offset = _mm256_subs_epu16(min1, offset);
+  const __m256i min2_offset = _mm256_subs_epu16(min2, offset);
+
+  for (size_t e = 0; e < degree; e++) {
+    auto* q_ptr = reinterpret_cast<__m256i*>(q_ptrs[e]);
+    auto* r_ptr = reinterpret_cast<__m256i*>(c2v + e * c2v_stride);
+    const __m256i q = _mm256_load_si256(q_ptr);
+    // The edge with the smallest magnitude gets the second smallest
+    __m256i r =
+        _mm256_blendv_epi8(min1_offset, min2_offset,
+                           _mm256_cmpeq_epi16(_mm256_abs_epi16(q), min1));
+    // Product of the signs of the other edges
+    r = _mm256_sign_epi16(r, _mm256_or_si256(_mm256_xor_si256(sign, q), one));
+    _mm256_store_si256(r_ptr, r);
+    _mm256_store_si256(q_ptr, _mm256_adds_epi16(q, r));
+  }
+}
+
+#ifdef __AVX512BW__
+static inline void UpdateLanesAvx512(int16_t* const* q_ptrs, int16_t* c2v,
+                                     size_t c2v_stride, size_t degree) {
+  const __m512i offset = _mm512_set1_epi16(LdpcDecoder::kMinSumOffset);
+  const __m512i zero = _mm512_setzero_si512();
+  __m512i min1 = _mm512_set1_epi16(INT16_MAX);
+  __m512i min2 = min1;
+  __m512i sign = zero;
+  for (size_t e = 0; e < degree; e++) {
+    int16_t* r_ptr = c2v + e * c2v_stride;
+    const __m512i q = _mm512_subs_epi16(_mm512_load_si512(q_ptrs[e]),
+                                        _mm512_load_si512(r_ptr));
+    _mm512_store_si512(q_ptrs[e], q);
+    const __m512i mag = _mm512_abs_epi16(q);
+    min2 = _mm512_min_epu16(min2, _mm512_max_epu16(min1, mag));
+    min1 = _mm512_min_epu16(min1, mag);
+    sign = _mm512_xor_si512(sign, q);
+  }
+  const __m512i min1_offset = _mm512_subs_epu16(min1, offset);
+  const __m512i min2_offset = _mm512_subs_epu16(min2, offset);
+
+  for (size_t e = 0; e < degree; e++) {
+    int16_t* r_ptr = c2v + e * c2v_stride;
+    const __m512i q = _mm512_load_si512(q_ptrs[e]);
+    __m512i r = _mm512_mask_blend_epi16(
+        _mm512_cmpeq_epi16_mask(_mm512_abs_epi16(q), min1), min1_offset,
+        min2_offset);
+    const __mmask32 negative = _mm512_movepi16_mask(_mm512_xor_si512(sign, q));
+    r = _mm512_mask_sub_epi16(r, negative, zero, r);
+    _mm512_store_si512(r_ptr, r);
+    _mm512_store_si512(q_ptrs[e], _mm512_adds_epi16(q, r));
+  }
+}
+#endif
+
+// Offset-min-sum update of one row whose degree variable-to-check messages
+// are in v2c and check-to-variable messages from the previous iteration are
+// in c2v, zc_padded lanes per edge. Replaces c2v with the new messages and
+// v2c with the updated APP LLRs.
+static void UpdateRowAvx2(int16_t* v2c, int16_t* c2v, size_t degree,
+                          size_t zc_padded) {
+  int16_t* q_ptrs[kMaxRowDegree];
+  for (size_t k = 0; k < zc_padded; k += kAvx2Lanes) {
+    for (size_t e = 0; e < degree; e++) {
+      q_ptrs[e] = v2c + e * zc_padded + k;
+    }
+    UpdateLanesAvx2(q_ptrs, c2v + k, zc_padded, degree);
+  }
+}
+
+#ifdef __AVX512BW__
+static void UpdateRowAvx512(int16_t* v2c, int16_t* c2v, size_t degree,
+                            size_t zc_padded) {
+  int16_t* q_ptrs[kMaxRowDegree];
+  for (size_t k = 0; k < zc_padded; k += kSimdLanes) {
+    for (size_t e = 0; e < degree; e++) {
+      q_ptrs[e] = v2c + e * zc_padded + k;
+    }
+    UpdateLanesAvx512(q_ptrs, c2v + k, zc_padded, degree);
+  }
+}
+#endif
+
+LdpcDecoder::LdpcDecoder(Isa isa)
+    : isa_(isa),
+      base_graph_(0),
+      zc_(0),
+      batch_zc_max_(0),
+      batch_app_(nullptr),
+      batch_c2v_(nullptr) {
+  if ((isa_ == Isa::kAvx512) && (kAvx512Available == false)) {
+    throw std::runtime_error(
+        "LdpcDecoder: AVX-512 kernels are not compiled in");
+  }
+  app_ = static_cast<int16_t*>(Agora_memory::PaddedAlignedAlloc(
+      Agora_memory::Alignment_t::kAlign64,
+      BG1_COL_TOTAL * kZcPaddedMax * sizeof(int16_t)));
+  c2v_ = static_cast<int16_t*>(Agora_memory::PaddedAlignedAlloc(
+      Agora_memory::Alignment_t::kAlign64,
+      (BG1_NONZERO_NUM + kNumCoreEdges) * kZcPaddedMax * sizeof(int16_t)));
+  v2c_ = static_cast<int16_t*>(Agora_memory::PaddedAlignedAlloc(
+      Agora_memory::Alignment_t::kAlign64,
+      kMaxRowDegree * kZcPaddedMax * sizeof(int16_t)));
+}
+
+LdpcDecoder::~LdpcDecoder() {
+  std::free(app_);
+  std::free(c2v_);
+  std::free(v2c_);
+  std::free(batch_app_);
+  std::free(batch_c2v_);
+}
+
+void LdpcDecoder::Configure(size_t base_graph, size_t zc) {
+  // Lifting sizes are a * 2^j for the set indices a of 38.212 Table 5.3.2-1
+  size_t set_idx = zc;
+  while ((set_idx % 2 == 0) && (set_idx > 2)) {
+    set_idx /= 2;
+  }
+  if (((base_graph != 1) && (base_graph != 2)) || (zc > ZC_MAX) ||
+      (set_idx < 2) || (set_idx > 15) || (set_idx % 2 == 0 && set_idx != 2)) {
+    throw std::runtime_error("LdpcDecoder: Unsupported base graph or Zc");
+  }
+
+  const uint8_t i_ls = SelectBaseMatrixEntry(zc);
+  const bool bg1 = (base_graph == 1);
+  const size_t num_cols = bg1 ? BG1_COL_TOTAL : BG2_COL_TOTAL;
+  const size_t num_rows = LdpcMaxNumRows(base_graph);
+  const size_t num_info_cols = LdpcNumInputCols(base_graph);
+  const int16_t* num_per_col = bg1 ? kBg1MatrixNumPerCol : kBg2MatrixNumPerCol;
+  const int16_t* address = bg1 ? kBg1Address : kBg2Address;
+  const int16_t* shift_matrix =
+      bg1 ? (kBg1HShiftMatrix + i_ls * BG1_NONZERO_NUM)
+          : (kBg2HShiftMatrix + i_ls * BG2_NONZERO_NUM);
+  const CoreEdge* core_edges = bg1 ? kBg1CoreEdges : kBg2CoreEdges;
+  int16_t core_shifts[] = {0, 1, 0};
+  if (bg1 && (i_ls == 6)) {
+    core_shifts[kShiftA] = 0;
+    core_shifts[kShiftB] = 105;
+  } else if (!bg1) {
+    const bool set_3_or_7 = (i_ls == 3) || (i_ls == 7);
+    core_shifts[kShiftA] = set_3_or_7 ? 1 : 0;
+    core_shifts[kShiftB] = set_3_or_7 ? 0 : 1;
+  }
+
+  // The encoder's tables are column-major with the row index in the address
+  std::vector<std::vector<Edge>> rows(num_rows);
+  size_t idx = 0;
+  for (size_t col = 0; col < num_cols; col++) {
+    for (int16_t i = 0; i < num_per_col[col]; i++, idx++) {
+      rows.at(address[idx] / PROC_BYTES)
+          .push_back({static_cast<uint16_t>(col),
+                      static_cast<uint16_t>(shift_matrix[idx] % zc)});
+    }
+  }
+  for (size_t i = 0; i < kNumCoreEdges; i++) {
+    rows.at(core_edges[i].row_)
+        .push_back(
+            {static_cast<uint16_t>(num_info_cols + core_edges[i].col_),
+             static_cast<uint16_t>(core_shifts[core_edges[i].shift_] % zc)});
+  }
+
+  row_start_.assign(1, 0);
+  edges_.clear();
+  for (auto& row : rows) {
+    RtAssert(row.size() <= kMaxRowDegree, "LdpcDecoder: Row degree too large");
+    std::sort(row.begin(), row.end(), [](const Edge& a, const Edge& b) {
+      return a.col_ < b.col_;
+    });
+    edges_.insert(edges_.end(), row.begin(), row.end());
+    row_start_.push_back(edges_.size());
+  }
+
+  base_graph_ = base_graph;
+  zc_ = zc;
+  zc_padded_ = Roundup<kSimdLanes>(zc);
+}
+
+void LdpcDecoder::GatherRow(size_t row) {
+  for (size_t e = row_start_[row]; e < row_start_[row + 1]; e++) {
+    const int16_t* src = app_ + edges_[e].col_ * zc_padded_;
+    int16_t* dst = v2c_ + (e - row_start_[row]) * zc_padded_;
+    const size_t shift = edges_[e].shift_;
+    // Lane k of the row checks bit (k + shift) mod Zc of the column
+    std::memcpy(dst, src + shift, (zc_ - shift) * sizeof(int16_t));
+    std::memcpy(dst + zc_ - shift, src, shift * sizeof(int16_t));
+  }
+}
+
+void LdpcDecoder::ScatterRow(size_t row) {
+  for (size_t e = row_start_[row]; e < row_start_[row + 1]; e++) {
+    int16_t* dst = app_ + edges_[e].col_ * zc_padded_;
+    const int16_t* src = v2c_ + (e - row_start_[row]) * zc_padded_;
+    const size_t shift = edges_[e].shift_;
+    std::memcpy(dst + shift, src, (zc_ - shift) * sizeof(int16_t));
+    std::memcpy(dst, src + zc_ - shift, shift * sizeof(int16_t));
+  }
+}
+
+// Sign bits of the 16 int16 lanes at [in], lane i in bit i
+static inline uint32_t SignBits(const int16_t* in) {
+  const auto byte_signs = static_cast<uint32_t>(_mm256_movemask_epi8(
+      _mm256_load_si256(reinterpret_cast<const __m256i*>(in))));
+  return _pext_u32(byte_signs, 0xAAAAAAAAu);
+}
+
+bool LdpcDecoder::CheckParity(size_t num_rows) {
+  for (size_t row = 0; row < num_rows; row++) {
+    GatherRow(row);
+    const size_t degree = row_start_[row + 1] - row_start_[row];
+    for (size_t k = 0; k < zc_; k += kAvx2Lanes) {
+      __m256i parity = _mm256_setzero_si256();
+      for (size_t e = 0; e < degree; e++) {
+        parity = _mm256_xor_si256(
+            parity, _mm256_load_si256(reinterpret_cast<const __m256i*>(
+                        v2c_ + e * zc_padded_ + k)));
+      }
+      alignas(32) int16_t parity_lanes[kAvx2Lanes];
+      _mm256_store_si256(reinterpret_cast<__m256i*>(parity_lanes), parity);
+      uint32_t failed = SignBits(parity_lanes);
+      if (zc_ - k < kAvx2Lanes) {
+        failed &= (1u << (zc_ - k)) - 1;  // Ignore the padding lanes
+      }
+      if (failed != 0) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+int32_t LdpcDecoder::Decode(const bblib_ldpc_decoder_5gnr_request* request,
+                            bblib_ldpc_decoder_5gnr_response* response) {
+  const size_t base_graph = request->baseGraph;
+  const size_t zc = request->Zc;
+  if ((base_graph != base_graph_) || (zc != zc_)) {
+    Configure(base_graph, zc);
+  }
+  const size_t num_rows = request->nRows;
+  if ((num_rows < 4) || (num_rows > LdpcMaxNumRows(base_graph))) {
+    throw std::runtime_error("LdpcDecoder: Unsupported number of rows");
+  }
+  const size_t num_cols = LdpcNumInputCols(base_graph) + num_rows;
+  const size_t num_info_bits = LdpcNumInputBits(base_graph, zc);
+  const size_t filler_start = num_info_bits - request->numFillerBits;
+
+  // The punctured bits are unknown, the filler bits are known zeros, and
+  // the channel LLRs fill the rest of the code block in order
+  const int8_t* llrs = request->varNodes;
+  size_t num_llrs_left = request->numChannelLlrs;
+  for (size_t col = 0; col < num_cols; col++) {
+    int16_t* app_col = app_ + col * zc_padded_;
+    std::memset(app_col, 0, zc_padded_ * sizeof(int16_t));
+    if (col < 2) {
+      continue;
+    }
+    for (size_t k = 0; k < zc;) {
+      const size_t bit = col * zc + k;
+      if ((bit >= filler_start) && (bit < num_info_bits)) {
+        const size_t n = std::min(zc - k, num_info_bits - bit);
+        std::fill_n(app_col + k, n, INT16_MAX);
+        k += n;
+      } else {
+        const size_t n = std::min(
+            {zc - k, num_llrs_left,
+             bit < filler_start ? filler_start - bit : SIZE_MAX});
+        std::copy(llrs, llrs + n, app_col + k);
+        llrs += n;
+        num_llrs_left -= n;
+        k = (n == 0) ? zc : k + n;
+      }
+    }
+  }
+  std::memset(c2v_, 0, row_start_[num_rows] * zc_padded_ * sizeof(int16_t));
+
+  auto* update_row = UpdateRowAvx2;
+#ifdef __AVX512BW__
+  if (isa_ == Isa::kAvx512) {
+    update_row = UpdateRowAvx512;
+  }
+#endif
+
+  const bool early_termination = (request->enableEarlyTermination != 0);
+  size_t iter = 0;
+  bool parity_passed = false;
+  while (iter < static_cast<size_t>(request->maxIterations)) {
+    for (size_t row = 0; row < num_rows; row++) {
+      GatherRow(row);
+      update_row(v2c_, c2v_ + row_start_[row] * zc_padded_,
+                 row_start_[row + 1] - row_start_[row], zc_padded_);
+      ScatterRow(row);
+    }
+    iter++;
+    if (early_termination && CheckParity(num_rows)) {
+      parity_passed = true;
+      break;
+    }
+  }
+  if (!early_termination) {
+    parity_passed = CheckParity(num_rows);
+  }
+
+  // Pack the sign bits of the first numMsgBits APP LLRs
+  uint8_t* out = response->compactedMessageBytes;
+  size_t bits_left = response->numMsgBits;
+  uint64_t acc = 0;
+  size_t acc_bits = 0;
+  for (size_t col = 0; bits_left > 0; col++) {
+    for (size_t k = 0; (k < zc) && (bits_left > 0); k += kAvx2Lanes) {
+      const size_t n = std::min({zc - k, kAvx2Lanes, bits_left});
+      uint32_t hard_bits = SignBits(app_ + col * zc_padded_ + k);
+      if (n < kAvx2Lanes) {
+        hard_bits &= (1u << n) - 1;
+      }
+      acc |= static_cast<uint64_t>(hard_bits) << acc_bits;
+      acc_bits += n;
+      bits_left -= n;
+      while (acc_bits >= 8) {
+        *out++ = static_cast<uint8_t>(acc);
+        acc >>= 8;
+        acc_bits -= 8;
+      }
+    }
+  }
+  if (acc_bits > 0) {
+    *out = static_cast<uint8_t>(acc);
+  }
+
+  response->iterationAtTermination = static_cast<int32_t>(iter);
+  response->parityPassedAtTermination = parity_passed ? 1 : 0;
+  return 0;
+}
+
+void LdpcDecoder::UpdateRowBatch(size_t row) {
+  const size_t lanes = BatchSize();
+  const size_t degree = row_start_[row + 1] - row_start_[row];
+  const Edge* edges = &edges_[row_start_[row]];
+  int16_t* c2v = batch_c2v_ + row_start_[row] * zc_ * lanes;
+  auto* update_lanes = UpdateLanesAvx2;
+#ifdef __AVX512BW__
+  if (isa_ == Isa::kAvx512) {
+    update_lanes = UpdateLanesAvx512;
+  }
+#endif
+
+  // Lifted copy k of the row checks bit (k + shift) mod Zc of each column
+  int16_t* cols[kMaxRowDegree];
+  size_t bits[kMaxRowDegree];
+  for (size_t e = 0; e < degree; e++) {
+    cols[e] = batch_app_ + edges[e].col_ * zc_ * lanes;
+    bits[e] = edges[e].shift_;
+  }
+  int16_t* q_ptrs[kMaxRowDegree];
+  for (size_t k = 0; k < zc_; k++) {
+    for (size_t e = 0; e < degree; e++) {
+      q_ptrs[e] = cols[e] + bits[e] * lanes;
+      bits[e] = (bits[e] + 1 == zc_) ? 0 : bits[e] + 1;
+    }
+    update_lanes(q_ptrs, c2v + k * lanes, zc_ * lanes, degree);
+  }
+}
+
+uint32_t LdpcDecoder::CheckParityBatch(size_t num_rows, uint32_t lanes_mask) {
+  const size_t lanes = BatchSize();
+  uint32_t failed = 0;
+  for (size_t row = 0; (row < num_rows) && (failed != lanes_mask); row++) {
+    const size_t degree = row_start_[row + 1] - row_start_[row];
+    const Edge* edges = &edges_[row_start_[row]];
+    const int16_t* cols[kMaxRowDegree];
+    size_t bits[kMaxRowDegree];
+    for (size_t e = 0; e < degree; e++) {
+      cols[e] = batch_app_ + edges[e].col_ * zc_ * lanes;
+      bits[e] = edges[e].shift_;
+    }
+    for (size_t k = 0; k < zc_; k++) {
+      for (size_t lane = 0; lane < lanes; lane += kAvx2Lanes) {
+        __m256i parity = _mm256_setzero_si256();
+        for (size_t e = 0; e < degree; e++) {
+          parity = _mm256_xor_si256(
+              parity, _mm256_load_si256(reinterpret_cast<const __m256i*>(
+                          cols[e] + bits[e] * lanes + lane)));
+        }
+        alignas(32) int16_t parity_lanes[kAvx2Lanes];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(parity_lanes), parity);
+        failed |= (SignBits(parity_lanes) << lane) & lanes_mask;
+      }
+      for (size_t e = 0; e < degree; e++) {
+        bits[e] = (bits[e] + 1 == zc_) ? 0 : bits[e] + 1;
+      }
+    }
+  }
+  return failed;
+}
+
+void LdpcDecoder::PackBatch(bblib_ldpc_decoder_5gnr_response* responses,
+                            uint32_t lanes, size_t iterations,
+                            bool parity_passed) {
+  const size_t batch_size = BatchSize();
+  size_t num_bits = 0;
+  for (size_t b = 0; b < batch_size; b++) {
+    if ((lanes >> b) & 1) {
+      num_bits = std::max(num_bits,
+                          static_cast<size_t>(responses[b].numMsgBits));
+    }
+  }
+  // Sign bits of all lanes of each bit, then the bits of each lane
+  batch_signs_.resize(num_bits);
+  for (size_t n = 0; n < num_bits; n++) {
+    uint32_t signs = 0;
+    for (size_t lane = 0; lane < batch_size; lane += kAvx2Lanes) {
+      signs |= SignBits(batch_app_ + n * batch_size + lane) << lane;
+    }
+    batch_signs_[n] = signs;
+  }
+
+  for (size_t b = 0; b < batch_size; b++) {
+    if (((lanes >> b) & 1) == 0) {
+      continue;
+    }
+    uint8_t* out = responses[b].compactedMessageBytes;
+    const size_t num_msg_bits = responses[b].numMsgBits;
+    for (size_t i = 0; i < num_msg_bits; i += 8) {
+      uint8_t byte = 0;
+      for (size_t j = 0; j < std::min(size_t{8}, num_msg_bits - i); j++) {
+        byte |= ((batch_signs_[i + j] >> b) & 1) << j;
+      }
+      out[i / 8] = byte;
+    }
+    responses[b].iterationAtTermination = static_cast<int32_t>(iterations);
+    responses[b].parityPassedAtTermination = parity_passed ? 1 : 0;
+  }
+}
+
+int32_t LdpcDecoder::DecodeBatch(
+    const bblib_ldpc_decoder_5gnr_request* requests,
+    bblib_ldpc_decoder_5gnr_response* responses, size_t num_blocks) {
+  RtAssert((num_blocks > 0) && (num_blocks <= BatchSize()),
+           "LdpcDecoder: Invalid number of code blocks in batch");
+  const bblib_ldpc_decoder_5gnr_request& first = requests[0];
+  for (size_t b = 1; b < num_blocks; b++) {
+    if ((requests[b].baseGraph != first.baseGraph) ||
+        (requests[b].Zc != first.Zc) || (requests[b].nRows != first.nRows) ||
+        (requests[b].maxIterations != first.maxIterations) ||
+        (requests[b].enableEarlyTermination != first.enableEarlyTermination)) {
+      throw std::runtime_error(
+          "LdpcDecoder: Code blocks of a batch must use the same code");
+    }
+  }
+  const size_t base_graph = first.baseGraph;
+  const size_t zc = first.Zc;
+  if ((base_graph != base_graph_) || (zc != zc_)) {
+    Configure(base_graph, zc);
+  }
+  const size_t num_rows = first.nRows;
+  if ((num_rows < 4) || (num_rows > LdpcMaxNumRows(base_graph))) {
+    throw std::runtime_error("LdpcDecoder: Unsupported number of rows");
+  }
+  const size_t lanes = BatchSize();
+  if (zc > batch_zc_max_) {
+    // Sized for base graph 1, which has more columns and edges
+    std::free(batch_app_);
+    std::free(batch_c2v_);
+    batch_app_ = static_cast<int16_t*>(Agora_memory::PaddedAlignedAlloc(
+        Agora_memory::Alignment_t::kAlign64,
+        BG1_COL_TOTAL * zc * lanes * sizeof(int16_t)));
+    batch_c2v_ = static_cast<int16_t*>(Agora_memory::PaddedAlignedAlloc(
+        Agora_memory::Alignment_t::kAlign64,
+        (BG1_NONZERO_NUM + kNumCoreEdges) * zc * lanes * sizeof(int16_t)));
+    batch_zc_max_ = zc;
+  }
+  const size_t num_bits = (LdpcNumInputCols(base_graph) + num_rows) * zc;
+  const size_t num_info_bits = LdpcNumInputBits(base_graph, zc);
+
+  // Same APP LLRs as in Decode. Unused lanes stay zero, the all-zeros
+  // code word.
+  std::memset(batch_app_, 0, num_bits * lanes * sizeof(int16_t));
+  for (size_t b = 0; b < num_blocks; b++) {
+    const size_t filler_start = num_info_bits - requests[b].numFillerBits;
+    const int8_t* llrs = requests[b].varNodes;
+    size_t num_llrs_left = requests[b].numChannelLlrs;
+    for (size_t n = 2 * zc; n < num_bits; n++) {
+      if ((n >= filler_start) && (n < num_info_bits)) {
+        batch_app_[n * lanes + b] = INT16_MAX;
+      } else if (num_llrs_left > 0) {
+        batch_app_[n * lanes + b] = *llrs++;
+        num_llrs_left--;
+      } else if (n >= num_info_bits) {
+        break;
+      }
+    }
+  }
+  std::memset(batch_c2v_, 0,
+              row_start_[num_rows] * zc * lanes * sizeof(int16_t));
+
+  const uint32_t all_lanes =
+      (num_blocks == 32) ? UINT32_MAX : (1u << num_blocks) - 1;
+  uint32_t done_lanes = 0;  // Lanes whose decoded bits are packed
+  const bool early_termination = (first.enableEarlyTermination != 0);
+  size_t iter = 0;
+  while ((iter < static_cast<size_t>(first.maxIterations)) &&
+         (done_lanes != all_lanes)) {
+    for (size_t row = 0; row < num_rows; row++) {
+      UpdateRowBatch(row);
+    }
+    iter++;
+    if (early_termination) {
+      // A code block's result is taken when it first passes, as in Decode
+      const uint32_t undone_lanes = all_lanes & ~done_lanes;
+      const uint32_t passed =
+          undone_lanes & ~CheckParityBatch(num_rows, undone_lanes);
+      if (passed != 0) {
+        PackBatch(responses, passed, iter, true);
+        done_lanes |= passed;
+      }
+    }
+  }
+  const uint32_t remaining = all_lanes & ~done_lanes;
+  if (remaining != 0) {
+    const uint32_t passed =
+        early_termination ? 0
+                          : remaining & ~CheckParityBatch(num_rows, remaining);
+    PackBatch(responses, passed, iter, true);
+    PackBatch(responses, remaining & ~passed, iter, false);
+  }
+  return 0;
+}
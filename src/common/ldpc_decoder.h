@@ -0,0 +1,122 @@
+/**
+ * @file ldpc_decoder.h
+ * @brief Declaration file for the LdpcDecoder class, Agora's layered
+ * offset-min-sum decoder for the 5G NR LDPC base graphs, an alternative to
+ * FlexRAN's bblib_ldpc_decoder_5gnr
+ */
+#ifndef LDPC_DECODER_H_
+#define LDPC_DECODER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "phy_ldpc_decoder_5gnr.h"
+
+class LdpcDecoder {
+ public:
+  /// Instruction set of the decoding kernels. The Zc lifted copies of a
+  /// base graph row are decoded in parallel, 16 (AVX2) or 32 (AVX-512) int16
+  /// lanes per instruction.
+  enum class Isa { kAvx2, kAvx512 };
+
+  /// True if the AVX-512 kernels are compiled in
+#ifdef __AVX512BW__
+  static constexpr bool kAvx512Available = true;
+#else
+  static constexpr bool kAvx512Available = false;
+#endif
+
+  /// Offset subtracted from the check-to-variable message magnitudes, in
+  /// units of the int8 channel LLRs: 0.5 for LLRs with the two fractional
+  /// bits of the scaled soft demappers (kSoftDemodLlrFracBits)
+  static constexpr int16_t kMinSumOffset = 2;
+
+  /// Largest number of code blocks that DecodeBatch decodes together
+  static constexpr size_t kMaxBatchSize = 32;
+
+  explicit LdpcDecoder(Isa isa);
+  ~LdpcDecoder();
+
+  /// Decode one code block, with the same inputs and outputs as FlexRAN's
+  /// bblib_ldpc_decoder_5gnr: request->varNodes are the numChannelLlrs int8
+  /// LLRs (positive for bit 0) of the code block after the 2 * Zc punctured
+  /// bits, without the filler bits, which are the last numFillerBits
+  /// information bits and known to be zero. The first response->numMsgBits
+  /// decoded bits are packed to response->compactedMessageBytes, least
+  /// significant bit first. response->varNodes is not used.
+  int32_t Decode(const bblib_ldpc_decoder_5gnr_request* request,
+                 bblib_ldpc_decoder_5gnr_response* response);
+
+  /// Number of code blocks that DecodeBatch decodes together, one per int16
+  /// lane of a SIMD register: 16 (AVX2) or 32 (AVX-512)
+  size_t BatchSize() const { return isa_ == Isa::kAvx512 ? 32 : 16; }
+
+  /// Decode num_blocks (at most BatchSize()) code blocks of the same code
+  /// together, code block i in lane i of every SIMD register. requests[i]
+  /// and responses[i] are as for Decode, and the requests must have the same
+  /// baseGraph, Zc, nRows, maxIterations, and enableEarlyTermination. Each
+  /// code block gets the same decoded bits and iteration count as from
+  /// Decode. The lifted copies of a row are updated one after another, so the
+  /// circulant shifts only select addresses, and small Zc leave no lanes idle.
+  int32_t DecodeBatch(const bblib_ldpc_decoder_5gnr_request* requests,
+                      bblib_ldpc_decoder_5gnr_response* responses,
+                      size_t num_blocks);
+
+ private:
+  /// Circulant of the lifted parity check matrix: the Zc x Zc identity
+  /// cyclically shifted by shift_, in base graph column col_
+  struct Edge {
+    uint16_t col_;
+    uint16_t shift_;
+  };
+
+  /// Build the rows of the lifted parity check matrix
+  void Configure(size_t base_graph, size_t zc);
+
+  /// Copy the APP LLRs of the columns of row [row] into v2c_, each rotated
+  /// by the shift of its circulant
+  void GatherRow(size_t row);
+  /// Copy v2c_ back to the APP LLRs of the columns of row [row]
+  void ScatterRow(size_t row);
+
+  /// True if the hard decisions of the APP LLRs satisfy the first num_rows
+  /// rows of the parity check matrix
+  bool CheckParity(size_t num_rows);
+
+  /// Layered update of row [row] of the code blocks of a batch
+  void UpdateRowBatch(size_t row);
+  /// Bitmask of the lanes in lanes_mask whose hard decisions do not satisfy
+  /// the first num_rows rows of the parity check matrix
+  uint32_t CheckParityBatch(size_t num_rows, uint32_t lanes_mask);
+  /// Pack the decoded bits of the code blocks in the lanes of [lanes] to
+  /// their responses
+  void PackBatch(bblib_ldpc_decoder_5gnr_response* responses, uint32_t lanes,
+                 size_t iterations, bool parity_passed);
+
+  Isa isa_;
+  size_t base_graph_;
+  size_t zc_;
+  size_t zc_padded_;  // zc_ rounded up to a multiple of the widest SIMD op
+
+  /// Edges of base graph row r are edges_[row_start_[r], row_start_[r + 1])
+  std::vector<size_t> row_start_;
+  std::vector<Edge> edges_;
+
+  // The int8 channel LLRs are widened to int16 so that the APP LLRs do not
+  // saturate, which breaks the layered updates
+  int16_t* app_;  // A posteriori LLRs, zc_padded_ per base graph column
+  int16_t* c2v_;  // Check-to-variable messages, zc_padded_ per edge
+  int16_t* v2c_;  // Variable-to-check messages of one row, zc_padded_ per edge
+
+  // DecodeBatch keeps the LLRs of lifted bit n of all code blocks of the
+  // batch in one SIMD register at batch_app_ + n * BatchSize(). The buffers
+  // are allocated by the first DecodeBatch, for lifting sizes up to
+  // batch_zc_max_.
+  size_t batch_zc_max_;
+  int16_t* batch_app_;
+  int16_t* batch_c2v_;
+  std::vector<uint32_t> batch_signs_;  // Sign bits of the lanes of each bit
+};
+
+#endif  // LDPC_DECODER_H_
@@ -1,5 +1,9 @@
 #include "modulation.h"
 
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
 void Print256Epi32(__m256i var) {
   auto* val = reinterpret_cast<int32_t*>(&var);
   std::printf("Numerical: %i %i %i %i %i %i %i %i \n", val[0], val[1], val[2],
@@ -254,6 +258,41 @@ void ModSimd(uint8_t* in, complex_float*& out, size_t len,
  ***********************************************************************************
  */
 
+float SoftDemodLlrScale(size_t mod_order_bits, float snr) {
+  // The max-log LLRs of unit-power QAM symbols are 4 * d * snr times the
+  // distances the soft demappers compute, where d is half the minimum
+  // distance of the constellation. The demappers scale those distances by
+  // SCALE_BYTE_CONV_*, and by sqrt(2) more for QPSK.
+  const size_t levels = size_t(1) << (mod_order_bits / 2);
+  const float d = 1.0f / std::sqrt(2.0f * (levels * levels - 1) / 3.0f);
+  float demod_scale;
+  switch (mod_order_bits) {
+    case 2:
+      demod_scale = SCALE_BYTE_CONV_QPSK * M_SQRT2;
+      break;
+    case 4:
+      demod_scale = SCALE_BYTE_CONV_QAM16;
+      break;
+    case 6:
+      demod_scale = SCALE_BYTE_CONV_QAM64;
+      break;
+    case 8:
+      demod_scale = SCALE_BYTE_CONV_QAM256;
+      break;
+    default:
+      throw std::runtime_error("Unsupported modulation order bits " +
+                               std::to_string(mod_order_bits));
+  }
+  const float llr_scale =
+      std::ldexp(4.0f * d * snr, kSoftDemodLlrFracBits) / demod_scale;
+  // The outermost levels, (levels - 1) * d, must stay within int8 range:
+  // saturating them would move symbols across the thresholds of the LLRs of
+  // the lower bits
+  const float max_llr_scale = std::min(
+      kMaxSoftDemodLlrScale, INT8_MAX / (demod_scale * (levels - 1) * d));
+  return std::min(std::max(llr_scale, kMinSoftDemodLlrScale), max_llr_scale);
+}
+
 // /**
 //   * 16-QAM demodulation
 //   *              Q
@@ -575,7 +614,8 @@ void Demod16qamHardAvx2(float* vec_in, uint8_t* vec_out, int num) {
                     num - next_start);
 }
 
-void Demod16qamSoftAvx2(float* vec_in, int8_t* llr, int num) {
+void Demod16qamSoftAvx2(float* vec_in, int8_t* llr, int num, float llr_scale) {
+  const float scale = SCALE_BYTE_CONV_QAM16 * llr_scale;
   float* symbols_ptr = vec_in;
   auto* result_ptr = reinterpret_cast<__m256i*>(llr);
   __m256 symbol1;
@@ -590,14 +630,14 @@ void Demod16qamSoftAvx2(float* vec_in, int8_t* llr, int num) {
   __m256i symbol_abs;
   __m256i symbol_12;
   __m256i symbol_34;
-  __m256i offset = _mm256_set1_epi8(2 * SCALE_BYTE_CONV_QAM16 / sqrt(10));
+  __m256i offset = _mm256_set1_epi8(2 * scale / sqrt(10));
   __m256i result1n;
   __m256i result1a;
   __m256i result2n;
   __m256i result2a;
   __m256i result1na;
   __m256i result2na;
-  __m256 scale_v = _mm256_set1_ps(SCALE_BYTE_CONV_QAM16);
+  __m256 scale_v = _mm256_set1_ps(scale);
 
   __m256i shuffle_negated_1 = _mm256_set_epi8(
       0xff, 0xff, 7, 6, 0xff, 0xff, 5, 4, 0xff, 0xff, 3, 2, 0xff, 0xff, 1, 0,
@@ -657,7 +697,7 @@ void Demod16qamSoftAvx2(float* vec_in, int8_t* llr, int num) {
   // Demodulate last symbols
   int next_start = 16 * (num / 16);
   Demod16qamSoftSse(vec_in + 2 * next_start, llr + next_start * 4,
-                    num - next_start);
+                    num - next_start, llr_scale);
 }
 
 /**
@@ -1077,7 +1117,8 @@ void Demod64qamHardAvx2(float* vec_in, uint8_t* vec_out, int num) {
                     num - next_start);
 }
 
-void Demod64qamSoftAvx2(float* vec_in, int8_t* llr, int num) {
+void Demod64qamSoftAvx2(float* vec_in, int8_t* llr, int num, float llr_scale) {
+  const float scale = SCALE_BYTE_CONV_QAM64 * llr_scale;
   auto* symbols_ptr = static_cast<float*>(vec_in);
   auto* result_ptr = reinterpret_cast<__m256i*>(llr);
   __m256 symbol1;
@@ -1093,9 +1134,9 @@ void Demod64qamSoftAvx2(float* vec_in, int8_t* llr, int num) {
   __m256i symbol_abs2;
   __m256i symbol_12;
   __m256i symbol_34;
-  __m256i offset1 = _mm256_set1_epi8(4 * SCALE_BYTE_CONV_QAM64 / sqrt(42));
-  __m256i offset2 = _mm256_set1_epi8(2 * SCALE_BYTE_CONV_QAM64 / sqrt(42));
-  __m256 scale_v = _mm256_set1_ps(SCALE_BYTE_CONV_QAM64);
+  __m256i offset1 = _mm256_set1_epi8(4 * scale / sqrt(42));
+  __m256i offset2 = _mm256_set1_epi8(2 * scale / sqrt(42));
+  __m256 scale_v = _mm256_set1_ps(scale);
   __m256i result11;
   __m256i result12;
   __m256i result13;
@@ -1219,7 +1260,7 @@ void Demod64qamSoftAvx2(float* vec_in, int8_t* llr, int num) {
   }
   int next_start = 16 * (num / 16);
   Demod64qamSoftSse(vec_in + 2 * next_start, llr + next_start * 6,
-                    num - next_start);
+                    num - next_start, llr_scale);
 }
 
 /**
@@ -2093,7 +2134,9 @@ void Demod256qamHardAvx512(float* vec_in, uint8_t* vec_out, int num) {
 
 #endif
 
-void Demod256qamSoftLoop(const float* vec_in, int8_t* llr, int num) {
+void Demod256qamSoftLoop(const float* vec_in, int8_t* llr, int num,
+                         float llr_scale) {
+  const float scale = SCALE_BYTE_CONV_QAM256 * llr_scale;
   /**
    * LLR algorithm derived from paper:
    * Q. Sun and W. Qi,
@@ -2102,26 +2145,30 @@ void Demod256qamSoftLoop(const float* vec_in, int8_t* llr, int num) {
    * pp. 2309-2312, doi: 10.1109/ICoSP.2012.6492042.
    *
    * Equations 7, 8, and 9
+   *
+   * The 256QAM table maps bit 1 to the positive levels, so the symbols and
+   * the threshold distances are negated to make the LLRs positive for bit 0,
+   * like those of the other demappers and as the LDPC decoders expect.
    */
   int i;
   int8_t re;
   int8_t im;
-  const uint8_t t1 = QAM256_THRESHOLD_4 * SCALE_BYTE_CONV_QAM256;
-  const uint8_t t2 = QAM256_THRESHOLD_2 * SCALE_BYTE_CONV_QAM256;
-  const uint8_t t3 = QAM256_THRESHOLD_1 * SCALE_BYTE_CONV_QAM256;
+  const uint8_t t1 = QAM256_THRESHOLD_4 * scale;
+  const uint8_t t2 = QAM256_THRESHOLD_2 * scale;
+  const uint8_t t3 = QAM256_THRESHOLD_1 * scale;
   for (i = 0; i < num; i++) {
-    re = (int8_t)(SCALE_BYTE_CONV_QAM256 * (vec_in[2 * i]));
-    im = (int8_t)(SCALE_BYTE_CONV_QAM256 * (vec_in[2 * i + 1]));
+    re = (int8_t)(-scale * (vec_in[2 * i]));
+    im = (int8_t)(-scale * (vec_in[2 * i + 1]));
 
     // Upper two bits simply use real and imaginary values
     llr[8 * i + 0] = re;
     llr[8 * i + 1] = im;
     // Next two bits use the absolute value of the prior 2 and a threshold
-    llr[8 * i + 2] = t1 - abs(re);
-    llr[8 * i + 3] = t1 - abs(im);
+    llr[8 * i + 2] = abs(re) - t1;
+    llr[8 * i + 3] = abs(im) - t1;
     // Once again, calculate the LLR recursively using boundary judgement method
-    llr[8 * i + 4] = t2 - abs(llr[8 * i + 2]);
-    llr[8 * i + 5] = t2 - abs(llr[8 * i + 3]);
+    llr[8 * i + 4] = abs(llr[8 * i + 2]) - t2;
+    llr[8 * i + 5] = abs(llr[8 * i + 3]) - t2;
     /**
      * Same pattern for the final bits. Note that the threshold that is
      * subtracted from is based on the threshold across which the bits revelant
@@ -2132,12 +2179,14 @@ void Demod256qamSoftLoop(const float* vec_in, int8_t* llr, int num) {
      * distance the symbol is from either QAM256_THRESHOLD_2 or
      * QAM256_THRESHOLD_6, whichever is closest.
      */
-    llr[8 * i + 6] = t3 - abs(llr[8 * i + 4]);
-    llr[8 * i + 7] = t3 - abs(llr[8 * i + 5]);
+    llr[8 * i + 6] = abs(llr[8 * i + 4]) - t3;
+    llr[8 * i + 7] = abs(llr[8 * i + 5]) - t3;
   }
 }
 
-void Demod256qamSoftSse(const float* vec_in, int8_t* llr, int num) {
+void Demod256qamSoftSse(const float* vec_in, int8_t* llr, int num,
+                        float llr_scale) {
+  const float scale = SCALE_BYTE_CONV_QAM256 * llr_scale;
   float* symbols_ptr = (float*)vec_in;
   auto* result_ptr = reinterpret_cast<__m128i*>(llr);
   __m128 symbol1;
@@ -2154,10 +2203,11 @@ void Demod256qamSoftSse(const float* vec_in, int8_t* llr, int num) {
   __m128i symbol_bit10;
   __m128i symbol_12;
   __m128i symbol_34;
-  __m128i offset1 = _mm_set1_epi8(QAM256_THRESHOLD_1 * SCALE_BYTE_CONV_QAM256);
-  __m128i offset2 = _mm_set1_epi8(QAM256_THRESHOLD_2 * SCALE_BYTE_CONV_QAM256);
-  __m128i offset3 = _mm_set1_epi8(QAM256_THRESHOLD_4 * SCALE_BYTE_CONV_QAM256);
-  __m128 scale_v = _mm_set1_ps(SCALE_BYTE_CONV_QAM256);
+  __m128i offset1 = _mm_set1_epi8(QAM256_THRESHOLD_1 * scale);
+  __m128i offset2 = _mm_set1_epi8(QAM256_THRESHOLD_2 * scale);
+  __m128i offset3 = _mm_set1_epi8(QAM256_THRESHOLD_4 * scale);
+  // Negated as in Demod256qamSoftLoop
+  __m128 scale_v = _mm_set1_ps(-scale);
   __m128i result10;
   __m128i result32;
   __m128i result54;
@@ -2246,9 +2296,9 @@ void Demod256qamSoftSse(const float* vec_in, int8_t* llr, int num) {
      * absolute value of the prior vector for the next subtraction,
      * like in the traditional LLR
      */
-    symbol_bit54 = _mm_sub_epi8(offset3, _mm_abs_epi8(symbol_i));
-    symbol_bit32 = _mm_sub_epi8(offset2, _mm_abs_epi8(symbol_bit54));
-    symbol_bit10 = _mm_sub_epi8(offset1, _mm_abs_epi8(symbol_bit32));
+    symbol_bit54 = _mm_sub_epi8(_mm_abs_epi8(symbol_i), offset3);
+    symbol_bit32 = _mm_sub_epi8(_mm_abs_epi8(symbol_bit54), offset2);
+    symbol_bit10 = _mm_sub_epi8(_mm_abs_epi8(symbol_bit32), offset1);
 
     /*
      * Now extract the result and store it. We must do this 4 times due
@@ -2298,10 +2348,12 @@ void Demod256qamSoftSse(const float* vec_in, int8_t* llr, int num) {
   // Demodulate the last symbols
   int next_start = 8 * (num / 8);
   Demod256qamSoftLoop(vec_in + 2 * next_start, llr + next_start * 8,
-                      num - next_start);
+                      num - next_start, llr_scale);
 }
 
-void Demod256qamSoftAvx2(const float* vec_in, int8_t* llr, int num) {
+void Demod256qamSoftAvx2(const float* vec_in, int8_t* llr, int num,
+                         float llr_scale) {
+  const float scale = SCALE_BYTE_CONV_QAM256 * llr_scale;
   float* symbols_ptr = (float*)vec_in;
   auto* result_ptr = reinterpret_cast<__m256i*>(llr);
   __m256 symbol1;
@@ -2319,12 +2371,13 @@ void Demod256qamSoftAvx2(const float* vec_in, int8_t* llr, int num) {
   __m256i symbol_12;
   __m256i symbol_34;
   __m256i offset1 =
-      _mm256_set1_epi8(QAM256_THRESHOLD_1 * SCALE_BYTE_CONV_QAM256);
+      _mm256_set1_epi8(QAM256_THRESHOLD_1 * scale);
   __m256i offset2 =
-      _mm256_set1_epi8(QAM256_THRESHOLD_2 * SCALE_BYTE_CONV_QAM256);
+      _mm256_set1_epi8(QAM256_THRESHOLD_2 * scale);
   __m256i offset3 =
-      _mm256_set1_epi8(QAM256_THRESHOLD_4 * SCALE_BYTE_CONV_QAM256);
-  __m256 scale_v = _mm256_set1_ps(SCALE_BYTE_CONV_QAM256);
+      _mm256_set1_epi8(QAM256_THRESHOLD_4 * scale);
+  // Negated as in Demod256qamSoftLoop
+  __m256 scale_v = _mm256_set1_ps(-scale);
   __m256i result10;
   __m256i result32;
   __m256i result54;
@@ -2430,9 +2483,9 @@ void Demod256qamSoftAvx2(const float* vec_in, int8_t* llr, int num) {
      * absolute value of the prior vector for the next subtraction,
      * like in the traditional LLR
      */
-    symbol_bit54 = _mm256_sub_epi8(offset3, _mm256_abs_epi8(symbol_i));
-    symbol_bit32 = _mm256_sub_epi8(offset2, _mm256_abs_epi8(symbol_bit54));
-    symbol_bit10 = _mm256_sub_epi8(offset1, _mm256_abs_epi8(symbol_bit32));
+    symbol_bit54 = _mm256_sub_epi8(_mm256_abs_epi8(symbol_i), offset3);
+    symbol_bit32 = _mm256_sub_epi8(_mm256_abs_epi8(symbol_bit54), offset2);
+    symbol_bit10 = _mm256_sub_epi8(_mm256_abs_epi8(symbol_bit32), offset1);
 
     /*
      * Now extract the result and store it. We must do this 4 times due
@@ -2493,11 +2546,13 @@ void Demod256qamSoftAvx2(const float* vec_in, int8_t* llr, int num) {
   // Demodulate the last symbols
   int next_start = 16 * (num / 16);
   Demod256qamSoftSse(vec_in + 2 * next_start, llr + next_start * 8,
-                     num - next_start);
+                     num - next_start, llr_scale);
 }
 
 #ifdef __AVX512F__
-void Demod256qamSoftAvx512(const float* vec_in, int8_t* llr, int num) {
+void Demod256qamSoftAvx512(const float* vec_in, int8_t* llr, int num,
+                           float llr_scale) {
+  const float scale = SCALE_BYTE_CONV_QAM256 * llr_scale;
   float* symbols_ptr = (float*)vec_in;
   auto* result_ptr = reinterpret_cast<__m512i*>(llr);
   __m512 symbol1;
@@ -2515,12 +2570,13 @@ void Demod256qamSoftAvx512(const float* vec_in, int8_t* llr, int num) {
   __m512i symbol_12;
   __m512i symbol_34;
   __m512i offset1 =
-      _mm512_set1_epi8(QAM256_THRESHOLD_1 * SCALE_BYTE_CONV_QAM256);
+      _mm512_set1_epi8(QAM256_THRESHOLD_1 * scale);
   __m512i offset2 =
-      _mm512_set1_epi8(QAM256_THRESHOLD_2 * SCALE_BYTE_CONV_QAM256);
+      _mm512_set1_epi8(QAM256_THRESHOLD_2 * scale);
   __m512i offset3 =
-      _mm512_set1_epi8(QAM256_THRESHOLD_4 * SCALE_BYTE_CONV_QAM256);
-  __m512 scale_v = _mm512_set1_ps(SCALE_BYTE_CONV_QAM256);
+      _mm512_set1_epi8(QAM256_THRESHOLD_4 * scale);
+  // Negated as in Demod256qamSoftLoop
+  __m512 scale_v = _mm512_set1_ps(-scale);
   __m512i result10;
   __m512i result32;
   __m512i result54;
@@ -2613,9 +2669,9 @@ void Demod256qamSoftAvx512(const float* vec_in, int8_t* llr, int num) {
      * absolute value of the prior vector for the next subtraction,
      * like in the traditional LLR
      */
-    symbol_bit54 = _mm512_sub_epi8(offset3, _mm512_abs_epi8(symbol_i));
-    symbol_bit32 = _mm512_sub_epi8(offset2, _mm512_abs_epi8(symbol_bit54));
-    symbol_bit10 = _mm512_sub_epi8(offset1, _mm512_abs_epi8(symbol_bit32));
+    symbol_bit54 = _mm512_sub_epi8(_mm512_abs_epi8(symbol_i), offset3);
+    symbol_bit32 = _mm512_sub_epi8(_mm512_abs_epi8(symbol_bit54), offset2);
+    symbol_bit10 = _mm512_sub_epi8(_mm512_abs_epi8(symbol_bit32), offset1);
 
     /*
      * Now extract the result and store it. We must do this 4 times due
@@ -2685,6 +2741,6 @@ void Demod256qamSoftAvx512(const float* vec_in, int8_t* llr, int num) {
   // Demodulate the last symbols
   int next_start = 32 * (num / 32);
   Demod256qamSoftAvx2(vec_in + 2 * next_start, llr + next_start * 8,
-                      num - next_start);
+                      num - next_start, llr_scale);
 }
 #endif
\ No newline at end of file
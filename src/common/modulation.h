@@ -42,23 +42,42 @@ complex_float ModSingleUint8(uint8_t x, Table<complex_float>& mod_table);
 void ModSimd(uint8_t* in, complex_float*& out, size_t len,
              Table<complex_float>& mod_table);
 
-void DemodQpskSoftSse(float* x, int8_t* z, int len);
+/// The soft demappers below multiply their int8 LLRs by llr_scale, which
+/// must not exceed kMaxSoftDemodLlrScale to keep their thresholds in range
+static constexpr float kMaxSoftDemodLlrScale = 2.0f;
+static constexpr float kMinSoftDemodLlrScale = 1.0f / 16;
+/// Number of fractional bits of the LLRs scaled by SoftDemodLlrScale
+static constexpr size_t kSoftDemodLlrFracBits = 2;
+
+/// Return the llr_scale that makes the int8 LLRs of symbols with
+/// post-equalization SNR [snr] (linear) their max-log LLRs with
+/// kSoftDemodLlrFracBits fractional bits, clamped to the supported range and
+/// to the scale that maps the outermost constellation levels to int8 range
+float SoftDemodLlrScale(size_t mod_order_bits, float snr);
+
+void DemodQpskSoftSse(float* x, int8_t* z, int len, float llr_scale = 1.0f);
 
 void Demod16qamHardLoop(const float* vec_in, uint8_t* vec_out, int num);
 void Demod16qamHardSse(float* vec_in, uint8_t* vec_out, int num);
 void Demod16qamHardAvx2(float* vec_in, uint8_t* vec_out, int num);
 
-void Demod16qamSoftLoop(const float* vec_in, int8_t* llr, int num);
-void Demod16qamSoftSse(float* vec_in, int8_t* llr, int num);
-void Demod16qamSoftAvx2(float* vec_in, int8_t* llr, int num);
+void Demod16qamSoftLoop(const float* vec_in, int8_t* llr, int num,
+                        float llr_scale = 1.0f);
+void Demod16qamSoftSse(float* vec_in, int8_t* llr, int num,
+                       float llr_scale = 1.0f);
+void Demod16qamSoftAvx2(float* vec_in, int8_t* llr, int num,
+                        float llr_scale = 1.0f);
 
 void Demod64qamHardLoop(const float* vec_in, uint8_t* vec_out, int num);
 void Demod64qamHardSse(float* vec_in, uint8_t* vec_out, int num);
 void Demod64qamHardAvx2(float* vec_in, uint8_t* vec_out, int num);
 
-void Demod64qamSoftLoop(const float* vec_in, int8_t* llr, int num);
-void Demod64qamSoftSse(float* vec_in, int8_t* llr, int num);
-void Demod64qamSoftAvx2(float* vec_in, int8_t* llr, int num);
+void Demod64qamSoftLoop(const float* vec_in, int8_t* llr, int num,
+                        float llr_scale = 1.0f);
+void Demod64qamSoftSse(float* vec_in, int8_t* llr, int num,
+                       float llr_scale = 1.0f);
+void Demod64qamSoftAvx2(float* vec_in, int8_t* llr, int num,
+                        float llr_scale = 1.0f);
 
 void Demod256qamHardLoop(const float* vec_in, uint8_t* vec_out, int num);
 void Demod256qamHardSse(float* vec_in, uint8_t* vec_out, int num);
@@ -66,12 +85,16 @@ void Demod256qamHardAvx2(float* vec_in, uint8_t* vec_out, int num);
 #ifdef __AVX512F__
 void Demod256qamHardAvx512(float* vec_in, uint8_t* vec_out, int num);
 #endif
-void Demod256qamSoftLoop(const float* vec_in, int8_t* llr, int num);
-void Demod256qamSoftSse(const float* vec_in, int8_t* llr, int num);
-void Demod256qamSoftAvx2(const float* vec_in, int8_t* llr, int num);
+void Demod256qamSoftLoop(const float* vec_in, int8_t* llr, int num,
+                         float llr_scale = 1.0f);
+void Demod256qamSoftSse(const float* vec_in, int8_t* llr, int num,
+                        float llr_scale = 1.0f);
+void Demod256qamSoftAvx2(const float* vec_in, int8_t* llr, int num,
+                         float llr_scale = 1.0f);
 
 #ifdef __AVX512F__
-void Demod256qamSoftAvx512(const float* vec_in, int8_t* llr, int num);
+void Demod256qamSoftAvx512(const float* vec_in, int8_t* llr, int num,
+                           float llr_scale = 1.0f);
 #endif
 void Print256Epi8(__m256i var);
 
@@ -21,19 +21,22 @@
 
 #include "modulation.h"
 
-void Demod16qamSoftLoop(const float* vec_in, int8_t* llr, int num) {
+void Demod16qamSoftLoop(const float* vec_in, int8_t* llr, int num,
+                        float llr_scale) {
+  const float scale = SCALE_BYTE_CONV_QAM16 * llr_scale;
   for (int i = 0; i < num; i++) {
-    auto yre = static_cast<int8_t>(SCALE_BYTE_CONV_QAM16 * (vec_in[2 * i]));
-    auto yim = static_cast<int8_t>(SCALE_BYTE_CONV_QAM16 * (vec_in[2 * i + 1]));
+    auto yre = static_cast<int8_t>(scale * (vec_in[2 * i]));
+    auto yim = static_cast<int8_t>(scale * (vec_in[2 * i + 1]));
 
     llr[4 * i + 0] = yre;
     llr[4 * i + 1] = yim;
-    llr[4 * i + 2] = 2 * SCALE_BYTE_CONV_QAM16 / sqrt(10) - abs(yre);
-    llr[4 * i + 3] = 2 * SCALE_BYTE_CONV_QAM16 / sqrt(10) - abs(yim);
+    llr[4 * i + 2] = 2 * scale / sqrt(10) - abs(yre);
+    llr[4 * i + 3] = 2 * scale / sqrt(10) - abs(yim);
   }
 }
 
-void Demod16qamSoftSse(float* vec_in, int8_t* llr, int num) {
+void Demod16qamSoftSse(float* vec_in, int8_t* llr, int num, float llr_scale) {
+  const float scale = SCALE_BYTE_CONV_QAM16 * llr_scale;
   float* symbols_ptr = vec_in;
   auto* result_ptr = reinterpret_cast<__m128i*>(llr);
   __m128 symbol1;
@@ -48,12 +51,12 @@ void Demod16qamSoftSse(float* vec_in, int8_t* llr, int num) {
   __m128i symbol_abs;
   __m128i symbol_12;
   __m128i symbol_34;
-  __m128i offset = _mm_set1_epi8(2 * SCALE_BYTE_CONV_QAM16 / sqrt(10));
+  __m128i offset = _mm_set1_epi8(2 * scale / sqrt(10));
   __m128i result1n;
   __m128i result1a;
   __m128i result2n;
   __m128i result2a;
-  __m128 scale_v = _mm_set1_ps(SCALE_BYTE_CONV_QAM16);
+  __m128 scale_v = _mm_set1_ps(scale);
 
   __m128i shuffle_negated_1 = _mm_set_epi8(0xff, 0xff, 7, 6, 0xff, 0xff, 5, 4,
                                            0xff, 0xff, 3, 2, 0xff, 0xff, 1, 0);
@@ -99,13 +102,13 @@ void Demod16qamSoftSse(float* vec_in, int8_t* llr, int num) {
   }
   // Demodulate last symbols
   for (int i = 8 * (num / 8); i < num; i++) {
-    auto yre = static_cast<int8_t>(SCALE_BYTE_CONV_QAM16 * (vec_in[2 * i]));
-    auto yim = static_cast<int8_t>(SCALE_BYTE_CONV_QAM16 * (vec_in[2 * i + 1]));
+    auto yre = static_cast<int8_t>(scale * (vec_in[2 * i]));
+    auto yim = static_cast<int8_t>(scale * (vec_in[2 * i + 1]));
 
     llr[4 * i + 0] = yre;
     llr[4 * i + 1] = yim;
-    llr[4 * i + 2] = 2 * SCALE_BYTE_CONV_QAM16 / sqrt(10) - abs(yre);
-    llr[4 * i + 3] = 2 * SCALE_BYTE_CONV_QAM16 / sqrt(10) - abs(yim);
+    llr[4 * i + 2] = 2 * scale / sqrt(10) - abs(yre);
+    llr[4 * i + 3] = 2 * scale / sqrt(10) - abs(yim);
   }
 
   // for (int i = 0; i < ue_num; i++) {
@@ -114,21 +117,24 @@ void Demod16qamSoftSse(float* vec_in, int8_t* llr, int num) {
   // }
 }
 
-void Demod64qamSoftLoop(const float* vec_in, int8_t* llr, int num) {
+void Demod64qamSoftLoop(const float* vec_in, int8_t* llr, int num,
+                        float llr_scale) {
+  const float scale = SCALE_BYTE_CONV_QAM64 * llr_scale;
   for (int i = 0; i < num; i++) {
-    float yre = (int8_t)(SCALE_BYTE_CONV_QAM64 * (vec_in[2 * i]));
-    float yim = (int8_t)(SCALE_BYTE_CONV_QAM64 * (vec_in[2 * i + 1]));
+    float yre = (int8_t)(scale * (vec_in[2 * i]));
+    float yim = (int8_t)(scale * (vec_in[2 * i + 1]));
 
     llr[6 * i + 0] = yre;
     llr[6 * i + 1] = yim;
-    llr[6 * i + 2] = 4 * SCALE_BYTE_CONV_QAM64 / sqrt(42) - abs(yre);
-    llr[6 * i + 3] = 4 * SCALE_BYTE_CONV_QAM64 / sqrt(42) - abs(yim);
-    llr[6 * i + 4] = 2 * SCALE_BYTE_CONV_QAM64 / sqrt(42) - abs(llr[6 * i + 2]);
-    llr[6 * i + 5] = 2 * SCALE_BYTE_CONV_QAM64 / sqrt(42) - abs(llr[6 * i + 3]);
+    llr[6 * i + 2] = 4 * scale / sqrt(42) - abs(yre);
+    llr[6 * i + 3] = 4 * scale / sqrt(42) - abs(yim);
+    llr[6 * i + 4] = 2 * scale / sqrt(42) - abs(llr[6 * i + 2]);
+    llr[6 * i + 5] = 2 * scale / sqrt(42) - abs(llr[6 * i + 3]);
   }
 }
 
-void Demod64qamSoftSse(float* vec_in, int8_t* llr, int num) {
+void Demod64qamSoftSse(float* vec_in, int8_t* llr, int num, float llr_scale) {
+  const float scale = SCALE_BYTE_CONV_QAM64 * llr_scale;
   auto* symbols_ptr = static_cast<float*>(vec_in);
   auto* result_ptr = reinterpret_cast<__m128i*>(llr);
   __m128 symbol1;
@@ -144,9 +150,9 @@ void Demod64qamSoftSse(float* vec_in, int8_t* llr, int num) {
   __m128i symbol_abs2;
   __m128i symbol_12;
   __m128i symbol_34;
-  __m128i offset1 = _mm_set1_epi8(4 * SCALE_BYTE_CONV_QAM64 / sqrt(42));
-  __m128i offset2 = _mm_set1_epi8(2 * SCALE_BYTE_CONV_QAM64 / sqrt(42));
-  __m128 scale_v = _mm_set1_ps(SCALE_BYTE_CONV_QAM64);
+  __m128i offset1 = _mm_set1_epi8(4 * scale / sqrt(42));
+  __m128i offset2 = _mm_set1_epi8(2 * scale / sqrt(42));
+  __m128 scale_v = _mm_set1_ps(scale);
   __m128i result11;
   __m128i result12;
   __m128i result13;
@@ -230,25 +236,26 @@ void Demod64qamSoftSse(float* vec_in, int8_t* llr, int num) {
     result_ptr++;
   }
   for (int i = 8 * (num / 8); i < num; i++) {
-    float yre = (int8_t)(SCALE_BYTE_CONV_QAM64 * (vec_in[2 * i]));
-    float yim = (int8_t)(SCALE_BYTE_CONV_QAM64 * (vec_in[2 * i + 1]));
+    float yre = (int8_t)(scale * (vec_in[2 * i]));
+    float yim = (int8_t)(scale * (vec_in[2 * i + 1]));
 
     llr[6 * i + 0] = yre;
     llr[6 * i + 1] = yim;
-    llr[6 * i + 2] = 4 * SCALE_BYTE_CONV_QAM64 / sqrt(42) - abs(yre);
-    llr[6 * i + 3] = 4 * SCALE_BYTE_CONV_QAM64 / sqrt(42) - abs(yim);
-    llr[6 * i + 4] = 2 * SCALE_BYTE_CONV_QAM64 / sqrt(42) - abs(llr[6 * i + 2]);
-    llr[6 * i + 5] = 2 * SCALE_BYTE_CONV_QAM64 / sqrt(42) - abs(llr[6 * i + 3]);
+    llr[6 * i + 2] = 4 * scale / sqrt(42) - abs(yre);
+    llr[6 * i + 3] = 4 * scale / sqrt(42) - abs(yim);
+    llr[6 * i + 4] = 2 * scale / sqrt(42) - abs(llr[6 * i + 2]);
+    llr[6 * i + 5] = 2 * scale / sqrt(42) - abs(llr[6 * i + 3]);
   }
 }
 
-void DemodQpskSoftSse(float* x, int8_t* z, int len) {
+void DemodQpskSoftSse(float* x, int8_t* z, int len, float llr_scale) {
+  const float scale = SCALE_BYTE_CONV_QPSK * llr_scale;
   int i = 0;
 
   // Force the use of SSE here instead of AVX since the implementations requires
   // too many permutes across 128-bit boundaries
 
-  __m128 s = _mm_set1_ps(-SCALE_BYTE_CONV_QPSK * M_SQRT2);
+  __m128 s = _mm_set1_ps(-scale * M_SQRT2);
   if (((size_t)(x)&0x0F) == 0 && ((size_t)(z)&0x0F) == 0) {
     for (; i < len - 16 + 1; i += 16) {
       __m128 a = _mm_load_ps(&x[i]);
@@ -298,6 +305,6 @@ void DemodQpskSoftSse(float* x, int8_t* z, int len) {
   }
 
   for (; i < len; i++) {
-    z[i] = (int8_t)(x[i] * -SCALE_BYTE_CONV_QPSK * M_SQRT2);
+    z[i] = (int8_t)(x[i] * -scale * M_SQRT2);
   }
 }
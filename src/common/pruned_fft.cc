@@ -0,0 +1,324 @@
+/**
+ * @file pruned_fft.cc
+ * @brief Implementation file for the PrunedFft class
+ *
+ * With N = kRadix * M, n = n1 + kRadix * n2, and k = M * k1 + k2, the FFT
+ * X[M * k1 + k2] = sum_n1 W_kRadix^(n1 * k1) * W_N^(n1 * k2) * Y_n1[k2],
+ * where Y_n1 is the M-point FFT of the samples x[n1 + kRadix * n2]. The
+ * outputs of each k1 are a contiguous block of M subcarriers, so the
+ * radix-kRadix stage computes only the blocks (and the parts of them) that
+ * overlap the band. The backward transform is the transpose: the
+ * radix-kRadix stage reads only the subcarriers of the band.
+ */
+#include "pruned_fft.h"
+
+#include <immintrin.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include "memory_manage.h"
+
+static_assert(PrunedFft::kRadix == 4, "The pruned stage is radix-4");
+
+/// Number of complex floats per AVX2 register
+static constexpr size_t kCxPerSimd = 4;
+
+// a * b of four complex floats
+static inline __m256 CxMul(__m256 a, __m256 b) {
+  const __m256 a_swap = _mm256_permute_ps(a, 0xB1);
+  return _mm256_fmaddsub_ps(a, _mm256_moveldup_ps(b),
+                            _mm256_mul_ps(a_swap, _mm256_movehdup_ps(b)));
+}
+
+// a * conj(b) of four complex floats
+static inline __m256 CxMulConj(__m256 a, __m256 b) {
+  const __m256 a_swap = _mm256_permute_ps(a, 0xB1);
+  return _mm256_fmsubadd_ps(a, _mm256_moveldup_ps(b),
+                            _mm256_mul_ps(a_swap, _mm256_movehdup_ps(b)));
+}
+
+// j * a, i.e., (-im, re), of four complex floats
+static inline __m256 CxMulJ(__m256 a) {
+  const __m256 neg_re = _mm256_setr_ps(-0.0f, 0.0f, -0.0f, 0.0f, -0.0f, 0.0f,
+                                       -0.0f, 0.0f);
+  return _mm256_xor_ps(_mm256_permute_ps(a, 0xB1), neg_re);
+}
+
+// -j * a, i.e., (im, -re), of four complex floats
+static inline __m256 CxMulMinusJ(__m256 a) {
+  const __m256 neg_im = _mm256_setr_ps(0.0f, -0.0f, 0.0f, -0.0f, 0.0f, -0.0f,
+                                       0.0f, -0.0f);
+  return _mm256_xor_ps(_mm256_permute_ps(a, 0xB1), neg_im);
+}
+
+static inline complex_float Add(complex_float a, complex_float b) {
+  return {a.re + b.re, a.im + b.im};
+}
+static inline complex_float Sub(complex_float a, complex_float b) {
+  return {a.re - b.re, a.im - b.im};
+}
+static inline complex_float Mul(complex_float a, complex_float b) {
+  return {a.re * b.re - a.im * b.im, a.re * b.im + a.im * b.re};
+}
+static inline complex_float MulConj(complex_float a, complex_float b) {
+  return {a.re * b.re + a.im * b.im, a.im * b.re - a.re * b.im};
+}
+static inline complex_float MulJ(complex_float a) { return {-a.im, a.re}; }
+static inline complex_float MulMinusJ(complex_float a) { return {a.im, -a.re}; }
+
+PrunedFft::PrunedFft(size_t fft_size, size_t band_start, size_t band_stop)
+    : fft_size_(fft_size),
+      sub_size_(fft_size / kRadix),
+      band_start_(band_start),
+      band_stop_(band_stop) {
+  if ((fft_size % kRadix != 0) || (band_start >= band_stop) ||
+      (band_stop > fft_size)) {
+    throw std::runtime_error(
+        "PrunedFft: invalid band [" + std::to_string(band_start) + ", " +
+        std::to_string(band_stop) + ") of an FFT of size " +
+        std::to_string(fft_size));
+  }
+
+  // Split the sub-FFT subcarriers into segments with the same blocks k1 in
+  // the band
+  std::vector<size_t> bounds = {0, sub_size_};
+  for (size_t k1 = 0; k1 < kRadix; k1++) {
+    const size_t block_start = k1 * sub_size_;
+    if (band_start_ > block_start && band_start_ < block_start + sub_size_) {
+      bounds.push_back(band_start_ - block_start);
+    }
+    if (band_stop_ > block_start && band_stop_ < block_start + sub_size_) {
+      bounds.push_back(band_stop_ - block_start);
+    }
+  }
+  std::sort(bounds.begin(), bounds.end());
+  bounds.erase(std::unique(bounds.begin(), bounds.end()), bounds.end());
+  for (size_t i = 0; i + 1 < bounds.size(); i++) {
+    Segment segment = {bounds[i], bounds[i + 1], 0};
+    for (size_t k1 = 0; k1 < kRadix; k1++) {
+      const size_t k = k1 * sub_size_ + segment.k2_begin_;
+      if (k >= band_start_ && k < band_stop_) {
+        segment.k1_mask_ |= 1u << k1;
+      }
+    }
+    segments_.push_back(segment);
+  }
+
+  MKL_LONG strided[2] = {0, static_cast<MKL_LONG>(kRadix)};
+  MKL_LONG contiguous[2] = {0, 1};
+  DftiCreateDescriptor(&forward_handle_, DFTI_SINGLE, DFTI_COMPLEX, 1,
+                       static_cast<MKL_LONG>(sub_size_));
+  DftiSetValue(forward_handle_, DFTI_PLACEMENT, DFTI_NOT_INPLACE);
+  DftiSetValue(forward_handle_, DFTI_NUMBER_OF_TRANSFORMS,
+               static_cast<MKL_LONG>(kRadix));
+  DftiSetValue(forward_handle_, DFTI_INPUT_STRIDES, strided);
+  DftiSetValue(forward_handle_, DFTI_INPUT_DISTANCE, static_cast<MKL_LONG>(1));
+  DftiSetValue(forward_handle_, DFTI_OUTPUT_STRIDES, contiguous);
+  DftiSetValue(forward_handle_, DFTI_OUTPUT_DISTANCE,
+               static_cast<MKL_LONG>(sub_size_));
+
+  DftiCreateDescriptor(&backward_handle_, DFTI_SINGLE, DFTI_COMPLEX, 1,
+                       static_cast<MKL_LONG>(sub_size_));
+  DftiSetValue(backward_handle_, DFTI_PLACEMENT, DFTI_NOT_INPLACE);
+  DftiSetValue(backward_handle_, DFTI_NUMBER_OF_TRANSFORMS,
+               static_cast<MKL_LONG>(kRadix));
+  DftiSetValue(backward_handle_, DFTI_INPUT_STRIDES, contiguous);
+  DftiSetValue(backward_handle_, DFTI_INPUT_DISTANCE,
+               static_cast<MKL_LONG>(sub_size_));
+  DftiSetValue(backward_handle_, DFTI_OUTPUT_STRIDES, strided);
+  DftiSetValue(backward_handle_, DFTI_OUTPUT_DISTANCE,
+               static_cast<MKL_LONG>(1));
+
+  if ((DftiCommitDescriptor(forward_handle_) != DFTI_NO_ERROR) ||
+      (DftiCommitDescriptor(backward_handle_) != DFTI_NO_ERROR)) {
+    throw std::runtime_error("PrunedFft: failed to commit MKL descriptors");
+  }
+
+  sub_ = static_cast<complex_float*>(Agora_memory::PaddedAlignedAlloc(
+      Agora_memory::Alignment_t::kAlign64,
+      kRadix * sub_size_ * sizeof(complex_float)));
+  twiddles_ = static_cast<complex_float*>(Agora_memory::PaddedAlignedAlloc(
+      Agora_memory::Alignment_t::kAlign64,
+      (kRadix - 1) * sub_size_ * sizeof(complex_float)));
+  for (size_t n1 = 1; n1 < kRadix; n1++) {
+    for (size_t k2 = 0; k2 < sub_size_; k2++) {
+      const double phase = -2.0 * M_PI * static_cast<double>(n1 * k2) /
+                           static_cast<double>(fft_size_);
+      twiddles_[(n1 - 1) * sub_size_ + k2] = {
+          static_cast<float>(std::cos(phase)),
+          static_cast<float>(std::sin(phase))};
+    }
+  }
+}
+
+PrunedFft::~PrunedFft() {
+  DftiFreeDescriptor(&forward_handle_);
+  DftiFreeDescriptor(&backward_handle_);
+  std::free(sub_);
+  std::free(twiddles_);
+}
+
+void PrunedFft::Forward(const complex_float* in, complex_float* out) {
+  DftiComputeForward(forward_handle_,
+                     const_cast<float*>(reinterpret_cast<const float*>(in)),
+                     reinterpret_cast<float*>(sub_));
+
+  const complex_float* y0 = sub_;
+  const complex_float* y1 = sub_ + sub_size_;
+  const complex_float* y2 = sub_ + 2 * sub_size_;
+  const complex_float* y3 = sub_ + 3 * sub_size_;
+  const complex_float* w1 = twiddles_;
+  const complex_float* w2 = twiddles_ + sub_size_;
+  const complex_float* w3 = twiddles_ + 2 * sub_size_;
+  complex_float* x0 = out;
+  complex_float* x1 = out + sub_size_;
+  complex_float* x2 = out + 2 * sub_size_;
+  complex_float* x3 = out + 3 * sub_size_;
+
+  for (const Segment& segment : segments_) {
+    const unsigned mask = segment.k1_mask_;
+    if (mask == 0) {
+      continue;
+    }
+    size_t k2 = segment.k2_begin_;
+    for (; k2 + kCxPerSimd <= segment.k2_end_; k2 += kCxPerSimd) {
+      const __m256 t0 =
+          _mm256_loadu_ps(reinterpret_cast<const float*>(y0 + k2));
+      const __m256 t1 =
+          CxMul(_mm256_loadu_ps(reinterpret_cast<const float*>(y1 + k2)),
+                _mm256_loadu_ps(reinterpret_cast<const float*>(w1 + k2)));
+      const __m256 t2 =
+          CxMul(_mm256_loadu_ps(reinterpret_cast<const float*>(y2 + k2)),
+                _mm256_loadu_ps(reinterpret_cast<const float*>(w2 + k2)));
+      const __m256 t3 =
+          CxMul(_mm256_loadu_ps(reinterpret_cast<const float*>(y3 + k2)),
+                _mm256_loadu_ps(reinterpret_cast<const float*>(w3 + k2)));
+      const __m256 a = _mm256_add_ps(t0, t2);
+      const __m256 b = _mm256_sub_ps(t0, t2);
+      const __m256 c = _mm256_add_ps(t1, t3);
+      const __m256 d = _mm256_sub_ps(t1, t3);
+      if (mask & 1u) {
+        _mm256_storeu_ps(reinterpret_cast<float*>(x0 + k2),
+                         _mm256_add_ps(a, c));
+      }
+      if (mask & 2u) {
+        _mm256_storeu_ps(reinterpret_cast<float*>(x1 + k2),
+                         _mm256_add_ps(b, CxMulMinusJ(d)));
+      }
+      if (mask & 4u) {
+        _mm256_storeu_ps(reinterpret_cast<float*>(x2 + k2),
+                         _mm256_sub_ps(a, c));
+      }
+      if (mask & 8u) {
+        _mm256_storeu_ps(reinterpret_cast<float*>(x3 + k2),
+                         _mm256_add_ps(b, CxMulJ(d)));
+      }
+    }
+    for (; k2 < segment.k2_end_; k2++) {
+      const complex_float t0 = y0[k2];
+      const complex_float t1 = Mul(y1[k2], w1[k2]);
+      const complex_float t2 = Mul(y2[k2], w2[k2]);
+      const complex_float t3 = Mul(y3[k2], w3[k2]);
+      const complex_float a = Add(t0, t2);
+      const complex_float b = Sub(t0, t2);
+      const complex_float c = Add(t1, t3);
+      const complex_float d = Sub(t1, t3);
+      if (mask & 1u) {
+        x0[k2] = Add(a, c);
+      }
+      if (mask & 2u) {
+        x1[k2] = Add(b, MulMinusJ(d));
+      }
+      if (mask & 4u) {
+        x2[k2] = Sub(a, c);
+      }
+      if (mask & 8u) {
+        x3[k2] = Add(b, MulJ(d));
+      }
+    }
+  }
+}
+
+void PrunedFft::Backward(const complex_float* in, complex_float* out) {
+  const complex_float* x0 = in;
+  const complex_float* x1 = in + sub_size_;
+  const complex_float* x2 = in + 2 * sub_size_;
+  const complex_float* x3 = in + 3 * sub_size_;
+  const complex_float* w1 = twiddles_;
+  const complex_float* w2 = twiddles_ + sub_size_;
+  const complex_float* w3 = twiddles_ + 2 * sub_size_;
+  complex_float* z0 = sub_;
+  complex_float* z1 = sub_ + sub_size_;
+  complex_float* z2 = sub_ + 2 * sub_size_;
+  complex_float* z3 = sub_ + 3 * sub_size_;
+
+  for (const Segment& segment : segments_) {
+    const unsigned mask = segment.k1_mask_;
+    if (mask == 0) {
+      // Only guard band subcarriers
+      const size_t len = (segment.k2_end_ - segment.k2_begin_);
+      for (size_t n1 = 0; n1 < kRadix; n1++) {
+        std::memset(&sub_[n1 * sub_size_ + segment.k2_begin_], 0,
+                    len * sizeof(complex_float));
+      }
+      continue;
+    }
+    size_t k2 = segment.k2_begin_;
+    for (; k2 + kCxPerSimd <= segment.k2_end_; k2 += kCxPerSimd) {
+      // Subcarriers outside the band are zero and not read
+      const __m256 zero = _mm256_setzero_ps();
+      const __m256 v0 =
+          (mask & 1u) ? _mm256_loadu_ps(reinterpret_cast<const float*>(x0 + k2))
+                      : zero;
+      const __m256 v1 =
+          (mask & 2u) ? _mm256_loadu_ps(reinterpret_cast<const float*>(x1 + k2))
+                      : zero;
+      const __m256 v2 =
+          (mask & 4u) ? _mm256_loadu_ps(reinterpret_cast<const float*>(x2 + k2))
+                      : zero;
+      const __m256 v3 =
+          (mask & 8u) ? _mm256_loadu_ps(reinterpret_cast<const float*>(x3 + k2))
+                      : zero;
+      const __m256 a = _mm256_add_ps(v0, v2);
+      const __m256 b = _mm256_sub_ps(v0, v2);
+      const __m256 c = _mm256_add_ps(v1, v3);
+      const __m256 d = _mm256_sub_ps(v1, v3);
+      _mm256_storeu_ps(reinterpret_cast<float*>(z0 + k2), _mm256_add_ps(a, c));
+      _mm256_storeu_ps(
+          reinterpret_cast<float*>(z1 + k2),
+          CxMulConj(_mm256_add_ps(b, CxMulJ(d)),
+                    _mm256_loadu_ps(reinterpret_cast<const float*>(w1 + k2))));
+      _mm256_storeu_ps(
+          reinterpret_cast<float*>(z2 + k2),
+          CxMulConj(_mm256_sub_ps(a, c),
+                    _mm256_loadu_ps(reinterpret_cast<const float*>(w2 + k2))));
+      _mm256_storeu_ps(
+          reinterpret_cast<float*>(z3 + k2),
+          CxMulConj(_mm256_add_ps(b, CxMulMinusJ(d)),
+                    _mm256_loadu_ps(reinterpret_cast<const float*>(w3 + k2))));
+    }
+    for (; k2 < segment.k2_end_; k2++) {
+      const complex_float zero = {0.0f, 0.0f};
+      const complex_float v0 = (mask & 1u) ? x0[k2] : zero;
+      const complex_float v1 = (mask & 2u) ? x1[k2] : zero;
+      const complex_float v2 = (mask & 4u) ? x2[k2] : zero;
+      const complex_float v3 = (mask & 8u) ? x3[k2] : zero;
+      const complex_float a = Add(v0, v2);
+      const complex_float b = Sub(v0, v2);
+      const complex_float c = Add(v1, v3);
+      const complex_float d = Sub(v1, v3);
+      z0[k2] = Add(a, c);
+      z1[k2] = MulConj(Add(b, MulJ(d)), w1[k2]);
+      z2[k2] = MulConj(Sub(a, c), w2[k2]);
+      z3[k2] = MulConj(Add(b, MulMinusJ(d)), w3[k2]);
+    }
+  }
+
+  DftiComputeBackward(backward_handle_, reinterpret_cast<float*>(sub_),
+                      reinterpret_cast<float*>(out));
+}
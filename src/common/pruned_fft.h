@@ -0,0 +1,65 @@
+/**
+ * @file pruned_fft.h
+ * @brief Declaration file for the PrunedFft class, which computes FFTs whose
+ * outputs (IFFTs whose inputs) are only the subcarriers of one contiguous
+ * band, skipping the work on the guard bands
+ */
+#ifndef PRUNED_FFT_H_
+#define PRUNED_FFT_H_
+
+#include <cstddef>
+#include <vector>
+
+#include "common_typedef_sdk.h"
+#include "mkl_dfti.h"
+
+class PrunedFft {
+ public:
+  /// Radix of the pruned stage. The FFT of size N is split into kRadix
+  /// interleaved FFTs of size N / kRadix, computed by MKL with one
+  /// multi-transform call, and one radix-kRadix stage that only touches the
+  /// subcarriers of the band.
+  static constexpr size_t kRadix = 4;
+
+  /// Transforms of fft_size points (a multiple of kRadix) whose useful
+  /// subcarriers are [band_start, band_stop)
+  PrunedFft(size_t fft_size, size_t band_start, size_t band_stop);
+  ~PrunedFft();
+
+  /// Forward FFT of the fft_size samples of [in], like DftiComputeForward,
+  /// writing only the subcarriers of the band to [out]. The other entries of
+  /// [out] are left unchanged. [in] and [out] may be the same buffer.
+  void Forward(const complex_float* in, complex_float* out);
+
+  /// Unscaled backward FFT, like DftiComputeBackward, of the subcarriers of
+  /// the band of [in], with all other subcarriers taken as zero, writing the
+  /// fft_size samples to [out]. [in] and [out] may be the same buffer.
+  void Backward(const complex_float* in, complex_float* out);
+
+ private:
+  /// Subcarriers [k2_begin, k2_end) of the sub-FFTs, for which the band has
+  /// the outputs (inputs) k1 * sub_size_ + k2 whose bit k1 is set in k1_mask
+  struct Segment {
+    size_t k2_begin_;
+    size_t k2_end_;
+    unsigned k1_mask_;
+  };
+
+  size_t fft_size_;
+  size_t sub_size_;  // fft_size_ / kRadix
+  size_t band_start_;
+  size_t band_stop_;
+  std::vector<Segment> segments_;
+
+  // kRadix sub-FFTs of sub_size_ points from every kRadix-th sample, and
+  // their inverses to every kRadix-th sample
+  DFTI_DESCRIPTOR_HANDLE forward_handle_;
+  DFTI_DESCRIPTOR_HANDLE backward_handle_;
+
+  complex_float* sub_;  // kRadix x sub_size_ sub-FFT outputs (inputs)
+  // Twiddle factors exp(-2 pi j * n1 * k2 / fft_size) of n1 = 1 ...
+  // kRadix - 1, stored as [n1 - 1][k2]
+  complex_float* twiddles_;
+};
+
+#endif  // PRUNED_FFT_H_
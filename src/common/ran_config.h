@@ -1,6 +1,9 @@
 #ifndef RAN_CONFIG_H_
 #define RAN_CONFIG_H_
 
+#include <cstddef>
+#include <cstdint>
+
 /**
  * @brief The struct that contains the RAN configuration that Agora must
  * apply for a particular frame.
@@ -11,9 +14,29 @@
  */
 class RanConfig {
  public:
+  /// ue_id_ of updates that apply to all UEs
+  static constexpr size_t kAllUes = SIZE_MAX;
+
   size_t n_antennas_;      /// Number of active antennas at the base station
   size_t mod_order_bits_;  /// modulation type (number of bits)
   size_t frame_id_;        /// frame ID
+  size_t ue_id_;           /// UE the MCS applies to, or kAllUes
+  size_t ldpc_num_rows_;   /// LDPC base graph rows, which set the code rate
+};
+
+/**
+ * @brief The modulation and coding scheme (MCS) of one UE in one frame.
+ *
+ * The UeMcs class holds the MCS that the PHY applies to a UE's uplink and
+ * downlink data. The code block fields are derived from the MCS by
+ * Config::UpdateUeMcs.
+ */
+class UeMcs {
+ public:
+  size_t mod_order_bits_;        /// modulation type (number of bits)
+  size_t ldpc_num_rows_;         /// LDPC base graph rows
+  size_t num_cb_codew_len_;      /// Number of bits per encoded code block
+  size_t num_blocks_in_symbol_;  /// Number of code blocks per data symbol
 };
 
 /**
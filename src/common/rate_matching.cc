@@ -0,0 +1,74 @@
+/**
+ * @file rate_matching.cc
+ * @brief Implementation file for the 5G NR LDPC rate matching
+ *
+ * Bit selection takes bit e_k = d_((k0 + k) mod N_cb) of the circular buffer
+ * d, and bit interleaving writes f_(i + j * Qm) = e_(i * E / Qm + j), so the
+ * Qm bits of a modulated symbol come from Qm equally spaced parts of e.
+ */
+#include "rate_matching.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+#include "utils.h"
+#include "utils_ldpc.h"
+
+// Numerators of k0 / N_cb for redundancy versions 1 to 3, over 66 (base
+// graph 1) or 50 (base graph 2)
+static constexpr std::array<size_t, kNumRedundancyVersions> kBg1RvNum = {
+    0, 17, 33, 56};
+static constexpr std::array<size_t, kNumRedundancyVersions> kBg2RvNum = {
+    0, 13, 25, 43};
+
+size_t LdpcCircularBufferLen(size_t base_graph, size_t zc) {
+  return LdpcMaxNumEncodedBits(base_graph, zc);
+}
+
+size_t LdpcRvStart(size_t base_graph, size_t zc, size_t rv) {
+  RtAssert(rv < kNumRedundancyVersions, "Invalid redundancy version");
+  const size_t ncb = LdpcCircularBufferLen(base_graph, zc);
+  if (base_graph == 1) {
+    return (kBg1RvNum.at(rv) * ncb / (66 * zc)) * zc;
+  }
+  return (kBg2RvNum.at(rv) * ncb / (50 * zc)) * zc;
+}
+
+void LdpcRateMatch(size_t base_graph, size_t zc, size_t rv,
+                   size_t mod_order_bits, const uint8_t* encoded,
+                   size_t num_out_bits, uint8_t* out) {
+  RtAssert(num_out_bits % mod_order_bits == 0,
+           "Rate matching output must fill whole symbols");
+  const size_t ncb = LdpcCircularBufferLen(base_graph, zc);
+  const size_t k0 = LdpcRvStart(base_graph, zc, rv);
+  const size_t num_symbols = num_out_bits / mod_order_bits;
+
+  std::memset(out, 0, BitsToBytes(num_out_bits));
+  for (size_t j = 0; j < num_symbols; j++) {
+    for (size_t i = 0; i < mod_order_bits; i++) {
+      const size_t pos = (k0 + i * num_symbols + j) % ncb;
+      const size_t n = i + j * mod_order_bits;
+      out[n / 8] |= ((encoded[pos / 8] >> (pos % 8)) & 1) << (n % 8);
+    }
+  }
+}
+
+void LdpcDeRateMatch(size_t base_graph, size_t zc, size_t rv,
+                     size_t mod_order_bits, const int8_t* llrs,
+                     size_t num_llrs, int16_t* soft_buffer) {
+  RtAssert(num_llrs % mod_order_bits == 0,
+           "Rate matching input must fill whole symbols");
+  const size_t ncb = LdpcCircularBufferLen(base_graph, zc);
+  const size_t k0 = LdpcRvStart(base_graph, zc, rv);
+  const size_t num_symbols = num_llrs / mod_order_bits;
+
+  for (size_t j = 0; j < num_symbols; j++) {
+    for (size_t i = 0; i < mod_order_bits; i++) {
+      const size_t pos = (k0 + i * num_symbols + j) % ncb;
+      const int32_t sum = soft_buffer[pos] + llrs[i + j * mod_order_bits];
+      soft_buffer[pos] = static_cast<int16_t>(
+          std::min<int32_t>(INT16_MAX, std::max<int32_t>(INT16_MIN, sum)));
+    }
+  }
+}
@@ -0,0 +1,44 @@
+/**
+ * @file rate_matching.h
+ * @brief Declaration file for the 5G NR LDPC rate matching (TS 38.212
+ * 5.4.2): bit selection from the circular buffer at the start position of a
+ * redundancy version, and bit interleaving, and their inverse for the soft
+ * bits of the receiver
+ */
+#ifndef RATE_MATCHING_H_
+#define RATE_MATCHING_H_
+
+#include <cstddef>
+#include <cstdint>
+
+/// Number of redundancy versions
+static constexpr size_t kNumRedundancyVersions = 4;
+
+/// Length N_cb of the circular buffer of a code block: all its coded bits
+/// after the 2 * zc punctured ones. Agora does not limit the buffer size
+/// (no LBRM) and has no filler bits.
+size_t LdpcCircularBufferLen(size_t base_graph, size_t zc);
+
+/// Start position k0 of redundancy version rv (0 to 3) in the circular
+/// buffer, TS 38.212 Table 5.4.2.1-2
+size_t LdpcRvStart(size_t base_graph, size_t zc, size_t rv);
+
+/// Rate match the circular buffer [encoded] (the packed bits, least
+/// significant bit first, written by LdpcEncodeHelper with all
+/// LdpcMaxNumRows rows) to the num_out_bits bits of a transmission with
+/// redundancy version rv, interleaved for mod_order_bits bits per symbol.
+/// num_out_bits must be a multiple of mod_order_bits, and may exceed the
+/// buffer length, which repeats bits. [out] gets BitsToBytes(num_out_bits)
+/// packed bytes, least significant bit first.
+void LdpcRateMatch(size_t base_graph, size_t zc, size_t rv,
+                   size_t mod_order_bits, const uint8_t* encoded,
+                   size_t num_out_bits, uint8_t* out);
+
+/// Inverse of LdpcRateMatch for the num_llrs LLRs of a transmission: undo
+/// the interleaving and add each LLR to its bit in the circular buffer
+/// [soft_buffer] of LdpcCircularBufferLen LLRs, saturating
+void LdpcDeRateMatch(size_t base_graph, size_t zc, size_t rv,
+                     size_t mod_order_bits, const int8_t* llrs,
+                     size_t num_llrs, int16_t* soft_buffer);
+
+#endif  // RATE_MATCHING_H_
@@ -3,6 +3,7 @@
 
 #include <mkl.h>
 
+#include <array>
 #include <map>
 #include <string>
 
@@ -61,6 +62,27 @@ enum class EventType : int {
 static constexpr size_t kNumEventTypes =
     static_cast<size_t>(EventType::kPacketToMac) + 1;
 
+// Scheduler used by the Agora worker threads to pick tasks
+enum class WorkerScheduler {
+  kQueues,        // Shared per-event-type queues polled in a fixed order
+  kWorkStealing,  // Per-worker deques with stealing from near workers
+  kEdf            // One queue shared by all workers, earliest deadline first
+};
+
+// Linear detector and precoder computed by DoZF from the CSI matrix H
+enum class BeamformerType {
+  kZF,    // Zeroforcing, inv(H' * H) * H'
+  kMMSE,  // inv(H' * H + noise_var * I) * H'
+  kRZF    // Regularized zeroforcing, inv(H' * H + ue_num * noise_var * I) * H'
+};
+
+// LDPC decoder used by DoDecode
+enum class LdpcDecoderType {
+  kFlexRan,     // FlexRAN's bblib_ldpc_decoder_5gnr
+  kAgoraAvx2,   // Agora's layered offset-min-sum LdpcDecoder, AVX2 kernels
+  kAgoraAvx512  // Agora's LdpcDecoder, AVX-512 kernels
+};
+
 // Types of Agora Doers
 enum class DoerType : size_t {
   kFFT,
@@ -183,6 +205,7 @@ enum class ThreadType {
   kWorkerMacTXRX,
   kMasterRX,
   kMasterTX,
+  kMasterShard,
 };
 
 static inline std::string ThreadTypeStr(ThreadType thread_type) {
@@ -211,6 +234,8 @@ static inline std::string ThreadTypeStr(ThreadType thread_type) {
       return "Master (RX)";
     case ThreadType::kMasterTX:
       return "Master (TX)";
+    case ThreadType::kMasterShard:
+      return "Master (shard)";
   }
   return "Invalid thread type";
 }
@@ -308,6 +333,12 @@ static constexpr bool kUseAVX2Encoder = true;
 static constexpr bool kUseAVX2Encoder = false;
 #endif
 
+#ifdef USE_AGORA_DECODER
+static constexpr bool kUseAgoraDecoder = true;
+#else
+static constexpr bool kUseAgoraDecoder = false;
+#endif
+
 // Enable debugging for sender and receiver applications
 static constexpr bool kDebugSenderReceiver = false;
 #endif  // SYMBOLS_H_
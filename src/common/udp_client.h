@@ -70,13 +70,91 @@ class UDPClient {
    */
   void Send(const std::string& rem_hostname, uint16_t rem_port,
             const uint8_t* msg, size_t len) {
-    std::string remote_uri = rem_hostname + ":" + std::to_string(rem_port);
-    struct addrinfo* rem_addrinfo = nullptr;
-
     if (kDebugPrintUdpClientSend) {
       std::printf("UDPClient sending message to %s to port %d\n",
                   rem_hostname.c_str(), rem_port);
     }
+    struct addrinfo* rem_addrinfo = GetAddrInfo(rem_hostname, rem_port);
+
+    ssize_t ret = sendto(sock_fd_, msg, len, 0, rem_addrinfo->ai_addr,
+                         rem_addrinfo->ai_addrlen);
+    if (ret != static_cast<ssize_t>(len)) {
+      throw std::runtime_error("sendto() failed. errno = " +
+                               std::string(std::strerror(errno)));
+    }
+
+    if (enable_recording_flag_) {
+      std::scoped_lock map_access(map_insert_access_);
+      sent_vec_.emplace_back(msg, msg + len);
+    }
+  }
+
+  /**
+   * @brief Send num_msgs UDP packets of equal length to a remote server with
+   * as few sendmmsg() calls as possible. Packet i is sent to
+   * rem_hostname:rem_ports[i].
+   *
+   * @param rem_hostname Hostname or IP address of the remote server
+   * @param rem_ports UDP ports that the remote server is listening on
+   * @param msgs Pointers to the messages to send
+   * @param len Length in bytes of each message to send
+   * @param num_msgs Number of messages to send
+   */
+  void SendBatch(const std::string& rem_hostname, const uint16_t* rem_ports,
+                 const uint8_t* const* msgs, size_t len, size_t num_msgs) {
+    if (batch_msgs_.size() < num_msgs) {
+      batch_msgs_.resize(num_msgs);
+      batch_iovecs_.resize(num_msgs);
+    }
+    for (size_t i = 0; i < num_msgs; i++) {
+      struct addrinfo* rem_addrinfo = GetAddrInfo(rem_hostname, rem_ports[i]);
+      batch_iovecs_[i].iov_base =
+          const_cast<void*>(static_cast<const void*>(msgs[i]));
+      batch_iovecs_[i].iov_len = len;
+      std::memset(&batch_msgs_[i], 0, sizeof(struct mmsghdr));
+      batch_msgs_[i].msg_hdr.msg_name = rem_addrinfo->ai_addr;
+      batch_msgs_[i].msg_hdr.msg_namelen = rem_addrinfo->ai_addrlen;
+      batch_msgs_[i].msg_hdr.msg_iov = &batch_iovecs_[i];
+      batch_msgs_[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    // sendmmsg() may send fewer messages than requested, resubmit the rest
+    size_t num_sent = 0;
+    while (num_sent < num_msgs) {
+      int ret = sendmmsg(sock_fd_, &batch_msgs_[num_sent],
+                         static_cast<unsigned int>(num_msgs - num_sent), 0);
+      if (ret <= 0) {
+        throw std::runtime_error("sendmmsg() failed. errno = " +
+                                 std::string(std::strerror(errno)));
+      }
+      for (size_t i = num_sent; i < num_sent + ret; i++) {
+        if (batch_msgs_[i].msg_len != len) {
+          throw std::runtime_error("sendmmsg() sent a partial message");
+        }
+      }
+      num_sent += ret;
+    }
+
+    if (enable_recording_flag_) {
+      std::scoped_lock map_access(map_insert_access_);
+      for (size_t i = 0; i < num_msgs; i++) {
+        sent_vec_.emplace_back(msgs[i], msgs[i] + len);
+      }
+    }
+  }
+
+  // Enable recording of all packets sent by this UDP client
+  void EnableRecording() { enable_recording_flag_ = true; }
+
+ private:
+  /**
+   * @brief Return the addrinfo of rem_hostname:rem_port, resolving and
+   * caching it on first use
+   */
+  struct addrinfo* GetAddrInfo(const std::string& rem_hostname,
+                               uint16_t rem_port) {
+    std::string remote_uri = rem_hostname + ":" + std::to_string(rem_port);
+    struct addrinfo* rem_addrinfo = nullptr;
 
     const auto remote_itr = addrinfo_map_.find(remote_uri);
     if (remote_itr == addrinfo_map_.end()) {
@@ -119,24 +197,9 @@ class UDPClient {
     } else {
       rem_addrinfo = remote_itr->second;
     }
-
-    ssize_t ret = sendto(sock_fd_, msg, len, 0, rem_addrinfo->ai_addr,
-                         rem_addrinfo->ai_addrlen);
-    if (ret != static_cast<ssize_t>(len)) {
-      throw std::runtime_error("sendto() failed. errno = " +
-                               std::string(std::strerror(errno)));
-    }
-
-    if (enable_recording_flag_) {
-      std::scoped_lock map_access(map_insert_access_);
-      sent_vec_.emplace_back(msg, msg + len);
-    }
+    return rem_addrinfo;
   }
 
-  // Enable recording of all packets sent by this UDP client
-  void EnableRecording() { enable_recording_flag_ = true; }
-
- private:
   /**
    * @brief The raw socket file descriptor
    */
@@ -161,6 +224,12 @@ class UDPClient {
    * @brief If set to ture, we record all sent packets, otherwise we dont
    */
   bool enable_recording_flag_ = false;
+
+  /**
+   * @brief Message headers and io vectors reused across SendBatch calls
+   */
+  std::vector<struct mmsghdr> batch_msgs_;
+  std::vector<struct iovec> batch_iovecs_;
 };
 
 #endif  // UDP_CLIENT_H_
\ No newline at end of file
@@ -25,6 +25,7 @@
 #include <map>
 #include <mutex>
 #include <stdexcept>
+#include <vector>
 
 /// Basic UDP server class based on OS sockets that supports receiving messages
 class UDPServer {
@@ -137,6 +138,46 @@ class UDPServer {
     return ret;
   }
 
+  /**
+   * @brief Try to receive up to num_bufs datagrams with a single recvmmsg()
+   * call, by default this will not block. Datagram i is written to bufs[i]
+   * and its length is returned in msg_lens[i].
+   *
+   * @return Return the number of datagrams received. If no datagrams are
+   * available, return zero. If there was an error in receiving, return -1.
+   */
+  ssize_t RecvBatch(uint8_t* const* bufs, size_t len, size_t num_bufs,
+                    size_t* msg_lens) {
+    if (batch_msgs_.size() < num_bufs) {
+      batch_msgs_.resize(num_bufs);
+      batch_iovecs_.resize(num_bufs);
+    }
+    for (size_t i = 0; i < num_bufs; i++) {
+      batch_iovecs_[i].iov_base = static_cast<void*>(bufs[i]);
+      batch_iovecs_[i].iov_len = len;
+      std::memset(&batch_msgs_[i], 0, sizeof(struct mmsghdr));
+      batch_msgs_[i].msg_hdr.msg_iov = &batch_iovecs_[i];
+      batch_msgs_[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    int ret = recvmmsg(sock_fd_, batch_msgs_.data(),
+                       static_cast<unsigned int>(num_bufs), 0, nullptr);
+    if (ret == -1) {
+      if ((errno == EAGAIN) || (errno == EWOULDBLOCK)) {
+        // These errors mean that there's no data to receive
+        ret = 0;
+      } else {
+        std::fprintf(stderr,
+                     "UDPServer: recvmmsg() failed with unexpected error %s\n",
+                     std::strerror(errno));
+      }
+    }
+    for (int i = 0; i < ret; i++) {
+      msg_lens[i] = batch_msgs_[i].msg_len;
+    }
+    return ret;
+  }
+
   /**
    * @brief Try once to receive up to len bytes in buf
    *
@@ -257,6 +298,12 @@ class UDPServer {
    * structures
    */
   std::mutex map_insert_access_;
+
+  /**
+   * @brief Message headers and io vectors reused across RecvBatch calls
+   */
+  std::vector<struct mmsghdr> batch_msgs_;
+  std::vector<struct iovec> batch_iovecs_;
 };
 
 #endif  // UDP_SERVER_H_
\ No newline at end of file
@@ -2,6 +2,7 @@
 #define UTILS_LDPC_H_
 
 #include <cstdlib> /* for std::aligned_alloc */
+#include <cstring>
 
 #include "encoder.h"
 #include "iobuffer.h"
@@ -192,27 +193,15 @@ static inline size_t LdpcGetMaxZc() {
   return kUseAVX2Encoder ? avx2enc::kZcMax : ZC_MAX;
 }
 
-// Generate the codeword output and parity buffer for this input buffer
-static inline void LdpcEncodeHelper(size_t base_graph, size_t zc, size_t nRows,
-                                    int8_t* encoded_buffer,
-                                    int8_t* parity_buffer,
-                                    const int8_t* input_buffer) {
+// Copy the input bits after the punctured ones and the first nRows * zc parity
+// bits of a code block into encoded_buffer
+static inline void LdpcConcatEncodedBits(size_t base_graph, size_t zc,
+                                         size_t nRows, int8_t* encoded_buffer,
+                                         int8_t* parity_buffer,
+                                         const int8_t* input_buffer) {
   const size_t num_input_bits = LdpcNumInputBits(base_graph, zc);
   const size_t num_parity_bits = nRows * zc;
 
-  bblib_ldpc_encoder_5gnr_request req;
-  bblib_ldpc_encoder_5gnr_response resp;
-  req.baseGraph = base_graph;
-  req.nRows = kUseAVX2Encoder ? LdpcMaxNumRows(base_graph) : nRows;
-  req.Zc = zc;
-  req.nRows = nRows;
-  req.numberCodeblocks = 1;
-  req.input[0] = const_cast<int8_t*>(input_buffer);
-  resp.output[0] = parity_buffer;
-
-  kUseAVX2Encoder ? avx2enc::BblibLdpcEncoder5gnr(&req, &resp)
-                  : bblib_ldpc_encoder_5gnr(&req, &resp);
-
   // Copy punctured input bits from the encoding request, and parity bits from
   // the encoding response into encoded_buffer
   static size_t k_num_punctured_cols = 2;
@@ -272,4 +261,49 @@ static inline void LdpcEncodeHelper(size_t base_graph, size_t zc, size_t nRows,
   }
 }
 
-#endif  // UTILS_LDPC_H_
\ No newline at end of file
+// Generate the codeword output and parity buffer for this input buffer
+static inline void LdpcEncodeHelper(size_t base_graph, size_t zc, size_t nRows,
+                                    int8_t* encoded_buffer,
+                                    int8_t* parity_buffer,
+                                    const int8_t* input_buffer) {
+  bblib_ldpc_encoder_5gnr_request req;
+  bblib_ldpc_encoder_5gnr_response resp;
+  req.baseGraph = base_graph;
+  req.nRows = kUseAVX2Encoder ? LdpcMaxNumRows(base_graph) : nRows;
+  req.Zc = zc;
+  req.nRows = nRows;
+  req.numberCodeblocks = 1;
+  req.input[0] = const_cast<int8_t*>(input_buffer);
+  resp.output[0] = parity_buffer;
+
+  kUseAVX2Encoder ? avx2enc::BblibLdpcEncoder5gnr(&req, &resp)
+                  : bblib_ldpc_encoder_5gnr(&req, &resp);
+
+  LdpcConcatEncodedBits(base_graph, zc, nRows, encoded_buffer, parity_buffer,
+                        input_buffer);
+}
+
+// Generate the codeword outputs and parity buffers of num_blocks code blocks
+// with the same base graph, expansion factor, and number of rows. Agora's
+// AVX2 encoder encodes them together, several code blocks per register.
+static inline void LdpcEncodeHelperBatch(size_t base_graph, size_t zc,
+                                         size_t nRows, size_t num_blocks,
+                                         int8_t* const* encoded_buffers,
+                                         int8_t* const* parity_buffers,
+                                         int8_t* const* input_buffers) {
+  if (kUseAVX2Encoder) {
+    avx2enc::LdpcEncodeBatch(base_graph, zc, nRows, input_buffers,
+                             parity_buffers, num_blocks);
+    for (size_t n = 0; n < num_blocks; n++) {
+      LdpcConcatEncodedBits(base_graph, zc, nRows, encoded_buffers[n],
+                            parity_buffers[n], input_buffers[n]);
+    }
+  } else {
+    for (size_t n = 0; n < num_blocks; n++) {
+      LdpcEncodeHelper(base_graph, zc, nRows, encoded_buffers[n],
+                       parity_buffers[n], input_buffers[n]);
+    }
+  }
+}
+
+#endif  // UTILS_LDPC_H_
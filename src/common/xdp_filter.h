@@ -0,0 +1,70 @@
+/**
+ * @file xdp_filter.h
+ * @brief Packet filter of Agora's XDP program, which picks the frames that
+ * are redirected to the AF_XDP sockets. It is plain C so that the BPF program
+ * (xdp_redirect.bpf.c) and the host code and tests share it, and it reads
+ * the headers at fixed offsets because the kernel's and glibc's header
+ * structs cannot be included together. Every access is checked against
+ * data_end, as the BPF verifier requires.
+ */
+
+#ifndef XDP_FILTER_H_
+#define XDP_FILTER_H_
+
+#include <linux/types.h>
+
+#define XDP_FILTER_ETH_HDR_LEN 14
+#define XDP_FILTER_IPV4_HDR_LEN 20
+#define XDP_FILTER_IPV6_HDR_LEN 40
+#define XDP_FILTER_UDP_HDR_LEN 8
+#define XDP_FILTER_PROTO_UDP 17
+
+/* Read a big endian 16-bit field */
+static inline __attribute__((always_inline)) __u32 XdpFilterRead16(
+    const __u8* p) {
+  return ((__u32)p[0] << 8) | p[1];
+}
+
+/* Return nonzero if the frame in [data, data_end) is a UDP datagram over IPv4
+ * (without options) or IPv6 (without extension headers) whose destination
+ * port is in [port_lo, port_lo + num_ports). Everything else, e.g., ARP and
+ * neighbor discovery, is left to the kernel. */
+static inline __attribute__((always_inline)) int XdpIsAgoraUdp(
+    const void* data, const void* data_end, __u32 port_lo, __u32 num_ports) {
+  const __u8* eth = (const __u8*)data;
+  const __u8* end = (const __u8*)data_end;
+  const __u8* udp;
+  __u32 ether_type;
+  __u32 dst_port;
+
+  if (eth + XDP_FILTER_ETH_HDR_LEN > end) {
+    return 0;
+  }
+  ether_type = XdpFilterRead16(eth + 12);
+  if (ether_type == 0x0800) {
+    const __u8* ip = eth + XDP_FILTER_ETH_HDR_LEN;
+    /* Version 4, header length 5 words */
+    if ((ip + XDP_FILTER_IPV4_HDR_LEN > end) || (ip[0] != 0x45) ||
+        (ip[9] != XDP_FILTER_PROTO_UDP)) {
+      return 0;
+    }
+    udp = ip + XDP_FILTER_IPV4_HDR_LEN;
+  } else if (ether_type == 0x86DD) {
+    const __u8* ip6 = eth + XDP_FILTER_ETH_HDR_LEN;
+    /* Next header */
+    if ((ip6 + XDP_FILTER_IPV6_HDR_LEN > end) ||
+        (ip6[6] != XDP_FILTER_PROTO_UDP)) {
+      return 0;
+    }
+    udp = ip6 + XDP_FILTER_IPV6_HDR_LEN;
+  } else {
+    return 0;
+  }
+  if (udp + XDP_FILTER_UDP_HDR_LEN > end) {
+    return 0;
+  }
+  dst_port = XdpFilterRead16(udp + 2);
+  return (dst_port >= port_lo) && (dst_port - port_lo < num_ports);
+}
+
+#endif  // XDP_FILTER_H_
@@ -0,0 +1,53 @@
+/**
+ * @file xdp_redirect.bpf.c
+ * @brief XDP program of Agora's AF_XDP backend. It redirects the UDP
+ * datagrams sent to Agora's server ports to the AF_XDP socket of the queue
+ * they arrive on, and passes all other traffic, e.g., ARP and neighbor
+ * discovery, to the kernel. Built with clang -target bpf when USE_AF_XDP is
+ * enabled, and loaded by XdpRedirectProgram.
+ */
+
+#include <bpf/bpf_helpers.h>
+#include <linux/bpf.h>
+
+#include "xdp_filter.h"
+
+/* Must match kXdpMaxQueues in xdp_transport.h */
+#define XDP_MAX_QUEUES 64
+
+/* AF_XDP socket of each queue */
+struct {
+  __uint(type, BPF_MAP_TYPE_XSKMAP);
+  __uint(max_entries, XDP_MAX_QUEUES);
+  __type(key, __u32);
+  __type(value, __u32);
+} xsks_map SEC(".maps");
+
+/* Entry 0 is the first server UDP port, entry 1 the number of ports. Both
+ * are zero, so nothing is redirected, until user space sets them. */
+struct {
+  __uint(type, BPF_MAP_TYPE_ARRAY);
+  __uint(max_entries, 2);
+  __type(key, __u32);
+  __type(value, __u32);
+} agora_ports SEC(".maps");
+
+SEC("xdp")
+int xdp_agora_redirect(struct xdp_md* ctx) {
+  __u32 key = 0;
+  const __u32* port_lo = bpf_map_lookup_elem(&agora_ports, &key);
+  key = 1;
+  const __u32* num_ports = bpf_map_lookup_elem(&agora_ports, &key);
+  if ((port_lo == 0) || (num_ports == 0)) {
+    return XDP_PASS;
+  }
+
+  if (XdpIsAgoraUdp((void*)(long)ctx->data, (void*)(long)ctx->data_end,
+                    *port_lo, *num_ports) == 0) {
+    return XDP_PASS;
+  }
+  /* Pass the frame if the queue has no socket */
+  return bpf_redirect_map(&xsks_map, ctx->rx_queue_index, XDP_PASS);
+}
+
+char _license[] SEC("license") = "GPL";
@@ -0,0 +1,370 @@
+/**
+ * @file xdp_transport.cc
+ * @brief Implementation file for the XdpTransport and XdpRedirectProgram
+ * classes.
+ */
+#if defined(USE_AF_XDP)
+
+#include "xdp_transport.h"
+
+#include <arpa/inet.h>
+#include <bpf/bpf.h>
+#include <bpf/libbpf.h>
+#include <net/if.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include "logger.h"
+#include "utils.h"
+
+/// Add [len] bytes at [data] to a ones' complement checksum
+static uint32_t CsumAdd(uint32_t sum, const void* data, size_t len) {
+  const auto* bytes = static_cast<const uint8_t*>(data);
+  for (size_t i = 0; i + 1 < len; i += 2) {
+    sum += (static_cast<uint32_t>(bytes[i]) << 8) | bytes[i + 1];
+  }
+  if ((len & 1) != 0) {
+    sum += static_cast<uint32_t>(bytes[len - 1]) << 8;
+  }
+  return sum;
+}
+
+/// Fold a ones' complement sum and return its complement in network order
+static uint16_t CsumFinish(uint32_t sum) {
+  while ((sum >> 16) != 0) {
+    sum = (sum & 0xffff) + (sum >> 16);
+  }
+  return htons(static_cast<uint16_t>(~sum & 0xffff));
+}
+
+XdpRedirectProgram::XdpRedirectProgram(const std::string& ifname,
+                                       bool generic_mode, uint16_t port_lo,
+                                       size_t num_ports)
+    : ifindex_(static_cast<int>(if_nametoindex(ifname.c_str()))),
+      mode_(generic_mode ? XDP_MODE_SKB : XDP_MODE_NATIVE) {
+  if (ifindex_ == 0) {
+    throw std::runtime_error("XdpRedirectProgram: Unknown interface " +
+                             ifname);
+  }
+  prog_ = xdp_program__open_file(XDP_REDIRECT_PROG_PATH, "xdp", nullptr);
+  int ret = libxdp_get_error(prog_);
+  if (ret != 0) {
+    throw std::runtime_error(
+        std::string("XdpRedirectProgram: Failed to open ") +
+        XDP_REDIRECT_PROG_PATH + ". Error: " + std::strerror(-ret));
+  }
+  ret = xdp_program__attach(prog_, ifindex_, mode_, 0);
+  if (ret != 0) {
+    xdp_program__close(prog_);
+    throw std::runtime_error("XdpRedirectProgram: Failed to attach to " +
+                             ifname + ". Error: " + std::strerror(-ret));
+  }
+
+  struct bpf_object* obj = xdp_program__bpf_obj(prog_);
+  xsks_map_fd_ = bpf_object__find_map_fd_by_name(obj, "xsks_map");
+  const int ports_map_fd = bpf_object__find_map_fd_by_name(obj, "agora_ports");
+  const uint32_t ports[2] = {port_lo, static_cast<uint32_t>(num_ports)};
+  for (uint32_t key = 0; key < 2; key++) {
+    if ((ports_map_fd < 0) ||
+        (bpf_map_update_elem(ports_map_fd, &key, &ports[key], BPF_ANY) != 0)) {
+      xdp_program__detach(prog_, ifindex_, mode_, 0);
+      xdp_program__close(prog_);
+      throw std::runtime_error(
+          "XdpRedirectProgram: Failed to set the UDP ports");
+    }
+  }
+  RtAssert(xsks_map_fd_ >= 0, "XdpRedirectProgram: Socket map not found");
+  MLPD_INFO(
+      "XdpRedirectProgram: Redirecting UDP ports %u-%zu of %s in %s mode\n",
+      port_lo, port_lo + num_ports - 1, ifname.c_str(),
+      generic_mode ? "generic" : "native");
+}
+
+XdpRedirectProgram::~XdpRedirectProgram() {
+  xdp_program__detach(prog_, ifindex_, mode_, 0);
+  xdp_program__close(prog_);
+}
+
+XdpTransport::XdpTransport(const std::string& ifname, uint32_t queue_id,
+                           void* umem_area, size_t umem_size,
+                           size_t frame_size, size_t frame_headroom,
+                           int xsks_map_fd, bool zero_copy)
+    : umem_area_(umem_area),
+      frame_size_(frame_size),
+      num_frames_(umem_size / frame_size) {
+  RtAssert((reinterpret_cast<uintptr_t>(umem_area) % getpagesize()) == 0,
+           "XdpTransport: UMEM area must be page aligned");
+
+  struct xsk_umem_config umem_cfg;
+  umem_cfg.fill_size = kXdpRingSize;
+  umem_cfg.comp_size = kXdpRingSize;
+  umem_cfg.frame_size = frame_size;
+  umem_cfg.frame_headroom = frame_headroom;
+  umem_cfg.flags = 0;
+  int ret = xsk_umem__create(&umem_, umem_area, num_frames_ * frame_size,
+                             &fill_ring_, &comp_ring_, &umem_cfg);
+  if (ret != 0) {
+    throw std::runtime_error("XdpTransport: Failed to create UMEM. Error: " +
+                             std::string(std::strerror(-ret)));
+  }
+
+  struct xsk_socket_config xsk_cfg;
+  std::memset(&xsk_cfg, 0, sizeof(xsk_cfg));
+  xsk_cfg.rx_size = kXdpRingSize;
+  xsk_cfg.tx_size = kXdpRingSize;
+  // XdpRedirectProgram is attached instead of libxdp's default program,
+  // which would redirect all traffic of the queue, including ARP and
+  // neighbor discovery, to the socket
+  xsk_cfg.libxdp_flags = XSK_LIBXDP_FLAGS__INHIBIT_PROG_LOAD;
+  xsk_cfg.bind_flags =
+      XDP_USE_NEED_WAKEUP | (zero_copy ? XDP_ZEROCOPY : XDP_COPY);
+  ret = xsk_socket__create(&xsk_, ifname.c_str(), queue_id, umem_, &rx_ring_,
+                           &tx_ring_, &xsk_cfg);
+  if (ret != 0) {
+    xsk_umem__delete(umem_);
+    throw std::runtime_error("XdpTransport: Failed to create AF_XDP socket on " +
+                             ifname + " queue " + std::to_string(queue_id) +
+                             ". Error: " + std::strerror(-ret));
+  }
+  ret = xsk_socket__update_xskmap(xsk_, xsks_map_fd);
+  if (ret != 0) {
+    xsk_socket__delete(xsk_);
+    xsk_umem__delete(umem_);
+    throw std::runtime_error(
+        "XdpTransport: Failed to add the AF_XDP socket to the XDP program. "
+        "Error: " +
+        std::string(std::strerror(-ret)));
+  }
+  MLPD_INFO(
+      "XdpTransport: AF_XDP socket on %s queue %u, %zu frames of %zu bytes, "
+      "%s\n",
+      ifname.c_str(), queue_id, num_frames_, frame_size_,
+      zero_copy ? "zero copy" : "copy");
+}
+
+XdpTransport::~XdpTransport() {
+  xsk_socket__delete(xsk_);
+  xsk_umem__delete(umem_);
+}
+
+size_t XdpTransport::Fill(const uint64_t* addrs, size_t num) {
+  const size_t num_free = xsk_prod_nb_free(&fill_ring_, num);
+  num = std::min(num, num_free);
+  uint32_t idx;
+  if ((num == 0) || (xsk_ring_prod__reserve(&fill_ring_, num, &idx) != num)) {
+    return 0;
+  }
+  for (size_t i = 0; i < num; i++) {
+    *xsk_ring_prod__fill_addr(&fill_ring_, idx + i) = addrs[i];
+  }
+  xsk_ring_prod__submit(&fill_ring_, num);
+  return num;
+}
+
+size_t XdpTransport::Recv(struct xdp_desc* descs, size_t num) {
+  uint32_t idx;
+  const size_t num_rx = xsk_ring_cons__peek(&rx_ring_, num, &idx);
+  if (num_rx == 0) {
+    // Let the kernel know that the fill ring has frames to receive into
+    if (xsk_ring_prod__needs_wakeup(&fill_ring_)) {
+      recvfrom(xsk_socket__fd(xsk_), nullptr, 0, MSG_DONTWAIT, nullptr,
+               nullptr);
+    }
+    return 0;
+  }
+  for (size_t i = 0; i < num_rx; i++) {
+    descs[i] = *xsk_ring_cons__rx_desc(&rx_ring_, idx + i);
+  }
+  xsk_ring_cons__release(&rx_ring_, num_rx);
+  return num_rx;
+}
+
+size_t XdpTransport::Send(const struct xdp_desc* descs, size_t num) {
+  const size_t num_free = xsk_prod_nb_free(&tx_ring_, num);
+  num = std::min(num, num_free);
+  uint32_t idx;
+  if ((num > 0) && (xsk_ring_prod__reserve(&tx_ring_, num, &idx) == num)) {
+    for (size_t i = 0; i < num; i++) {
+      *xsk_ring_prod__tx_desc(&tx_ring_, idx + i) = descs[i];
+    }
+    xsk_ring_prod__submit(&tx_ring_, num);
+  } else {
+    num = 0;
+  }
+
+  // Kick the kernel even if the tx ring was full, so that it drains the ring
+  if (xsk_ring_prod__needs_wakeup(&tx_ring_)) {
+    const ssize_t ret =
+        sendto(xsk_socket__fd(xsk_), nullptr, 0, MSG_DONTWAIT, nullptr, 0);
+    // These errors mean the kernel is busy and will send the frames later
+    if ((ret < 0) && (errno != ENOBUFS) && (errno != EAGAIN) &&
+        (errno != EBUSY) && (errno != ENETDOWN)) {
+      throw std::runtime_error("XdpTransport: sendto() failed. Error: " +
+                               std::string(std::strerror(errno)));
+    }
+  }
+  return num;
+}
+
+size_t XdpTransport::Complete(uint64_t* addrs, size_t num) {
+  uint32_t idx;
+  const size_t num_done = xsk_ring_cons__peek(&comp_ring_, num, &idx);
+  for (size_t i = 0; i < num_done; i++) {
+    addrs[i] = *xsk_ring_cons__comp_addr(&comp_ring_, idx + i);
+  }
+  if (num_done > 0) {
+    xsk_ring_cons__release(&comp_ring_, num_done);
+  }
+  return num_done;
+}
+
+void XdpTransport::GetMacAddr(const std::string& ifname, uint8_t* mac_addr) {
+  int fd = socket(AF_INET, SOCK_DGRAM, 0);
+  RtAssert(fd >= 0, "XdpTransport: Failed to create ioctl socket");
+  struct ifreq ifr;
+  std::memset(&ifr, 0, sizeof(ifr));
+  std::strncpy(ifr.ifr_name, ifname.c_str(), IFNAMSIZ - 1);
+  const int ret = ioctl(fd, SIOCGIFHWADDR, &ifr);
+  close(fd);
+  if (ret != 0) {
+    throw std::runtime_error("XdpTransport: Failed to get MAC address of " +
+                             ifname);
+  }
+  std::memcpy(mac_addr, ifr.ifr_hwaddr.sa_data, kMacAddrLen);
+}
+
+struct sockaddr_storage XdpTransport::ParseAddr(const std::string& addr) {
+  struct sockaddr_storage ss;
+  std::memset(&ss, 0, sizeof(ss));
+  auto* sin = reinterpret_cast<struct sockaddr_in*>(&ss);
+  auto* sin6 = reinterpret_cast<struct sockaddr_in6*>(&ss);
+  if (inet_pton(AF_INET, addr.c_str(), &sin->sin_addr) == 1) {
+    ss.ss_family = AF_INET;
+  } else if (inet_pton(AF_INET6, addr.c_str(), &sin6->sin6_addr) == 1) {
+    ss.ss_family = AF_INET6;
+  } else {
+    throw std::runtime_error("XdpTransport: Invalid IP address " + addr);
+  }
+  return ss;
+}
+
+size_t XdpTransport::WriteUdpHeaders(uint8_t* frame, const uint8_t* src_mac,
+                                     const uint8_t* dst_mac,
+                                     const struct sockaddr_storage& src_addr,
+                                     const struct sockaddr_storage& dst_addr,
+                                     uint16_t src_port, uint16_t dst_port,
+                                     size_t payload_len) {
+  auto* eth = reinterpret_cast<struct ethhdr*>(frame);
+  std::memcpy(eth->h_dest, dst_mac, kMacAddrLen);
+  std::memcpy(eth->h_source, src_mac, kMacAddrLen);
+
+  const size_t udp_len = sizeof(struct udphdr) + payload_len;
+  struct udphdr* udp = nullptr;
+  size_t frame_len = 0;
+  if (src_addr.ss_family == AF_INET) {
+    eth->h_proto = htons(ETH_P_IP);
+    auto* ip = reinterpret_cast<struct iphdr*>(eth + 1);
+    ip->version = 4;
+    ip->ihl = sizeof(struct iphdr) / 4;
+    ip->tos = 0;
+    ip->tot_len = htons(sizeof(struct iphdr) + udp_len);
+    ip->id = 0;
+    ip->frag_off = htons(IP_DF);
+    ip->ttl = 64;
+    ip->protocol = IPPROTO_UDP;
+    ip->check = 0;
+    ip->saddr =
+        reinterpret_cast<const struct sockaddr_in*>(&src_addr)->sin_addr.s_addr;
+    ip->daddr =
+        reinterpret_cast<const struct sockaddr_in*>(&dst_addr)->sin_addr.s_addr;
+    ip->check = CsumFinish(CsumAdd(0, ip, sizeof(struct iphdr)));
+
+    udp = reinterpret_cast<struct udphdr*>(ip + 1);
+    udp->source = htons(src_port);
+    udp->dest = htons(dst_port);
+    udp->len = htons(udp_len);
+    // The UDP checksum is optional over IPv4
+    udp->check = 0;
+    frame_len = kXdpIpv4HdrLen + payload_len;
+  } else {
+    eth->h_proto = htons(ETH_P_IPV6);
+    auto* ip6 = reinterpret_cast<struct ip6_hdr*>(eth + 1);
+    ip6->ip6_flow = htonl(6u << 28);
+    ip6->ip6_plen = htons(udp_len);
+    ip6->ip6_nxt = IPPROTO_UDP;
+    ip6->ip6_hlim = 64;
+    ip6->ip6_src =
+        reinterpret_cast<const struct sockaddr_in6*>(&src_addr)->sin6_addr;
+    ip6->ip6_dst =
+        reinterpret_cast<const struct sockaddr_in6*>(&dst_addr)->sin6_addr;
+
+    udp = reinterpret_cast<struct udphdr*>(ip6 + 1);
+    udp->source = htons(src_port);
+    udp->dest = htons(dst_port);
+    udp->len = htons(udp_len);
+    udp->check = 0;
+
+    // The UDP checksum is mandatory over IPv6, it covers a pseudo header
+    uint32_t sum = CsumAdd(0, &ip6->ip6_src, 2 * sizeof(struct in6_addr));
+    sum += udp_len + IPPROTO_UDP;
+    sum = CsumAdd(sum, udp, udp_len);
+    udp->check = CsumFinish(sum);
+    if (udp->check == 0) {
+      udp->check = 0xffff;
+    }
+    frame_len = kXdpIpv6HdrLen + payload_len;
+  }
+  return frame_len;
+}
+
+uint8_t* XdpTransport::ParseUdp(uint8_t* frame, size_t frame_len,
+                                const struct sockaddr_storage& dst_addr,
+                                uint16_t* dst_port, size_t* payload_len) {
+  auto* eth = reinterpret_cast<struct ethhdr*>(frame);
+  struct udphdr* udp = nullptr;
+  size_t hdr_len = 0;
+
+  if ((dst_addr.ss_family == AF_INET) && (frame_len >= kXdpIpv4HdrLen) &&
+      (eth->h_proto == htons(ETH_P_IP))) {
+    auto* ip = reinterpret_cast<struct iphdr*>(eth + 1);
+    if ((ip->ihl != sizeof(struct iphdr) / 4) ||
+        (ip->protocol != IPPROTO_UDP) ||
+        (ip->daddr != reinterpret_cast<const struct sockaddr_in*>(&dst_addr)
+                          ->sin_addr.s_addr)) {
+      return nullptr;
+    }
+    udp = reinterpret_cast<struct udphdr*>(ip + 1);
+    hdr_len = kXdpIpv4HdrLen;
+  } else if ((dst_addr.ss_family == AF_INET6) &&
+             (frame_len >= kXdpIpv6HdrLen) &&
+             (eth->h_proto == htons(ETH_P_IPV6))) {
+    auto* ip6 = reinterpret_cast<struct ip6_hdr*>(eth + 1);
+    if ((ip6->ip6_nxt != IPPROTO_UDP) ||
+        (std::memcmp(&ip6->ip6_dst,
+                     &reinterpret_cast<const struct sockaddr_in6*>(&dst_addr)
+                          ->sin6_addr,
+                     sizeof(struct in6_addr)) != 0)) {
+      return nullptr;
+    }
+    udp = reinterpret_cast<struct udphdr*>(ip6 + 1);
+    hdr_len = kXdpIpv6HdrLen;
+  } else {
+    return nullptr;
+  }
+
+  const size_t udp_len = ntohs(udp->len);
+  if ((udp_len < sizeof(struct udphdr)) ||
+      (hdr_len + udp_len - sizeof(struct udphdr) > frame_len)) {
+    return nullptr;
+  }
+  *dst_port = ntohs(udp->dest);
+  *payload_len = udp_len - sizeof(struct udphdr);
+  return frame + hdr_len;
+}
+
+#endif  // defined(USE_AF_XDP)
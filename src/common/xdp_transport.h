@@ -0,0 +1,158 @@
+/**
+ * @file xdp_transport.h
+ * @brief Declaration file for the XdpTransport class, an AF_XDP socket bound
+ * to one NIC queue whose UMEM is provided by the caller, and the
+ * XdpRedirectProgram class, the XDP program that feeds the sockets.
+ */
+
+#ifndef XDP_TRANSPORT_H_
+#define XDP_TRANSPORT_H_
+
+#include <linux/bpf.h>
+#include <linux/if_ether.h>
+#include <linux/if_link.h>
+#include <linux/if_xdp.h>
+#include <netinet/in.h>
+#include <netinet/ip.h>
+#include <netinet/ip6.h>
+#include <netinet/udp.h>
+#include <sys/socket.h>
+#include <xdp/libxdp.h>
+#include <xdp/xsk.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+static constexpr size_t kXdpRingSize = XSK_RING_CONS__DEFAULT_NUM_DESCS;
+/// Maximum number of descriptors handled per ring operation
+static constexpr size_t kXdpBatchSize = 64;
+/// Number of UMEM frames of each socket reserved for transmission
+static constexpr size_t kXdpTxFrames = 2 * kXdpBatchSize;
+static constexpr size_t kMacAddrLen = ETH_ALEN;
+/// Number of queues the XDP program can redirect to (XDP_MAX_QUEUES in
+/// xdp_redirect.bpf.c)
+static constexpr size_t kXdpMaxQueues = 64;
+
+/// Layer 2-4 header lengths of the UDP frames handled by the XDP backend
+static constexpr size_t kXdpIpv4HdrLen =
+    sizeof(struct ethhdr) + sizeof(struct iphdr) + sizeof(struct udphdr);
+static constexpr size_t kXdpIpv6HdrLen =
+    sizeof(struct ethhdr) + sizeof(struct ip6_hdr) + sizeof(struct udphdr);
+static_assert(kXdpIpv4HdrLen == 42 && kXdpIpv6HdrLen == 62, "");
+
+/**
+ * @brief Agora's XDP program (xdp_redirect.bpf.c) attached to one interface.
+ * It redirects the UDP datagrams sent to ports [port_lo, port_lo + num_ports)
+ * to the AF_XDP socket of their queue, and passes everything else, e.g., ARP
+ * and neighbor discovery, to the kernel.
+ */
+class XdpRedirectProgram {
+ public:
+  /**
+   * @param generic_mode Attach in generic (skb) mode, which works on any
+   * interface including veth and loopback, instead of native mode
+   */
+  XdpRedirectProgram(const std::string& ifname, bool generic_mode,
+                     uint16_t port_lo, size_t num_ports);
+  ~XdpRedirectProgram();
+
+  XdpRedirectProgram& operator=(const XdpRedirectProgram&) = delete;
+  XdpRedirectProgram(const XdpRedirectProgram&) = delete;
+
+  /// The map of AF_XDP sockets, indexed by queue
+  inline int XsksMapFd() const { return xsks_map_fd_; }
+
+ private:
+  struct xdp_program* prog_;
+  int ifindex_;
+  enum xdp_attach_mode mode_;
+  int xsks_map_fd_;
+};
+
+class XdpTransport {
+ public:
+  /**
+   * @brief Create an AF_XDP socket on queue [queue_id] of interface [ifname],
+   * using [umem_size] bytes at [umem_area] (page aligned) as its UMEM, and
+   * add it to the socket map of the XDP program
+   *
+   * @param frame_size Size of one UMEM frame, 2048 or 4096
+   * @param frame_headroom Bytes the kernel leaves in front of each received
+   * frame, in addition to XDP_PACKET_HEADROOM
+   * @param xsks_map_fd Socket map of the XdpRedirectProgram of [ifname]
+   * @param zero_copy Request zero copy mode, only supported in native mode
+   */
+  XdpTransport(const std::string& ifname, uint32_t queue_id, void* umem_area,
+               size_t umem_size, size_t frame_size, size_t frame_headroom,
+               int xsks_map_fd, bool zero_copy);
+  ~XdpTransport();
+
+  XdpTransport& operator=(const XdpTransport&) = delete;
+  XdpTransport(const XdpTransport&) = delete;
+
+  /// Give up to [num] UMEM frames to the kernel for receiving, return the
+  /// number of frames given
+  size_t Fill(const uint64_t* addrs, size_t num);
+
+  /// Dequeue up to [num] received frame descriptors, return the number
+  /// dequeued
+  size_t Recv(struct xdp_desc* descs, size_t num);
+
+  /// Enqueue up to [num] frames for transmission and kick the kernel if
+  /// needed, return the number of frames enqueued
+  size_t Send(const struct xdp_desc* descs, size_t num);
+
+  /// Return up to [num] UMEM frames whose transmission is complete
+  size_t Complete(uint64_t* addrs, size_t num);
+
+  inline uint8_t* Data(uint64_t addr) const {
+    return static_cast<uint8_t*>(xsk_umem__get_data(umem_area_, addr));
+  }
+  inline size_t FrameSize() const { return frame_size_; }
+  inline size_t NumFrames() const { return num_frames_; }
+
+  /// Fill [mac_addr] with the MAC address of interface [ifname]
+  static void GetMacAddr(const std::string& ifname, uint8_t* mac_addr);
+
+  /**
+   * @brief Write Ethernet, IP (v4 or v6, following src_addr's family), and
+   * UDP headers for a [payload_len] byte payload that already follows the
+   * headers in [frame]
+   *
+   * @return The total frame length
+   */
+  static size_t WriteUdpHeaders(uint8_t* frame, const uint8_t* src_mac,
+                                const uint8_t* dst_mac,
+                                const struct sockaddr_storage& src_addr,
+                                const struct sockaddr_storage& dst_addr,
+                                uint16_t src_port, uint16_t dst_port,
+                                size_t payload_len);
+
+  /**
+   * @brief Check that [frame] is a UDP datagram sent to [dst_addr]
+   *
+   * @return Pointer to the UDP payload, or nullptr if the frame does not
+   * match. On success, dst_port and payload_len are set.
+   */
+  static uint8_t* ParseUdp(uint8_t* frame, size_t frame_len,
+                           const struct sockaddr_storage& dst_addr,
+                           uint16_t* dst_port, size_t* payload_len);
+
+  /// Resolve a numeric IPv4 or IPv6 address string
+  static struct sockaddr_storage ParseAddr(const std::string& addr);
+
+ private:
+  void* umem_area_;
+  size_t frame_size_;
+  size_t num_frames_;
+
+  struct xsk_umem* umem_;
+  struct xsk_socket* xsk_;
+  struct xsk_ring_prod fill_ring_;
+  struct xsk_ring_cons comp_ring_;
+  struct xsk_ring_cons rx_ring_;
+  struct xsk_ring_prod tx_ring_;
+};
+
+#endif  // XDP_TRANSPORT_H_
@@ -163,6 +163,77 @@ inline __m256i CycleBitShift144to256(__m256i data, int16_t cyc_shift,
   return x1;
 }
 
+inline __m256i CycleBitShift2to64Lanes(__m256i data, int16_t cyc_shift,
+                                       int16_t zc) {
+  __m256i x1;
+  __m256i x2;
+  __m256i bit_mask;
+  cyc_shift = cyc_shift % zc;
+  __int64_t e0;
+
+  if (zc >= 64) {
+    e0 = 0xffffffffffffffff;
+  } else {
+    e0 = (1UL << zc) - 1;
+  }
+
+  // Same as CycleBitShift2to64, with the segments in all four 64-bit lanes
+  bit_mask = _mm256_set1_epi64x(e0);
+  data = _mm256_and_si256(data, bit_mask);
+
+  x1 = _mm256_srli_epi64(data, cyc_shift);
+  x2 = _mm256_slli_epi64(data, zc - cyc_shift);
+
+  x1 = _mm256_or_si256(x1, x2);
+  x1 = _mm256_and_si256(x1, bit_mask);
+
+  return x1;
+}
+
+inline __m256i CycleBitShift72to128Lanes(__m256i data, int16_t cyc_shift,
+                                         int16_t zc) {
+  /* zc in this range is always a multiple of 8 */
+  const int zc_in_bytes = zc >> 3;
+  const int right_shift = cyc_shift % zc;
+  const int byte_shift = right_shift >> 3;
+  const int bit_shift = right_shift & 0x7;
+
+  // Byte i of each 128-bit lane of x0 is byte (i + byte_shift) % zc_in_bytes
+  // of the lane's segment, and byte i of x1 the byte after it. Bytes past the
+  // segment get don't-care indices and are masked out at the end.
+  const __m256i byte_index = _mm256_setr_epi8(
+      0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15,
+      0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+  const __m256i zc_bytes = _mm256_set1_epi8(static_cast<char>(zc_in_bytes));
+  const __m256i last_byte =
+      _mm256_set1_epi8(static_cast<char>(zc_in_bytes - 1));
+  __m256i shuffle0 = _mm256_add_epi8(
+      byte_index, _mm256_set1_epi8(static_cast<char>(byte_shift)));
+  shuffle0 = _mm256_sub_epi8(
+      shuffle0,
+      _mm256_and_si256(_mm256_cmpgt_epi8(shuffle0, last_byte), zc_bytes));
+  __m256i shuffle1 = _mm256_add_epi8(shuffle0, _mm256_set1_epi8(1));
+  shuffle1 = _mm256_sub_epi8(
+      shuffle1,
+      _mm256_and_si256(_mm256_cmpgt_epi8(shuffle1, last_byte), zc_bytes));
+  const __m256i x0 = _mm256_shuffle_epi8(data, shuffle0);
+  const __m256i x1 = _mm256_shuffle_epi8(data, shuffle1);
+
+  // Shift the remaining bits: byte i is (x0[i] >> bit_shift) |
+  // (x1[i] << (8 - bit_shift)). The 16-bit shifts move bits across bytes,
+  // which the masks remove.
+  const __m256i lo = _mm256_and_si256(
+      _mm256_srli_epi16(x0, bit_shift),
+      _mm256_set1_epi8(static_cast<char>(0xff >> bit_shift)));
+  const __m256i hi = _mm256_and_si256(
+      _mm256_slli_epi16(x1, 8 - bit_shift),
+      _mm256_set1_epi8(static_cast<char>((0xff << (8 - bit_shift)) & 0xff)));
+
+  // zero out the bytes outside zc range in each lane
+  const __m256i byte_mask = _mm256_cmpgt_epi8(zc_bytes, byte_index);
+  return _mm256_and_si256(_mm256_or_si256(lo, hi), byte_mask);
+}
+
 CYCLIC_BIT_SHIFT LdpcSelectShiftFunc(int16_t zcSize) {
   if (zcSize <= 64) {
     return CycleBitShift2to64;
@@ -175,4 +246,22 @@ CYCLIC_BIT_SHIFT LdpcSelectShiftFunc(int16_t zcSize) {
         "cyclic shifter for zc larger than 256 has not been implemented");
   }
 }
+
+size_t LdpcBatchLanes(int16_t zcSize) {
+  if (zcSize <= 64) {
+    return 4;
+  } else if (zcSize <= 128) {
+    return 2;
+  }
+  return 1;
+}
+
+CYCLIC_BIT_SHIFT LdpcSelectBatchShiftFunc(int16_t zcSize) {
+  if (zcSize <= 64) {
+    return CycleBitShift2to64Lanes;
+  } else if (zcSize <= 128) {
+    return CycleBitShift72to128Lanes;
+  }
+  return LdpcSelectShiftFunc(zcSize);
+}
 }  // namespace avx2enc
\ No newline at end of file
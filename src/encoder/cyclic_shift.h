@@ -7,6 +7,7 @@
 
 #include <immintrin.h>
 
+#include <cstddef>
 #include <stdexcept>
 
 namespace avx2enc {
@@ -16,8 +17,22 @@ inline __m256i CycleBitShift72to128(__m256i data, int16_t cyc_shift,
 inline __m256i CycleBitShift144to256(__m256i data, int16_t cyc_shift,
                                      int16_t zc);
 
+// Shift the Zc-bit segments of several code blocks at once: one per 64-bit
+// lane for Zc <= 64, and one per 128-bit lane for Zc <= 128
+inline __m256i CycleBitShift2to64Lanes(__m256i data, int16_t cyc_shift,
+                                       int16_t zc);
+inline __m256i CycleBitShift72to128Lanes(__m256i data, int16_t cyc_shift,
+                                         int16_t zc);
+
 using CYCLIC_BIT_SHIFT = __m256i (*)(__m256i, int16_t, int16_t);
 CYCLIC_BIT_SHIFT LdpcSelectShiftFunc(int16_t zcSize);
+
+/// Number of code blocks whose Zc-bit segments share one 256-bit register
+/// for the shift function of LdpcSelectBatchShiftFunc: 4, 2, or 1
+size_t LdpcBatchLanes(int16_t zcSize);
+/// Cyclic shift function that shifts the segments of LdpcBatchLanes(zcSize)
+/// code blocks in one register
+CYCLIC_BIT_SHIFT LdpcSelectBatchShiftFunc(int16_t zcSize);
 }  // namespace avx2enc
 
 #endif  // CYCLIC_SHIFT_H_
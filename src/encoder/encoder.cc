@@ -7,14 +7,18 @@
  */
 #include "encoder.h"
 
+#include <cstring>
+
 #include "common_typedef_sdk.h"
 #include "cyclic_shift.h"
 #include "iobuffer.h"
+#include "utils_ldpc.h"
 
 namespace avx2enc {
 void LdpcEncoderBg1(int8_t* pDataIn, int8_t* pDataOut,
                     const int16_t* pMatrixNumPerCol, const int16_t* pAddr,
-                    const int16_t* pShiftMatrix, int16_t zcSize, uint8_t i_LS) {
+                    const int16_t* pShiftMatrix, int16_t zcSize, uint8_t i_LS,
+                    CYCLIC_BIT_SHIFT cycle_bit_shift_p) {
   const int16_t* p_temp_addr;
   const int16_t* p_temp_matrix;
   int8_t* p_temp_in;
@@ -30,7 +34,6 @@ void LdpcEncoderBg1(int8_t* pDataIn, int8_t* pDataOut,
   __m256i x7;
   __m256i x8;
   __m256i x9;
-  CYCLIC_BIT_SHIFT cycle_bit_shift_p = LdpcSelectShiftFunc(zcSize);
 
   for (size_t j = 0; j < BG1_ROW_TOTAL; j++) {
     _mm256_storeu_si256((__m256i*)(pDataOut + j * kProcBytes),
@@ -129,7 +132,8 @@ void LdpcEncoderBg1(int8_t* pDataIn, int8_t* pDataOut,
 
 void LdpcEncoderBg2(int8_t* pDataIn, int8_t* pDataOut,
                     const int16_t* pMatrixNumPerCol, const int16_t* pAddr,
-                    const int16_t* pShiftMatrix, int16_t zcSize, uint8_t i_LS) {
+                    const int16_t* pShiftMatrix, int16_t zcSize, uint8_t i_LS,
+                    CYCLIC_BIT_SHIFT cycle_bit_shift_p) {
   const int16_t* p_temp_addr;
   const int16_t* p_temp_matrix;
   int8_t* p_temp_in;
@@ -145,7 +149,6 @@ void LdpcEncoderBg2(int8_t* pDataIn, int8_t* pDataOut,
   __m256i x7;
   __m256i x8;
   __m256i x9;
-  CYCLIC_BIT_SHIFT cycle_bit_shift_p = LdpcSelectShiftFunc(zcSize);
 
   for (size_t j = 0; j < BG2_ROW_TOTAL; j++) {
     _mm256_storeu_si256((__m256i*)(pDataOut + j * kProcBytes),
@@ -236,6 +239,21 @@ void LdpcEncoderBg2(int8_t* pDataIn, int8_t* pDataOut,
   }
 }
 
+static void SelectBaseMatrix(uint16_t bg, uint8_t i_ls,
+                             const int16_t*& p_shift_matrix,
+                             const int16_t*& p_matrix_num_per_col,
+                             const int16_t*& p_addr) {
+  if (bg == 1) {
+    p_shift_matrix = kBg1HShiftMatrix + i_ls * BG1_NONZERO_NUM;
+    p_matrix_num_per_col = kBg1MatrixNumPerCol;
+    p_addr = kBg1Address;
+  } else {
+    p_shift_matrix = kBg2HShiftMatrix + i_ls * BG2_NONZERO_NUM;
+    p_matrix_num_per_col = kBg2MatrixNumPerCol;
+    p_addr = kBg2Address;
+  }
+}
+
 int32_t BblibLdpcEncoder5gnr(
     struct bblib_ldpc_encoder_5gnr_request* request,
     struct bblib_ldpc_encoder_5gnr_response* response) {
@@ -262,38 +280,11 @@ int32_t BblibLdpcEncoder5gnr(
     parity[i] = response->output[i];
   }
 
-  // i_Ls decides the base matrix entries
-  uint8_t i_ls;
-  if ((zc % 15) == 0) {
-    i_ls = 7;
-  } else if ((zc % 13) == 0) {
-    i_ls = 6;
-  } else if ((zc % 11) == 0) {
-    i_ls = 5;
-  } else if ((zc % 9) == 0) {
-    i_ls = 4;
-  } else if ((zc % 7) == 0) {
-    i_ls = 3;
-  } else if ((zc % 5) == 0) {
-    i_ls = 2;
-  } else if ((zc % 3) == 0) {
-    i_ls = 1;
-  } else {
-    i_ls = 0;
-  }
-
+  const uint8_t i_ls = SelectBaseMatrixEntry(zc);
   const int16_t* p_shift_matrix;
   const int16_t* p_matrix_num_per_col;
   const int16_t* p_addr;
-  if (bg == 1) {
-    p_shift_matrix = kBg1HShiftMatrix + i_ls * BG1_NONZERO_NUM;
-    p_matrix_num_per_col = kBg1MatrixNumPerCol;
-    p_addr = kBg1Address;
-  } else {
-    p_shift_matrix = kBg2HShiftMatrix + i_ls * BG2_NONZERO_NUM;
-    p_matrix_num_per_col = kBg2MatrixNumPerCol;
-    p_addr = kBg2Address;
-  }
+  SelectBaseMatrix(bg, i_ls, p_shift_matrix, p_matrix_num_per_col, p_addr);
 
   __attribute__((aligned(64)))
   int8_t input_internal_buffer[BG1_COL_TOTAL * avx2enc::kProcBytes] = {0};
@@ -304,6 +295,7 @@ int32_t BblibLdpcEncoder5gnr(
       avx2enc::LdpcSelectAdapterFunc(zc);
   auto ldpc_encoder_func =
       (bg == 1 ? avx2enc::LdpcEncoderBg1 : avx2enc::LdpcEncoderBg2);
+  CYCLIC_BIT_SHIFT cycle_bit_shift_p = LdpcSelectShiftFunc(zc);
 
   for (int n = 0; n < number_codeblocks; n++) {
     // Scatter Zc-bit chunks of the input into kProcBytes-sized chunks
@@ -313,7 +305,7 @@ int32_t BblibLdpcEncoder5gnr(
     // Encode into parity_internal_buffer
     ldpc_encoder_func(input_internal_buffer, parity_internal_buffer,
                       p_matrix_num_per_col, p_addr, p_shift_matrix, (int16_t)zc,
-                      i_ls);
+                      i_ls, cycle_bit_shift_p);
 
     // Gather parity bits from kProcBytes-sized chunks of
     // parity_internal_buffer
@@ -322,4 +314,84 @@ int32_t BblibLdpcEncoder5gnr(
 
   return 0;
 }
+
+int32_t LdpcEncodeBatch(uint16_t base_graph, uint16_t zc, uint32_t num_rows,
+                        int8_t* const* inputs, int8_t* const* parities,
+                        size_t num_blocks) {
+  if (zc > ZC_MAX) {
+    std::fprintf(stderr, "Error: This AVX2 encoder supports only Zc <= %d\n",
+                 ZC_MAX);
+    throw std::runtime_error("Encoder: This AVX2 encoder supports only Zc");
+  }
+
+  const uint32_t cb_enc_len = num_rows * zc;
+  const uint32_t num_cols =
+      (base_graph == 1) ? BG1_COL_INF_NUM : BG2_COL_INF_NUM;
+  const uint32_t cb_len = zc * num_cols;
+  const uint8_t i_ls = SelectBaseMatrixEntry(zc);
+  const int16_t* p_shift_matrix;
+  const int16_t* p_matrix_num_per_col;
+  const int16_t* p_addr;
+  SelectBaseMatrix(base_graph, i_ls, p_shift_matrix, p_matrix_num_per_col,
+                   p_addr);
+
+  // Segment j of the code block in lane k of a batch is at byte k *
+  // lane_bytes of slot j of the batch buffers
+  const size_t num_lanes = LdpcBatchLanes(zc);
+  const size_t lane_bytes = kProcBytes / num_lanes;
+
+  __attribute__((aligned(64)))
+  int8_t input_internal_buffer[BG1_COL_TOTAL * avx2enc::kProcBytes] = {0};
+  __attribute__((aligned(64)))
+  int8_t parity_internal_buffer[BG1_ROW_TOTAL * avx2enc::kProcBytes] = {0};
+  __attribute__((aligned(64)))
+  int8_t batch_input_buffer[BG1_COL_TOTAL * avx2enc::kProcBytes] = {0};
+  __attribute__((aligned(64)))
+  int8_t batch_parity_buffer[BG1_ROW_TOTAL * avx2enc::kProcBytes] = {0};
+
+  // With one code block per register, the batch buffers are the per-block
+  // buffers
+  int8_t* scatter_buffer =
+      (num_lanes == 1) ? batch_input_buffer : input_internal_buffer;
+  int8_t* gather_buffer =
+      (num_lanes == 1) ? batch_parity_buffer : parity_internal_buffer;
+
+  avx2enc::LDPC_ADAPTER_P ldpc_adapter_func =
+      avx2enc::LdpcSelectAdapterFunc(zc);
+  auto ldpc_encoder_func =
+      (base_graph == 1 ? avx2enc::LdpcEncoderBg1 : avx2enc::LdpcEncoderBg2);
+  CYCLIC_BIT_SHIFT cycle_bit_shift_p = LdpcSelectBatchShiftFunc(zc);
+
+  for (size_t first = 0; first < num_blocks; first += num_lanes) {
+    const size_t batch_size = MIN(num_lanes, num_blocks - first);
+    // Interleave the Zc-bit segments of the code blocks of the batch. Lanes
+    // without a code block keep stale segments, whose parity is discarded.
+    for (size_t k = 0; k < batch_size; k++) {
+      ldpc_adapter_func(inputs[first + k], scatter_buffer, zc, cb_len, 1);
+      if (num_lanes > 1) {
+        for (size_t j = 0; j < num_cols; j++) {
+          std::memcpy(batch_input_buffer + j * kProcBytes + k * lane_bytes,
+                      input_internal_buffer + j * kProcBytes, lane_bytes);
+        }
+      }
+    }
+
+    ldpc_encoder_func(batch_input_buffer, batch_parity_buffer,
+                      p_matrix_num_per_col, p_addr, p_shift_matrix, (int16_t)zc,
+                      i_ls, cycle_bit_shift_p);
+
+    for (size_t k = 0; k < batch_size; k++) {
+      if (num_lanes > 1) {
+        for (size_t j = 0; j < num_rows; j++) {
+          std::memcpy(parity_internal_buffer + j * kProcBytes,
+                      batch_parity_buffer + j * kProcBytes + k * lane_bytes,
+                      lane_bytes);
+        }
+      }
+      ldpc_adapter_func(parities[first + k], gather_buffer, zc, cb_enc_len, 0);
+    }
+  }
+
+  return 0;
+}
 }  // namespace avx2enc
\ No newline at end of file
@@ -22,6 +22,15 @@ static constexpr size_t kZcMax = 255;
 static constexpr size_t kProcBytes = 32;
 int32_t BblibLdpcEncoder5gnr(struct bblib_ldpc_encoder_5gnr_request* request,
                              struct bblib_ldpc_encoder_5gnr_response* response);
+
+/// Encode num_blocks code blocks of the same base graph, Zc, and number of
+/// rows: the parity bits of inputs[n] go to parities[n], as from
+/// BblibLdpcEncoder5gnr. The Zc-bit segments of up to four (Zc <= 64) or two
+/// (Zc <= 128) code blocks are interleaved in each register, so that every
+/// cyclic shift and XOR of the encoder works on all of them.
+int32_t LdpcEncodeBatch(uint16_t base_graph, uint16_t zc, uint32_t num_rows,
+                        int8_t* const* inputs, int8_t* const* parities,
+                        size_t num_blocks);
 };  // namespace avx2enc
 
 // PROC_BYTES (maximum bytes processed as an LDPC chunk) is 64 bytes in
@@ -97,20 +97,24 @@ void MacThreadBaseStation::ProcessSnrReportFromPhy(EventData event) {
   server_.snr_[ue_id].push(snr);
 }
 
-void MacThreadBaseStation::SendRanConfigUpdate(EventData /*event*/) {
+void MacThreadBaseStation::SendRanConfigUpdate(const RBIndicator& ri) {
   RanConfig rc;
   rc.n_antennas_ = 0;  // TODO [arjun]: What's the correct value here?
-  rc.mod_order_bits_ = CommsLib::kQaM16;
+  rc.mod_order_bits_ = ri.mod_order_bits_;
   rc.frame_id_ = scheduler_next_frame_id_;
+  rc.ue_id_ = ri.ue_id_;
+  rc.ldpc_num_rows_ = cfg_->LdpcConfig().NumRows();
   // TODO: change n_antennas to a desired value
   // cfg_->BsAntNum() is added to fix compiler warning
   rc.n_antennas_ = cfg_->BsAntNum();
 
   EventData msg(EventType::kRANUpdate);
-  msg.num_tags_ = 3;
+  msg.num_tags_ = 5;
   msg.tags_[0] = rc.n_antennas_;
   msg.tags_[1] = rc.mod_order_bits_;
   msg.tags_[2] = rc.frame_id_;
+  msg.tags_[3] = rc.ue_id_;
+  msg.tags_[4] = rc.ldpc_num_rows_;
   RtAssert(tx_queue_->enqueue(msg),
            "MAC thread: failed to send RAN update to Agora");
 
@@ -253,12 +257,13 @@ void MacThreadBaseStation::SendControlInformation() {
   // send RAN control information UE
   RBIndicator ri;
   ri.ue_id_ = next_radio_id_;
-  ri.mod_order_bits_ = CommsLib::kQaM16;
+  ri.mod_order_bits_ = cfg_->ModOrderBits();
   udp_client_->Send(cfg_->UeServerAddr(), kMacBaseClientPort + ri.ue_id_,
                     (uint8_t*)&ri, sizeof(RBIndicator));
 
-  // update RAN config within Agora
-  SendRanConfigUpdate(EventData(EventType::kRANUpdate));
+  // update RAN config within Agora, so that the PHY uses the MCS the UE was
+  // told
+  SendRanConfigUpdate(ri);
 }
 
 void MacThreadBaseStation::ProcessUdpPacketsFromApps() {
@@ -423,7 +428,7 @@ void MacThreadBaseStation::ProcessUdpPacketsFromAppsBs(const char* payload) {
 #if ENABLE_RB_IND
   RBIndicator ri;
   ri.ue_id_ = next_radio_id_;
-  ri.mod_order_bits_ = CommsLib::kQaM16;
+  ri.mod_order_bits_ = cfg_->ModOrderBits();
 #endif
 
   if (kLogMacPackets) {
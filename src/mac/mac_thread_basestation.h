@@ -65,8 +65,9 @@ class MacThreadBaseStation {
   // TODO: process CQI report here as well.
   void ProcessSnrReportFromPhy(EventData event);
 
-  // Push RAN config update to PHY master thread.
-  void SendRanConfigUpdate(EventData event);
+  // Push RAN config update to PHY master thread, which applies the MCS of
+  // [ri] to its UE.
+  void SendRanConfigUpdate(const RBIndicator& ri);
 
   // Send control information over (out-of-band) control channel
   // from server to client
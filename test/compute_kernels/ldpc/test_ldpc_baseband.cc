@@ -35,6 +35,10 @@ DEFINE_string(profile, "random",
 DEFINE_string(conf_file,
               TOSTRING(PROJECT_DIRECTORY) "/data/tddconfig-sim-ul.json",
               "Agora config filename");
+DEFINE_string(beamformer, "zf",
+              "The uplink detector (i.e., 'zf', 'mmse', or 'rzf')");
+DEFINE_bool(llr_scaling, false,
+            "Scale the LLRs of each user by its post-equalization SNR");
 
 int main(int argc, char* argv[]) {
   unsigned seed = std::chrono::system_clock::now().time_since_epoch().count();
@@ -44,6 +48,9 @@ int main(int argc, char* argv[]) {
   const std::string cur_directory = TOSTRING(PROJECT_DIRECTORY);
   gflags::ParseCommandLineFlags(&argc, &argv, true);
   auto cfg = std::make_unique<Config>(FLAGS_conf_file.c_str());
+  RtAssert(FLAGS_beamformer == "zf" || FLAGS_beamformer == "mmse" ||
+               FLAGS_beamformer == "rzf",
+           "Unknown beamformer " + FLAGS_beamformer);
 
   const DataGenerator::Profile profile =
       FLAGS_profile == "123" ? DataGenerator::Profile::kProfile123
@@ -259,7 +266,44 @@ int main(int argc, char* argv[]) {
           cfg->BsAntNum(), cfg->UeAntNum(), false);
       arma::cx_fmat mat_output(reinterpret_cast<arma::cx_float*>(precoder[i]),
                                cfg->UeAntNum(), cfg->BsAntNum(), false);
-      pinv(mat_output, mat_input, 1e-2, "dc");
+      if (FLAGS_beamformer == "zf") {
+        pinv(mat_output, mat_input, 1e-2, "dc");
+      } else {
+        // Variance of the complex noise added to each CSI entry
+        float noise_var = 2 * kNoiseLevels[noise_id] * kNoiseLevels[noise_id];
+        if (FLAGS_beamformer == "rzf") {
+          noise_var *= cfg->UeAntNum();
+        }
+        mat_output = arma::inv_sympd(mat_input.t() * mat_input +
+                                     noise_var * arma::eye<arma::cx_fmat>(
+                                                     cfg->UeAntNum(),
+                                                     cfg->UeAntNum())) *
+                     mat_input.t();
+      }
+    }
+
+    // The CSI noise added to the data channel reaches each antenna through
+    // all users, so user u is detected with noise variance
+    // UeAntNum() * noise_var * |w_u|^2
+    std::vector<float> llr_scales(cfg->UeAntNum(), 1.0f);
+    if (FLAGS_llr_scaling) {
+      const float noise_var = 2 * kNoiseLevels[noise_id] *
+                              kNoiseLevels[noise_id] * cfg->UeAntNum();
+      for (size_t ue_id = 0; ue_id < cfg->UeAntNum(); ue_id++) {
+        float w_norm2 = 0;
+        for (size_t j = 0; j < cfg->OfdmDataNum(); j++) {
+          const complex_float* w =
+              precoder[cfg->FreqOrthogonalPilot() ? (j % cfg->UeAntNum())
+                                                  : j];
+          for (size_t ant = 0; ant < cfg->BsAntNum(); ant++) {
+            const complex_float& w_ant = w[ant * cfg->UeAntNum() + ue_id];
+            w_norm2 += w_ant.re * w_ant.re + w_ant.im * w_ant.im;
+          }
+        }
+        w_norm2 /= cfg->OfdmDataNum();
+        llr_scales.at(ue_id) = SoftDemodLlrScale(cfg->ModOrderBits(),
+                                                 1.0f / (noise_var * w_norm2));
+      }
     }
 
     Table<complex_float> equalized_data_all_symbols;
@@ -303,10 +347,16 @@ int main(int argc, char* argv[]) {
                      j * cfg->OfdmDataNum());
         switch (cfg->ModOrderBits()) {
           case (4):
-            Demod16qamSoftAvx2(equal_t_ptr, demod_ptr, cfg->OfdmDataNum());
+            Demod16qamSoftAvx2(equal_t_ptr, demod_ptr, cfg->OfdmDataNum(),
+                               llr_scales.at(j));
             break;
           case (6):
-            Demod64qamSoftAvx2(equal_t_ptr, demod_ptr, cfg->OfdmDataNum());
+            Demod64qamSoftAvx2(equal_t_ptr, demod_ptr, cfg->OfdmDataNum(),
+                               llr_scales.at(j));
+            break;
+          case (8):
+            Demod256qamSoftAvx2(equal_t_ptr, demod_ptr, cfg->OfdmDataNum(),
+                                llr_scales.at(j));
             break;
           default:
             std::printf("Demodulation: modulation type %s not supported!\n",
@@ -339,6 +389,7 @@ int main(int argc, char* argv[]) {
     decoded_codewords.Calloc(num_codeblocks, cfg->OfdmDataNum(),
                              Agora_memory::Alignment_t::kAlign64);
     double freq_ghz = GetTime::MeasureRdtscFreq();
+    size_t total_iterations = 0;
     size_t start_tsc = GetTime::WorkerRdtsc();
     for (size_t i = 0; i < cfg->UeAntNum(); i++) {
       for (size_t j = 0; j < num_cbs_per_ue; j++) {
@@ -349,6 +400,7 @@ int main(int argc, char* argv[]) {
             decoded_codewords[i * num_cbs_per_ue + j];
         bblib_ldpc_decoder_5gnr(&ldpc_decoder_5gnr_request,
                                 &ldpc_decoder_5gnr_response);
+        total_iterations += ldpc_decoder_5gnr_response.iterationAtTermination;
       }
     }
 
@@ -386,12 +438,15 @@ int main(int argc, char* argv[]) {
     }
 
     std::printf(
-        "Noise: %.3f, snr: %.1f dB, error rate: %zu/%zu = %.6f, block "
-        "error: "
-        "%zu/%zu = %.6f\n",
+        "Beamformer: %s, LLR scaling: %s, noise: %.3f, snr: %.1f dB, error "
+        "rate: %zu/%zu = %.6f, block error: %zu/%zu = %.6f, decoder "
+        "iterations: %.2f, decode time: %.2f us per block\n",
+        FLAGS_beamformer.c_str(), FLAGS_llr_scaling ? "on" : "off",
         kNoiseLevels[noise_id], kSnrLevels[noise_id], error_num, total,
         1.f * error_num / total, block_error_num, num_codeblocks,
-        1.f * block_error_num / num_codeblocks);
+        1.f * block_error_num / num_codeblocks,
+        1.f * total_iterations / num_codeblocks,
+        GetTime::CyclesToUs(duration, freq_ghz) / num_codeblocks);
 
     std::free(resp_var_nodes);
     demod_data_all_symbols.Free();
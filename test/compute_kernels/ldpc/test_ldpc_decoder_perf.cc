@@ -0,0 +1,204 @@
+/**
+ * @file test_ldpc_decoder_perf.cc
+ *
+ * @brief Throughput and BLER-vs-SNR comparison of FlexRAN's LDPC decoder and
+ * Agora's layered offset-min-sum LdpcDecoder (AVX2 and, if compiled in,
+ * AVX-512 kernels), decoding one code block per call or a batch of code
+ * blocks per call with DecodeBatch. All decoders get the same LLRs of the
+ * same code blocks: BPSK over AWGN, with the two fractional bits of Agora's
+ * scaled soft demappers. Throughput is information bits per second of
+ * decoding on one core.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "encoder.h"
+#include "gettime.h"
+#include "ldpc_decoder.h"
+#include "memory_manage.h"
+#include "phy_ldpc_decoder_5gnr.h"
+#include "symbols.h"
+#include "utils_ldpc.h"
+
+static constexpr size_t kNumCodeBlocks = 100;
+static constexpr size_t kMaxDecoderIters = 10;
+static constexpr bool kEnableEarlyTermination = true;
+static constexpr float kLlrScale = 4.0f;  // Two fractional bits
+static constexpr size_t kVarNodesSize = 1024 * 1024;
+
+// Base graph, expansion factor, and number of rows of the tested codes
+static const std::vector<std::vector<size_t>> kCodes = {
+    {1, 32, 46}, {1, 64, 46}, {1, 384, 46}, {1, 208, 46}, {2, 104, 42}};
+static const std::vector<float> kEbN0Db = {0.0, 0.5, 1.0, 1.5, 2.0, 2.5};
+
+enum class Decoder {
+  kFlexRan,
+  kAgoraAvx2,
+  kAgoraAvx512,
+  kAgoraAvx2Batch,
+  kAgoraAvx512Batch
+};
+
+struct DecoderStats {
+  size_t block_errors_ = 0;
+  size_t iterations_ = 0;
+  size_t cycles_ = 0;
+};
+
+int main() {
+  double freq_ghz = GetTime::MeasureRdtscFreq();
+  std::printf("Spinning for one second for Turbo Boost\n");
+  GetTime::NanoSleep(1000 * 1000 * 1000, freq_ghz);
+
+  std::vector<Decoder> decoders = {Decoder::kFlexRan, Decoder::kAgoraAvx2,
+                                   Decoder::kAgoraAvx2Batch};
+  if (LdpcDecoder::kAvx512Available) {
+    decoders.push_back(Decoder::kAgoraAvx512);
+    decoders.push_back(Decoder::kAgoraAvx512Batch);
+  }
+  LdpcDecoder agora_avx2(LdpcDecoder::Isa::kAvx2);
+  std::unique_ptr<LdpcDecoder> agora_avx512;
+  if (LdpcDecoder::kAvx512Available) {
+    agora_avx512 = std::make_unique<LdpcDecoder>(LdpcDecoder::Isa::kAvx512);
+  }
+  auto* var_nodes = static_cast<int16_t*>(Agora_memory::PaddedAlignedAlloc(
+      Agora_memory::Alignment_t::kAlign64, kVarNodesSize * sizeof(int16_t)));
+
+  std::mt19937 gen(0);
+  std::printf(
+      "Columns: FlexRAN, Agora AVX2, Agora AVX2 batched%s. Max %zu "
+      "iterations, early termination %d\n",
+      LdpcDecoder::kAvx512Available
+          ? ", Agora AVX-512, Agora AVX-512 batched"
+          : "",
+      kMaxDecoderIters, kEnableEarlyTermination);
+  for (const auto& code : kCodes) {
+    const size_t base_graph = code.at(0);
+    const size_t zc = code.at(1);
+    const size_t num_rows = code.at(2);
+    if (zc < LdpcGetMinZc() || zc > LdpcGetMaxZc()) {
+      std::fprintf(stderr, "Zc value %zu not supported. Skipping.\n", zc);
+      continue;
+    }
+    const size_t num_info_bits = LdpcNumInputBits(base_graph, zc);
+    const size_t num_encoded_bits =
+        LdpcNumEncodedBits(base_graph, zc, num_rows);
+    const float rate = static_cast<float>(num_info_bits) / num_encoded_bits;
+
+    std::vector<std::vector<int8_t>> inputs(
+        kNumCodeBlocks,
+        std::vector<int8_t>(LdpcEncodingInputBufSize(base_graph, zc)));
+    std::vector<int8_t> parity(LdpcEncodingParityBufSize(base_graph, zc));
+    std::vector<int8_t> encoded(LdpcEncodingEncodedBufSize(base_graph, zc));
+    auto* llrs = static_cast<int8_t*>(Agora_memory::PaddedAlignedAlloc(
+        Agora_memory::Alignment_t::kAlign64,
+        kNumCodeBlocks * num_encoded_bits));
+    std::vector<std::vector<uint8_t>> decoded(
+        kNumCodeBlocks,
+        std::vector<uint8_t>(BitsToBytes(num_info_bits) + kMaxProcBytes));
+
+    for (const float eb_n0_db : kEbN0Db) {
+      const float noise_var =
+          1.0f / (2 * rate * std::pow(10.0f, eb_n0_db / 10));
+      std::normal_distribution<float> noise(0.0, std::sqrt(noise_var));
+      std::vector<DecoderStats> stats(decoders.size());
+
+      for (size_t n = 0; n < kNumCodeBlocks; n++) {
+        for (size_t i = 0; i < BitsToBytes(num_info_bits); i++) {
+          inputs[n][i] = static_cast<int8_t>(gen());
+        }
+        LdpcEncodeHelper(base_graph, zc, num_rows, encoded.data(),
+                         parity.data(), inputs[n].data());
+        for (size_t i = 0; i < num_encoded_bits; i++) {
+          const int bit = (encoded[i / 8] >> (i % 8)) & 1;
+          const float y = (bit == 1 ? -1.0f : 1.0f) + noise(gen);
+          const float llr = std::round(kLlrScale * 2 * y / noise_var);
+          llrs[n * num_encoded_bits + i] = static_cast<int8_t>(
+              std::max(-127.0f, std::min(127.0f, llr)));
+        }
+      }
+
+      for (size_t d = 0; d < decoders.size(); d++) {
+        std::vector<bblib_ldpc_decoder_5gnr_request> requests(kNumCodeBlocks);
+        std::vector<bblib_ldpc_decoder_5gnr_response> responses(
+            kNumCodeBlocks);
+        for (size_t n = 0; n < kNumCodeBlocks; n++) {
+          requests[n] = {};
+          requests[n].varNodes = llrs + n * num_encoded_bits;
+          requests[n].numChannelLlrs = num_encoded_bits;
+          requests[n].numFillerBits = 0;
+          requests[n].maxIterations = kMaxDecoderIters;
+          requests[n].enableEarlyTermination = kEnableEarlyTermination;
+          requests[n].Zc = zc;
+          requests[n].baseGraph = base_graph;
+          requests[n].nRows = num_rows;
+          responses[n] = {};
+          responses[n].numMsgBits = num_info_bits;
+          responses[n].varNodes = var_nodes;
+          responses[n].compactedMessageBytes = decoded[n].data();
+        }
+
+        const size_t start_tsc = GetTime::Rdtsc();
+        for (size_t n = 0; n < kNumCodeBlocks; n++) {
+          switch (decoders[d]) {
+            case Decoder::kFlexRan:
+              bblib_ldpc_decoder_5gnr(&requests[n], &responses[n]);
+              break;
+            case Decoder::kAgoraAvx2:
+              agora_avx2.Decode(&requests[n], &responses[n]);
+              break;
+            case Decoder::kAgoraAvx512:
+              agora_avx512->Decode(&requests[n], &responses[n]);
+              break;
+            case Decoder::kAgoraAvx2Batch:
+            case Decoder::kAgoraAvx512Batch: {
+              LdpcDecoder& decoder = (decoders[d] == Decoder::kAgoraAvx2Batch)
+                                         ? agora_avx2
+                                         : *agora_avx512;
+              const size_t num_blocks =
+                  std::min(decoder.BatchSize(), kNumCodeBlocks - n);
+              decoder.DecodeBatch(&requests[n], &responses[n], num_blocks);
+              n += num_blocks - 1;
+            } break;
+          }
+        }
+        stats[d].cycles_ += GetTime::Rdtsc() - start_tsc;
+
+        for (size_t n = 0; n < kNumCodeBlocks; n++) {
+          stats[d].iterations_ += responses[n].iterationAtTermination;
+          for (size_t i = 0; i < num_info_bits; i++) {
+            if (((decoded[n][i / 8] ^ static_cast<uint8_t>(inputs[n][i / 8])) >>
+                 (i % 8)) &
+                1) {
+              stats[d].block_errors_++;
+              break;
+            }
+          }
+        }
+      }
+
+      std::printf("BG %zu, Zc %zu, rate %.3f, Eb/N0 %.1f dB: BLER {",
+                  base_graph, zc, rate, eb_n0_db);
+      for (const auto& s : stats) {
+        std::printf(" %.3f", s.block_errors_ * 1.0 / kNumCodeBlocks);
+      }
+      std::printf(" }, Mbps per core {");
+      for (const auto& s : stats) {
+        std::printf(" %.1f", num_info_bits * kNumCodeBlocks /
+                                 GetTime::CyclesToUs(s.cycles_, freq_ghz));
+      }
+      std::printf(" }, avg iterations {");
+      for (const auto& s : stats) {
+        std::printf(" %.2f", s.iterations_ * 1.0 / kNumCodeBlocks);
+      }
+      std::printf(" }\n");
+    }
+    std::free(llrs);
+  }
+  std::free(var_nodes);
+  return 0;
+}
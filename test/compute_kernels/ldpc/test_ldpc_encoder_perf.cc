@@ -0,0 +1,97 @@
+/**
+ * @file test_ldpc_encoder_perf.cc
+ *
+ * @brief Throughput of Agora's AVX2 LDPC encoder, encoding one code block per
+ * call with avx2enc::BblibLdpcEncoder5gnr or a batch of code blocks per call
+ * with avx2enc::LdpcEncodeBatch, for base graphs 1 and 2. Throughput is
+ * information bits per second of encoding on one core. The parity bits of the
+ * two paths are compared.
+ */
+
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "encoder.h"
+#include "gettime.h"
+#include "symbols.h"
+#include "utils_ldpc.h"
+
+static constexpr size_t kNumCodeBlocks = 7;  // One encode event of kMaxTags
+static constexpr size_t kNumIterations = 2000;
+static const std::vector<size_t> kZcs = {16, 32, 64, 104, 128, 208, 240};
+
+int main() {
+  double freq_ghz = GetTime::MeasureRdtscFreq();
+  std::printf("Spinning for one second for Turbo Boost\n");
+  GetTime::NanoSleep(1000 * 1000 * 1000, freq_ghz);
+
+  std::mt19937 gen(0);
+  std::printf("Columns: one code block per call, %zu code blocks per call\n",
+              kNumCodeBlocks);
+  for (const size_t base_graph : {1, 2}) {
+    const size_t num_rows = LdpcMaxNumRows(base_graph);
+    for (const size_t zc : kZcs) {
+      if (zc > avx2enc::kZcMax) {
+        std::fprintf(stderr, "Zc value %zu not supported. Skipping.\n", zc);
+        continue;
+      }
+      const size_t num_info_bits = LdpcNumInputBits(base_graph, zc);
+      std::vector<std::vector<int8_t>> inputs(
+          kNumCodeBlocks,
+          std::vector<int8_t>(LdpcEncodingInputBufSize(base_graph, zc)));
+      std::vector<std::vector<int8_t>> parity(
+          kNumCodeBlocks,
+          std::vector<int8_t>(LdpcEncodingParityBufSize(base_graph, zc)));
+      std::vector<std::vector<int8_t>> batch_parity = parity;
+      std::vector<int8_t*> input_ptrs(kNumCodeBlocks);
+      std::vector<int8_t*> batch_parity_ptrs(kNumCodeBlocks);
+      for (size_t n = 0; n < kNumCodeBlocks; n++) {
+        for (size_t i = 0; i < BitsToBytes(num_info_bits); i++) {
+          inputs[n][i] = static_cast<int8_t>(gen());
+        }
+        input_ptrs[n] = inputs[n].data();
+        batch_parity_ptrs[n] = batch_parity[n].data();
+      }
+
+      size_t start_tsc = GetTime::Rdtsc();
+      for (size_t iter = 0; iter < kNumIterations; iter++) {
+        for (size_t n = 0; n < kNumCodeBlocks; n++) {
+          bblib_ldpc_encoder_5gnr_request req = {};
+          bblib_ldpc_encoder_5gnr_response resp = {};
+          req.baseGraph = base_graph;
+          req.Zc = zc;
+          req.nRows = num_rows;
+          req.numberCodeblocks = 1;
+          req.input[0] = inputs[n].data();
+          resp.output[0] = parity[n].data();
+          avx2enc::BblibLdpcEncoder5gnr(&req, &resp);
+        }
+      }
+      const double single_us =
+          GetTime::CyclesToUs(GetTime::Rdtsc() - start_tsc, freq_ghz);
+
+      start_tsc = GetTime::Rdtsc();
+      for (size_t iter = 0; iter < kNumIterations; iter++) {
+        avx2enc::LdpcEncodeBatch(base_graph, zc, num_rows, input_ptrs.data(),
+                                 batch_parity_ptrs.data(), kNumCodeBlocks);
+      }
+      const double batch_us =
+          GetTime::CyclesToUs(GetTime::Rdtsc() - start_tsc, freq_ghz);
+
+      size_t mismatches = 0;
+      for (size_t n = 0; n < kNumCodeBlocks; n++) {
+        mismatches += std::memcmp(parity[n].data(), batch_parity[n].data(),
+                                  BitsToBytes(num_rows * zc)) != 0;
+      }
+      const double num_bits =
+          static_cast<double>(num_info_bits) * kNumCodeBlocks * kNumIterations;
+      std::printf(
+          "BG %zu, Zc %zu: Gbps per core {%.2f, %.2f}, speedup %.2fx, %zu "
+          "code blocks with different parity\n",
+          base_graph, zc, num_bits / (single_us * 1000),
+          num_bits / (batch_us * 1000), single_us / batch_us, mismatches);
+    }
+  }
+  return 0;
+}
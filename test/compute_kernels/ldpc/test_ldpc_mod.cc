@@ -158,6 +158,10 @@ int main(int argc, char* argv[]) {
           Demod64qamSoftAvx2((float*)modulated_codewords[i],
                              demod_data_all_symbols[i], cfg->OfdmDataNum());
           break;
+        case (8):
+          Demod256qamSoftAvx2((float*)modulated_codewords[i],
+                              demod_data_all_symbols[i], cfg->OfdmDataNum());
+          break;
         default:
           std::printf("Demodulation: modulation type %s not supported!\n",
                       cfg->Modulation().c_str());
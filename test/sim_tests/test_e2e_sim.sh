@@ -4,10 +4,18 @@
 #  * This script must be run from Agora's top-level directory.
 #  * If a number is passed to the script, it is used as Pass/Fail threshold.
 #  * Otherwise, the default 0.005 shall be used as Pass/Fail threshold.
+#  * If a config file is passed as the second argument, it is used instead of
+#    data/chsim.json, e.g., "test_e2e_sim.sh 0.005 data/chsim-256qam.json"
+#    runs the test with 256QAM.
 ###############################################################################
 
+CONF_FILE=$2
+if [ "$CONF_FILE" == "" ]; then
+  CONF_FILE=data/chsim.json
+fi
+
 # Check that all required executables are present
-exe_list="build/user build/data_generator build/chsim build/agora data/chsim.json"
+exe_list="build/user build/data_generator build/chsim build/agora ${CONF_FILE}"
 for exe in ${exe_list}; do
   if [ ! -f ${exe} ]; then
       echo "${exe} not found. Exiting."
@@ -17,7 +25,7 @@ done
 
 
 # Setup the config with the number of frames to test
-cp data/chsim.json data/chsim-tmp.json
+cp ${CONF_FILE} data/chsim-tmp.json
 sed -i '2i\ \ "max_frame": 1000,' data/chsim-tmp.json
 
 echo "==========================================="
@@ -48,6 +56,7 @@ sleep 1
 grep ".*bit errors (BER).*" test_user_output.txt > test_output.txt
 grep ".*bit errors (BER).*" test_agora_output.txt >> test_output.txt
 grep ".*bit errors (BER).*" test_output.txt
+grep "Max Mac data tp" test_agora_output.txt
 echo "=================================================="
 
 
@@ -0,0 +1,40 @@
+/**
+ * @file ldpc_test_utils.h
+ * @brief Encoded LDPC code blocks shared by the decoder and HARQ unit tests
+ */
+#ifndef LDPC_TEST_UTILS_H_
+#define LDPC_TEST_UTILS_H_
+
+#include <random>
+#include <vector>
+
+#include "utils_ldpc.h"
+
+// Encoded code block of random information bits, with the last
+// num_filler_bits information bits zero
+struct CodeBlock {
+  CodeBlock(size_t base_graph, size_t zc, size_t num_rows,
+            size_t num_filler_bits, std::mt19937& gen)
+      : input(LdpcEncodingInputBufSize(base_graph, zc)),
+        encoded(LdpcEncodingEncodedBufSize(base_graph, zc)) {
+    const size_t num_info_bits = LdpcNumInputBits(base_graph, zc);
+    for (size_t i = 0; i < BitsToBytes(num_info_bits); i++) {
+      input.at(i) = static_cast<int8_t>(gen());
+    }
+    for (size_t i = num_info_bits - num_filler_bits; i < num_info_bits; i++) {
+      input.at(i / 8) &= ~(1 << (i % 8));
+    }
+    std::vector<int8_t> parity(LdpcEncodingParityBufSize(base_graph, zc));
+    LdpcEncodeHelper(base_graph, zc, num_rows, encoded.data(), parity.data(),
+                     input.data());
+  }
+
+  // Bit i of the code block after the punctured bits, i.e., of the circular
+  // buffer of rate matching
+  int Bit(size_t i) const { return (encoded.at(i / 8) >> (i % 8)) & 1; }
+
+  std::vector<int8_t> input;
+  std::vector<int8_t> encoded;
+};
+
+#endif  // LDPC_TEST_UTILS_H_
@@ -48,7 +48,8 @@ static void ApplyAwgn(complex_float *signal, complex_float *output, int len,
  * @param demod_func: Function to use for demodulation
  * @param func_desc: string describing function
  */
-static void Run256QamSoftDemod(void (*demod_func)(const float *, int8_t *, int),
+static void Run256QamSoftDemod(void (*demod_func)(const float *, int8_t *, int,
+                                                  float),
                                const char *func_desc) {
   uint8_t *input_symbols;
   uint8_t *output_symbols;
@@ -97,15 +98,15 @@ static void Run256QamSoftDemod(void (*demod_func)(const float *, int8_t *, int),
       ApplyAwgn(channel_input, channel_output, num, snr);
       // Demodulate Symbols
       start_time = GetTime::GetTimeUs();
-      demod_func((float *)channel_output, output_demod, num);
+      demod_func((float *)channel_output, output_demod, num, 1.0f);
       runtime += (GetTime::GetTimeUs() - start_time);
       // Decode Symbols
       for (j = 0; j < num * 8; j++) {
         /*
-         * If llr value is negative, bit will be zero.
-         * If it is positive, bit will be 1
+         * If llr value is positive, bit will be zero.
+         * If it is negative, bit will be 1
          */
-        if (output_demod[j] > 0) {
+        if (output_demod[j] < 0) {
           output_symbols[j / 8] |= 0x1 << shift_offset;
         } else {
           output_symbols[j / 8] &= ~(0x1 << shift_offset);
@@ -199,17 +200,24 @@ TEST(TestDemod256QAM, VerifyCorrectness) {
   for (i = 0; i < num; i++) {
     channel_input[i] = ModSingle(input_symbols[i], mod_table);
   }
-  // Generate ground truth
-  Demod256qamSoftSse((float *)channel_input, output_demod_truth, num);
-  // Test AVX2 implementation
-  Demod256qamSoftAvx2((float *)channel_input, output_demod_check, num);
-  ASSERT_EQ(memcmp(output_demod_check, output_demod_truth, num * 8), 0);
+  // Check the LLRs scaled by the supported range of LLR scales
+  for (float llr_scale : {1.0f, kMinSoftDemodLlrScale, 0.3f, 1.5f,
+                          kMaxSoftDemodLlrScale}) {
+    // Generate ground truth
+    Demod256qamSoftSse((float *)channel_input, output_demod_truth, num,
+                       llr_scale);
+    // Test AVX2 implementation
+    Demod256qamSoftAvx2((float *)channel_input, output_demod_check, num,
+                        llr_scale);
+    ASSERT_EQ(memcmp(output_demod_check, output_demod_truth, num * 8), 0);
 
 #ifdef __AVX512F__
-  // Test AVX512 implementation
-  Demod256qamSoftAvx512((float *)channel_input, output_demod_check, num);
-  ASSERT_EQ(memcmp(output_demod_check, output_demod_truth, num * 8), 0);
+    // Test AVX512 implementation
+    Demod256qamSoftAvx512((float *)channel_input, output_demod_check, num,
+                          llr_scale);
+    ASSERT_EQ(memcmp(output_demod_check, output_demod_truth, num * 8), 0);
 #endif
+  }
 }
 
 int main(int argc, char **argv) {
@@ -0,0 +1,138 @@
+#include <gtest/gtest.h>
+
+#include <complex>
+#include <random>
+#include <vector>
+
+#include "batched_zf.h"
+
+using cx = std::complex<float>;
+
+// Fill the engine with random channels and return them, indexed as
+// [subcarrier][ant * ue_ant_num + ue]
+static std::vector<std::vector<cx>> RandomCsi(BatchedZf& zf, size_t sc_num,
+                                              size_t bs_ant_num,
+                                              size_t ue_ant_num) {
+  std::mt19937 gen(1);
+  std::normal_distribution<float> dist(0.0, 1.0);
+  std::vector<std::vector<cx>> csi(sc_num,
+                                   std::vector<cx>(bs_ant_num * ue_ant_num));
+  for (size_t sc = 0; sc < sc_num; sc++) {
+    for (size_t ant = 0; ant < bs_ant_num; ant++) {
+      for (size_t ue = 0; ue < ue_ant_num; ue++) {
+        const cx val(dist(gen), dist(gen));
+        csi.at(sc).at(ant * ue_ant_num + ue) = val;
+        zf.SetCsi(sc, ant, ue, {val.real(), val.imag()});
+      }
+    }
+  }
+  return csi;
+}
+
+// Largest deviation of W * H from the identity matrix
+static float ZfError(const BatchedZf& zf, size_t sc,
+                     const std::vector<cx>& csi, size_t bs_ant_num,
+                     size_t ue_ant_num) {
+  std::vector<complex_float> mat_zf(bs_ant_num * ue_ant_num);
+  zf.GetZf(sc, mat_zf.data());
+  float max_err = 0;
+  for (size_t i = 0; i < ue_ant_num; i++) {
+    for (size_t j = 0; j < ue_ant_num; j++) {
+      cx sum = 0;
+      for (size_t b = 0; b < bs_ant_num; b++) {
+        const complex_float w = mat_zf.at(b * ue_ant_num + i);
+        sum += cx(w.re, w.im) * csi.at(b * ue_ant_num + j);
+      }
+      max_err = std::max(max_err, std::abs(sum - cx(i == j ? 1 : 0, 0)));
+    }
+  }
+  return max_err;
+}
+
+// The detectors invert the channel, W * H = I
+TEST(TestBatchedZf, Inverse) {
+  const std::vector<std::pair<size_t, size_t>> sizes = {
+      {8, 8}, {16, 4}, {64, 16}};
+  const size_t sc_num = BatchedZf::kLanes * 2 + 3;
+  for (const auto& [bs_ant_num, ue_ant_num] : sizes) {
+    BatchedZf zf(bs_ant_num, ue_ant_num, sc_num);
+    auto csi = RandomCsi(zf, sc_num, bs_ant_num, ue_ant_num);
+    ASSERT_EQ(zf.Compute(sc_num), 0);
+    for (size_t sc = 0; sc < sc_num; sc++) {
+      ASSERT_FALSE(zf.Failed(sc));
+      ASSERT_LT(ZfError(zf, sc, csi.at(sc), bs_ant_num, ue_ant_num), 2e-3);
+      ASSERT_GT(zf.Rcond(sc), 0.0f);
+      ASSERT_LE(zf.Rcond(sc), 1.0f);
+    }
+  }
+}
+
+// Rank-deficient channels are reported without affecting other subcarriers
+TEST(TestBatchedZf, RankDeficient) {
+  const size_t bs_ant_num = 16;
+  const size_t ue_ant_num = 4;
+  const size_t sc_num = BatchedZf::kLanes;
+  const size_t bad_sc = 3;
+  BatchedZf zf(bs_ant_num, ue_ant_num, sc_num);
+  auto csi = RandomCsi(zf, sc_num, bs_ant_num, ue_ant_num);
+  for (size_t ant = 0; ant < bs_ant_num; ant++) {
+    const cx val = csi.at(bad_sc).at(ant * ue_ant_num);
+    zf.SetCsi(bad_sc, ant, 1, {val.real(), val.imag()});
+  }
+
+  ASSERT_EQ(zf.Compute(sc_num), 1);
+  for (size_t sc = 0; sc < sc_num; sc++) {
+    ASSERT_EQ(zf.Failed(sc), sc == bad_sc);
+    if (sc != bad_sc) {
+      ASSERT_LT(ZfError(zf, sc, csi.at(sc), bs_ant_num, ue_ant_num), 2e-3);
+    }
+  }
+}
+
+// With regularization r, the detectors solve (H' * H + r * I) * W = H'
+TEST(TestBatchedZf, Regularized) {
+  const size_t bs_ant_num = 16;
+  const size_t ue_ant_num = 4;
+  const size_t sc_num = BatchedZf::kLanes + 1;
+  const float regularization = 0.1;
+  BatchedZf zf(bs_ant_num, ue_ant_num, sc_num);
+  auto csi = RandomCsi(zf, sc_num, bs_ant_num, ue_ant_num);
+  ASSERT_EQ(zf.Compute(sc_num, regularization), 0);
+
+  for (size_t sc = 0; sc < sc_num; sc++) {
+    const std::vector<cx>& h = csi.at(sc);
+    std::vector<complex_float> mat_zf(bs_ant_num * ue_ant_num);
+    zf.GetZf(sc, mat_zf.data());
+
+    std::vector<cx> gram(ue_ant_num * ue_ant_num, 0);
+    float trace = 0;
+    for (size_t i = 0; i < ue_ant_num; i++) {
+      for (size_t j = 0; j < ue_ant_num; j++) {
+        for (size_t b = 0; b < bs_ant_num; b++) {
+          gram.at(i * ue_ant_num + j) += std::conj(h.at(b * ue_ant_num + i)) *
+                                         h.at(b * ue_ant_num + j);
+        }
+      }
+      trace += gram.at(i * ue_ant_num + i).real();
+    }
+    for (size_t i = 0; i < ue_ant_num; i++) {
+      gram.at(i * ue_ant_num + i) += regularization * trace / ue_ant_num;
+    }
+
+    for (size_t i = 0; i < ue_ant_num; i++) {
+      for (size_t b = 0; b < bs_ant_num; b++) {
+        cx sum = 0;
+        for (size_t k = 0; k < ue_ant_num; k++) {
+          const complex_float w = mat_zf.at(b * ue_ant_num + k);
+          sum += gram.at(i * ue_ant_num + k) * cx(w.re, w.im);
+        }
+        ASSERT_LT(std::abs(sum - std::conj(h.at(b * ue_ant_num + i))), 2e-3);
+      }
+    }
+  }
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,58 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <limits>
+
+#include "decoder_iter_policy.h"
+
+static constexpr size_t kMinIter = 2;
+static constexpr size_t kMaxIter = 20;
+
+// With time to spare, low margins get the minimum cap, high margins half of
+// the maximum, and margins in between or unknown get the maximum
+TEST(TestDecoderIterPolicy, SnrMargin) {
+  const DecoderIterPolicy policy(kMinIter, kMaxIter);
+  const float unknown = std::numeric_limits<float>::quiet_NaN();
+  ASSERT_EQ(policy.Cap(-3.0f, 1.0), kMinIter);
+  ASSERT_EQ(policy.Cap(3.0f, 1.0), kMaxIter);
+  ASSERT_EQ(policy.Cap(unknown, 1.0), kMaxIter);
+  ASSERT_EQ(policy.Cap(10.0f, 1.0), (kMaxIter + 1) / 2);
+
+  // Half of the maximum is never below the minimum
+  const DecoderIterPolicy narrow(8, 10);
+  ASSERT_EQ(narrow.Cap(10.0f, 1.0), 8);
+}
+
+// Near the deadline, caps drop linearly to the minimum, and late frames get
+// the minimum
+TEST(TestDecoderIterPolicy, Slack) {
+  const DecoderIterPolicy policy(kMinIter, kMaxIter);
+  const double relaxed = DecoderIterPolicy::kRelaxedSlack;
+  ASSERT_EQ(policy.Cap(3.0f, relaxed), kMaxIter);
+  ASSERT_EQ(policy.Cap(3.0f, relaxed / 2),
+            kMinIter + (kMaxIter - kMinIter) / 2);
+  ASSERT_EQ(policy.Cap(3.0f, 0.0), kMinIter);
+  ASSERT_EQ(policy.Cap(3.0f, -0.5), kMinIter);
+
+  size_t prev_cap = kMinIter;
+  for (double slack = 0.0; slack <= relaxed; slack += relaxed / 16) {
+    const size_t cap = policy.Cap(3.0f, slack);
+    ASSERT_GE(cap, prev_cap);
+    ASSERT_LE(cap, kMaxIter);
+    prev_cap = cap;
+  }
+}
+
+// The margin is 0 dB at the Shannon limit, and NaN if the SNR is unknown
+TEST(TestDecoderIterPolicy, SnrMarginDb) {
+  // 2 bits per symbol need an SNR of 3
+  ASSERT_NEAR(DecoderIterPolicy::SnrMarginDb(3.0f, 2.0), 0.0f, 1e-4);
+  ASSERT_NEAR(DecoderIterPolicy::SnrMarginDb(30.0f, 2.0), 10.0f, 1e-4);
+  ASSERT_LT(DecoderIterPolicy::SnrMarginDb(1.0f, 2.0), 0.0f);
+  ASSERT_TRUE(std::isnan(DecoderIterPolicy::SnrMarginDb(0.0f, 2.0)));
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,73 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "edf_scheduler.h"
+
+static constexpr size_t kNumWorkers = 4;
+static constexpr size_t kNumTasks = (1 << 16);
+
+// Tasks are handed out by deadline, then in push order
+TEST(TestEdfScheduler, Order) {
+  EdfScheduler scheduler;
+  scheduler.Push(300, 0, EventData(EventType::kDemul, 1));
+  scheduler.Push(100, 1, EventData(EventType::kFFT, 2));
+  scheduler.Push(200, 0, EventData(EventType::kZF, 3));
+  scheduler.Push(100, 1, EventData(EventType::kFFT, 4));
+  ASSERT_EQ(scheduler.Size(), 4);
+
+  const std::vector<size_t> expected_tags = {2, 4, 3, 1};
+  const std::vector<size_t> expected_qids = {1, 1, 0, 0};
+  for (size_t i = 0; i < expected_tags.size(); i++) {
+    EventData event;
+    size_t qid;
+    ASSERT_TRUE(scheduler.Pop(event, qid));
+    ASSERT_EQ(event.tags_[0], expected_tags.at(i));
+    ASSERT_EQ(qid, expected_qids.at(i));
+  }
+
+  EventData event;
+  size_t qid;
+  ASSERT_FALSE(scheduler.Pop(event, qid));
+  ASSERT_EQ(scheduler.Size(), 0);
+}
+
+// All pushed tasks are run exactly once by concurrent workers
+TEST(TestEdfScheduler, Concurrent) {
+  EdfScheduler scheduler;
+  std::vector<std::atomic<size_t>> run_count(kNumTasks);
+  std::atomic<size_t> num_done(0);
+
+  auto worker_func = [&]() {
+    while (num_done < kNumTasks) {
+      EventData event;
+      size_t qid;
+      if (scheduler.Pop(event, qid)) {
+        run_count.at(event.tags_[0])++;
+        num_done++;
+      }
+    }
+  };
+
+  std::vector<std::thread> workers;
+  for (size_t i = 0; i < kNumWorkers; i++) {
+    workers.emplace_back(worker_func);
+  }
+  for (size_t i = 0; i < kNumTasks; i++) {
+    scheduler.Push(kNumTasks - i, i & 0x1, EventData(EventType::kDemul, i));
+  }
+  for (auto& w : workers) {
+    w.join();
+  }
+
+  for (size_t i = 0; i < kNumTasks; i++) {
+    ASSERT_EQ(run_count.at(i), 1);
+  }
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,224 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "batched_zf.h"
+#include "comms-lib.h"
+#include "fixed_point.h"
+#include "modulation.h"
+
+static constexpr size_t kNumSc = 64;
+static constexpr float kChannelGain = 0.05f;
+static constexpr float kNoiseStd = 0.03f;
+
+// Block exponents keep the largest sample below 2^bits, and round trips
+// through Q15 lose at most half a step
+TEST(TestFixedPointDemul, Quantize) {
+  const std::vector<float> in = {0.75f, -3.0f, 1e-3f, 0.0f, 2.5f, -0.1f,
+                                 0.3f,  1.0f,  -2.0f, 0.5f, 0.2f, 1.5f,
+                                 -1.5f, 0.6f,  0.7f,  -0.8f, 2.9f};
+  const size_t bits = 11;
+  const int exponent = Q15BlockExponent(in.data(), in.size(), bits);
+  ASSERT_EQ(exponent, 9);
+  std::vector<int16_t> out(in.size());
+  FloatToQ15(in.data(), out.data(), in.size(), exponent);
+  for (size_t i = 0; i < in.size(); i++) {
+    ASSERT_LT(std::abs(out.at(i)), 1 << bits);
+    ASSERT_LE(std::fabs(out.at(i) - std::ldexp(in.at(i), exponent)), 0.5f);
+  }
+  ASSERT_EQ(Q15OperandBits(64), 11);
+  ASSERT_EQ(Q15OperandBits(8), 13);
+
+  // Rotating by -j maps (re, im) to (im, -re)
+  std::vector<int16_t> rot(out.size() - 1);
+  Q15RotateMinusJ(out.data(), rot.data(), rot.size() / 2);
+  for (size_t i = 0; i < rot.size() / 2; i++) {
+    ASSERT_EQ(rot.at(2 * i), out.at(2 * i + 1));
+    ASSERT_EQ(rot.at(2 * i + 1), -out.at(2 * i));
+  }
+
+  // All-zero blocks do not lower the exponent of other blocks
+  const std::vector<float> zeros(16, 0.0f);
+  ASSERT_GT(Q15BlockExponent(zeros.data(), zeros.size(), bits), exponent);
+}
+
+// Random QAM symbol with unit average power
+static complex_float RandomSymbol(std::mt19937& gen, size_t mod_order_bits) {
+  const size_t levels = size_t(1) << (mod_order_bits / 2);
+  const float norm = std::sqrt(2.0f * (levels * levels - 1) / 3.0f);
+  std::uniform_int_distribution<int> level(0, static_cast<int>(levels) - 1);
+  return {(2.0f * level(gen) - (levels - 1)) / norm,
+          (2.0f * level(gen) - (levels - 1)) / norm};
+}
+
+// Float soft demapping of [num] <= kNumSc symbols, as done by DoDemul
+// without "fixed_point_demul"
+static void DemodFloat(const std::vector<float>& equal, int8_t* llr,
+                       size_t num, size_t mod_order_bits, float llr_scale) {
+  // The SIMD demappers need aligned buffers
+  alignas(64) float in[2 * kNumSc];
+  alignas(64) int8_t out[kMaxModType * kNumSc];
+  std::copy(equal.begin(), equal.end(), in);
+  switch (mod_order_bits) {
+    case (CommsLib::kQpsk):
+      // Takes the number of floats, i.e., of LLRs
+      DemodQpskSoftSse(in, out, 2 * num, llr_scale);
+      break;
+    case (CommsLib::kQaM16):
+      Demod16qamSoftAvx2(in, out, num, llr_scale);
+      break;
+    case (CommsLib::kQaM64):
+      Demod64qamSoftAvx2(in, out, num, llr_scale);
+      break;
+    case (CommsLib::kQaM256):
+#ifdef __AVX512F__
+      Demod256qamSoftAvx512(in, out, num, llr_scale);
+#else
+      Demod256qamSoftAvx2(in, out, num, llr_scale);
+#endif
+      break;
+  }
+  std::copy(out, out + num * mod_order_bits, llr);
+}
+
+// The LLRs of the Q15 datapath match those of the float datapath for
+// zeroforcing detection of noisy QAM symbols, with users of different
+// modulation orders and LLR scales sharing the detectors
+TEST(TestFixedPointDemul, FloatParity) {
+  const std::vector<std::pair<size_t, size_t>> sizes = {
+      {8, 4}, {32, 20}, {64, 16}, {64, 40}};
+  const std::vector<size_t> mods = {2, 4, 6, 8};
+  const std::vector<float> demod_llr_scales = {1.0f, 0.5f, 2.0f, 0.3f, 1.5f};
+  for (const auto& [bs_ant_num, ue_ant_num] : sizes) {
+    for (size_t mod_id = 0; mod_id < mods.size(); mod_id++) {
+      std::vector<size_t> ue_mod_order_bits(ue_ant_num);
+      std::vector<float> ue_llr_scales(ue_ant_num);
+      std::vector<float> llr_scales(ue_ant_num);
+      for (size_t ue = 0; ue < ue_ant_num; ue++) {
+        ue_mod_order_bits.at(ue) = mods.at((mod_id + ue) % mods.size());
+        ue_llr_scales.at(ue) =
+            demod_llr_scales.at(ue % demod_llr_scales.size());
+        llr_scales.at(ue) =
+            Q15LlrScale(ue_mod_order_bits.at(ue)) * ue_llr_scales.at(ue);
+      }
+      std::mt19937 gen(bs_ant_num + ue_ant_num + mod_id);
+      std::normal_distribution<float> dist(0.0, 1.0);
+
+      // Detectors of random channels, with room for their Q15 copies
+      BatchedZf batched_zf(bs_ant_num, ue_ant_num, kNumSc);
+      std::vector<std::vector<complex_float>> csi(kNumSc);
+      for (size_t sc = 0; sc < kNumSc; sc++) {
+        for (size_t i = 0; i < bs_ant_num * ue_ant_num; i++) {
+          const complex_float val = {kChannelGain * dist(gen),
+                                     kChannelGain * dist(gen)};
+          csi.at(sc).push_back(val);
+          batched_zf.SetCsi(sc, i / ue_ant_num, i % ue_ant_num, val);
+        }
+      }
+      ASSERT_EQ(batched_zf.Compute(kNumSc), 0);
+      const size_t cell_entries =
+          bs_ant_num * ue_ant_num + Q15ZfEntries(bs_ant_num, ue_ant_num);
+      std::vector<std::vector<complex_float>> zf(
+          kNumSc, std::vector<complex_float>(cell_entries));
+      for (size_t sc = 0; sc < kNumSc; sc++) {
+        batched_zf.GetZf(sc, zf.at(sc).data());
+        Q15QuantizeZf(zf.at(sc).data(), bs_ant_num, ue_ant_num,
+                      llr_scales.data());
+      }
+
+      // Received samples, stored as [ant][sc]
+      std::vector<complex_float> rx(bs_ant_num * kNumSc);
+      for (size_t sc = 0; sc < kNumSc; sc++) {
+        std::vector<complex_float> tx(ue_ant_num);
+        for (size_t ue = 0; ue < ue_ant_num; ue++) {
+          tx.at(ue) = RandomSymbol(gen, ue_mod_order_bits.at(ue));
+        }
+        for (size_t ant = 0; ant < bs_ant_num; ant++) {
+          complex_float y = {kNoiseStd * kChannelGain * dist(gen),
+                             kNoiseStd * kChannelGain * dist(gen)};
+          for (size_t ue = 0; ue < ue_ant_num; ue++) {
+            const complex_float h = csi.at(sc).at(ant * ue_ant_num + ue);
+            y.re += h.re * tx.at(ue).re - h.im * tx.at(ue).im;
+            y.im += h.re * tx.at(ue).im + h.im * tx.at(ue).re;
+          }
+          rx.at(ant * kNumSc + sc) = y;
+        }
+      }
+
+      // Float datapath
+      std::vector<std::vector<float>> equal(
+          ue_ant_num, std::vector<float>(2 * kNumSc));
+      for (size_t sc = 0; sc < kNumSc; sc++) {
+        for (size_t ue = 0; ue < ue_ant_num; ue++) {
+          complex_float sum = {0, 0};
+          for (size_t ant = 0; ant < bs_ant_num; ant++) {
+            const complex_float w = zf.at(sc).at(ant * ue_ant_num + ue);
+            const complex_float x = rx.at(ant * kNumSc + sc);
+            sum.re += w.re * x.re - w.im * x.im;
+            sum.im += w.re * x.im + w.im * x.re;
+          }
+          equal.at(ue).at(2 * sc) = sum.re;
+          equal.at(ue).at(2 * sc + 1) = sum.im;
+        }
+      }
+
+      // Q15 datapath, with one block exponent per cache line of subcarriers
+      std::vector<int16_t> rx_q15(2 * rx.size());
+      std::vector<int16_t> rx_rot(2 * rx.size());
+      std::vector<int8_t> symbols(2 * ue_ant_num * kNumSc);
+      for (size_t sc = 0; sc < kNumSc; sc += kSCsPerCacheline) {
+        int exponent = INT32_MAX;
+        for (size_t ant = 0; ant < bs_ant_num; ant++) {
+          exponent = std::min(
+              exponent,
+              Q15BlockExponent(
+                  reinterpret_cast<const float*>(&rx.at(ant * kNumSc + sc)),
+                  2 * kSCsPerCacheline, Q15OperandBits(bs_ant_num)));
+        }
+        for (size_t ant = 0; ant < bs_ant_num; ant++) {
+          FloatToQ15(reinterpret_cast<const float*>(&rx.at(ant * kNumSc + sc)),
+                     &rx_q15.at(2 * (ant * kNumSc + sc)),
+                     2 * kSCsPerCacheline, exponent);
+          Q15RotateMinusJ(&rx_q15.at(2 * (ant * kNumSc + sc)),
+                          &rx_rot.at(2 * (ant * kNumSc + sc)),
+                          kSCsPerCacheline);
+        }
+        for (size_t j = 0; j < kSCsPerCacheline; j++) {
+          Q15Equalize(zf.at(sc + j).data(), bs_ant_num, ue_ant_num,
+                      &rx_q15.at(2 * (sc + j)), &rx_rot.at(2 * (sc + j)),
+                      kNumSc, exponent, &symbols.at(2 * (sc + j)), kNumSc);
+        }
+      }
+
+      size_t num_llrs = 0;
+      size_t num_off_by_two = 0;
+      for (size_t ue = 0; ue < ue_ant_num; ue++) {
+        const size_t mod_order_bits = ue_mod_order_bits.at(ue);
+        std::vector<int8_t> llr_float(kNumSc * mod_order_bits);
+        std::vector<int8_t> llr_q15(kNumSc * mod_order_bits);
+        DemodFloat(equal.at(ue), llr_float.data(), kNumSc, mod_order_bits,
+                   ue_llr_scales.at(ue));
+        Q15DemodSoft(&symbols.at(2 * ue * kNumSc), llr_q15.data(), kNumSc,
+                     mod_order_bits, ue_llr_scales.at(ue));
+        for (size_t i = 0; i < llr_float.size(); i++) {
+          const int diff = std::abs(llr_float.at(i) - llr_q15.at(i));
+          ASSERT_LE(diff, 2) << "bs_ant_num " << bs_ant_num << ", ue_ant_num "
+                             << ue_ant_num << ", ue " << ue
+                             << ", mod_order_bits " << mod_order_bits
+                             << ", llr " << i;
+          num_off_by_two += (diff == 2);
+          num_llrs++;
+        }
+      }
+      ASSERT_LT(num_off_by_two, num_llrs / 100);
+    }
+  }
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
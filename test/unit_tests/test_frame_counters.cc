@@ -0,0 +1,199 @@
+#include <gtest/gtest.h>
+
+#include <array>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "buffer.h"
+#include "concurrentqueue.h"
+
+static constexpr size_t kNumThreads = 4;
+static constexpr size_t kNumSymbols = 14;
+static constexpr size_t kTasksPerSymbol = 64;
+static constexpr size_t kNumRounds = 10;
+static constexpr size_t kMaxMasterThreads = 4;
+static constexpr size_t kScheduleQueues = 2;
+static constexpr size_t kDequeueBulkSize = 64;
+
+// Complete the tasks of all frames in the window from several threads. Exactly
+// one thread must see the last task of each symbol and the last symbol of
+// each frame.
+TEST(TestFrameCounters, ConcurrentComplete) {
+  FrameCounters counters;
+  counters.Init(kNumSymbols, kTasksPerSymbol);
+  std::array<std::atomic<size_t>, kFrameWnd> num_last_symbols = {};
+  std::array<std::atomic<size_t>, kFrameWnd> num_last_frames = {};
+
+  auto complete_func = [&](size_t tid) {
+    for (size_t frame_id = 0; frame_id < kFrameWnd; frame_id++) {
+      for (size_t symbol_id = 0; symbol_id < kNumSymbols; symbol_id++) {
+        for (size_t task = tid; task < kTasksPerSymbol; task += kNumThreads) {
+          if (counters.CompleteTask(frame_id, symbol_id) == true) {
+            num_last_symbols.at(frame_id)++;
+            if (counters.CompleteSymbol(frame_id) == true) {
+              num_last_frames.at(frame_id)++;
+            }
+          }
+        }
+      }
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < kNumThreads; i++) {
+    threads.emplace_back(complete_func, i);
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+
+  for (size_t frame_id = 0; frame_id < kFrameWnd; frame_id++) {
+    ASSERT_EQ(num_last_symbols.at(frame_id), kNumSymbols);
+    ASSERT_EQ(num_last_frames.at(frame_id), 1);
+    ASSERT_TRUE(counters.IsLastSymbol(frame_id));
+    for (size_t symbol_id = 0; symbol_id < kNumSymbols; symbol_id++) {
+      ASSERT_TRUE(counters.IsLastTask(frame_id, symbol_id));
+    }
+  }
+}
+
+// What the first master thread saw while completing the frames of the window
+struct MasterCounts {
+  // Completion events counted with CompleteTask, by any master thread
+  size_t num_tasks_counted = 0;
+  // Symbols and frames completed at the first master thread, per frame
+  std::array<size_t, kFrameWnd> num_symbols_done = {};
+  std::array<size_t, kFrameWnd> num_frames_done = {};
+  // Completion events still queued once all frames were done
+  size_t num_events_left = 0;
+};
+
+// Model of the Agora master: completion events of kFrameWnd frames are
+// waiting in the per-frame-parity completion queues. With one master thread,
+// it counts every event. With more, the other master threads (shards) count
+// the events and forward only symbol completions to the first master thread.
+// microbench/master_shard_perf times the same model.
+MasterCounts RunMasters(size_t num_masters) {
+  using mt_queue_t = moodycamel::ConcurrentQueue<EventData>;
+  const size_t num_shards = num_masters - 1;
+
+  FrameCounters counters;
+  counters.Init(kNumSymbols, kTasksPerSymbol);
+  mt_queue_t complete_task_queue[kScheduleQueues];
+  mt_queue_t shard_complete_queue;
+  std::atomic<size_t> num_tasks_counted(0);
+  MasterCounts master_counts;
+
+  for (size_t round = 0; round < kNumRounds; round++) {
+    for (size_t frame_id = 0; frame_id < kFrameWnd; frame_id++) {
+      for (size_t symbol_id = 0; symbol_id < kNumSymbols; symbol_id++) {
+        for (size_t task = 0; task < kTasksPerSymbol; task++) {
+          complete_task_queue[frame_id & 0x1].enqueue(EventData(
+              EventType::kDemul,
+              gen_tag_t::FrmSymSc(frame_id, symbol_id, task).tag_));
+        }
+      }
+    }
+
+    std::atomic<bool> running(true);
+    auto shard_func = [&](size_t shard_id) {
+      const bool own_queue = (num_shards >= kScheduleQueues);
+      moodycamel::ProducerToken ptok(shard_complete_queue);
+      EventData events_list[kDequeueBulkSize];
+      while (running == true) {
+        for (size_t qid = 0; qid < kScheduleQueues; qid++) {
+          if (own_queue && (qid != (shard_id % kScheduleQueues))) {
+            continue;
+          }
+          const size_t num = complete_task_queue[qid].try_dequeue_bulk(
+              events_list, kDequeueBulkSize);
+          for (size_t i = 0; i < num; i++) {
+            gen_tag_t tag(events_list[i].tags_[0]);
+            num_tasks_counted++;
+            if (counters.CompleteTask(tag.frame_id_, tag.symbol_id_)) {
+              shard_complete_queue.enqueue(ptok, events_list[i]);
+            }
+          }
+        }
+      }
+    };
+
+    std::vector<std::thread> shards;
+    for (size_t i = 0; i < num_shards; i++) {
+      shards.emplace_back(shard_func, i);
+    }
+
+    size_t num_frames_done = 0;
+    size_t qid = 0;
+    EventData events_list[kDequeueBulkSize];
+    while (num_frames_done < kFrameWnd) {
+      size_t num = 0;
+      if (num_shards > 0) {
+        num = shard_complete_queue.try_dequeue_bulk(events_list,
+                                                    kDequeueBulkSize);
+      } else {
+        num = complete_task_queue[qid].try_dequeue_bulk(events_list,
+                                                        kDequeueBulkSize);
+        qid ^= 0x1;
+      }
+      for (size_t i = 0; i < num; i++) {
+        gen_tag_t tag(events_list[i].tags_[0]);
+        bool last_task = true;
+        if (num_shards == 0) {
+          num_tasks_counted++;
+          last_task = counters.CompleteTask(tag.frame_id_, tag.symbol_id_);
+        }
+        if (last_task) {
+          master_counts.num_symbols_done.at(tag.frame_id_)++;
+          if (counters.CompleteSymbol(tag.frame_id_)) {
+            counters.Reset(tag.frame_id_);
+            master_counts.num_frames_done.at(tag.frame_id_)++;
+            num_frames_done++;
+          }
+        }
+      }
+    }
+
+    running = false;
+    for (auto& t : shards) {
+      t.join();
+    }
+    master_counts.num_events_left += complete_task_queue[0].size_approx() +
+                                     complete_task_queue[1].size_approx() +
+                                     shard_complete_queue.size_approx();
+  }
+  master_counts.num_tasks_counted = num_tasks_counted;
+  return master_counts;
+}
+
+// With master shards, the first master thread must see exactly the symbol and
+// frame completions that a single master thread counting every event sees
+TEST(TestFrameCounters, ShardedMastersMatchSingleMaster) {
+  const MasterCounts reference = RunMasters(1);
+  ASSERT_EQ(reference.num_tasks_counted,
+            kNumRounds * kFrameWnd * kNumSymbols * kTasksPerSymbol);
+  ASSERT_EQ(reference.num_events_left, 0);
+  for (size_t frame_id = 0; frame_id < kFrameWnd; frame_id++) {
+    ASSERT_EQ(reference.num_symbols_done.at(frame_id),
+              kNumRounds * kNumSymbols);
+    ASSERT_EQ(reference.num_frames_done.at(frame_id), kNumRounds);
+  }
+
+  for (size_t num_masters = 2; num_masters <= kMaxMasterThreads;
+       num_masters++) {
+    const MasterCounts sharded = RunMasters(num_masters);
+    ASSERT_EQ(sharded.num_tasks_counted, reference.num_tasks_counted)
+        << num_masters << " master threads";
+    ASSERT_EQ(sharded.num_events_left, 0) << num_masters << " master threads";
+    ASSERT_EQ(sharded.num_symbols_done, reference.num_symbols_done)
+        << num_masters << " master threads";
+    ASSERT_EQ(sharded.num_frames_done, reference.num_frames_done)
+        << num_masters << " master threads";
+  }
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,195 @@
+#include <gtest/gtest.h>
+
+#include <random>
+#include <vector>
+
+#include "harq_manager.h"
+#include "ldpc_decoder.h"
+#include "ldpc_test_utils.h"
+#include "rate_matching.h"
+#include "utils_ldpc.h"
+
+static constexpr int8_t kLlr = 40;
+
+// Error-free LLRs of a transmission of num_bits bits with redundancy version
+// rv
+static std::vector<int8_t> Transmit(const CodeBlock& cb, size_t base_graph,
+                                    size_t zc, size_t rv, size_t mod_order_bits,
+                                    size_t num_bits) {
+  std::vector<uint8_t> bits(BitsToBytes(num_bits));
+  LdpcRateMatch(base_graph, zc, rv, mod_order_bits,
+                reinterpret_cast<const uint8_t*>(cb.encoded.data()), num_bits,
+                bits.data());
+  std::vector<int8_t> llrs(num_bits);
+  for (size_t i = 0; i < num_bits; i++) {
+    llrs.at(i) = ((bits.at(i / 8) >> (i % 8)) & 1) ? -kLlr : kLlr;
+  }
+  return llrs;
+}
+
+// Table 5.4.2.1-2 of TS 38.212 with N_cb = 66 Zc (BG1) or 50 Zc (BG2)
+TEST(TestRateMatching, RvStartPositions) {
+  const size_t zc = 64;
+  ASSERT_EQ(LdpcCircularBufferLen(1, zc), 66 * zc);
+  ASSERT_EQ(LdpcCircularBufferLen(2, zc), 50 * zc);
+  const std::vector<size_t> bg1_k0 = {0, 17 * zc, 33 * zc, 56 * zc};
+  const std::vector<size_t> bg2_k0 = {0, 13 * zc, 25 * zc, 43 * zc};
+  for (size_t rv = 0; rv < kNumRedundancyVersions; rv++) {
+    ASSERT_EQ(LdpcRvStart(1, zc, rv), bg1_k0.at(rv));
+    ASSERT_EQ(LdpcRvStart(2, zc, rv), bg2_k0.at(rv));
+  }
+}
+
+// Bit n = i + j * Qm of a transmission is bit (k0 + i * E / Qm + j) mod N_cb
+// of the circular buffer, and de-rate matching adds its LLR back there
+TEST(TestRateMatching, DeRateMatchInvertsRateMatch) {
+  std::mt19937 gen(0);
+  for (size_t base_graph : {1, 2}) {
+    const size_t zc = 52;
+    const CodeBlock cb(base_graph, zc, LdpcMaxNumRows(base_graph), 0, gen);
+    const size_t ncb = LdpcCircularBufferLen(base_graph, zc);
+    for (size_t mod_order_bits : {2, 4, 6, 8}) {
+      for (size_t rv = 0; rv < kNumRedundancyVersions; rv++) {
+        // A punctured transmission, and one that repeats bits
+        for (size_t num_bits : {ncb / 3, ncb + ncb / 2}) {
+          num_bits -= num_bits % mod_order_bits;
+          const std::vector<int8_t> llrs =
+              Transmit(cb, base_graph, zc, rv, mod_order_bits, num_bits);
+          const size_t k0 = LdpcRvStart(base_graph, zc, rv);
+          const size_t num_symbols = num_bits / mod_order_bits;
+          for (size_t n = 0; n < num_bits; n++) {
+            const size_t i = n % mod_order_bits;
+            const size_t j = n / mod_order_bits;
+            const size_t pos = (k0 + i * num_symbols + j) % ncb;
+            ASSERT_EQ(llrs.at(n), cb.Bit(pos) ? -kLlr : kLlr);
+          }
+
+          std::vector<int16_t> soft_buffer(ncb, 0);
+          LdpcDeRateMatch(base_graph, zc, rv, mod_order_bits, llrs.data(),
+                          num_bits, soft_buffer.data());
+          for (size_t pos = 0; pos < ncb; pos++) {
+            const size_t offset = (ncb + pos - k0) % ncb;
+            const size_t copies =
+                offset < num_bits ? (num_bits - offset + ncb - 1) / ncb : 0;
+            const int llr = cb.Bit(pos) ? -kLlr : kLlr;
+            ASSERT_EQ(soft_buffer.at(pos), static_cast<int16_t>(copies * llr))
+                << "base graph " << base_graph << ", Qm " << mod_order_bits
+                << ", rv " << rv << ", bit " << pos;
+          }
+        }
+      }
+    }
+  }
+}
+
+// Each retransmission adds its redundancy version's bits to the soft buffer
+// and raises the number of rows to decode with, and the combined LLRs decode
+TEST(TestHarqManager, CombinesRedundancyVersions) {
+  const size_t base_graph = 1;
+  const size_t zc = 64;
+  const size_t mod_order_bits = 4;
+  const size_t num_bits = LdpcNumEncodedBits(base_graph, zc, 4);  // 24 Zc
+  std::mt19937 gen(1);
+  const CodeBlock cb(base_graph, zc, LdpcMaxNumRows(base_graph), 0, gen);
+  HarqManager harq(2, 8, 4, 1, base_graph, zc);
+  std::vector<int8_t> decoder_llrs(harq.SoftBufferLen());
+
+  // rv 0 covers [0, 24 Zc), rv 2 [33 Zc, 57 Zc), and rv 3 [56 Zc, 66 Zc)
+  // and [0, 14 Zc) of the circular buffer
+  const std::vector<size_t> expected_rows = {4, 37, 46};
+  for (size_t tx = 0; tx < expected_rows.size(); tx++) {
+    const size_t rv = HarqManager::kRvSequence.at(tx);
+    const std::vector<int8_t> llrs =
+        Transmit(cb, base_graph, zc, rv, mod_order_bits, num_bits);
+    ASSERT_EQ(harq.Combine(1, 3, 0, tx == 0, rv, mod_order_bits, llrs.data(),
+                           num_bits, decoder_llrs.data()),
+              expected_rows.at(tx));
+  }
+  ASSERT_EQ(harq.NumCombined(), 2u);
+  for (size_t pos = 0; pos < harq.SoftBufferLen(); pos++) {
+    size_t copies = 1;
+    if (pos < 14 * zc || (pos >= 56 * zc && pos < 57 * zc)) {
+      copies = 2;
+    } else if (pos >= 24 * zc && pos < 33 * zc) {
+      copies = 0;
+    }
+    ASSERT_EQ(decoder_llrs.at(pos),
+              static_cast<int8_t>(copies * (cb.Bit(pos) ? -kLlr : kLlr)))
+        << "bit " << pos;
+  }
+
+  LdpcDecoder decoder(LdpcDecoder::Isa::kAvx2);
+  const size_t num_info_bits = LdpcNumInputBits(base_graph, zc);
+  std::vector<uint8_t> decoded(BitsToBytes(num_info_bits) + kMaxProcBytes);
+  bblib_ldpc_decoder_5gnr_request request = {};
+  request.varNodes = decoder_llrs.data();
+  request.numChannelLlrs = harq.SoftBufferLen();
+  request.numFillerBits = 0;
+  request.maxIterations = 10;
+  request.enableEarlyTermination = 1;
+  request.Zc = zc;
+  request.baseGraph = base_graph;
+  request.nRows = LdpcMaxNumRows(base_graph);
+  bblib_ldpc_decoder_5gnr_response response = {};
+  response.numMsgBits = num_info_bits;
+  response.compactedMessageBytes = decoded.data();
+  decoder.Decode(&request, &response);
+  for (size_t i = 0; i < BitsToBytes(num_info_bits); i++) {
+    ASSERT_EQ(decoded.at(i), static_cast<uint8_t>(cb.input.at(i)));
+  }
+
+  // New data drops the soft bits of the previous transport block
+  const std::vector<int8_t> llrs =
+      Transmit(cb, base_graph, zc, 2, mod_order_bits, num_bits);
+  ASSERT_EQ(harq.Combine(1, 3, 0, true, 2, mod_order_bits, llrs.data(),
+                         num_bits, decoder_llrs.data()),
+            37u);
+  ASSERT_EQ(decoder_llrs.at(0), 0);
+  ASSERT_EQ(harq.NumCombined(), 2u);
+}
+
+// A full pool hands the least recently used soft buffer to a new process,
+// and released buffers are reused first
+TEST(TestHarqManager, EvictsLeastRecentlyUsed) {
+  const size_t base_graph = 2;
+  const size_t zc = 32;
+  const size_t mod_order_bits = 2;
+  const size_t num_bits = LdpcNumEncodedBits(base_graph, zc, 4);
+  std::mt19937 gen(2);
+  const CodeBlock cb(base_graph, zc, LdpcMaxNumRows(base_graph), 0, gen);
+  HarqManager harq(4, 2, 2, 1, base_graph, zc);
+  std::vector<int8_t> decoder_llrs(harq.SoftBufferLen());
+  auto send = [&](size_t ue_id, size_t process_id, bool new_data, size_t rv) {
+    const std::vector<int8_t> llrs =
+        Transmit(cb, base_graph, zc, rv, mod_order_bits, num_bits);
+    harq.Combine(ue_id, process_id, 0, new_data, rv, mod_order_bits,
+                 llrs.data(), num_bits, decoder_llrs.data());
+  };
+
+  send(0, 0, true, 0);
+  send(1, 1, true, 0);
+  send(0, 0, false, 2);
+  ASSERT_EQ(harq.NumEvictions(), 0u);
+  ASSERT_EQ(harq.NumCombined(), 1u);
+
+  // User 1's process is the least recently used
+  send(2, 0, true, 0);
+  ASSERT_EQ(harq.NumEvictions(), 1u);
+  send(0, 0, false, 3);
+  ASSERT_EQ(harq.NumCombined(), 2u);
+
+  // User 1's retransmission starts over, evicting user 2's process
+  send(1, 1, false, 2);
+  ASSERT_EQ(harq.NumEvictions(), 2u);
+  ASSERT_EQ(harq.NumCombined(), 2u);
+  ASSERT_EQ(decoder_llrs.at(0), 0);
+
+  harq.Release(0, 0);
+  send(3, 1, true, 0);
+  ASSERT_EQ(harq.NumEvictions(), 2u);
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
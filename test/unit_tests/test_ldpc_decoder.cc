@@ -0,0 +1,228 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "ldpc_decoder.h"
+#include "ldpc_test_utils.h"
+#include "utils_ldpc.h"
+
+static constexpr size_t kMaxDecoderIters = 20;
+
+// Base graph, expansion factor, and number of rows of the tested codes
+static const std::vector<std::vector<size_t>> kCodes = {
+    {1, 104, 46}, {1, 208, 10}, {1, 13, 46}, {1, 64, 4},  {1, 240, 46},
+    {2, 104, 42}, {2, 120, 7},  {2, 14, 42}, {2, 52, 20}, {2, 224, 42}};
+
+static std::vector<LdpcDecoder::Isa> DecoderIsas() {
+  if (LdpcDecoder::kAvx512Available) {
+    return {LdpcDecoder::Isa::kAvx2, LdpcDecoder::Isa::kAvx512};
+  }
+  return {LdpcDecoder::Isa::kAvx2};
+}
+
+// Number of the first num_bits bits that differ between a and b
+static size_t BitErrors(const uint8_t* a, const int8_t* b, size_t num_bits) {
+  size_t errors = 0;
+  for (size_t i = 0; i < num_bits; i++) {
+    errors += ((a[i / 8] ^ static_cast<uint8_t>(b[i / 8])) >> (i % 8)) & 1;
+  }
+  return errors;
+}
+
+static int32_t Decode(LdpcDecoder& decoder, size_t base_graph, size_t zc,
+                      size_t num_rows, size_t num_filler_bits,
+                      std::vector<int8_t>& llrs, std::vector<uint8_t>& out,
+                      bblib_ldpc_decoder_5gnr_response& response) {
+  bblib_ldpc_decoder_5gnr_request request = {};
+  request.varNodes = llrs.data();
+  request.numChannelLlrs = llrs.size();
+  request.numFillerBits = num_filler_bits;
+  request.maxIterations = kMaxDecoderIters;
+  request.enableEarlyTermination = 1;
+  request.Zc = zc;
+  request.baseGraph = base_graph;
+  request.nRows = num_rows;
+  response = {};
+  response.numMsgBits = LdpcNumInputBits(base_graph, zc) - num_filler_bits;
+  response.compactedMessageBytes = out.data();
+  return decoder.Decode(&request, &response);
+}
+
+// Error-free LLRs decode in one iteration, and no parity check of the
+// lifted base graph fails on the encoder's code blocks
+TEST(TestLdpcDecoder, Noiseless) {
+  std::mt19937 gen(1);
+  for (const auto isa : DecoderIsas()) {
+    LdpcDecoder decoder(isa);
+    for (const auto& code : kCodes) {
+      const size_t base_graph = code.at(0);
+      const size_t zc = code.at(1);
+      const size_t num_rows = code.at(2);
+      const size_t num_info_bits = LdpcNumInputBits(base_graph, zc);
+      const CodeBlock cb(base_graph, zc, num_rows, 0, gen);
+      std::vector<int8_t> llrs(LdpcNumEncodedBits(base_graph, zc, num_rows));
+      for (size_t i = 0; i < llrs.size(); i++) {
+        llrs.at(i) = cb.Bit(i) == 1 ? -16 : 16;
+      }
+
+      std::vector<uint8_t> out(BitsToBytes(num_info_bits));
+      bblib_ldpc_decoder_5gnr_response response;
+      ASSERT_EQ(Decode(decoder, base_graph, zc, num_rows, 0, llrs, out,
+                       response),
+                0);
+      ASSERT_EQ(BitErrors(out.data(), cb.input.data(), num_info_bits), 0)
+          << "base graph " << base_graph << ", Zc " << zc;
+      ASSERT_EQ(response.parityPassedAtTermination, 1);
+      ASSERT_EQ(response.iterationAtTermination, 1);
+    }
+  }
+}
+
+// BPSK over AWGN with a raw bit error rate of several percent at rate 1/3:
+// all code blocks decode, and the AVX2 and AVX-512 kernels agree bit for bit
+TEST(TestLdpcDecoder, Awgn) {
+  static constexpr size_t kNumCodeBlocks = 10;
+  static constexpr float kEbN0Db = 4.0;
+  static constexpr size_t kNumFillerBits = 40;
+  std::mt19937 gen(2);
+  std::vector<std::unique_ptr<LdpcDecoder>> decoders;
+  for (const auto isa : DecoderIsas()) {
+    decoders.push_back(std::make_unique<LdpcDecoder>(isa));
+  }
+  for (const auto& code : kCodes) {
+    const size_t base_graph = code.at(0);
+    const size_t zc = code.at(1);
+    const size_t num_rows = code.at(2);
+    const size_t num_info_bits = LdpcNumInputBits(base_graph, zc);
+    const size_t num_encoded_bits =
+        LdpcNumEncodedBits(base_graph, zc, num_rows);
+    const size_t num_msg_bits = num_info_bits - kNumFillerBits;
+    const float rate =
+        static_cast<float>(num_msg_bits) / (num_encoded_bits - kNumFillerBits);
+    if ((zc < 32) || (rate > 0.8f)) {
+      continue;  // Too short or too high rate to decode reliably at kEbN0Db
+    }
+    const float noise_var = 1.0f / (2 * rate * std::pow(10, kEbN0Db / 10));
+    std::normal_distribution<float> noise(0.0, std::sqrt(noise_var));
+
+    size_t raw_errors = 0;
+    for (size_t n = 0; n < kNumCodeBlocks; n++) {
+      const CodeBlock cb(base_graph, zc, num_rows, kNumFillerBits, gen);
+      // LLRs with two fractional bits, without the filler bits
+      std::vector<int8_t> llrs;
+      const size_t filler_start = num_info_bits - kNumFillerBits - 2 * zc;
+      for (size_t i = 0; i < num_encoded_bits; i++) {
+        if (i >= filler_start && i < filler_start + kNumFillerBits) {
+          continue;
+        }
+        const float y = (cb.Bit(i) == 1 ? -1.0f : 1.0f) + noise(gen);
+        const float llr = std::round(4 * 2 * y / noise_var);
+        llrs.push_back(
+            static_cast<int8_t>(std::fmax(-127.0f, std::fmin(127.0f, llr))));
+        raw_errors += (llrs.back() < 0) != (cb.Bit(i) == 1);
+      }
+
+      std::vector<uint8_t> ref_out;
+      int32_t ref_iters = 0;
+      for (auto& decoder : decoders) {
+        std::vector<uint8_t> out(BitsToBytes(num_info_bits));
+        bblib_ldpc_decoder_5gnr_response response;
+        Decode(*decoder, base_graph, zc, num_rows, kNumFillerBits, llrs, out,
+               response);
+        ASSERT_EQ(BitErrors(out.data(), cb.input.data(), num_msg_bits), 0)
+            << "base graph " << base_graph << ", Zc " << zc;
+        ASSERT_EQ(response.parityPassedAtTermination, 1);
+        if (ref_out.empty()) {
+          ref_out = out;
+          ref_iters = response.iterationAtTermination;
+        } else {
+          ASSERT_EQ(out, ref_out);
+          ASSERT_EQ(response.iterationAtTermination, ref_iters);
+        }
+      }
+    }
+    // The decoder had errors to correct
+    ASSERT_GT(raw_errors, 0);
+  }
+}
+
+// Each code block of a batch, including partial batches, gets the same
+// decoded bits, iteration count, and parity check result as from Decode, also
+// when some of them fail to decode
+TEST(TestLdpcDecoder, Batch) {
+  static constexpr float kEbN0Db = 2.0;
+  std::mt19937 gen(3);
+  for (const auto isa : DecoderIsas()) {
+    LdpcDecoder decoder(isa);
+    for (const auto& code : kCodes) {
+      const size_t base_graph = code.at(0);
+      const size_t zc = code.at(1);
+      const size_t num_rows = code.at(2);
+      const size_t num_info_bits = LdpcNumInputBits(base_graph, zc);
+      const size_t num_encoded_bits =
+          LdpcNumEncodedBits(base_graph, zc, num_rows);
+      const float rate = static_cast<float>(num_info_bits) / num_encoded_bits;
+      const float noise_var = 1.0f / (2 * rate * std::pow(10, kEbN0Db / 10));
+      std::normal_distribution<float> noise(0.0, std::sqrt(noise_var));
+
+      for (const size_t num_blocks : {size_t{1}, decoder.BatchSize() - 3}) {
+        std::vector<std::vector<int8_t>> llrs(num_blocks);
+        std::vector<std::vector<uint8_t>> outs(num_blocks);
+        std::vector<bblib_ldpc_decoder_5gnr_request> requests(num_blocks);
+        std::vector<bblib_ldpc_decoder_5gnr_response> responses(num_blocks);
+        for (size_t b = 0; b < num_blocks; b++) {
+          const size_t num_filler_bits = (b % 4) * (zc / 4);
+          const CodeBlock cb(base_graph, zc, num_rows, num_filler_bits, gen);
+          const size_t filler_start = num_info_bits - num_filler_bits - 2 * zc;
+          for (size_t i = 0; i < num_encoded_bits; i++) {
+            if (i >= filler_start && i < filler_start + num_filler_bits) {
+              continue;
+            }
+            const float y = (cb.Bit(i) == 1 ? -1.0f : 1.0f) + noise(gen);
+            const float llr = std::round(4 * 2 * y / noise_var);
+            llrs[b].push_back(static_cast<int8_t>(
+                std::fmax(-127.0f, std::fmin(127.0f, llr))));
+          }
+          outs[b].resize(BitsToBytes(num_info_bits));
+          requests[b] = {};
+          requests[b].varNodes = llrs[b].data();
+          requests[b].numChannelLlrs = llrs[b].size();
+          requests[b].numFillerBits = num_filler_bits;
+          requests[b].maxIterations = kMaxDecoderIters;
+          requests[b].enableEarlyTermination = 1;
+          requests[b].Zc = zc;
+          requests[b].baseGraph = base_graph;
+          requests[b].nRows = num_rows;
+          responses[b] = {};
+          responses[b].numMsgBits = num_info_bits - num_filler_bits;
+          responses[b].compactedMessageBytes = outs[b].data();
+        }
+        ASSERT_EQ(decoder.DecodeBatch(requests.data(), responses.data(),
+                                      num_blocks),
+                  0);
+
+        for (size_t b = 0; b < num_blocks; b++) {
+          std::vector<uint8_t> out(BitsToBytes(num_info_bits));
+          bblib_ldpc_decoder_5gnr_response response;
+          Decode(decoder, base_graph, zc, num_rows, requests[b].numFillerBits,
+                 llrs[b], out, response);
+          ASSERT_EQ(outs[b], out) << "base graph " << base_graph << ", Zc "
+                                  << zc << ", code block " << b;
+          ASSERT_EQ(responses[b].iterationAtTermination,
+                    response.iterationAtTermination);
+          ASSERT_EQ(responses[b].parityPassedAtTermination,
+                    response.parityPassedAtTermination);
+        }
+      }
+    }
+  }
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,72 @@
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "encoder.h"
+#include "utils_ldpc.h"
+
+// Expansion factors of each range of the AVX2 encoder's cyclic shifters
+static const std::vector<size_t> kZcs = {2,  3,  7,   13,  16,  30,  52,  64,
+                                         72, 88, 104, 120, 128, 144, 208, 240};
+
+// Every code block of a batch, including partial batches and code blocks that
+// do not fill all lanes of a register, gets the parity bits that
+// BblibLdpcEncoder5gnr gives it
+TEST(TestLdpcEncoderBatch, MatchesSingle) {
+  std::mt19937 gen(1);
+  for (const size_t base_graph : {1, 2}) {
+    for (const size_t zc : kZcs) {
+      for (const size_t num_rows : {size_t{4}, LdpcMaxNumRows(base_graph)}) {
+        for (const size_t num_blocks : {1, 3, 4, 7}) {
+          std::vector<std::vector<int8_t>> inputs(num_blocks);
+          std::vector<std::vector<int8_t>> parity(num_blocks);
+          std::vector<std::vector<int8_t>> batch_parity(num_blocks);
+          std::vector<int8_t*> input_ptrs(num_blocks);
+          std::vector<int8_t*> batch_parity_ptrs(num_blocks);
+          for (size_t n = 0; n < num_blocks; n++) {
+            inputs[n].resize(LdpcEncodingInputBufSize(base_graph, zc));
+            for (size_t i = 0;
+                 i < BitsToBytes(LdpcNumInputBits(base_graph, zc)); i++) {
+              inputs[n][i] = static_cast<int8_t>(gen());
+            }
+            parity[n].resize(LdpcEncodingParityBufSize(base_graph, zc));
+            batch_parity[n].resize(LdpcEncodingParityBufSize(base_graph, zc));
+            input_ptrs[n] = inputs[n].data();
+            batch_parity_ptrs[n] = batch_parity[n].data();
+
+            bblib_ldpc_encoder_5gnr_request req = {};
+            bblib_ldpc_encoder_5gnr_response resp = {};
+            req.baseGraph = base_graph;
+            req.Zc = zc;
+            req.nRows = num_rows;
+            req.numberCodeblocks = 1;
+            req.input[0] = inputs[n].data();
+            resp.output[0] = parity[n].data();
+            avx2enc::BblibLdpcEncoder5gnr(&req, &resp);
+          }
+
+          ASSERT_EQ(avx2enc::LdpcEncodeBatch(base_graph, zc, num_rows,
+                                             input_ptrs.data(),
+                                             batch_parity_ptrs.data(),
+                                             num_blocks),
+                    0);
+          for (size_t n = 0; n < num_blocks; n++) {
+            ASSERT_EQ(std::memcmp(parity[n].data(), batch_parity[n].data(),
+                                  BitsToBytes(num_rows * zc)),
+                      0)
+                << "base graph " << base_graph << ", Zc " << zc << ", "
+                << num_rows << " rows, code block " << n << " of "
+                << num_blocks;
+          }
+        }
+      }
+    }
+  }
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
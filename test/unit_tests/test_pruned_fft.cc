@@ -0,0 +1,119 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "mkl_dfti.h"
+#include "pruned_fft.h"
+
+static constexpr float kMaxRelativeError = 1e-5f;
+
+// FFT sizes and bands [start, stop) to test, including the data subcarriers
+// of 2048 and 4096-point OFDM symbols and bands not aligned to the SIMD width
+static const std::vector<std::vector<size_t>> kBands = {
+    {2048, 424, 1624}, {4096, 848, 3248}, {2048, 0, 2048},
+    {256, 3, 201},     {256, 70, 130},    {64, 1, 63}};
+
+// ||a - b|| / ||b|| over [start, stop)
+static float RelativeError(const std::vector<complex_float>& a,
+                           const std::vector<complex_float>& b, size_t start,
+                           size_t stop) {
+  double err = 0;
+  double ref = 0;
+  for (size_t i = start; i < stop; i++) {
+    err += std::pow(a.at(i).re - b.at(i).re, 2) +
+           std::pow(a.at(i).im - b.at(i).im, 2);
+    ref += std::pow(b.at(i).re, 2) + std::pow(b.at(i).im, 2);
+  }
+  return static_cast<float>(std::sqrt(err / ref));
+}
+
+// Full FFT of [in] with a single-transform MKL descriptor, as in DoFFT
+static std::vector<complex_float> FullFft(std::vector<complex_float> in,
+                                          bool forward) {
+  DFTI_DESCRIPTOR_HANDLE handle;
+  DftiCreateDescriptor(&handle, DFTI_SINGLE, DFTI_COMPLEX, 1,
+                       static_cast<MKL_LONG>(in.size()));
+  DftiCommitDescriptor(handle);
+  if (forward) {
+    DftiComputeForward(handle, reinterpret_cast<float*>(in.data()));
+  } else {
+    DftiComputeBackward(handle, reinterpret_cast<float*>(in.data()));
+  }
+  DftiFreeDescriptor(&handle);
+  return in;
+}
+
+// The pruned FFT matches the band of the full FFT, and leaves the other
+// subcarriers of its output untouched
+TEST(TestPrunedFft, Forward) {
+  std::mt19937 gen(1);
+  std::normal_distribution<float> dist(0.0, 1.0);
+  for (const auto& band : kBands) {
+    const size_t fft_size = band.at(0);
+    const size_t start = band.at(1);
+    const size_t stop = band.at(2);
+    std::vector<complex_float> in(fft_size);
+    for (auto& x : in) {
+      x = {dist(gen), dist(gen)};
+    }
+    const std::vector<complex_float> ref = FullFft(in, true);
+
+    PrunedFft pruned_fft(fft_size, start, stop);
+    const complex_float sentinel = {-7.0f, 7.0f};
+    std::vector<complex_float> out(fft_size, sentinel);
+    pruned_fft.Forward(in.data(), out.data());
+    ASSERT_LT(RelativeError(out, ref, start, stop), kMaxRelativeError)
+        << "fft_size " << fft_size << ", band [" << start << ", " << stop
+        << ")";
+    for (size_t i = 0; i < fft_size; i++) {
+      if (i < start || i >= stop) {
+        ASSERT_EQ(out.at(i).re, sentinel.re);
+        ASSERT_EQ(out.at(i).im, sentinel.im);
+      }
+    }
+
+    // In-place, as used by DoFFT
+    pruned_fft.Forward(in.data(), in.data());
+    ASSERT_LT(RelativeError(in, ref, start, stop), kMaxRelativeError);
+  }
+}
+
+// The pruned IFFT matches the full IFFT of the band with zero guard bands,
+// without reading the guard bands of its input
+TEST(TestPrunedFft, Backward) {
+  std::mt19937 gen(2);
+  std::normal_distribution<float> dist(0.0, 1.0);
+  for (const auto& band : kBands) {
+    const size_t fft_size = band.at(0);
+    const size_t start = band.at(1);
+    const size_t stop = band.at(2);
+    std::vector<complex_float> in(fft_size, {0.0f, 0.0f});
+    for (size_t i = start; i < stop; i++) {
+      in.at(i) = {dist(gen), dist(gen)};
+    }
+    const std::vector<complex_float> ref = FullFft(in, false);
+
+    // Garbage in the guard bands is ignored
+    for (size_t i = 0; i < fft_size; i++) {
+      if (i < start || i >= stop) {
+        in.at(i) = {dist(gen), dist(gen)};
+      }
+    }
+    PrunedFft pruned_fft(fft_size, start, stop);
+    std::vector<complex_float> out(fft_size);
+    pruned_fft.Backward(in.data(), out.data());
+    ASSERT_LT(RelativeError(out, ref, 0, fft_size), kMaxRelativeError)
+        << "fft_size " << fft_size << ", band [" << start << ", " << stop
+        << ")";
+
+    pruned_fft.Backward(in.data(), in.data());
+    ASSERT_LT(RelativeError(in, ref, 0, fft_size), kMaxRelativeError);
+  }
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
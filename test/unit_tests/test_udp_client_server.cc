@@ -11,6 +11,7 @@
 static constexpr size_t kServerUDPPort = 3185;
 static constexpr size_t kMessageSize = 9000;
 static constexpr size_t kNumPackets = 10000;
+static constexpr size_t kBatchSize = 16;
 std::atomic<size_t> server_ready;
 
 void ClientFunc() {
@@ -66,6 +67,68 @@ void ServerFunc() {
               num_pkts_reordered);
 }
 
+void BatchClientFunc() {
+  std::vector<std::vector<uint8_t>> packets(
+      kBatchSize, std::vector<uint8_t>(kMessageSize));
+  std::vector<const uint8_t*> msgs(kBatchSize);
+  std::vector<uint16_t> ports(kBatchSize, kServerUDPPort);
+  UDPClient udp_client;
+
+  while (server_ready == 0) {
+    // Wait for server to get ready
+  }
+
+  static_assert(kNumPackets % kBatchSize == 0);
+  for (size_t i = 1; i <= kNumPackets; i += kBatchSize) {
+    for (size_t j = 0; j < kBatchSize; j++) {
+      *reinterpret_cast<size_t*>(&packets[j][0]) = i + j;
+      msgs[j] = &packets[j][0];
+    }
+    udp_client.SendBatch("localhost", &ports[0], &msgs[0], kMessageSize,
+                         kBatchSize);
+  }
+}
+
+// Spin until kNumPackets are received with batched receives
+void BatchServerFunc() {
+  double freq_ghz = GetTime::MeasureRdtscFreq();
+
+  UDPServer udp_server(kServerUDPPort, kMessageSize * kNumPackets);
+  std::vector<std::vector<uint8_t>> pkt_bufs(
+      kBatchSize, std::vector<uint8_t>(kMessageSize));
+  std::vector<uint8_t*> bufs(kBatchSize);
+  for (size_t j = 0; j < kBatchSize; j++) {
+    bufs[j] = &pkt_bufs[j][0];
+  }
+  std::vector<size_t> msg_lens(kBatchSize);
+
+  server_ready = 1;
+  size_t start_time = GetTime::Rdtsc();
+  size_t num_pkts_received = 0;
+  size_t num_recv_calls = 0;
+  while (num_pkts_received < kNumPackets) {
+    ssize_t ret =
+        udp_server.RecvBatch(&bufs[0], kMessageSize, kBatchSize, &msg_lens[0]);
+    ASSERT_GE(ret, 0);
+    if (ret != 0) {
+      num_recv_calls++;
+      for (ssize_t j = 0; j < ret; j++) {
+        ASSERT_EQ(msg_lens[j], kMessageSize);
+        auto pkt_index = *reinterpret_cast<size_t*>(&pkt_bufs[j][0]);
+        ASSERT_GE(pkt_index, 1);
+        ASSERT_LE(pkt_index, kNumPackets);
+      }
+      num_pkts_received += ret;
+    }
+  }
+
+  std::printf(
+      "Batched bandwidth = %.2f Gbps/s, average packets per recvmmsg = %.2f\n",
+      (kNumPackets * kMessageSize * 8) /
+          GetTime::CyclesToNs(GetTime::Rdtsc() - start_time, freq_ghz),
+      num_pkts_received * 1.0 / num_recv_calls);
+}
+
 // Test bandwidth between client and server
 TEST(UDPClientServer, Perf) {
   server_ready = 0;
@@ -76,6 +139,16 @@ TEST(UDPClientServer, Perf) {
   client_thread.join();
 }
 
+// Test bandwidth between client and server using sendmmsg / recvmmsg
+TEST(UDPClientServer, BatchPerf) {
+  server_ready = 0;
+  std::thread server_thread(BatchServerFunc);
+  std::thread client_thread(BatchClientFunc);
+
+  server_thread.join();
+  client_thread.join();
+}
+
 // Test that the server is actually non-blocking
 TEST(UDPClientServer, ServerIsNonBlocking) {
   UDPServer udp_server(kServerUDPPort);
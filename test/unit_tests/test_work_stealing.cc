@@ -0,0 +1,103 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "work_stealing_scheduler.h"
+
+static constexpr size_t kNumWorkers = 4;
+static constexpr size_t kNumTasks = (1 << 16);
+
+static const std::vector<EventType> kPriorities = {
+    EventType::kZF, EventType::kFFT, EventType::kDemul};
+
+// A worker runs its own tasks by priority, then by age
+TEST(TestWorkStealing, Priority) {
+  WorkStealingScheduler scheduler(kNumWorkers, kPriorities);
+  scheduler.Push(0, 0, EventData(EventType::kDemul, 1));
+  scheduler.Push(0, 0, EventData(EventType::kFFT, 2));
+  scheduler.Push(0, 0, EventData(EventType::kDemul, 3));
+  scheduler.Push(0, 0, EventData(EventType::kZF, 4));
+
+  const std::vector<size_t> expected_tags = {4, 2, 1, 3};
+  for (size_t expected_tag : expected_tags) {
+    EventData event;
+    size_t qid;
+    bool stolen;
+    ASSERT_TRUE(scheduler.Pop(0, 0, event, qid, stolen));
+    ASSERT_EQ(event.tags_[0], expected_tag);
+    ASSERT_EQ(qid, 0);
+    ASSERT_FALSE(stolen);
+  }
+}
+
+// Idle workers steal from the nearest worker, and look at the first queue
+// set before the other one
+TEST(TestWorkStealing, StealOrder) {
+  WorkStealingScheduler scheduler(kNumWorkers, kPriorities);
+  scheduler.Push(3, 0, EventData(EventType::kFFT, 1));
+  scheduler.Push(1, 1, EventData(EventType::kFFT, 2));
+  scheduler.Push(0, 0, EventData(EventType::kFFT, 3));
+
+  EventData event;
+  size_t qid;
+  bool stolen;
+  ASSERT_TRUE(scheduler.Pop(2, 1, event, qid, stolen));
+  ASSERT_EQ(event.tags_[0], 2);
+  ASSERT_EQ(qid, 1);
+  ASSERT_TRUE(stolen);
+
+  ASSERT_TRUE(scheduler.Pop(2, 0, event, qid, stolen));
+  ASSERT_EQ(event.tags_[0], 1);
+  ASSERT_TRUE(stolen);
+
+  ASSERT_TRUE(scheduler.Pop(2, 0, event, qid, stolen));
+  ASSERT_EQ(event.tags_[0], 3);
+  ASSERT_FALSE(scheduler.Pop(2, 0, event, qid, stolen));
+}
+
+// All tasks pushed to one worker are run exactly once by all workers
+TEST(TestWorkStealing, Concurrent) {
+  WorkStealingScheduler scheduler(kNumWorkers, kPriorities);
+  std::vector<std::atomic<size_t>> run_count(kNumTasks);
+  std::atomic<size_t> num_done(0);
+  std::array<size_t, kNumWorkers> num_stolen = {};
+
+  auto worker_func = [&](size_t worker_id) {
+    while (num_done < kNumTasks) {
+      EventData event;
+      size_t qid;
+      bool stolen;
+      if (scheduler.Pop(worker_id, 0, event, qid, stolen)) {
+        run_count.at(event.tags_[0])++;
+        num_stolen.at(worker_id) += stolen ? 1 : 0;
+        num_done++;
+      }
+    }
+  };
+
+  std::vector<std::thread> workers;
+  for (size_t i = 0; i < kNumWorkers; i++) {
+    workers.emplace_back(worker_func, i);
+  }
+  for (size_t i = 0; i < kNumTasks; i++) {
+    scheduler.Push(0, i & 0x1, EventData(EventType::kDemul, i));
+  }
+  for (auto& w : workers) {
+    w.join();
+  }
+
+  for (size_t i = 0; i < kNumTasks; i++) {
+    ASSERT_EQ(run_count.at(i), 1);
+  }
+  ASSERT_EQ(num_stolen.at(0), 0);
+  for (size_t i = 0; i < kNumWorkers; i++) {
+    std::printf("Worker %zu stole %zu tasks\n", i, num_stolen.at(i));
+  }
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
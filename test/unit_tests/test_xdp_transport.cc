@@ -0,0 +1,152 @@
+#include <gtest/gtest.h>
+#include <linux/if_arp.h>
+
+#include <cstring>
+#include <vector>
+
+#include "xdp_filter.h"
+#include "xdp_transport.h"
+
+static constexpr uint16_t kServerPort = 7000;
+static constexpr uint16_t kRruPort = 8000;
+static constexpr size_t kNumPorts = 8;
+static constexpr size_t kPayloadLen = 1000;
+static constexpr size_t kFrameLen = 2048;
+static const uint8_t kServerMac[kMacAddrLen] = {0x02, 0, 0, 0, 0, 1};
+static const uint8_t kRruMac[kMacAddrLen] = {0x02, 0, 0, 0, 0, 2};
+
+// Ones' complement sum of [len] bytes, folded to 16 bits
+static uint16_t CsumFold(const uint8_t* data, size_t len, uint32_t sum = 0) {
+  for (size_t i = 0; i + 1 < len; i += 2) {
+    sum += (static_cast<uint32_t>(data[i]) << 8) | data[i + 1];
+  }
+  if ((len & 1) != 0) {
+    sum += static_cast<uint32_t>(data[len - 1]) << 8;
+  }
+  while ((sum >> 16) != 0) {
+    sum = (sum & 0xffff) + (sum >> 16);
+  }
+  return static_cast<uint16_t>(sum);
+}
+
+// Write a frame from the RRU to the server, as the emulated RRU sends it
+static size_t WriteRruFrame(std::vector<uint8_t>& frame,
+                            const std::string& rru_addr,
+                            const std::string& server_addr, uint16_t dst_port) {
+  const struct sockaddr_storage src = XdpTransport::ParseAddr(rru_addr);
+  const size_t hdr_len =
+      (src.ss_family == AF_INET) ? kXdpIpv4HdrLen : kXdpIpv6HdrLen;
+  for (size_t i = 0; i < kPayloadLen; i++) {
+    frame.at(hdr_len + i) = static_cast<uint8_t>(i);
+  }
+  return XdpTransport::WriteUdpHeaders(
+      frame.data(), kRruMac, kServerMac, src,
+      XdpTransport::ParseAddr(server_addr), kRruPort, dst_port, kPayloadLen);
+}
+
+// The kernel accepts the frame only if its checksums are valid
+static void CheckChecksums(const std::vector<uint8_t>& frame, size_t len) {
+  const auto* eth = reinterpret_cast<const struct ethhdr*>(frame.data());
+  if (eth->h_proto == htons(ETH_P_IP)) {
+    ASSERT_EQ(len, kXdpIpv4HdrLen + kPayloadLen);
+    ASSERT_EQ(CsumFold(frame.data() + sizeof(struct ethhdr),
+                       sizeof(struct iphdr)),
+              0xffff);
+  } else {
+    ASSERT_EQ(eth->h_proto, htons(ETH_P_IPV6));
+    ASSERT_EQ(len, kXdpIpv6HdrLen + kPayloadLen);
+    // Pseudo header: addresses, UDP length, and next header
+    const size_t udp_len = sizeof(struct udphdr) + kPayloadLen;
+    const uint8_t* addrs =
+        frame.data() + sizeof(struct ethhdr) + offsetof(struct ip6_hdr, ip6_src);
+    uint32_t sum = CsumFold(addrs, 2 * sizeof(struct in6_addr));
+    sum += udp_len + IPPROTO_UDP;
+    ASSERT_EQ(CsumFold(frame.data() + kXdpIpv6HdrLen - sizeof(struct udphdr),
+                       udp_len, sum),
+              0xffff);
+  }
+}
+
+TEST(TestXdpTransport, UdpHeadersRoundTrip) {
+  for (const auto& addrs : {std::make_pair("10.0.0.2", "10.0.0.1"),
+                            std::make_pair("fd00::2", "fd00::1")}) {
+    std::vector<uint8_t> frame(kFrameLen, 0);
+    const size_t len =
+        WriteRruFrame(frame, addrs.first, addrs.second, kServerPort + 3);
+    CheckChecksums(frame, len);
+
+    uint16_t dst_port = 0;
+    size_t payload_len = 0;
+    const uint8_t* payload =
+        XdpTransport::ParseUdp(frame.data(), len,
+                               XdpTransport::ParseAddr(addrs.second),
+                               &dst_port, &payload_len);
+    ASSERT_NE(payload, nullptr) << addrs.first;
+    ASSERT_EQ(dst_port, kServerPort + 3);
+    ASSERT_EQ(payload_len, kPayloadLen);
+    ASSERT_EQ(payload, frame.data() + len - kPayloadLen);
+    for (size_t i = 0; i < kPayloadLen; i++) {
+      ASSERT_EQ(payload[i], static_cast<uint8_t>(i));
+    }
+
+    // Sent to another address, or truncated
+    ASSERT_EQ(XdpTransport::ParseUdp(frame.data(), len,
+                                     XdpTransport::ParseAddr(addrs.first),
+                                     &dst_port, &payload_len),
+              nullptr);
+    ASSERT_EQ(XdpTransport::ParseUdp(frame.data(), len - 1,
+                                     XdpTransport::ParseAddr(addrs.second),
+                                     &dst_port, &payload_len),
+              nullptr);
+  }
+}
+
+// The XDP program redirects UDP to the server ports only, and passes ARP,
+// neighbor discovery, and other UDP traffic to the kernel
+TEST(TestXdpTransport, FilterRedirectsOnlyAgoraPorts) {
+  for (const auto& addrs : {std::make_pair("10.0.0.2", "10.0.0.1"),
+                            std::make_pair("fd00::2", "fd00::1")}) {
+    std::vector<uint8_t> frame(kFrameLen, 0);
+    for (size_t port = kServerPort - 1; port <= kServerPort + kNumPorts;
+         port++) {
+      const size_t len = WriteRruFrame(frame, addrs.first, addrs.second, port);
+      const bool agora_port =
+          (port >= kServerPort) && (port < kServerPort + kNumPorts);
+      ASSERT_EQ(XdpIsAgoraUdp(frame.data(), frame.data() + len, kServerPort,
+                              kNumPorts) != 0,
+                agora_port)
+          << addrs.first << " port " << port;
+      // Headers cut short
+      ASSERT_EQ(XdpIsAgoraUdp(frame.data(),
+                              frame.data() + len - kPayloadLen - 1,
+                              kServerPort, kNumPorts),
+                0);
+    }
+    // No ports configured
+    const size_t len =
+        WriteRruFrame(frame, addrs.first, addrs.second, kServerPort);
+    ASSERT_EQ(XdpIsAgoraUdp(frame.data(), frame.data() + len, 0, 0), 0);
+  }
+
+  // ARP request
+  std::vector<uint8_t> frame(kFrameLen, 0);
+  auto* eth = reinterpret_cast<struct ethhdr*>(frame.data());
+  eth->h_proto = htons(ETH_P_ARP);
+  auto* arp = reinterpret_cast<struct arphdr*>(eth + 1);
+  arp->ar_op = htons(ARPOP_REQUEST);
+  ASSERT_EQ(XdpIsAgoraUdp(frame.data(), frame.data() + 60, kServerPort,
+                          kNumPorts),
+            0);
+
+  // ICMPv6 neighbor solicitation
+  const size_t len = WriteRruFrame(frame, "fd00::2", "fd00::1", kServerPort);
+  reinterpret_cast<struct ip6_hdr*>(eth + 1)->ip6_nxt = IPPROTO_ICMPV6;
+  ASSERT_EQ(XdpIsAgoraUdp(frame.data(), frame.data() + len, kServerPort,
+                          kNumPorts),
+            0);
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}